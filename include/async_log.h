@@ -0,0 +1,97 @@
+#pragma once
+
+#include "utils.h"
+
+namespace gearforge {
+
+enum class LogOverflow { Drop, Block };
+
+struct AsyncLogOptions {
+    std::string path = "data/gearforge.log";
+    size_t ring_capacity = 4096;  // Records per thread, rounded up to a power of two
+    LogOverflow overflow = LogOverflow::Drop;
+    std::chrono::milliseconds flush_interval{50};
+};
+
+// Fixed-size log record; longer messages are truncated
+struct LogRecord {
+    int64_t time_us;       // Microseconds since the epoch
+    int severity;
+    int line;
+    const char* file;      // glog passes __FILE__ basenames, which live forever
+    uint32_t length;
+    char message[228];
+};
+
+// Single-producer single-consumer ring, one per logging thread
+struct LogRing {
+    alignas(64) std::atomic<uint64_t> head{0};  // Next slot the writer reads
+    alignas(64) std::atomic<uint64_t> tail{0};  // Next slot the owner writes
+    alignas(64) std::atomic<bool> retired{false};  // Owner thread has exited
+    std::atomic<uint64_t> flushed{0};              // Records before this are in the file
+    std::vector<LogRecord> slots;
+    uint64_t mask;
+
+    explicit LogRing(size_t capacity) : slots(capacity), mask(capacity - 1) {}
+};
+
+// glog sink that takes file writes off the caller's thread. send() copies
+// the message into the calling thread's ring (no locks, no syscalls); a
+// background thread merges all rings by time, formats glog-style lines
+// and writes them in batches. FATAL messages, LOG(FATAL)'s failure
+// function, crash signals and exit all flush synchronously. The crash
+// signal path takes no locks and allocates nothing: it formats unflushed
+// records from the rings listed in crash_rings into a static buffer and
+// write(2)s it to the saved descriptor.
+class AsyncLogSink : public google::LogSink {
+private:
+    static constexpr size_t kCrashRings = 64;  // Threads past this aren't flushed on a crash signal
+
+    std::mutex mutex;              // Guards rings and the writer state
+    std::mutex drain_mutex;        // One drainer at a time
+    std::condition_variable wake;
+    std::vector<std::shared_ptr<LogRing>> rings;
+    std::thread writer;
+    std::FILE* file = nullptr;
+    AsyncLogOptions options;
+    std::atomic<bool> running{false};
+    std::atomic<uint64_t> generation{0};
+    std::atomic<uint64_t> dropped_count{0};
+    uint64_t dropped_reported = 0;
+    std::vector<LogRecord> batch;
+    std::array<std::atomic<LogRing*>, kCrashRings> crash_rings{};  // Read by the signal handler
+    std::atomic<int> crash_fd{-1};
+    std::atomic<bool> crashing{false};   // Rings stay allocated once set
+    long utc_offset = 0;                 // Seconds east of UTC, taken at start(); localtime isn't signal-safe
+
+    AsyncLogSink() = default;
+    LogRing* ring_for_this_thread();
+    void writer_loop();
+    void drain();  // Caller holds drain_mutex
+    bool forget_ring(LogRing* ring);  // Off crash_rings; false if a crash flush may still read it
+    void crash_flush();               // Async-signal-safe
+
+    [[noreturn]] static void on_fatal();
+    static void on_crash_signal(int sig);
+
+public:
+    ~AsyncLogSink() override;
+    AsyncLogSink(const AsyncLogSink&) = delete;
+    AsyncLogSink& operator=(const AsyncLogSink&) = delete;
+
+    static AsyncLogSink& instance();
+
+    // Open the log file, start the writer and register with glog (which
+    // then stops writing its own files); false if the file can't be opened
+    bool start(const AsyncLogOptions& opts);
+    void stop();   // Unregister, drain everything and close
+    void flush();  // Synchronously write whatever is queued
+
+    bool is_running() const { return running.load(std::memory_order_acquire); }
+    uint64_t dropped() const { return dropped_count.load(std::memory_order_relaxed); }
+
+    void send(google::LogSeverity severity, const char* full_filename, const char* base_filename, int line,
+              const struct ::tm* tm_time, const char* message, size_t message_len) override;
+};
+
+}  // namespace gearforge
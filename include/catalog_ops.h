@@ -0,0 +1,53 @@
+#pragma once
+
+#include "gear_calculator.h"
+#include "utils.h"
+
+namespace gearforge {
+
+enum class CatalogOp {
+    Merge,      // Union: every row of A plus rows of B whose gear A lacks
+    Intersect,  // Rows of A whose gear is also in B
+    Dedup,      // First row of each gear in A
+    Diff        // Rows removed from A, added in B, or changed between them
+};
+
+// Two rows describe the same gear when N matches, DP (module converted)
+// agrees within rel_tolerance and PA within angle_tolerance.
+struct CatalogOptions {
+    double rel_tolerance = 1e-4;      // Relative; also used for "changed" fields
+    double angle_tolerance = 0.01;    // Degrees
+    size_t memory_limit = size_t(512) << 20;  // Input bytes held in memory before spilling
+    size_t partitions = 64;
+    std::string spill_dir;            // Empty: system temp directory
+    unsigned threads = 0;             // 0 = all cores
+};
+
+struct CatalogStats {
+    size_t rows_a = 0, rows_b = 0;
+    size_t rows_out = 0;
+    size_t skipped = 0;               // Unparseable input rows
+    size_t partitions = 0;
+    bool spilled = false;
+};
+
+// Set operations over GearParams CSV catalogs. Rows are hash-partitioned
+// on a tolerance-quantized key and each partition is joined independently
+// (in parallel), in memory or through temporary files when the inputs are
+// larger than memory_limit. Output keeps input order: A's rows, then B's.
+class CatalogTool {
+private:
+    CatalogOptions options;
+
+public:
+    explicit CatalogTool(const CatalogOptions& opts = CatalogOptions()) : options(opts) {}
+
+    // Writes A's header plus the result rows (unchanged text) to out; diff
+    // output has a leading "Change" column (removed, added, changed).
+    // b_path is unused for Dedup. Throws std::runtime_error on I/O errors.
+    CatalogStats run(CatalogOp op, const std::string& a_path, const std::string& b_path, std::ostream& out) const;
+
+    static bool parse_op(const std::string& name, CatalogOp& op);
+};
+
+}  // namespace gearforge
@@ -0,0 +1,88 @@
+#pragma once
+
+#include "gear_calculator.h"
+#include "utils.h"
+#include "watched_catalog.h"
+
+namespace gearforge {
+
+struct SearchHit {
+    uint32_t row;
+    double score;
+};
+
+struct SearchResult {
+    std::vector<SearchHit> hits;  // Best first, at most `limit`
+    size_t matches = 0;           // Rows matched
+    bool complete = true;         // False when the time budget cut ranking short
+};
+
+// As-you-type search over a known-gear catalog. Queries mix free text
+// (prefix-matched against part labels and formatted fields such as "dp10")
+// with numeric filters: "N 30..40 m 2", "pa=20", "od ..2.5". Built from a
+// CatalogSnapshot it follows the WatchedCatalog through update().
+class CatalogIndex {
+private:
+    struct Term {
+        bool numeric = false;
+        int field = -1;
+        double lo = 0.0, hi = 0.0;  // Numeric range (inclusive)
+        std::string text;           // Text prefix
+        uint32_t token_lo = 0, token_hi = 0;  // Matching token id range
+    };
+
+    std::shared_ptr<const CatalogSnapshot> catalog;  // Holds the rows when built from a snapshot
+    std::vector<const GearParams*> rows;             // Into the caller's vector or the snapshot's chunks
+    std::vector<std::string> labels;
+
+    // Prefix index: tokens sorted so a prefix maps to one id range
+    std::vector<std::string> tokens;
+    std::vector<uint32_t> posting_offsets, postings;     // token -> rows
+    std::vector<uint32_t> row_token_offsets, row_tokens;  // row -> tokens
+
+    // Numeric index per field: ids of the rows with a value (not NaN), sorted by it
+    std::vector<std::vector<uint32_t>> sorted_by_field;
+
+    // Previous match set (one bit per row), reused when the next query only narrows it
+    std::vector<Term> last_terms;
+    std::vector<uint64_t> last_bits;
+    size_t last_count = 0;
+    bool last_valid = false;
+
+    void build();
+    void post_tokens();  // postings and posting_offsets from row_tokens (sorted per row)
+    std::vector<Term> parse(const std::string& query) const;
+    bool row_matches(uint32_t row, const Term& term) const;
+    double row_score(uint32_t row, const std::vector<Term>& terms) const;
+    bool same_term(const Term& a, const Term& b) const;
+    bool refines(const std::vector<Term>& next, const std::vector<Term>& prev) const;
+    void term_range(const Term& term, size_t& lo, size_t& hi) const;
+    void apply(const Term& term, std::vector<uint64_t>& bits, size_t& count) const;
+
+public:
+    // rows must outlive the index; labels are optional part names, one per row
+    explicit CatalogIndex(const std::vector<GearParams>& rows, const std::vector<std::string>& labels = {});
+    explicit CatalogIndex(std::shared_ptr<const CatalogSnapshot> snapshot);
+
+    // Moves a snapshot-built index to a newer version. Only rows of the
+    // chunks in reload.added (or missing from the current version) are
+    // tokenized and sorted; the rest keep their tokens and sort order under
+    // their new row numbers. Resets the last search.
+    void update(std::shared_ptr<const CatalogSnapshot> after, const CatalogReload& reload);
+
+    SearchResult search(const std::string& query, size_t limit = 20,
+                        std::chrono::microseconds budget = std::chrono::microseconds(5000));
+
+    // Every row the last search matched, in row order (all rows after an empty query)
+    std::vector<uint32_t> last_matches() const;
+
+    std::string describe(uint32_t row) const;  // One-line summary for display
+    size_t size() const { return rows.size(); }
+    const GearParams& row(uint32_t r) const { return *rows[r]; }
+    std::shared_ptr<const CatalogSnapshot> snapshot() const { return catalog; }  // Null when built from a vector
+
+    static double field_value(const GearParams& p, int field);
+    static int field_index(const std::string& name);  // -1 when not a field name
+};
+
+}  // namespace gearforge
@@ -0,0 +1,107 @@
+#pragma once
+
+#include "gear_calculator.h"
+#include "record_codec.h"
+#include "utils.h"
+
+namespace gearforge {
+
+// A lathe's change-gear end. Spindle -> stud (fixed_ratio) -> train ->
+// leadscrew. The banjo carries the intermediate stud; distances are in
+// GearParams units (inches).
+struct LatheProfile {
+    std::string name = "lathe";
+    double leadscrew_tpi = NAN;        // One of these two
+    double leadscrew_pitch = NAN;      // mm
+    double fixed_ratio = 1.0;          // Stud turns per spindle turn
+    std::vector<int> gears;            // The set supplied, duplicates included
+    double dp = NAN;                   // Change gear pitch (or module)
+    double module = NAN;
+    double pa = 14.5;
+    double stud_distance = 0.0;        // Stud to leadscrew centers
+    double slot_min = 0.0;             // Banjo slot: intermediate stud to leadscrew
+    double slot_max = INFINITY;
+    double clearance = 0.375;          // Shaft/nut radius a gear's tip must clear
+    bool simple_trains = true;         // Also A -> idler -> D
+
+    // Reads "key = value" lines (';' comments): name, leadscrew_tpi,
+    // leadscrew_pitch, fixed_ratio, gears (comma list), dp, module, pa,
+    // stud_distance, slot_min, slot_max, clearance, simple_trains
+    static LatheProfile load(const std::string& filename);
+
+    // Canonical text of everything that affects the table; names its cache file
+    std::string key() const;
+};
+
+// Compound train A:B then C:D (B and C share the intermediate stud), or a
+// simple train A -> idler -> D (b = c = idler). Teeth, not gear indexes.
+struct GearTrain {
+    double pitch = 0.0;      // mm of carriage travel per spindle turn
+    int a = 0, b = 0, c = 0, d = 0;
+    int simple = 0;          // 1: simple train through idler b
+    int alternatives = 0;    // Other feasible trains with exactly this ratio
+
+    double tpi() const { return 25.4 / pitch; }
+};
+
+template <>
+struct RecordSchema<GearTrain> {
+    static constexpr const char* name = "GearTrain";
+    static constexpr auto fields = std::make_tuple(
+        record_field("Pitch", &GearTrain::pitch), record_field("A", &GearTrain::a), record_field("B", &GearTrain::b),
+        record_field("C", &GearTrain::c), record_field("D", &GearTrain::d), record_field("Simple", &GearTrain::simple),
+        record_field("Alternatives", &GearTrain::alternatives));
+};
+
+struct ThreadMatch {
+    GearTrain train;
+    double error = 0.0;      // Relative pitch error (train / wanted - 1)
+};
+
+// Every distinct ratio the profile can set up, sorted by pitch
+class ThreadTable {
+private:
+    std::vector<GearTrain> trains;
+
+public:
+    ThreadTable() = default;
+    explicit ThreadTable(std::vector<GearTrain> sorted) : trains(std::move(sorted)) {}
+
+    // Closest `count` trains to a pitch (mm) or a TPI, nearest first (binary search, then outwards)
+    std::vector<ThreadMatch> nearest_pitch(double pitch, size_t count = 5) const;
+    std::vector<ThreadMatch> nearest_tpi(double tpi, size_t count = 5) const { return nearest_pitch(25.4 / tpi, count); }
+
+    const std::vector<GearTrain>& entries() const { return trains; }
+    size_t size() const { return trains.size(); }
+
+    // "# <rows> trains", then the GearTrain CSV; written beside filename and
+    // renamed over it, so an interrupted save leaves the old file
+    bool save(const std::string& filename) const;
+    // Throws if the row count line is missing or doesn't match the rows read
+    static ThreadTable load(const std::string& filename);
+
+    // The cached table for this profile under cache_dir, building (and caching) it on a miss
+    static ThreadTable load_or_build(const LatheProfile& profile, const std::string& cache_dir = "data/thread_tables",
+                                     unsigned threads = 0);
+};
+
+// Enumerates every compound train (and simple train, if allowed) the gear
+// set can make, in parallel over the first driver. A train is feasible
+// when the banjo can place the intermediate stud: its distances to the
+// stud (A+B pitch radii) and leadscrew (C+D) close a triangle with the
+// stud distance, the latter within the slot, and B and C clear the
+// leadscrew and stud shafts. Per ratio, the train kept is the simplest.
+class ChangeGearSolver {
+private:
+    LatheProfile profile;
+
+public:
+    explicit ChangeGearSolver(const LatheProfile& p) : profile(p) {}
+
+    ThreadTable build(unsigned threads = 0) const;
+
+    // Geometry check used by build; exposed for tests
+    bool feasible(int a, int b, int c, int d, bool simple) const;
+};
+
+}  // namespace gearforge
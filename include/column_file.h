@@ -0,0 +1,77 @@
+#pragma once
+
+#include "utils.h"
+
+namespace gearforge {
+
+// Where one chunk lives and what it holds, per column: encoded size and
+// value range (a zone map, so readers can skip chunks without decoding)
+struct ColumnChunkInfo {
+    uint64_t offset = 0;
+    uint32_t rows = 0;
+    std::vector<uint32_t> sizes;
+    std::vector<double> min, max;
+};
+
+// Chunked columnar file of doubles. Every chunk stores each column on its
+// own, in the smallest of: delta runs (integer-valued columns), dictionary
+// runs (up to 255 distinct values) or XOR against the previous value
+// (Gorilla-style bit packing), raw as a fallback. A footer indexes the
+// chunks, so a reader fetches only the columns and chunks it asks for.
+// Numbers are stored in host (little-endian) byte order.
+class ColumnFileWriter {
+private:
+    std::ofstream file;
+    std::string path;
+    std::vector<std::string> names;
+    std::vector<ColumnChunkInfo> chunks;
+    uint64_t offset = 0;
+    uint64_t rows = 0;
+    std::mutex mutex;
+    bool closed = false;
+
+public:
+    ColumnFileWriter(const std::string& path, const std::vector<std::string>& columns);
+    ~ColumnFileWriter();
+    ColumnFileWriter(const ColumnFileWriter&) = delete;
+    ColumnFileWriter& operator=(const ColumnFileWriter&) = delete;
+
+    // columns[c][row], one vector per column, all the same length. Safe to
+    // call from several threads: encoding happens outside the lock; chunks
+    // land in the order they are written.
+    void write_chunk(const std::vector<std::vector<double>>& columns);
+
+    // Writes the footer; false if any write failed
+    bool close();
+
+    uint64_t bytes() const { return offset; }
+    uint64_t row_count() const { return rows; }
+    size_t chunk_count() const { return chunks.size(); }
+};
+
+class ColumnFileReader {
+private:
+    std::ifstream file;
+    std::vector<std::string> names;
+    std::vector<ColumnChunkInfo> chunks;
+    uint64_t rows = 0;
+    std::string scratch;
+
+public:
+    explicit ColumnFileReader(const std::string& path);  // Throws on a missing or damaged file
+
+    const std::vector<std::string>& columns() const { return names; }
+    int column(const std::string& name) const;  // -1 if absent
+    size_t chunk_count() const { return chunks.size(); }
+    const ColumnChunkInfo& chunk(size_t i) const { return chunks[i]; }
+    uint64_t row_count() const { return rows; }
+
+    // Decodes one column of one chunk, reading only its bytes
+    void read(size_t chunk, int column, std::vector<double>& out);
+    std::vector<double> read(size_t chunk, int column);
+
+    // Chunks whose zone map for `column` overlaps [lo, hi]
+    std::vector<size_t> chunks_overlapping(int column, double lo, double hi) const;
+};
+
+}  // namespace gearforge
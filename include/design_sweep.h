@@ -0,0 +1,70 @@
+#pragma once
+
+#include "column_file.h"
+#include "utils.h"
+
+namespace gearforge {
+
+// The grid of a design sweep: every combination of pinion teeth, gear
+// teeth, pitch, pressure angle, center distance and backlash. Lengths are
+// inches with pitch as DP, or mm with pitch as module (units = mm).
+struct SweepSpec {
+    std::vector<double> n1, n2;      // n2 empty: same as n1
+    std::vector<double> pitch;
+    std::vector<double> pa{20.0};
+    std::vector<double> cd;
+    std::vector<double> backlash{0.0};
+    bool metric = false;
+    int min_teeth = 7;
+    double max_shift = 0.0;          // |x| either gear may take to reach the center distance; 0: standard teeth
+    double cd_tolerance = 0.001;     // Standard teeth: |(N1 + N2) / 2DP - CD| allowed
+    double min_contact = 1.2;
+    bool allow_undercut = false;
+    bool ordered = true;             // Only N1 <= N2 (the pinion first)
+
+    // Axes take "a..b" (step 1), "a..b step s" or "a, b, c"
+    static std::vector<double> parse_axis(const std::string& text);
+
+    // One "key = value": n1, n2, dp / module, pa, cd, backlash, units,
+    // min_teeth, max_shift, cd_tolerance, min_contact, allow_undercut, ordered
+    void set(const std::string& key, const std::string& value);
+
+    // "key = value" lines, ';' or '#' comments
+    static SweepSpec load(const std::string& filename);
+
+    uint64_t grid_points() const;  // The full product, before pruning
+};
+
+struct SweepStats {
+    uint64_t grid = 0;
+    uint64_t written = 0;
+    uint64_t pruned_teeth = 0;      // Below min_teeth
+    uint64_t pruned_order = 0;      // N1 > N2
+    uint64_t pruned_center = 0;     // Tooth sum can't make the center distance
+    uint64_t pruned_undercut = 0;   // No shift split within limits avoids undercut
+    uint64_t rejected_contact = 0;  // Evaluated, contact ratio too low
+    uint64_t bytes = 0;
+    size_t chunks = 0;
+    double seconds = 0.0;
+};
+
+// Runs a sweep without ever materializing the grid. Work is split into
+// cells of (PA, pitch, CD), handed to workers one at a time; within a cell
+// the center distance fixes which tooth sums can mesh, so each pinion only
+// visits the gears that fit and everything else is counted as pruned in
+// bulk. Feasible points go to a ColumnFileWriter in chunks of chunk_rows,
+// each worker filling its own.
+class DesignSweep {
+private:
+    SweepSpec spec;
+
+public:
+    explicit DesignSweep(const SweepSpec& s);
+
+    SweepStats run(const std::string& path, unsigned threads = 0, size_t chunk_rows = 65536) const;
+
+    // N1, N2, DP (or Module), PA, CD, Backlash, Ratio, X1, X2, WorkingPA, ContactRatio, Thickness1, Thickness2
+    std::vector<std::string> columns() const;
+};
+
+}  // namespace gearforge
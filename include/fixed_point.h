@@ -0,0 +1,71 @@
+#pragma once
+
+#include "utils.h"
+
+namespace gearforge {
+
+// Signed Q32.32 fixed point. Integer-only arithmetic, so results are
+// bit-identical on every machine and compiler. The most negative raw
+// value is reserved as NaN ("not entered") and propagates like one.
+class Fixed {
+private:
+    int64_t raw_ = 0;
+
+    static constexpr int64_t kNaN = std::numeric_limits<int64_t>::min();
+    static constexpr int kFracBits = 32;
+    __extension__ typedef __int128 Wide;  // Products before rescaling; __extension__ keeps -pedantic quiet
+
+    static constexpr Fixed from_raw(int64_t raw) {
+        Fixed f;
+        f.raw_ = raw;
+        return f;
+    }
+
+public:
+    constexpr Fixed() = default;
+    constexpr Fixed(int v) : raw_(static_cast<int64_t>(v) * (int64_t(1) << kFracBits)) {}
+
+    static constexpr Fixed nan() { return from_raw(kNaN); }
+    static constexpr Fixed from_double(double v) {
+        if (v != v) return nan();
+        double scaled = v * 4294967296.0;
+        if (scaled >= 9.2233720368547758e18 || scaled <= -9.2233720368547758e18) return nan();
+        return from_raw(static_cast<int64_t>(scaled + (scaled >= 0 ? 0.5 : -0.5)));
+    }
+
+    constexpr bool is_nan() const { return raw_ == kNaN; }
+    constexpr int64_t raw() const { return raw_; }
+    constexpr double to_double() const {
+        return is_nan() ? std::numeric_limits<double>::quiet_NaN() : static_cast<double>(raw_) / 4294967296.0;
+    }
+
+    friend constexpr Fixed operator+(Fixed a, Fixed b) {
+        return a.is_nan() || b.is_nan() ? nan() : from_raw(a.raw_ + b.raw_);
+    }
+    friend constexpr Fixed operator-(Fixed a, Fixed b) {
+        return a.is_nan() || b.is_nan() ? nan() : from_raw(a.raw_ - b.raw_);
+    }
+    friend constexpr Fixed operator*(Fixed a, Fixed b) {
+        if (a.is_nan() || b.is_nan()) return nan();
+        Wide p = static_cast<Wide>(a.raw_) * b.raw_;
+        return from_raw(static_cast<int64_t>(p >> kFracBits));
+    }
+    friend constexpr Fixed operator/(Fixed a, Fixed b) {
+        if (a.is_nan() || b.is_nan() || b.raw_ == 0) return nan();
+        Wide n = static_cast<Wide>(a.raw_) * (int64_t(1) << kFracBits);
+        return from_raw(static_cast<int64_t>(n / b.raw_));
+    }
+    constexpr Fixed operator-() const { return is_nan() ? nan() : from_raw(-raw_); }
+
+    // NaN compares unequal and unordered, as for floating point
+    friend constexpr bool operator==(Fixed a, Fixed b) { return !a.is_nan() && !b.is_nan() && a.raw_ == b.raw_; }
+    friend constexpr bool operator!=(Fixed a, Fixed b) { return !(a == b); }
+    friend constexpr bool operator<(Fixed a, Fixed b) { return !a.is_nan() && !b.is_nan() && a.raw_ < b.raw_; }
+};
+
+// Deterministic sine and cosine (range reduction plus a fixed Taylor
+// series); accurate to a few units in the last place
+Fixed sin(Fixed x);
+Fixed cos(Fixed x);
+
+}  // namespace gearforge
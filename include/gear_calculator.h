@@ -1,35 +1,112 @@
 #pragma once
 
+#include "fixed_point.h"
+#include "mem_stats.h"
+#include "number_format.h"
+#include "record_codec.h"
 #include "utils.h"
 
 namespace gearforge {
 
-struct GearParams {
-    int n;             // Number of teeth
-    double dp;         // Diametrical Pitch
-    double m;          // Module (metric)
-    double pd;         // Pitch Diameter
-    double od;         // Outside Diameter
-    double rd;         // Root Diameter
-    double a;          // Addendum
-    double d;          // Dedendum
-    double wd;         // Whole Depth
-    double cp;         // Circular Pitch
-    double pa;         // Pressure Angle (degrees)
-    double cd;         // Center Distance (for pair)
-    double backlash;   // Backlash
-
-    // Serialize to vector for CSV
+// Numeric policy helpers. Everything dispatches at compile time, so the
+// calculator's hot path has no branches on the precision in use.
+namespace precision {
+
+template <typename T>
+constexpr T from_double(double v) {
+    if constexpr (std::is_same_v<T, Fixed>) return Fixed::from_double(v);
+    else return static_cast<T>(v);
+}
+
+template <typename T>
+constexpr double to_double(T v) {
+    if constexpr (std::is_same_v<T, Fixed>) return v.to_double();
+    else return static_cast<double>(v);
+}
+
+template <typename T>
+constexpr T nan() {
+    if constexpr (std::is_same_v<T, Fixed>) return Fixed::nan();
+    else return std::numeric_limits<T>::quiet_NaN();
+}
+
+template <typename T>
+constexpr bool is_nan(T v) {
+    if constexpr (std::is_same_v<T, Fixed>) return v.is_nan();
+    else return v != v;
+}
+
+}  // namespace precision
+
+template <typename T>
+struct BasicGearParams {
+    int n;        // Number of teeth
+    T dp;         // Diametrical Pitch
+    T m;          // Module (metric)
+    T pd;         // Pitch Diameter
+    T od;         // Outside Diameter
+    T rd;         // Root Diameter
+    T a;          // Addendum
+    T d;          // Dedendum
+    T wd;         // Whole Depth
+    T cp;         // Circular Pitch
+    T pa;         // Pressure Angle (degrees)
+    T cd;         // Center Distance (for pair)
+    T backlash;   // Backlash
+    T x{};        // Profile shift coefficient (shift = x / DP); 0 for standard teeth
+
+    // Input for BasicGearCalculator::calculate: everything it derives is NaN.
+    // For metric gears pass dp = NaN and set m.
+    static BasicGearParams spec(int n, T dp, T pa, T x = T{}) {
+        const T nan = precision::nan<T>();
+        return {n, dp, nan, nan, nan, nan, nan, nan, nan, nan, pa, nan, nan, x};
+    }
+
+    // Cells in RecordSchema order (shortest round-trip text, so reloading gives the same values)
     std::vector<std::string> to_csv_row() const;
-    static GearParams from_csv_row(const std::vector<std::string>& row);
+    static BasicGearParams from_csv_row(const std::vector<std::string>& row);
 };
 
-class GearCalculator {
+// Column names and order of gear CSV files. X is optional (0 when a file
+// lacks it), so catalogs written before it existed still load.
+template <typename T>
+struct RecordSchema<BasicGearParams<T>> {
+    using P = BasicGearParams<T>;
+    static constexpr const char* name = "GearParams";
+    static constexpr auto fields = std::make_tuple(
+        record_field("N", &P::n), record_field("DP", &P::dp), record_field("M", &P::m),
+        record_field("PD", &P::pd), record_field("OD", &P::od), record_field("RD", &P::rd),
+        record_field("A", &P::a), record_field("D", &P::d), record_field("WD", &P::wd),
+        record_field("CP", &P::cp), record_field("PA", &P::pa), record_field("CD", &P::cd),
+        record_field("Backlash", &P::backlash), optional_record_field("X", &P::x));
+};
+
+// double is the default everywhere; float halves memory in large sweeps,
+// Fixed (Q32.32) gives bit-identical results on any machine
+using GearParams = BasicGearParams<double>;
+
+// Convert params between precisions (NaN stays NaN)
+template <typename To, typename From>
+BasicGearParams<To> precision_cast(const BasicGearParams<From>& p) {
+    auto c = [](From v) { return precision::from_double<To>(precision::to_double(v)); };
+    return {p.n, c(p.dp), c(p.m), c(p.pd), c(p.od), c(p.rd), c(p.a),
+            c(p.d), c(p.wd), c(p.cp), c(p.pa), c(p.cd), c(p.backlash), c(p.x)};
+}
+
+template <typename T>
+class BasicGearCalculator {
 public:
-    GearCalculator() = default;
+    using Params = BasicGearParams<T>;
 
-    // Calculate all from minimal inputs (e.g., N, DP or M, PA)
-    GearParams calculate(const GearParams& input);
+    BasicGearCalculator() = default;
+
+    // Calculate all from minimal inputs (e.g., N, DP or M, PA); a shift x
+    // moves addendum and dedendum by x / DP, the pitch circle stays put
+    Params calculate(const Params& input);
+
+    // Calculate every row of a catalog in parallel blocks. Within the
+    // policy's tolerance of double: float to 1e-6 relative, Fixed to 1e-8 inch
+    std::vector<Params> calculate(const std::vector<Params>& inputs);
 
     // Select cutter: Returns cutter number (1-8 for standard involute)
     int select_cutter(int teeth);
@@ -38,13 +115,24 @@ public:
     std::string dividing_head_instructions(int teeth);
 
     // Involute points (parametric, theta in radians)
-    std::pair<double, double> involute_point(double r_base, double theta);
+    std::pair<T, T> involute_point(T r_base, T theta);
 
-    // Load known values from CSV
-    std::vector<GearParams> load_known(const std::string& filename);
+    // Load known values from CSV; columns are matched by header name
+    std::vector<Params> load_known(const std::string& filename);
 
     // Save to CSV
-    bool save(const GearParams& params, const std::string& filename);
+    bool save(const Params& params, const std::string& filename);
+    bool save(const std::vector<Params>& params, const std::string& filename);
 };
 
+using GearCalculator = BasicGearCalculator<double>;
+
+// Instantiated once in gear_calculator.cpp
+extern template struct BasicGearParams<float>;
+extern template struct BasicGearParams<double>;
+extern template struct BasicGearParams<Fixed>;
+extern template class BasicGearCalculator<float>;
+extern template class BasicGearCalculator<double>;
+extern template class BasicGearCalculator<Fixed>;
+
 }  // namespace gearforge
@@ -0,0 +1,47 @@
+#pragma once
+
+#include "gear_calculator.h"
+#include "utils.h"
+
+namespace gearforge {
+
+struct GenerationOptions {
+    int radial_samples = 256;     // Sample radii between root and tip
+    int steps_per_pitch = 128;    // Generating roll steps per angular pitch
+    double tolerance = 1e-4;      // Form deviation tolerance, fraction of module (1/DP)
+    double working_depth = 1.0;   // Straight rack flank depth below reference line, in modules
+};
+
+struct GenerationResult {
+    bool undercut = false;
+    bool pointed_tip = false;
+    bool tip_interference = false;  // Only checked when a mate is given
+    double undercut_depth = 0.0;    // Max material cut away below the involute (same units as PD)
+    double form_diameter = 0.0;     // True form diameter: lowest point of the usable involute
+    double base_diameter = 0.0;
+    double min_profile_shift = 0.0; // Shift coefficient x that just avoids undercut (<= 0: none needed)
+
+    // Generated envelope: tooth half-thickness angle (rad) at each sample radius
+    std::vector<double> radii;
+    std::vector<double> half_thickness;
+};
+
+// Simulates generating a spur gear with a basic rack (hob) profile: the rack
+// is rolled through the blank in fine angular steps and the tooth space is
+// accumulated as the envelope of every rack position.
+class GearGenerator {
+private:
+    GenerationOptions options;
+
+public:
+    explicit GearGenerator(const GenerationOptions& opts = GenerationOptions()) : options(opts) {}
+
+    // The shift comes from gear.x (shift = x / DP); mate_teeth > 0 enables tip interference checks
+    GenerationResult simulate(const GearParams& gear, int mate_teeth = 0) const;
+
+    // Screen a whole catalog, one gear per task across worker threads
+    std::vector<GenerationResult> screen(const std::vector<GearParams>& gears, int mate_teeth = 0,
+                                         unsigned threads = 0) const;
+};
+
+}  // namespace gearforge
@@ -0,0 +1,71 @@
+#pragma once
+
+#include "gear_calculator.h"
+#include "utils.h"
+
+namespace gearforge {
+
+// What can be measured on a broken gear. Lengths in inches, like PD = N / DP.
+struct GearMeasurement {
+    int n = 0;                 // Tooth count (required)
+    double od = NAN;           // Outside diameter
+    double rd = NAN;           // Root diameter
+    double span = NAN;         // Span (base tangent length) over span_teeth teeth
+    int span_teeth = 0;        // 0: the usual count for N and PA
+    double tolerance = 0.002;  // Measurement uncertainty
+};
+
+struct IdentifyCandidate {
+    std::string source;        // "DP 10", "Module 2.5" or "Catalog row 12"
+    GearParams params;         // Full geometry of the candidate
+    double od_residual = NAN;  // Measured minus candidate; NAN when not measured
+    double rd_residual = NAN;
+    double span_residual = NAN;
+    double score = 0.0;        // RMS residual in tolerances; lower is better
+};
+
+// Reverse identification: which standard DP, module and PA (or catalog
+// gear) best explains the measurements. Geometry for every series pitch
+// and tooth count is precomputed into indexes sorted by (N, OD) and
+// (N, RD), so a query is a binary search plus a scan of a narrow window.
+class GearIdentifier {
+private:
+    struct Spec {
+        double dp;            // Diametrical pitch (module converted)
+        double module;        // NAN for DP series and catalog rows
+        double dedendum;      // In pitches: 1.157 for DP series, 1.25 for modules
+        int catalog_row;      // -1 for series entries
+    };
+
+    struct IndexEntry {
+        int n;
+        double key;           // OD or RD
+        uint32_t spec;
+    };
+
+    std::vector<Spec> specs;
+    std::vector<GearParams> catalog;
+    std::vector<IndexEntry> by_od, by_rd;
+
+    void add_entries(int n, uint32_t spec, double od, double rd);
+    GearParams geometry(int n, const Spec& spec, double pa) const;
+    void evaluate(const GearMeasurement& m, const Spec& spec, double pa, IdentifyCandidate& c) const;
+
+public:
+    static constexpr int kMinTeeth = 4;
+    static constexpr int kMaxTeeth = 400;
+
+    // Catalog rows are matched as-is (their own OD/RD and PA), any N
+    explicit GearIdentifier(const std::vector<GearParams>& catalog = {});
+
+    // Best `limit` candidates, best first. Needs N and OD or RD; lengths
+    // given must be positive and span_teeth below N (throws otherwise). When few
+    // fit within tolerance the search widens so there are always answers.
+    std::vector<IdentifyCandidate> identify(const GearMeasurement& m, size_t limit = 10) const;
+
+    static const std::vector<double>& dp_series();
+    static const std::vector<double>& module_series();
+    static const std::vector<double>& pressure_angles();
+};
+
+}  // namespace gearforge
@@ -0,0 +1,86 @@
+#pragma once
+
+#include "gear_calculator.h"
+#include "gear_generation.h"
+#include "utils.h"
+
+namespace gearforge {
+
+struct PreviewPoint {
+    double x, y;
+};
+
+// Terminal raster of Unicode braille cells: every character cell holds
+// 2x4 subpixels (dots), so a 80x24 terminal is a 160x96 bitmap. Each cell
+// also remembers the layer that last drew in it, shown as its color.
+class BrailleCanvas {
+private:
+    int cols, rows;
+    std::vector<uint8_t> dots;    // Per cell: braille dot bits (U+2800 + bits)
+    std::vector<uint8_t> layers;  // Per cell
+
+public:
+    BrailleCanvas(int cols, int rows);
+
+    int columns() const { return cols; }
+    int lines() const { return rows; }
+    int width() const { return cols * 2; }   // Subpixels
+    int height() const { return rows * 4; }
+
+    void clear();
+    void set(int x, int y, uint8_t layer = 0);
+    bool dot(int x, int y) const;
+    uint8_t cell(int col, int row) const { return dots[size_t(row) * cols + col]; }
+    size_t count() const;  // Dots set
+
+    // Subpixels x0..x1 (inclusive, clipped) of row y
+    void fill_span(int y, int x0, int x1, uint8_t layer = 0);
+
+    // Even-odd scanline fill of closed contours in subpixel coordinates (a
+    // contour inside another is a hole). Edges are bucketed by first scanline
+    // and kept in an active list, so each row only sorts the crossings it has.
+    void fill_polygon(const std::vector<std::vector<PreviewPoint>>& contours, uint8_t layer = 0);
+
+    // Appends the rows as UTF-8, each line cleared to its end; layer 1 cells are colored
+    void render(std::string& out) const;
+};
+
+// Animated preview of a gear, or a gear and its mate in mesh. Each tooth
+// form's outline (from the generating simulation, in modules) is built
+// once and shared; a frame only rotates, scales and fills it.
+class GearPreview {
+private:
+    GearParams gear;
+    GearParams mate;
+    bool meshing = false;
+    std::shared_ptr<const std::vector<PreviewPoint>> outline1, outline2;
+    BrailleCanvas canvas;
+    double scale = 1.0;         // Subpixels per inch
+    PreviewPoint center1{0, 0}, center2{0, 0};
+    double bore1 = 0.0, bore2 = 0.0;
+    std::string buffer;
+    std::vector<std::vector<PreviewPoint>> contours;
+
+    void place(const std::vector<PreviewPoint>& outline, double angle, PreviewPoint center, double radius,
+               double bore, uint8_t layer);
+
+public:
+    // mate_teeth > 0 adds a mate of the same DP, PA and shift to the right
+    GearPreview(const GearParams& gear, int mate_teeth, int cols, int rows);
+
+    const BrailleCanvas& raster() const { return canvas; }
+
+    // Rasterizes with the gear turned by `angle` (rad; the mate follows) and
+    // returns the whole frame: cursor home, cells, status line
+    const std::string& frame(double angle, const std::string& status = "");
+
+    // Animates at `fps` on the terminal until a key is pressed (or `seconds`
+    // pass, if > 0); one write per frame. Returns the frame rate achieved.
+    double play(double fps = 30.0, double seconds = 0.0);
+
+    // Unit-module outline of one tooth form, all teeth, cached
+    static std::shared_ptr<const std::vector<PreviewPoint>> outline(int n, double pa, double x);
+    static size_t cached_outlines();
+};
+
+}  // namespace gearforge
@@ -0,0 +1,86 @@
+#pragma once
+
+#include "gear_calculator.h"
+#include "gear_generation.h"
+#include "utils.h"
+
+namespace gearforge {
+
+// Allowable stresses (psi) and elastic coefficient (sqrt psi); both gears of a mesh are the same material
+struct GearMaterial {
+    std::string name;
+    double bending_allowable = 0.0;  // St
+    double contact_allowable = 0.0;  // Sc
+    double elastic_coefficient = 0.0;  // Cp
+
+    static GearMaterial steel(double brinell);  // Through hardened, grade 1
+    static GearMaterial cast_iron();
+    static GearMaterial bronze();
+    // "steel[:HB]", "cast-iron" or "bronze"
+    static GearMaterial parse(const std::string& spec);
+};
+
+struct RatingConditions {
+    double face_width = NAN;          // Inches; NaN: 10 / DP
+    double rpm = 1800.0;              // Of the rated gear
+    int mate_teeth = 0;               // 0: a mate of the same size
+    double power = 1.0;               // Transmitted horsepower the stresses are given at
+    GearMaterial material = GearMaterial::steel(250.0);
+    int quality = 7;                  // Transmission accuracy Qv, 5 to 11
+    double overload = 1.0;            // Ko
+    double load_distribution = 1.6;   // Km
+    double bending_safety = 1.0;      // SF
+    double contact_safety = 1.0;      // SH
+};
+
+// Geometry factors of one tooth form, independent of size
+struct GeometryFactors {
+    double lewis_y = NAN;   // Lewis form factor, load at the tip
+    double j = NAN;         // Bending geometry factor, Y over the fillet stress concentration
+    double contact = NAN;   // cos(pa) sin(pa) / 2; I = contact * mG / (mG + 1)
+};
+
+// Results in columns, one row per rated gear; NaN where a gear can't be rated
+struct RatingColumns {
+    std::vector<double> lewis_y;
+    std::vector<double> geometry_j;
+    std::vector<double> geometry_i;
+    std::vector<double> bending_stress;   // psi at RatingConditions::power
+    std::vector<double> contact_stress;
+    std::vector<double> bending_power;    // hp the allowable stresses permit
+    std::vector<double> contact_power;
+    std::vector<double> rated_power;      // The smaller of the two
+
+    size_t size() const { return rated_power.size(); }
+    void resize(size_t n);
+
+    // Rows that can carry `power` hp, in order
+    std::vector<size_t> at_least(double power) const;
+};
+
+// AGMA spur gear rating (Lewis/AGMA bending, Hertzian contact) with unity
+// life, temperature and reliability factors. Geometry factors come from the
+// generated tooth form (GearGenerator) and are cached per (N, PA, x); the
+// rest is a straight-line pass over the rows that the compiler vectorizes.
+class GearRater {
+private:
+    RatingConditions conditions;
+    GenerationOptions generation;
+    mutable std::mutex cache_mutex;
+    mutable std::unordered_map<uint64_t, GeometryFactors> cache;
+
+public:
+    explicit GearRater(const RatingConditions& cond = RatingConditions(),
+                       const GenerationOptions& gen = GenerationOptions())
+        : conditions(cond), generation(gen) {}
+
+    // Tooth form factors for n teeth (full-depth rack, shift coefficient x)
+    GeometryFactors geometry(int n, double pa, double x = 0.0) const;
+
+    // Rates every gear (N, DP or M, PA and x are used) across worker threads
+    RatingColumns rate(const std::vector<GearParams>& gears, unsigned threads = 0) const;
+
+    size_t cached_forms() const;
+};
+
+}  // namespace gearforge
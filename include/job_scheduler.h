@@ -0,0 +1,100 @@
+#pragma once
+
+#include "gear_calculator.h"
+#include "record_codec.h"
+#include "utils.h"
+
+namespace gearforge {
+
+// One gear to cut, quantity times
+struct CutJob {
+    std::string id;
+    int teeth = 0;
+    double dp = NAN;
+    double pa = 20.0;
+    int quantity = 1;
+    double due = 0.0;        // Hours from the start of the plan
+    std::string machine;     // Required machine; "" or "any": any of them
+};
+
+template <>
+struct RecordSchema<CutJob> {
+    static constexpr const char* name = "CutJob";
+    static constexpr auto fields = std::make_tuple(
+        record_field("Job", &CutJob::id), record_field("Teeth", &CutJob::teeth), record_field("DP", &CutJob::dp),
+        record_field("PA", &CutJob::pa), record_field("Quantity", &CutJob::quantity),
+        record_field("Due", &CutJob::due), record_field("Machine", &CutJob::machine));
+};
+
+struct ScheduleOptions {
+    std::vector<std::string> machines;     // Empty: the machines named by jobs, or one "M1"
+    double cutter_change = 15.0;           // Minutes to swap the involute cutter
+    double arbor_change = 20.0;            // Extra when the new cutter needs another arbor (bore size)
+    double plate_change = 10.0;            // Swap the dividing plate
+    double minutes_per_tooth = 0.5;        // Cutting, at 10 DP; scales with tooth depth (10 / DP)
+    double load_minutes = 5.0;             // Per blank
+    double tardiness_weight = 2.0;         // Cost per minute late, against setup minutes
+    std::chrono::milliseconds budget{200}; // Local search time
+    size_t max_iterations = 2000000;
+    uint64_t seed = 1;
+};
+
+// Hole circle on the Brown & Sharpe plates (1: 15-20, 2: 21-33, 3: 37-49)
+// for a 40:1 head. plate 0: whole turns only; -1: no plate divides it
+// (differential indexing).
+struct IndexPlate {
+    int plate = 0;
+    int circle = 0;
+    int turns = 0;
+    int holes = 0;
+};
+
+// Plan times are minutes from the start of the plan
+struct ScheduledJob {
+    size_t job;              // Index into the job list
+    double start = 0.0;      // Minutes, after the setup
+    double end = 0.0;
+    double setup = 0.0;      // Setup minutes spent before this job
+    std::string changes;     // "cutter 5 10DP 20PA; arbor 2; plate 1", "" when nothing changes
+    double lateness = 0.0;   // Minutes past due (0 when on time)
+};
+
+struct MachinePlan {
+    std::string machine;
+    std::vector<ScheduledJob> jobs;
+    double finish = 0.0;
+    double setup = 0.0;
+};
+
+struct SchedulePlan {
+    std::vector<MachinePlan> machines;
+    double setup = 0.0;          // Total setup minutes
+    double tardiness = 0.0;      // Total minutes late
+    size_t late_jobs = 0;
+    double makespan = 0.0;
+    double cost = 0.0;           // setup + tardiness_weight * tardiness
+    double initial_cost = 0.0;   // Of the greedy plan, before local search
+    size_t iterations = 0;
+};
+
+// Sequences cutting jobs on gear-cutting machines. Jobs sharing a setup
+// (involute cutter number from select_cutter, DP and PA; arbor; dividing
+// plate) are grouped, groups are placed earliest-due first on the machine
+// that finishes them soonest, and a local search (relocate and swap of jobs
+// and of whole setup groups, accepting moves that don't raise the cost)
+// improves the plan until the time budget runs out.
+class JobScheduler {
+private:
+    ScheduleOptions options;
+
+public:
+    explicit JobScheduler(const ScheduleOptions& opts = ScheduleOptions()) : options(opts) {}
+
+    // Throws if a job is invalid or names a machine that isn't in options.machines
+    SchedulePlan schedule(const std::vector<CutJob>& jobs) const;
+
+    static IndexPlate dividing_plate(int teeth);
+    static int arbor(double dp);  // Cutter bore class: 1 (1-1/4"), 2 (1"), 3 (7/8")
+};
+
+}  // namespace gearforge
@@ -0,0 +1,60 @@
+#pragma once
+
+#include "utils.h"
+
+namespace gearforge {
+
+struct ListColumn {
+    std::string title;
+    size_t width = 10;
+    std::function<std::string(size_t row)> format;  // Cell text for a data row
+    std::function<double(size_t row)> sort_key;     // Empty: column can't be sorted
+};
+
+// Scrolling table that only ever touches the rows in its viewport, so it
+// costs the same for 5 rows or 1M. Sorting goes through a permutation
+// built once per column (descending just walks it backwards) and each
+// visible row's formatted line is cached until it scrolls well away.
+class ListView {
+private:
+    std::vector<ListColumn> columns;
+    size_t rows;
+    size_t height;                  // Data rows in the viewport
+    size_t top = 0;                 // First visible position
+    size_t cursor = 0;              // Selected position
+    int sort_column = -1;
+    bool descending = false;
+    std::vector<std::vector<uint32_t>> permutations;  // Per column, built on first sort
+    mutable std::unordered_map<size_t, std::string> line_cache;  // Data row -> formatted cells
+
+    void follow_cursor();
+    const std::string& line_for(size_t row) const;
+
+public:
+    ListView(std::vector<ListColumn> columns, size_t rows, size_t height = 20);
+
+    // Navigation, all O(1) (clamped to the list)
+    void move(long delta);
+    void page(long pages);
+    void jump(size_t position);
+    void jump_end() { jump(rows ? rows - 1 : 0); }
+
+    // Sort by column; sorting by the current column again flips direction
+    void sort_by(int column);
+
+    size_t size() const { return rows; }
+    size_t position() const { return cursor; }
+    size_t first_visible() const { return top; }
+    size_t row_at(size_t position) const;  // Data row shown at a display position
+    size_t selected_row() const { return row_at(cursor); }
+
+    // Header, visible rows (cursor highlighted) and a status line; one
+    // buffered write, overwriting in place rather than clearing the screen
+    std::string render() const;
+
+    // w/s (arrows): line; a/d: page; g/b: top/bottom; 1-9: sort by column.
+    // Returns false for keys it doesn't handle.
+    bool handle_key(char key);
+};
+
+}  // namespace gearforge
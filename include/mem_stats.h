@@ -0,0 +1,54 @@
+#pragma once
+
+#include "utils.h"
+
+namespace gearforge {
+
+// Subsystems allocations are charged to; Other is untagged code
+enum class MemTag : uint8_t { Other, Catalog, Csv, Ui, Auth, Hash };
+constexpr size_t kMemTagCount = 6;
+
+const char* mem_tag_name(MemTag tag);
+
+struct MemTagStats {
+    uint64_t allocations = 0;  // operator new calls
+    uint64_t frees = 0;
+    uint64_t bytes = 0;        // Total requested
+    int64_t live = 0;          // Allocated under the tag and not yet freed (wherever the free happens)
+    int64_t peak = 0;          // Highest live since start or reset_peaks()
+};
+
+// Allocation accounting per tag. Only binaries that link src/mem_hook.cpp
+// count anything: it replaces the global operator new/delete (the tests
+// always link it; gearforge does when built with GEARFORGE_MEM_STATS).
+// Without it a tag is a thread_local store and every count stays zero.
+class MemStats {
+public:
+    static bool enabled();
+    static MemTagStats get(MemTag tag);
+    static std::array<MemTagStats, kMemTagCount> snapshot();
+    static void reset_peaks();  // Peak = live, to measure one phase
+    static void report(std::ostream& out);
+
+    // For the hook: charge to this thread's current tag (returned), and release
+    static void install();
+    static MemTag on_allocate(size_t bytes);
+    static void on_free(MemTag tag, size_t bytes);
+};
+
+// Charges this thread's allocations to `tag` until destroyed; scopes nest
+// and the innermost wins. utils::parallel_for carries the tag to workers.
+class MemTagScope {
+private:
+    MemTag previous;
+
+public:
+    explicit MemTagScope(MemTag tag);
+    ~MemTagScope();
+    MemTagScope(const MemTagScope&) = delete;
+    MemTagScope& operator=(const MemTagScope&) = delete;
+
+    static MemTag current();
+};
+
+}  // namespace gearforge
@@ -0,0 +1,72 @@
+#pragma once
+
+#include "gear_calculator.h"
+#include "utils.h"
+
+namespace gearforge {
+
+struct MeshGear {
+    GearParams params;            // params.x is the profile shift coefficient (shift = x / DP)
+    double tip_relief = 0.0;      // Material removed at the tip, normal to the profile; tapers linearly to zero
+    double relief_start = NAN;    // Diameter where the relief starts; NAN: highest point of single tooth contact
+};
+
+struct MeshDesign {
+    MeshGear pinion;              // Driver
+    MeshGear gear;
+    double center_distance = NAN; // NAN: tight mesh for the profile shifts
+    double load = 0.0;            // Transmitted force along the line of action
+    double face_width = 1.0;
+};
+
+struct MeshOptions {
+    int steps_per_pitch = 64;     // Rotation steps per pinion angular pitch
+    int pitches = 1;              // Mesh cycles to simulate
+    int profile_points = 200;     // Samples along each active flank
+    double tooth_stiffness = 2.0e6;    // Single tooth pair, per unit face width (psi; ~14 N/mm/um)
+    double contact_tolerance = 1e-4;   // Pairs closer than this (fraction of module) count as touching when unloaded
+};
+
+struct MeshSample {
+    double angle;                 // Pinion rotation (rad)
+    double te;                    // Unloaded transmission error along the line of action (> 0: gear ahead)
+    double loaded_te;             // With tooth deflection under the design load
+    double stiffness;             // Mesh stiffness: stiffness of the pairs carrying load
+    int pairs;                    // Tooth pairs in contact
+};
+
+struct MeshResult {
+    std::vector<MeshSample> samples;
+    double center_distance = 0.0;
+    double working_pressure_angle = 0.0;  // Degrees
+    double contact_ratio = 0.0;
+    double te_peak_to_peak = 0.0;
+    double loaded_te_peak_to_peak = 0.0;
+    double mean_stiffness = 0.0;
+    double min_stiffness = 0.0;
+    double max_stiffness = 0.0;
+};
+
+// Quasi-static mesh of a spur pair. Both flanks are tabulated from the
+// involute (with shift and tip relief) over their active profiles; at each
+// pinion angle every flank sample of one gear is located on the other gear
+// by radius (table lookup) and angle (tooth index arithmetic), giving the
+// rotation each tooth pair needs to close. The smallest gap is the
+// transmission error; under load, pairs share it by stiffness.
+class MeshSimulator {
+private:
+    MeshOptions options;
+
+    MeshResult run(const MeshDesign& design, unsigned threads) const;
+
+public:
+    explicit MeshSimulator(const MeshOptions& opts = MeshOptions()) : options(opts) {}
+
+    // Rotation steps are spread over worker threads
+    MeshResult simulate(const MeshDesign& design, unsigned threads = 0) const;
+
+    // Design variants across worker threads, each one single-threaded
+    std::vector<MeshResult> batch(const std::vector<MeshDesign>& designs, unsigned threads = 0) const;
+};
+
+}  // namespace gearforge
@@ -0,0 +1,105 @@
+#pragma once
+
+#include "utils.h"
+
+namespace gearforge {
+
+// Longest text format_number can produce
+constexpr size_t kMaxNumberChars = 32;
+
+// Most decimals worth asking for: a double carries 17 significant digits
+constexpr int kMaxDecimals = 17;
+
+// Writes v at out (at least kMaxNumberChars free) and returns the end.
+// decimals < 0: shortest text that reads back to exactly v (std::to_chars);
+// otherwise fixed with that many decimals. NaN is written as "nan".
+char* format_number(char* out, double v, int decimals = -1);
+char* format_number(char* out, float v, int decimals = -1);  // Shortest for float, not for its double widening
+
+std::string number_to_string(double v, int decimals = -1);
+
+// Append-only text buffer that keeps its storage across clear(), so
+// formatting rows into it allocates nothing once it has grown
+class FormatBuffer {
+private:
+    std::vector<char> storage;
+    size_t used = 0;
+
+    char* reserve(size_t n) {
+        if (used + n > storage.size()) storage.resize(std::max(storage.size() * 2, used + n));
+        return storage.data() + used;
+    }
+
+public:
+    explicit FormatBuffer(size_t capacity = 4096) : storage(capacity) {}
+
+    void append(double v, int decimals = -1) {
+        char* p = reserve(kMaxNumberChars);
+        used += format_number(p, v, decimals) - p;
+    }
+    void append(float v, int decimals = -1) {
+        char* p = reserve(kMaxNumberChars);
+        used += format_number(p, v, decimals) - p;
+    }
+    void append(long long v) {
+        char* p = reserve(24);
+        used += std::to_chars(p, p + 24, v).ptr - p;
+    }
+    void append(int v) { append(static_cast<long long>(v)); }
+    void append(char c) { *reserve(1) = c; ++used; }
+    void append(const std::string& s) {
+        std::memcpy(reserve(s.size()), s.data(), s.size());
+        used += s.size();
+    }
+
+    const char* data() const { return storage.data(); }
+    size_t size() const { return used; }
+    void clear() { used = 0; }
+    std::string str() const { return std::string(storage.data(), used); }
+};
+
+// Buffered CSV output: cells are formatted straight into one buffer that
+// goes to the file in large writes. No quoting, like utils::read_csv.
+class CsvWriter {
+private:
+    std::ofstream file;
+    FormatBuffer buffer;
+    bool row_start = true;
+    static constexpr size_t kFlushBytes = 1 << 20;
+
+    void separate() {
+        if (!row_start) buffer.append(',');
+        row_start = false;
+    }
+    void flush();
+
+public:
+    // buffer_bytes: initial cell buffer (it grows); 0 suits callers that only write()
+    explicit CsvWriter(const std::string& filename, size_t buffer_bytes = 2 * kFlushBytes);
+    ~CsvWriter() { close(); }
+    CsvWriter(const CsvWriter&) = delete;
+    CsvWriter& operator=(const CsvWriter&) = delete;
+
+    bool is_open() const { return file.is_open(); }
+
+    template <typename V>
+    CsvWriter& cell(const V& v) {
+        separate();
+        buffer.append(v);
+        return *this;
+    }
+    CsvWriter& cell(double v, int decimals) {
+        separate();
+        buffer.append(v, decimals);
+        return *this;
+    }
+    void end_row();
+
+    // Whole rows already formatted elsewhere (each ending in a newline)
+    void write(const FormatBuffer& rows);
+
+    // Flushes and closes; false if any write failed
+    bool close();
+};
+
+}  // namespace gearforge
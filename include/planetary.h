@@ -0,0 +1,64 @@
+#pragma once
+
+#include "gear_calculator.h"
+#include "utils.h"
+
+namespace gearforge {
+
+// Simple planetary stage: sun input, carrier output, ring fixed, so the
+// ratio is 1 + ring / sun. Lengths in millimetres.
+struct PlanetaryOptions {
+    double target_ratio = 4.0;
+    double ratio_tolerance = 0.01;     // Relative
+    int min_teeth = 0;                 // Sun and planet; 0: the undercut limit 2 / sin^2(PA)
+    int max_teeth = 200;               // Sun and planet
+    int min_planets = 3;
+    int max_planets = 8;
+    int min_ring_planet_difference = 12;  // Smaller differences foul on internal gears
+    double min_tip_gap = 0.5;          // Between neighbouring planets' tips, in modules
+    double pressure_angle = 20.0;
+    double module = NAN;               // NAN: largest standard module that fits max_ring_diameter (1 if unbounded)
+    double max_ring_diameter = NAN;    // Ring root diameter envelope; NAN: unbounded
+    size_t limit = 100;                // Results to keep, best first
+};
+
+struct PlanetaryConfig {
+    int sun = 0, planet = 0, ring = 0, planets = 0;
+    double module = 0.0;
+    double ratio = 0.0;
+    double ratio_error = 0.0;          // Relative to the target, signed
+    double center_distance = 0.0;      // Sun to planet
+    double planet_gap = 0.0;           // Tip to tip between neighbouring planets
+    double ring_diameter = 0.0;        // Ring root diameter
+    GearParams sun_params, planet_params, ring_params;  // From GearCalculator (inches, like the rest)
+};
+
+// Enumerates (sun, planet, ring, planet count) for a target ratio. The ratio
+// window fixes the ring teeth for each sun, coaxiality fixes the planet
+// (ring = sun + 2 planet), the neighbour clearance bounds the planet count
+// in closed form and the assembly condition ((sun + ring) % planets == 0)
+// picks from what is left, so only valid candidates are ever built. Sun
+// counts are partitioned across threads; each candidate is checked with
+// GearCalculator::calculate.
+class PlanetaryEnumerator {
+private:
+    PlanetaryOptions options;
+
+    bool build(int sun, int ring, int planets, PlanetaryConfig& out) const;
+
+public:
+    explicit PlanetaryEnumerator(const PlanetaryOptions& opts) : options(opts) {}
+
+    // Best first: smallest ratio error, then fewest ring teeth, then more
+    // planets. Nothing is emitted until the whole search has finished: the
+    // per-sun lists are then merged and handed to `emit` in rank order.
+    // Returns the number of valid configurations found (which may exceed
+    // options.limit).
+    size_t enumerate(const std::function<void(const PlanetaryConfig&)>& emit, unsigned threads = 0) const;
+
+    std::vector<PlanetaryConfig> enumerate(unsigned threads = 0) const;
+
+    static bool better(const PlanetaryConfig& a, const PlanetaryConfig& b);
+};
+
+}  // namespace gearforge
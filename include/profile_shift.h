@@ -0,0 +1,91 @@
+#pragma once
+
+#include "gear_calculator.h"
+#include "record_codec.h"
+#include "utils.h"
+
+namespace gearforge {
+
+// One spur pair of a gearbox bill of materials. Lengths are in GearParams
+// units (inches); cd <= 0 or NaN keeps the standard center distance.
+struct ShiftPair {
+    std::string id;
+    int n1 = 0;              // Pinion teeth
+    int n2 = 0;              // Gear teeth
+    double dp = NAN;
+    double pa = 20.0;
+    double cd = NAN;         // Required center distance
+};
+
+template <>
+struct RecordSchema<ShiftPair> {
+    static constexpr const char* name = "ShiftPair";
+    static constexpr auto fields = std::make_tuple(
+        record_field("Pair", &ShiftPair::id), record_field("N1", &ShiftPair::n1), record_field("N2", &ShiftPair::n2),
+        record_field("DP", &ShiftPair::dp), record_field("PA", &ShiftPair::pa), record_field("CD", &ShiftPair::cd));
+};
+
+struct ShiftOptions {
+    double x_min = -1.0;           // Range searched for each coefficient
+    double x_max = 1.5;
+    double min_tip = 0.25;         // Tooth thickness at the tip, in modules (x / DP units)
+    double min_contact = 1.1;      // Transverse contact ratio
+    double strength_weight = 1.0;  // Against |ln(pinion / gear base thickness)|
+    size_t grid = 128;             // Candidates per pass
+    int refine_passes = 4;         // Each narrows the range around the best to two grid steps
+};
+
+struct ShiftResult {
+    std::string id;
+    double x1 = 0.0, x2 = 0.0;
+    double cd = 0.0;               // Operating center distance
+    double working_pa = 0.0;       // Degrees
+    double tip_shortening = 0.0;   // Addendum reduction keeping the bottom clearance (x / DP units)
+    double sliding1 = 0.0;         // Peak specific sliding, pinion root (magnitude)
+    double sliding2 = 0.0;         // Peak specific sliding, gear root
+    double contact_ratio = 0.0;
+    double tip1 = 0.0, tip2 = 0.0; // Tip thickness, in modules
+    double cost = 0.0;
+    bool feasible = false;
+    std::string note;              // First constraint the best candidate breaks
+
+    // Both gears with their shift, addenda shortened by tip_shortening
+    std::pair<GearParams, GearParams> gears(const ShiftPair& pair) const;
+};
+
+template <>
+struct RecordSchema<ShiftResult> {
+    static constexpr const char* name = "ShiftResult";
+    static constexpr auto fields = std::make_tuple(
+        record_field("Pair", &ShiftResult::id), record_field("X1", &ShiftResult::x1), record_field("X2", &ShiftResult::x2),
+        record_field("CD", &ShiftResult::cd), record_field("WorkingPA", &ShiftResult::working_pa),
+        record_field("TipShortening", &ShiftResult::tip_shortening), record_field("Sliding1", &ShiftResult::sliding1),
+        record_field("Sliding2", &ShiftResult::sliding2), record_field("ContactRatio", &ShiftResult::contact_ratio),
+        record_field("Tip1", &ShiftResult::tip1), record_field("Tip2", &ShiftResult::tip2),
+        record_field("Note", &ShiftResult::note));
+};
+
+// Chooses (x1, x2) for spur pairs. A required center distance fixes the
+// working pressure angle and so x1 + x2 (no backlash); the split between
+// the gears is searched. Candidates are scored a grid at a time in one
+// straight-line loop over contiguous arrays: the larger of the two peak
+// specific slidings plus a penalty for unequal base tooth thickness, with
+// undercut, pointed tips, interference and a short contact ratio as
+// penalties that dominate the cost. The grid then narrows around the best.
+class ProfileShiftOptimizer {
+private:
+    ShiftOptions options;
+
+public:
+    explicit ProfileShiftOptimizer(const ShiftOptions& opts = ShiftOptions()) : options(opts) {}
+
+    ShiftResult optimize(const ShiftPair& pair) const;
+
+    // Pairs across worker threads, results in input order
+    std::vector<ShiftResult> optimize(const std::vector<ShiftPair>& pairs, unsigned threads = 0) const;
+
+    // Smallest x that generates n teeth without undercut (full-depth rack)
+    static double min_shift(int n, double pa);
+};
+
+}  // namespace gearforge
@@ -0,0 +1,65 @@
+#pragma once
+
+#include "utils.h"
+
+namespace gearforge {
+
+// One unit of tracked work. Producers only touch the atomics, so updating
+// from a hot loop (or several threads) costs a relaxed store.
+struct ProgressTask {
+    std::string label;
+    std::atomic<uint64_t> done{0};
+    std::atomic<uint64_t> total{0};
+    std::atomic<bool> finished{false};
+};
+
+class ProgressReporter {
+private:
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::vector<std::shared_ptr<ProgressTask>> tasks;
+    std::thread renderer;
+    uint64_t generation = 0;
+    bool enabled;
+    size_t lines_drawn = 0;
+    std::chrono::milliseconds interval{100};  // 10 Hz
+
+    ProgressReporter();
+    void render_loop(uint64_t gen);
+    void render_frame();  // Caller holds mutex
+    void stop_renderer(std::unique_lock<std::mutex>& lock);
+
+public:
+    ~ProgressReporter();
+    ProgressReporter(const ProgressReporter&) = delete;
+    ProgressReporter& operator=(const ProgressReporter&) = delete;
+
+    static ProgressReporter& instance();
+
+    // Register a task; total is in caller-defined units (bytes for loaders)
+    std::shared_ptr<ProgressTask> begin(const std::string& label, uint64_t total);
+    void end(const std::shared_ptr<ProgressTask>& task);
+
+    // Disabled automatically when stdout is not a TTY
+    bool is_enabled() const { return enabled; }
+    void set_enabled(bool on);
+    void set_refresh_interval(std::chrono::milliseconds ms);
+};
+
+// RAII handle used by loaders: begin on construction, end on destruction
+class ScopedProgress {
+private:
+    std::shared_ptr<ProgressTask> task;
+
+public:
+    ScopedProgress(const std::string& label, uint64_t total);
+    ~ScopedProgress();
+    ScopedProgress(const ScopedProgress&) = delete;
+    ScopedProgress& operator=(const ScopedProgress&) = delete;
+
+    void set(uint64_t done) { task->done.store(done, std::memory_order_relaxed); }
+    void add(uint64_t delta) { task->done.fetch_add(delta, std::memory_order_relaxed); }
+    const ProgressTask& state() const { return *task; }
+};
+
+}  // namespace gearforge
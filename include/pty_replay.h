@@ -0,0 +1,82 @@
+#pragma once
+
+#include <sys/types.h>
+
+#include "utils.h"
+
+namespace gearforge {
+
+// One scripted action from a trace file:
+//   key <k>         one keystroke: a character, or up/down/left/right/enter/tab/backspace/esc
+//   type <text>     each character as its own keystroke
+//   expect <text>   wait (up to the timeout) until the screen output contains text
+//   wait <ms>       sleep, draining output
+// Blank lines and lines starting with '#' are ignored.
+struct ReplayStep {
+    enum Kind { Key, Expect, Wait } kind = Key;
+    std::string bytes;   // Key: what to write; Expect: text to find
+    int wait_ms = 0;
+    int line = 0;        // Trace line, for error messages
+};
+
+std::vector<ReplayStep> parse_trace(std::istream& in);  // Throws std::runtime_error on bad lines
+
+struct FrameSample {
+    std::string key;          // Printable form of the keystroke
+    double first_byte_ms;     // Keystroke to first output byte (NAN if none)
+    double settle_ms;         // Keystroke to last byte before the output went quiet
+    size_t bytes;             // Bytes written for this frame
+};
+
+struct LatencySummary {
+    size_t frames = 0;
+    double p50 = 0.0, p90 = 0.0, p99 = 0.0, max = 0.0;
+};
+
+struct ReplayReport {
+    std::vector<FrameSample> frames;
+    LatencySummary first_byte;
+    LatencySummary settle;
+    double mean_bytes = 0.0;
+    size_t max_bytes = 0;
+    bool ok = true;           // False if an expect timed out or the program exited early
+    std::string error;
+};
+
+struct ReplayOptions {
+    std::vector<std::string> argv;    // Program and arguments
+    std::string workdir;              // Empty: current directory
+    int settle_ms = 30;               // Output quiet this long = frame done
+    int frame_timeout_ms = 2000;      // A key with no output by then has no frame
+    int expect_timeout_ms = 10000;
+    unsigned short rows = 40, cols = 120;
+};
+
+// Runs a program on a pseudo-terminal (so raw mode, echo and escape
+// sequences behave as on a real terminal), replays keystrokes and times
+// each frame from the write of the key to the output settling.
+class PtyReplay {
+private:
+    ReplayOptions options;
+    int master = -1;
+    pid_t child = -1;
+    std::string screen;   // Output since the last expect matched
+
+    bool exited = false;
+
+    long read_chunk(int timeout_ms);   // Appends to screen; 0 on timeout, -1 once the program is gone
+    bool start(ReplayReport& report);
+    void stop();
+
+public:
+    explicit PtyReplay(const ReplayOptions& opts) : options(opts) {}
+    ~PtyReplay() { stop(); }
+    PtyReplay(const PtyReplay&) = delete;
+    PtyReplay& operator=(const PtyReplay&) = delete;
+
+    ReplayReport run(const std::vector<ReplayStep>& steps);
+
+    static LatencySummary summarize(std::vector<double> samples);
+};
+
+}  // namespace gearforge
@@ -0,0 +1,237 @@
+#pragma once
+
+#include "fixed_point.h"
+#include "mem_stats.h"
+#include "number_format.h"
+#include "progress.h"
+#include "utils.h"
+
+namespace gearforge {
+
+// One CSV column: its header name and the member it binds to. An optional
+// column may be missing from a file; its member is then value-initialized.
+template <typename Record, typename Value>
+struct FieldDescriptor {
+    const char* name;
+    Value Record::*member;
+    bool optional;
+};
+
+template <typename Record, typename Value>
+constexpr FieldDescriptor<Record, Value> record_field(const char* name, Value Record::*member) {
+    return {name, member, false};
+}
+
+// Optional columns go last, so headerless files written before they existed still load
+template <typename Record, typename Value>
+constexpr FieldDescriptor<Record, Value> optional_record_field(const char* name, Value Record::*member) {
+    return {name, member, true};
+}
+
+// Specialized next to each record type:
+//   static constexpr const char* name = "...";
+//   static constexpr auto fields = std::make_tuple(record_field("Col", &Record::member), ...);
+// The tuple order is the column order written to files.
+template <typename Record>
+struct RecordSchema;
+
+// Cell conversions; records with their own member types (enums) add
+// overloads in their namespace. parse_field gets the trimmed cell and
+// returns false unless all of it is a valid value.
+bool parse_field(const char* begin, const char* end, int& out);
+bool parse_field(const char* begin, const char* end, double& out);
+bool parse_field(const char* begin, const char* end, float& out);
+bool parse_field(const char* begin, const char* end, Fixed& out);
+bool parse_field(const char* begin, const char* end, std::string& out);
+
+inline void write_field(FormatBuffer& out, int v) { out.append(v); }
+inline void write_field(FormatBuffer& out, double v) { out.append(v); }
+inline void write_field(FormatBuffer& out, float v) { out.append(v); }  // Shortest for float, so 0.1f reads "0.1"
+inline void write_field(FormatBuffer& out, Fixed v) { out.append(v.to_double()); }
+inline void write_field(FormatBuffer& out, const std::string& v) { out.append(v); }  // No quoting, like utils::read_csv
+
+// Calls fn(descriptor, index) for every field, in schema order; expands at compile time
+template <typename Record, typename Fn, size_t... I>
+void for_each_field(Fn&& fn, std::index_sequence<I...>) {
+    (fn(std::get<I>(RecordSchema<Record>::fields), I), ...);
+}
+
+template <typename Record, typename Fn>
+void for_each_field(Fn&& fn) {
+    constexpr size_t count = std::tuple_size_v<std::decay_t<decltype(RecordSchema<Record>::fields)>>;
+    for_each_field<Record>(std::forward<Fn>(fn), std::make_index_sequence<count>());
+}
+
+// Parses and writes one CSV line per record straight between the text and
+// the typed members. Columns are located by header name, so files with
+// reordered or extra columns load; without a header, schema order is used.
+template <typename Record>
+class RecordCodec {
+public:
+    static constexpr size_t kFields = std::tuple_size_v<std::decay_t<decltype(RecordSchema<Record>::fields)>>;
+    static constexpr size_t kRequiredFields = std::apply(
+        [](const auto&... f) { return (size_t(0) + ... + (f.optional ? 0 : 1)); }, RecordSchema<Record>::fields);
+
+private:
+    std::vector<int> slots;  // Per file column: schema field index, or -1 for extra columns
+
+    static std::pair<const char*, const char*> trim(const char* begin, const char* end) {
+        while (begin < end && (*begin == ' ' || *begin == '\t')) ++begin;
+        while (end > begin && (end[-1] == ' ' || end[-1] == '\t')) --end;
+        return {begin, end};
+    }
+
+    static bool same_name(std::pair<const char*, const char*> cell, const char* name) {
+        size_t len = std::strlen(name);
+        if (static_cast<size_t>(cell.second - cell.first) != len) return false;
+        for (size_t i = 0; i < len; ++i) {
+            if (std::tolower(static_cast<unsigned char>(cell.first[i])) != std::tolower(static_cast<unsigned char>(name[i]))) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+public:
+    RecordCodec() : slots(kFields) { std::iota(slots.begin(), slots.end(), 0); }
+
+    // Maps the header's columns to fields (names match case-insensitively);
+    // throws if a required field has no column, or any field has two
+    explicit RecordCodec(std::string_view header) {
+        const char* c = header.data();
+        const char* last = c + header.size();
+        while (true) {
+            const char* stop = std::find(c, last, ',');
+            auto cell = trim(c, stop);
+            int slot = -1;
+            for_each_field<Record>([&](const auto& f, size_t i) {
+                if (slot < 0 && same_name(cell, f.name)) slot = static_cast<int>(i);
+            });
+            if (slot >= 0 && std::find(slots.begin(), slots.end(), slot) != slots.end()) {
+                throw std::runtime_error(std::string("Duplicate ") + RecordSchema<Record>::name + " column: " +
+                                         std::string(cell.first, cell.second));
+            }
+            slots.push_back(slot);
+            if (stop == last) break;
+            c = stop + 1;
+        }
+        for_each_field<Record>([&](const auto& f, size_t i) {
+            if (!f.optional && std::find(slots.begin(), slots.end(), static_cast<int>(i)) == slots.end()) {
+                throw std::runtime_error(std::string("Missing ") + RecordSchema<Record>::name + " column: " + f.name);
+            }
+        });
+    }
+
+    // One line, without its newline; false if a required column is missing
+    // or a cell is invalid. Missing optional columns are value-initialized.
+    bool parse(const char* begin, const char* end, Record& out) const {
+        std::array<std::pair<const char*, const char*>, kFields> cells{};
+        const char* c = begin;
+        for (size_t column = 0; column < slots.size(); ++column) {
+            const char* stop = std::find(c, end, ',');
+            if (slots[column] >= 0) cells[slots[column]] = trim(c, stop);
+            if (stop == end) break;
+            c = stop + 1;
+        }
+        bool ok = true;
+        for_each_field<Record>([&](const auto& f, size_t i) {
+            if (!ok) return;
+            if (!cells[i].first) {
+                ok = f.optional;
+                out.*(f.member) = {};
+            } else {
+                ok = parse_field(cells[i].first, cells[i].second, out.*(f.member));
+            }
+        });
+        return ok;
+    }
+
+    static void write_header(FormatBuffer& out) {
+        for_each_field<Record>([&](const auto& f, size_t i) {
+            if (i > 0) out.append(',');
+            out.append(std::string(f.name));
+        });
+        out.append('\n');
+    }
+
+    // Cells in schema order and a newline
+    static void write(FormatBuffer& out, const Record& r) {
+        for_each_field<Record>([&](const auto& f, size_t i) {
+            if (i > 0) out.append(',');
+            write_field(out, r.*(f.member));
+        });
+        out.append('\n');
+    }
+};
+
+// A whole file in one buffer, handed out a line at a time
+class CsvLines {
+private:
+    std::string text;        // Owned bytes, when opened from a file
+    std::string_view bytes;  // What next() walks
+    size_t pos = 0;
+    size_t line_number = 0;
+
+public:
+    bool open(const std::string& filename);  // false if it can't be read
+
+    // Walks contents in place (no copy); they must outlive the lines
+    void assign(std::string_view contents);
+
+    // Next non-blank line, without its line ending
+    bool next(const char*& begin, const char*& end);
+
+    size_t line() const { return line_number; }  // 1-based, of the last line returned
+    size_t offset() const { return pos; }
+    size_t size() const { return bytes.size(); }
+};
+
+// Header line, then one record per line. A missing file reads as empty;
+// a bad header or row throws, naming filename.
+template <typename Record>
+std::vector<Record> read_records(CsvLines& lines, const std::string& filename) {
+    MemTagScope tag(MemTag::Csv);
+    std::vector<Record> records;
+    ScopedProgress progress("Loading " + std::filesystem::path(filename).filename().string(), lines.size());
+    const char* begin;
+    const char* end;
+    if (!lines.next(begin, end)) return records;
+    RecordCodec<Record> codec(std::string_view(begin, end - begin));
+    Record r{};
+    while (lines.next(begin, end)) {
+        if (!codec.parse(begin, end, r)) {
+            throw std::runtime_error("Invalid " + std::string(RecordSchema<Record>::name) + " row at " + filename + ":" +
+                                     std::to_string(lines.line()));
+        }
+        records.push_back(r);
+        progress.set(lines.offset());
+    }
+    return records;
+}
+
+template <typename Record>
+std::vector<Record> read_records(const std::string& filename) {
+    CsvLines lines;
+    if (!lines.open(filename)) return {};
+    return read_records<Record>(lines, filename);
+}
+
+template <typename Record>
+bool write_records(const std::string& filename, const std::vector<Record>& records) {
+    MemTagScope tag(MemTag::Csv);
+    CsvWriter out(filename);
+    if (!out.is_open()) return false;
+    FormatBuffer rows;
+    RecordCodec<Record>::write_header(rows);
+    for (const auto& r : records) {
+        RecordCodec<Record>::write(rows, r);
+        if (rows.size() >= (1 << 20)) {
+            out.write(rows);
+            rows.clear();
+        }
+    }
+    out.write(rows);
+    return out.close();
+}
+
+}  // namespace gearforge
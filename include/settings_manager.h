@@ -1,22 +1,42 @@
 #pragma once
 
+#include "shared_state.h"
 #include "utils.h"
 
 namespace gearforge {
 
+// Settings file shared by every session. Lookups read the shared copy,
+// re-parsing it only when its version moves, so a save in one session is
+// seen by the others on their next lookup. Changes stay pending in this
+// session until save(), which merges only the keys it changed into the
+// file as it is at that moment, so two sessions saving different keys keep
+// both.
 class SettingsManager {
+public:
+    using Map = std::unordered_map<std::string, std::string>;
+
 private:
-    std::mutex mutex;
-    std::string filename = "data/settings.ini";
+    mutable std::mutex mutex;
+    SharedFile file;
+    mutable uint64_t parsed_version = ~uint64_t{0};
+    mutable Map parsed;                      // The shared copy at parsed_version
+    Map pending;                             // Unsaved values
+    std::unordered_set<std::string> erased;  // Unsaved removals
 
-    std::unordered_map<std::string, std::string> read_ini(const std::string& filename);
-    void load();
+    static Map parse_ini(std::string_view text);
+    const Map& current() const;  // Caller holds mutex
 
 public:
-    SettingsManager();
-    std::unordered_map<std::string, std::string> data;
+    explicit SettingsManager(const std::string& filename = "data/settings.ini");
+
+    std::string get(const std::string& key, const std::string& fallback = "") const;
+    bool has(const std::string& key) const;
+    std::map<std::string, std::string> all();  // Sorted, with unsaved changes; picks up hand edits
+
+    void set(const std::string& key, const std::string& value);
+    void erase(const std::string& key);
     void save();
-    void add_setting(std::string& line);
+    void add_setting(std::string& line);  // "key : value", or a bare key
 };
 
 }  // namespace gearforge
@@ -0,0 +1,186 @@
+#pragma once
+
+#include "utils.h"
+
+namespace gearforge {
+
+// Exclusive flock() on "<path>.lock", held for the object's lifetime. The
+// lock lives on a side file because replace_file() swaps the data file's
+// inode. Blocks until granted; the kernel drops it if the process dies.
+class FileLock {
+private:
+    int fd = -1;
+
+public:
+    explicit FileLock(const std::string& path);
+    ~FileLock();
+    FileLock(const FileLock&) = delete;
+    FileLock& operator=(const FileLock&) = delete;
+
+    bool locked() const { return fd >= 0; }  // false if the lock file can't be created
+};
+
+// Writes contents to a temporary file beside path, syncs it and renames it
+// over path, so readers see the old file or the new one, never a mix
+bool replace_file(const std::string& path, const std::string& contents);
+
+// One file's contents shared by every process that opens it. The bytes sit
+// in a POSIX shared-memory segment named after the file's absolute path, so
+// N sessions hold one copy. Readers take seqlock snapshots: no file locks
+// and no system calls, retried only if a write lands mid-copy. Writers
+// serialize on a FileLock, re-read the file, edit, replace_file() and
+// publish, so concurrent edits from different processes all survive.
+class SharedFile {
+public:
+    struct Header;
+
+private:
+    std::string path;
+    std::string name;             // Segment name
+    int fd = -1;
+    mutable Header* header = nullptr;  // Start of the current mapping
+    mutable size_t mapped = 0;
+    mutable std::mutex map_mutex;      // Guards the mapping (and local)
+    mutable std::vector<std::pair<void*, size_t>> retired;  // Old mappings; readers may still be inside them
+    std::string local;                 // Stand-in when shared memory is unavailable
+    uint64_t local_version = 0;
+
+    // Which version of the file was last published
+    struct Stamp {
+        uint64_t inode = 0, size = 0;
+        int64_t mtime = -2;  // ns; -1: no file, -2: never published
+    };
+    Stamp local_stamp;
+
+    void ensure_mapped(size_t bytes) const;     // Caller holds map_mutex
+    void publish(const std::string& contents);  // Caller holds the FileLock
+    Stamp recorded() const;
+    bool file_changed() const;                  // Against the stamp recorded at the last publish
+    std::string read_locked() const;            // The file itself, under the FileLock
+
+public:
+    // Attaches to (or creates) the segment and loads the file if the segment
+    // is new or older than the file. capacity is the initial data size; the
+    // segment grows when a write needs more.
+    explicit SharedFile(const std::string& path, size_t capacity = size_t(64) << 10);
+    ~SharedFile();
+    SharedFile(const SharedFile&) = delete;
+    SharedFile& operator=(const SharedFile&) = delete;
+
+    const std::string& filename() const { return path; }
+    bool is_shared() const { return header != nullptr; }
+    uint64_t version() const;  // Bumped by every publish, from any process
+
+    // Consistent copy of the contents
+    std::string read() const;
+
+    // fn(std::string_view) over the shared bytes without copying them; run
+    // again if a write overlapped, so fn must tolerate torn input (throwing
+    // is fine) and only the last call's result is returned
+    template <typename Fn>
+    auto view(Fn&& fn) const -> decltype(fn(std::string_view()));
+
+    // Under the lock: contents = the file as it is now; edit(contents)
+    // returns false to leave it alone. Returns edit's result; throws if the
+    // lock can't be taken or the file can't be replaced.
+    bool update(const std::function<bool(std::string& contents)>& edit);
+
+    // Republishes if the file was changed outside of update() (hand edits)
+    bool refresh();
+
+    // Drops the segment name; attached processes keep their mapping
+    static void remove(const std::string& path);
+};
+
+// Segment layout: this header, then the data. Everything but the bytes is
+// atomic, so a reader's racing loads are well defined; the seqlock tells it
+// whether the bytes it copied were stable.
+struct SharedFile::Header {
+    char magic[8];
+    std::atomic<uint64_t> sequence;   // Odd while a publish is in progress
+    std::atomic<uint64_t> size;       // Of the data
+    std::atomic<uint64_t> capacity;   // Data bytes the segment holds
+    std::atomic<uint64_t> file_inode;
+    std::atomic<uint64_t> file_size;
+    std::atomic<int64_t> file_mtime;  // As in Stamp
+
+    char* data() { return reinterpret_cast<char*>(this + 1); }
+};
+
+// A named shared-memory block that is written once, at creation, and only
+// read after that, so holders may keep pointers into it. Every process that
+// opens the name maps the same pages.
+class SharedBlock {
+public:
+    struct Header;
+
+private:
+    std::string shm_name;
+    int fd = -1;  // Holds the liveness lock
+    Header* header = nullptr;
+    size_t mapped = 0;
+
+    SharedBlock(std::string name, int fd, Header* header, size_t mapped);
+
+public:
+    ~SharedBlock();
+    SharedBlock(const SharedBlock&) = delete;
+    SharedBlock& operator=(const SharedBlock&) = delete;
+
+    // The block called name, once its creator has filled it; null if there
+    // is none (or its creator died mid-fill, which also removes it)
+    static std::shared_ptr<const SharedBlock> attach(const std::string& name);
+
+    // Creates name with `size` data bytes and fill()s them before anyone can
+    // attach. If another process created it first, attaches to theirs. Null
+    // when shared memory is unavailable.
+    static std::shared_ptr<const SharedBlock> create(const std::string& name, size_t size,
+                                                     const std::function<void(char* data)>& fill);
+
+    const std::string& name() const { return shm_name; }
+    const char* data() const;
+    size_t size() const;
+};
+
+// Every process holds a shared flock on each segment it uses, and the last
+// one out removes the segment. This removes the ones no process holds any
+// more (left by sessions that were killed or crashed) and returns how many;
+// it runs once per process, at the first segment opened.
+size_t remove_stale_segments();
+
+template <typename Fn>
+auto SharedFile::view(Fn&& fn) const -> decltype(fn(std::string_view())) {
+    if (!header) {
+        std::unique_lock<std::mutex> lock(map_mutex);
+        std::string copy = local;
+        lock.unlock();
+        return fn(std::string_view(copy));
+    }
+    for (int attempt = 0;; ++attempt) {
+        Header* h;
+        uint64_t seq, size;
+        {
+            std::lock_guard<std::mutex> lock(map_mutex);
+            seq = header->sequence.load(std::memory_order_acquire);
+            size = header->size.load(std::memory_order_relaxed);
+            if (size + sizeof(Header) > mapped) ensure_mapped(size + sizeof(Header));
+            h = header;
+        }
+        if (seq & 1) {
+            if (attempt > 1000) return fn(std::string_view(read_locked()));  // A writer may have died mid-publish
+            std::this_thread::yield();
+            continue;
+        }
+        std::string_view bytes(h->data(), size);
+        try {
+            auto result = fn(bytes);
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (h->sequence.load(std::memory_order_relaxed) == seq) return result;
+        } catch (...) {
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (h->sequence.load(std::memory_order_relaxed) == seq) throw;
+        }
+    }
+}
+
+}  // namespace gearforge
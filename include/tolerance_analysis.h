@@ -0,0 +1,61 @@
+#pragma once
+
+#include "gear_calculator.h"
+#include "utils.h"
+
+namespace gearforge {
+
+enum class Distribution { Normal, Uniform };
+
+struct ToleranceSpec {
+    double mean = 0.0;    // Systematic offset
+    double spread = 0.0;  // Normal: standard deviation; Uniform: half-width
+    Distribution kind = Distribution::Normal;
+};
+
+// Manufacturing variation per gear (pitch, PA, runout, thickness) and per pair (center distance).
+// Lengths are in the same units as PD.
+struct ToleranceInputs {
+    ToleranceSpec pitch_error{0.0, 0.0005, Distribution::Normal};     // Relative DP/module error
+    ToleranceSpec pressure_angle{0.0, 0.25, Distribution::Normal};    // Degrees
+    ToleranceSpec runout{0.001, 0.001, Distribution::Uniform};        // Total indicated runout
+    ToleranceSpec center_distance{0.0, 0.001, Distribution::Uniform};
+    ToleranceSpec tooth_thickness{0.0, 0.0005, Distribution::Normal}; // Circular thickness error
+};
+
+struct DistributionSummary {
+    double mean = 0.0;
+    double stddev = 0.0;
+    double min = 0.0;
+    double max = 0.0;
+    double p01 = 0.0, p05 = 0.0, p50 = 0.0, p95 = 0.0, p99 = 0.0;
+};
+
+struct ToleranceReport {
+    uint64_t trials = 0;
+    double nominal_backlash = 0.0;
+    double nominal_contact_ratio = 0.0;
+    DistributionSummary backlash;        // At the tight spot of the runout
+    DistributionSummary contact_ratio;
+    double binding_probability = 0.0;    // Fraction of trials with zero or negative backlash
+};
+
+// Monte Carlo stack-up of backlash and contact ratio for a gear pair.
+// Trial i always draws the same numbers (counter-based RNG keyed by seed),
+// and trials are reduced in fixed-size blocks in block order, so a report
+// is bit-identical for any thread count.
+class ToleranceAnalyzer {
+private:
+    uint64_t seed;
+
+public:
+    explicit ToleranceAnalyzer(uint64_t seed = 0x9e3779b97f4a7c15ULL) : seed(seed) {}
+
+    ToleranceReport analyze(const GearParams& pinion, const GearParams& gear, const ToleranceInputs& tol,
+                            uint64_t trials, unsigned threads = 0) const;
+
+    // Uniform [0, 1) for (trial, dimension); exposed for tests
+    double uniform(uint64_t trial, uint32_t dim) const;
+};
+
+}  // namespace gearforge
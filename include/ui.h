@@ -1,9 +1,14 @@
 #pragma once
 
+#include "catalog_search.h"
 #include "gear_calculator.h"
+#include "gear_generation.h"
+#include "gear_preview.h"
+#include "list_view.h"
 #include "user_manager.h"
 #include "settings_manager.h"
 #include "utils.h"
+#include "watched_catalog.h"
 
 namespace gearforge {
 
@@ -12,15 +17,30 @@ private:
     UserManager& user_manager;
     SettingsManager& settings_manager;
     GearCalculator gear_calc;
+    GearParams last_gear{};  // Last one calculated or looked up, for the preview
+    bool has_gear = false;
     bool running = true;
 
+    // data/known_values.csv, loaded on the first search and followed for the
+    // rest of the session; the watcher's listener updates known_index under
+    // known_mutex. known is declared last so its watcher stops first.
+    std::mutex known_mutex;
+    std::unique_ptr<CatalogIndex> known_index;
+    std::unique_ptr<WatchedCatalog> known;
+
     void draw_box(const std::string& title, const std::vector<std::string>& lines);
     void show_main_screen();
     bool show_login_register();
     void show_main_menu();
+    bool open_known_catalog();
+    void show_catalog_search();
+    int browse_gears(const std::vector<const GearParams*>& gears);
     void show_settings();
     GearParams input_gear_params();
     void display_results(const GearParams& params);
+    // v as results show it: shortest round-trip text, or the decimals set for field
+    std::string format_value(const std::string& field, double v);
+    void show_preview();
     void handle_error(const std::string& msg);
     int select_menu(const std::vector<std::string>& options);
 
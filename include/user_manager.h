@@ -1,5 +1,7 @@
 #pragma once
 
+#include "record_codec.h"
+#include "shared_state.h"
 #include "utils.h"
 
 namespace gearforge {
@@ -15,18 +17,28 @@ struct User {
     static User from_csv_row(const std::vector<std::string>& row);
 };
 
+// Written as "Admin" or "User"; anything but "Admin" reads as User
+bool parse_field(const char* begin, const char* end, UserRole& out);
+void write_field(FormatBuffer& out, UserRole role);
+
+template <>
+struct RecordSchema<User> {
+    static constexpr const char* name = "User";
+    static constexpr auto fields = std::make_tuple(
+        record_field("Username", &User::username), record_field("PasswordHash", &User::password_hash),
+        record_field("Role", &User::role));
+};
+
+// Accounts live in the users file, shared by every session on the machine:
+// logins read it in place from shared memory, registrations append under
+// the file lock, so two sessions registering at once both land.
 class UserManager {
 private:
-    std::vector<User> users;
-    std::mutex mutex;
-    std::string filename = "data/users.csv";
+    SharedFile file;
     User current_user;
 
-    void load_users();
-    void save_users();
-
 public:
-    UserManager();
+    explicit UserManager(const std::string& filename = "data/users.csv");
     bool register_user(const std::string& username, const std::string& password, UserRole role = UserRole::User);
     bool login(const std::string& username, const std::string& password);
     const User& get_current_user() const;
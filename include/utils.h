@@ -4,8 +4,13 @@
 #include <array>
 #include <atomic>
 #include <cctype>
+#include <cerrno>
+#include <charconv>
 #include <chrono>
 #include <cmath>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
 #include <cstdio>
 #include <cstdlib>
 #include <cstring>
@@ -13,6 +18,7 @@
 #include <exception>
 #include <filesystem>
 #include <fstream>
+#include <functional>
 #include <iomanip>
 #include <iostream>
 #include <limits>
@@ -20,15 +26,19 @@
 #include <map>
 #include <memory>
 #include <mutex>
+#include <new>
 #include <numeric>
+#include <queue>
 #include <random>
 #include <regex>
 #include <set>
 #include <sstream>
 #include <stdexcept>
 #include <string>
+#include <string_view>
 #include <thread>
 #include <tuple>
+#include <type_traits>
 #include <unordered_map>
 #include <unordered_set>
 #include <utility>
@@ -66,9 +76,6 @@ struct Sha256Hash {
 };
 Sha256Hash sha256(const std::string& input);  // Returns hash state; use to_string on digest
 
-// Progress bar
-void show_progress(int progress, int total, const std::string& label);
-
 // File utils
 bool file_exists(const std::filesystem::path& p);
 std::vector<std::vector<std::string>> read_csv(const std::string& filename);
@@ -81,12 +88,17 @@ std::string to_lower(const std::string& str);
 // Input utils
 char get_key();  // For WASD/arrow handling (uses system("stty raw"))
 
+// Threading utils
+// Runs body(begin, end) over [0, count) in chunks on up to `threads` workers (0 = all cores)
+void parallel_for(size_t count, const std::function<void(size_t, size_t)>& body, unsigned threads = 0);
+
 // Time utils
 std::string current_date();
 
 // Other reusables...
 double safe_stod(const std::string& str);
 double safe_stod_or(const std::string& str, const double default_value);
+int safe_stoi_or(const std::string& str, const int default_value);  // Whole (trimmed) string as an int
 double input_double_or(const std::string& str, const double default_value);
 
 }  // namespace utils
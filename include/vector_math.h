@@ -0,0 +1,118 @@
+#pragma once
+
+#include "utils.h"
+
+namespace gearforge {
+
+// Elementary functions for loops that should vectorize. libm calls are
+// opaque to the vectorizer, so these evaluate Cephes' rational
+// approximations inline and pick between ranges with selects; nothing
+// branches. Accurate to a few ulp over the ranges noted; infinities and
+// signed zeros are not handled the way libm handles them.
+//
+// The selects only become blends when the compiler may evaluate both arms,
+// and sqrt only vectorizes when it needn't set errno: files that include
+// this are built with -fno-trapping-math -fno-math-errno (see the build
+// files). Neither flag changes a computed value.
+
+// atan2(y, x) for finite arguments; 0 for (0, 0)
+inline double vec_atan2(double y, double x) {
+    const double ax = std::fabs(x), ay = std::fabs(y);
+    const double hi = std::max(ax, ay), lo = std::min(ax, ay);
+    const double a = hi > 0.0 ? lo / hi : 0.0;  // In [0, 1]
+    // Above 0.66 use atan(a) = pi/4 + atan((a - 1) / (a + 1)), so |t| <= 0.66
+    const bool shifted = a > 0.66;
+    const double t = shifted ? (a - 1.0) / (a + 1.0) : a;
+    const double z = t * t;
+    const double p = (((-8.750608600031904122785e-1 * z - 1.615753718733365076637e1) * z -
+                       7.500855792314704667340e1) * z - 1.228866684490136173410e2) * z -
+                     6.485021904942025371773e1;
+    const double q = ((((z + 2.485846490142306297962e1) * z + 1.650270098316988542046e2) * z +
+                       4.328810604912902668951e2) * z + 4.853903996359136964868e2) * z +
+                     1.945506571482613964425e2;
+    double r = t + t * z * p / q;
+    r = shifted ? r + M_PI_4 : r;
+    r = ay > ax ? M_PI_2 - r : r;  // a was x / y
+    r = x < 0.0 ? M_PI - r : r;
+    return std::copysign(r, y);
+}
+
+// Natural log for positive normal arguments. The exponent and mantissa
+// come from the bits (integer ops vectorize too); the exponent is turned
+// into a double by the 2^52 trick, since SSE2 can't convert int64 lanes
+inline double vec_log(double v) {
+    uint64_t bits;
+    std::memcpy(&bits, &v, sizeof bits);
+    const uint64_t mantissa_bits = (bits & 0x000fffffffffffffULL) | 0x3ff0000000000000ULL;
+    const uint64_t exponent_bits = (bits >> 52) | 0x4330000000000000ULL;
+    double m, e;
+    std::memcpy(&m, &mantissa_bits, sizeof m);  // In [1, 2)
+    std::memcpy(&e, &exponent_bits, sizeof e);
+    e -= 4503599627370496.0 + 1023.0;
+    // Center the mantissa on 1: m in [sqrt(1/2), sqrt(2)]
+    const bool high = m > M_SQRT2;
+    m = high ? 0.5 * m : m;
+    e = high ? e + 1.0 : e;
+    const double x = m - 1.0;
+    const double z = x * x;
+    const double p = ((((1.01875663804580931796e-4 * x + 4.97494994976747001425e-1) * x +
+                        4.70579119878881725854e0) * x + 1.44989225341610930846e1) * x +
+                      1.79368678507819816313e1) * x + 7.70838733755885391666e0;
+    const double q = ((((x + 1.12873587189167450590e1) * x + 4.52279145837532221105e1) * x +
+                       8.29875266912776603211e1) * x + 7.11544750618563894466e1) * x +
+                     2.31251620126765340583e1;
+    // ln 2 split in two so e * ln 2 stays exact in the high part
+    const double y = x * (z * p / q) - e * 2.121944400546905827679e-4 - 0.5 * z;
+    return x + y + e * 0.693359375;
+}
+
+// sin(x) and cos(x) for |x| < 1e5. x = q pi/2 + r with |r| <= pi/4 (pi/2
+// in three parts, so r keeps its bits), Cephes' polynomials for sin r and
+// cos r, then the quadrant q mod 4 picks and signs them
+inline void vec_sincos(double x, double& sin_x, double& cos_x) {
+    const double round = 6755399441055744.0;
+    const double q = (x * M_2_PI + round) - round;
+    const double r = ((x - q * 1.57079625129699707031e0) - q * 7.54978941586159635335e-8) -
+                     q * 5.39030285815811905290e-15;
+    const double z = r * r;
+    const double s = r + r * z * (((((1.58962301576546568060e-10 * z - 2.50507477628578072866e-8) * z +
+                                     2.75573136213857245213e-6) * z - 1.98412698295895385996e-4) * z +
+                                   8.33333333332211858878e-3) * z - 1.66666666666666307295e-1);
+    const double c = 1.0 - 0.5 * z + z * z * (((((-1.13585365213876817300e-11 * z + 2.08757008419747316778e-9) * z -
+                                                 2.75573141792967388112e-7) * z + 2.48015872888517045348e-5) * z -
+                                               1.38888888888730564116e-3) * z + 4.16666666666665929218e-2);
+    const double k = q - 4.0 * ((q * 0.25 + round) - round);  // q mod 4, as -2 to 2
+    const bool odd = k == 1.0 || k == -1.0;
+    const double sin_r = odd ? c : s, cos_r = odd ? s : c;
+    sin_x = (k >= 2.0 || k <= -1.0) ? -sin_r : sin_r;
+    cos_x = (k >= 1.0 || k <= -2.0) ? -cos_r : cos_r;
+}
+
+// e^v for |v| < 708 (finite, normal results). v = n ln 2 + r with
+// |r| <= ln 2 / 2, Cephes' Pade form for e^r, and 2^n built in the
+// exponent bits; rounding to n uses the 1.5 * 2^52 trick instead of
+// floor(), which plain SSE2 has no vector instruction for
+inline double vec_exp(double v) {
+    const double round = 6755399441055744.0;
+    const double n = (v * M_LOG2E + round) - round;
+    const double r = (v - n * 6.93145751953125e-1) - n * 1.42860682030941723212e-6;  // ln 2 in two parts
+    const double rr = r * r;
+    const double p = r * ((1.26177193074810590878e-4 * rr + 3.02994407707441961300e-2) * rr +
+                          9.99999999999999999910e-1);
+    const double q = ((3.00198505138664455042e-6 * rr + 2.52448340349684104192e-3) * rr +
+                      2.27265548208155028766e-1) * rr + 2.00000000000000000009e0;
+    const double er = 1.0 + 2.0 * p / (q - p);
+    const double biased = n + (4503599627370496.0 + 1023.0);  // n + 1023 in the low mantissa bits
+    uint64_t bits;
+    std::memcpy(&bits, &biased, sizeof bits);
+    bits <<= 52;
+    double scale;
+    std::memcpy(&scale, &bits, sizeof scale);
+    return er * scale;
+}
+
+// base^e for positive base, through vec_exp(e * vec_log(base)); the
+// relative error grows with |e ln base|, about 1e-15 for e ln base near 5
+inline double vec_pow(double base, double e) { return vec_exp(e * vec_log(base)); }
+
+}  // namespace gearforge
@@ -0,0 +1,134 @@
+#pragma once
+
+#include "gear_calculator.h"
+#include "shared_state.h"
+#include "utils.h"
+
+namespace gearforge {
+
+// A chunk's rows, wherever they are stored
+class CatalogRows {
+private:
+    const GearParams* first = nullptr;
+    size_t count = 0;
+
+public:
+    CatalogRows() = default;
+    CatalogRows(const GearParams* first, size_t count) : first(first), count(count) {}
+
+    size_t size() const { return count; }
+    bool empty() const { return count == 0; }
+    const GearParams& operator[](size_t i) const { return first[i]; }
+    const GearParams* begin() const { return first; }
+    const GearParams* end() const { return first + count; }
+};
+
+// A run of catalog lines. Chunk boundaries are content-defined (a line
+// whose hash matches a mask ends a chunk), so an edit only changes the
+// chunks around it, wherever later lines move to.
+struct CatalogChunk {
+    uint64_t hash = 0;            // Of the chunk's bytes
+    size_t bytes = 0;
+    CatalogRows rows;             // Into block, or into parsed until it is published
+    std::shared_ptr<const SharedBlock> block;
+    std::vector<GearParams> parsed;
+    int min_teeth = 0, max_teeth = -1;  // Zone map: lookups skip chunks outside it
+
+    CatalogChunk() = default;
+    CatalogChunk(const CatalogChunk&) = delete;  // rows would point into the original
+    CatalogChunk& operator=(const CatalogChunk&) = delete;
+};
+
+// Immutable view of the catalog at one version. Unchanged chunks are
+// shared between versions, so holding an old snapshot is cheap.
+class CatalogSnapshot {
+public:
+    uint64_t version = 0;
+    std::vector<std::shared_ptr<const CatalogChunk>> chunks;
+    std::vector<size_t> first_row;  // Per chunk, plus the total at the end
+    std::shared_ptr<const SharedBlock> table;  // Where other sessions find this version; null if private
+
+    size_t size() const { return first_row.empty() ? 0 : first_row.back(); }
+    const GearParams& operator[](size_t row) const;
+    std::vector<GearParams> rows() const;  // Flattened copy
+
+    // fn(row index, params) for every row with n teeth, in row order
+    template <typename Fn>
+    void for_each_with_teeth(int n, Fn&& fn) const {
+        for (size_t c = 0; c < chunks.size(); ++c) {
+            const CatalogChunk& chunk = *chunks[c];
+            if (n < chunk.min_teeth || n > chunk.max_teeth) continue;
+            for (size_t i = 0; i < chunk.rows.size(); ++i) {
+                if (chunk.rows[i].n == n) fn(first_row[c] + i, chunk.rows[i]);
+            }
+        }
+    }
+};
+
+struct CatalogReload {
+    bool changed = false;
+    uint64_t version = 0;
+    size_t chunks = 0;
+    size_t reparsed_chunks = 0;
+    size_t reparsed_rows = 0;
+    size_t removed_chunks = 0;
+    double milliseconds = 0.0;
+    double scan_milliseconds = 0.0;  // Part spent reading and hashing the file; the rest is the patch
+    bool attached = false;        // Another session had this version in shared memory; nothing was parsed
+    std::vector<size_t> added;    // Indexes into the new snapshot's chunks the old one lacked
+};
+
+// Known-gear catalog that follows its file. reload() maps the file, splits
+// it into content-defined chunks while hashing it, and re-parses only the
+// chunks whose (hash, size) the previous version lacks. The watcher thread
+// calls reload() when inotify reports the file written or replaced.
+//
+// Rows live in shared memory, so sessions with the same catalog hold one
+// copy: the first to load a version parses what's new and publishes it,
+// the rest attach without parsing.
+class WatchedCatalog {
+public:
+    using Listener = std::function<void(const CatalogSnapshot& before, const CatalogSnapshot& after,
+                                        const CatalogReload& reload)>;
+
+private:
+    std::string filename;
+    mutable std::mutex mutex;      // Guards current, listeners and error
+    std::mutex reload_mutex;       // One reload at a time
+    std::shared_ptr<const CatalogSnapshot> current;
+    uint64_t header_hash = 0;      // Reload thread only
+    std::vector<Listener> listeners;
+    std::string error;
+    std::thread watcher;
+    int stop_pipe[2] = {-1, -1};
+    std::chrono::milliseconds settle{20};
+
+    void watch_loop(int inotify_fd);
+
+public:
+    // Loads the file once (empty if it does not exist); throws on a bad header or row
+    explicit WatchedCatalog(const std::string& filename);
+    ~WatchedCatalog();
+    WatchedCatalog(const WatchedCatalog&) = delete;
+    WatchedCatalog& operator=(const WatchedCatalog&) = delete;
+
+    // Current version; stays valid (and unchanged) for as long as it is held
+    std::shared_ptr<const CatalogSnapshot> snapshot() const;
+
+    // Re-reads the file now. Throws on a bad header or row and keeps the
+    // current snapshot; a missing file (mid-replace) is not a change.
+    CatalogReload reload();
+
+    // Called after each change, on the reloading thread, with both versions
+    void on_update(Listener listener);
+
+    // Watch for changes in the background; false if inotify is unavailable
+    bool start();
+    void stop();
+    bool is_watching() const { return watcher.joinable(); }
+
+    // Last error from a background reload ("" when it succeeded)
+    std::string last_error() const;
+};
+
+}  // namespace gearforge
@@ -0,0 +1,392 @@
+#include <unistd.h>
+
+#include <csignal>
+
+#include "async_log.h"
+
+namespace gearforge {
+
+namespace {
+
+// The calling thread's ring. generation ties it to one start() of the
+// sink; a ring left over from an earlier run is retired and replaced.
+struct ThreadRing {
+    std::shared_ptr<LogRing> ring;
+    uint64_t generation = 0;
+
+    ~ThreadRing() {
+        if (ring) ring->retired.store(true, std::memory_order_release);
+    }
+};
+
+thread_local ThreadRing tls_ring;
+
+const int kCrashSignals[] = {SIGSEGV, SIGBUS, SIGFPE, SIGILL, SIGABRT};
+
+void append_line(std::string& out, char level, int64_t time_us, const char* file, int line, const char* msg, size_t len) {
+    time_t seconds = static_cast<time_t>(time_us / 1000000);
+    struct tm tm_time;
+    localtime_r(&seconds, &tm_time);
+    char prefix[96];
+    int n = std::snprintf(prefix, sizeof(prefix), "%c%02d%02d %02d:%02d:%02d.%06d %s:%d] ", level,
+                          tm_time.tm_mon + 1, tm_time.tm_mday, tm_time.tm_hour, tm_time.tm_min, tm_time.tm_sec,
+                          static_cast<int>(time_us % 1000000), file, line);
+    out.append(prefix, static_cast<size_t>(std::max(0, std::min(n, static_cast<int>(sizeof(prefix)) - 1))));
+    out.append(msg, len);
+    out += '\n';
+}
+
+// Crash-time output: fixed storage and hand-rolled formatting, because
+// snprintf, localtime and malloc are not async-signal-safe
+char crash_bytes[1 << 16];
+
+class CrashWriter {
+private:
+    int fd;
+    size_t used = 0;
+
+public:
+    explicit CrashWriter(int f) : fd(f) {}
+
+    void flush() {
+        size_t done = 0;
+        while (done < used) {
+            ssize_t w = ::write(fd, crash_bytes + done, used - done);
+            if (w < 0 && errno == EINTR) continue;
+            if (w <= 0) break;
+            done += static_cast<size_t>(w);
+        }
+        used = 0;
+    }
+
+    void put(const char* p, size_t n) {
+        while (n > 0) {
+            if (used == sizeof(crash_bytes)) flush();
+            size_t take = std::min(n, sizeof(crash_bytes) - used);
+            std::memcpy(crash_bytes + used, p, take);
+            used += take;
+            p += take;
+            n -= take;
+        }
+    }
+
+    void put(char c) { put(&c, 1); }
+
+    void put(const char* s) { put(s, std::strlen(s)); }
+
+    // Zero-padded to width
+    void number(uint64_t v, int width) {
+        char digits[20];
+        int n = 0;
+        do {
+            digits[n++] = static_cast<char>('0' + v % 10);
+            v /= 10;
+        } while (v > 0);
+        for (int i = n; i < width; ++i) put('0');
+        while (n > 0) put(digits[--n]);
+    }
+
+    // Same layout as append_line
+    void line(char level, int64_t local_us, const char* file, int line_no, const char* msg, size_t len) {
+        int64_t secs = local_us / 1000000 - (local_us % 1000000 < 0 ? 1 : 0);
+        int64_t days = secs / 86400 - (secs % 86400 < 0 ? 1 : 0);
+        int64_t of_day = secs - days * 86400;
+        // Month and day from days since 1970-01-01 (civil_from_days)
+        int64_t z = days + 719468;
+        int64_t era = (z >= 0 ? z : z - 146096) / 146097;
+        int64_t doe = z - era * 146097;
+        int64_t yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+        int64_t doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+        int64_t mp = (5 * doy + 2) / 153;
+        int64_t day = doy - (153 * mp + 2) / 5 + 1;
+        int64_t month = mp < 10 ? mp + 3 : mp - 9;
+        put(level);
+        number(month, 2);
+        number(day, 2);
+        put(' ');
+        number(of_day / 3600, 2);
+        put(':');
+        number(of_day / 60 % 60, 2);
+        put(':');
+        number(of_day % 60, 2);
+        put('.');
+        number(static_cast<uint64_t>(local_us - secs * 1000000), 6);
+        put(' ');
+        put(file);
+        put(':');
+        if (line_no < 0) put('-');
+        number(static_cast<uint64_t>(line_no < 0 ? -int64_t(line_no) : line_no), 0);
+        put("] ");
+        put(msg, len);
+        put('\n');
+    }
+};
+
+}  // unnamed namespace
+
+AsyncLogSink::~AsyncLogSink() { stop(); }
+
+AsyncLogSink& AsyncLogSink::instance() {
+    static AsyncLogSink sink;
+    return sink;
+}
+
+bool AsyncLogSink::start(const AsyncLogOptions& opts) {
+    stop();
+    std::FILE* f = std::fopen(opts.path.c_str(), "a");
+    if (!f) {
+        LOG(ERROR) << "Cannot open log file " << opts.path;
+        return false;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        file = f;
+        options = opts;
+        size_t capacity = 2;
+        while (capacity < opts.ring_capacity) capacity <<= 1;
+        options.ring_capacity = capacity;
+        dropped_count.store(0, std::memory_order_relaxed);
+        dropped_reported = 0;
+        time_t now = std::time(nullptr);
+        struct tm tm_now;
+        localtime_r(&now, &tm_now);
+        utc_offset = tm_now.tm_gmtoff;
+        crash_fd.store(fileno(f));
+        generation.fetch_add(1, std::memory_order_acq_rel);
+        running.store(true, std::memory_order_release);
+        writer = std::thread(&AsyncLogSink::writer_loop, this);
+    }
+
+    // Crash paths flush synchronously; installed once per process
+    static bool handlers_installed = false;
+    if (!handlers_installed) {
+        handlers_installed = true;
+        google::InstallFailureFunction(&AsyncLogSink::on_fatal);
+        for (int sig : kCrashSignals) std::signal(sig, &AsyncLogSink::on_crash_signal);
+    }
+
+    // The sink replaces glog's own (synchronous) log files
+    for (google::LogSeverity s : {google::GLOG_INFO, google::GLOG_WARNING, google::GLOG_ERROR, google::GLOG_FATAL}) {
+        google::SetLogDestination(s, "");
+    }
+    google::AddLogSink(this);
+    return true;
+}
+
+void AsyncLogSink::stop() {
+    if (!running.load(std::memory_order_acquire)) return;
+    // After this returns glog makes no further send() calls
+    google::RemoveLogSink(this);
+
+    std::thread finished;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        running.store(false, std::memory_order_release);
+        finished = std::move(writer);
+    }
+    wake.notify_all();
+    if (finished.joinable()) finished.join();
+
+    std::lock_guard<std::mutex> drain_lock(drain_mutex);
+    drain();
+    std::lock_guard<std::mutex> lock(mutex);
+    crash_fd.store(-1);
+    std::fclose(file);
+    file = nullptr;
+    bool keep = false;
+    for (const auto& ring : rings) keep = !forget_ring(ring.get()) || keep;
+    if (!keep) rings.clear();
+}
+
+void AsyncLogSink::flush() {
+    std::lock_guard<std::mutex> lock(drain_mutex);
+    drain();
+}
+
+void AsyncLogSink::on_fatal() {
+    instance().flush();
+    std::abort();
+}
+
+void AsyncLogSink::on_crash_signal(int sig) {
+    // One flush even if several threads crash at once
+    static std::atomic_flag flushing = ATOMIC_FLAG_INIT;
+    if (!flushing.test_and_set()) instance().crash_flush();
+    std::signal(sig, SIG_DFL);
+    std::raise(sig);
+}
+
+void AsyncLogSink::crash_flush() {
+    // Pairs with forget_ring: either it sees crashing and keeps the ring, or we see its slot empty
+    crashing.store(true);
+    int fd = crash_fd.load();
+    if (fd < 0) return;
+
+    // Everything not yet written, per ring; the writer thread may hold some of it in its batch
+    LogRing* live[kCrashRings];
+    uint64_t next[kCrashRings], end[kCrashRings];
+    size_t count = 0;
+    for (auto& slot : crash_rings) {
+        LogRing* ring = slot.load();
+        if (!ring) continue;
+        uint64_t tail = ring->tail.load(std::memory_order_acquire);
+        uint64_t from = ring->flushed.load(std::memory_order_acquire);
+        if (tail - from > ring->mask + 1) from = tail - (ring->mask + 1);
+        live[count] = ring;
+        next[count] = from;
+        end[count] = tail;
+        ++count;
+    }
+
+    // Merge by time, as drain() does
+    static const char kLevels[] = "IWEF";
+    CrashWriter out(fd);
+    while (true) {
+        size_t pick = count;
+        for (size_t i = 0; i < count; ++i) {
+            if (next[i] == end[i]) continue;
+            if (pick == count ||
+                live[i]->slots[next[i] & live[i]->mask].time_us < live[pick]->slots[next[pick] & live[pick]->mask].time_us) {
+                pick = i;
+            }
+        }
+        if (pick == count) break;
+        const LogRecord& rec = live[pick]->slots[next[pick]++ & live[pick]->mask];
+        out.line(kLevels[std::min(3, std::max(0, rec.severity))], rec.time_us + int64_t(utc_offset) * 1000000,
+                 rec.file ? rec.file : "?", rec.line, rec.message, std::min<size_t>(rec.length, sizeof(rec.message)));
+    }
+    out.flush();
+}
+
+bool AsyncLogSink::forget_ring(LogRing* ring) {
+    for (auto& slot : crash_rings) {
+        LogRing* expected = ring;
+        slot.compare_exchange_strong(expected, nullptr);
+    }
+    return !crashing.load();
+}
+
+LogRing* AsyncLogSink::ring_for_this_thread() {
+    uint64_t gen = generation.load(std::memory_order_acquire);
+    if (tls_ring.ring && tls_ring.generation == gen) return tls_ring.ring.get();
+
+    // First message from this thread (this run): the only locked step
+    auto ring = std::make_shared<LogRing>(options.ring_capacity);
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        rings.push_back(ring);
+        for (auto& slot : crash_rings) {
+            LogRing* empty = nullptr;
+            if (slot.compare_exchange_strong(empty, ring.get())) break;
+        }
+    }
+    if (tls_ring.ring) tls_ring.ring->retired.store(true, std::memory_order_release);
+    tls_ring.ring = ring;
+    tls_ring.generation = gen;
+    return ring.get();
+}
+
+void AsyncLogSink::send(google::LogSeverity severity, const char* full_filename, const char* base_filename, int line,
+                        const struct ::tm* tm_time, const char* message, size_t message_len) {
+    (void)full_filename;
+    (void)tm_time;
+    if (!running.load(std::memory_order_acquire)) return;
+    LogRing* ring = ring_for_this_thread();
+
+    uint64_t tail = ring->tail.load(std::memory_order_relaxed);
+    while (tail - ring->head.load(std::memory_order_acquire) > ring->mask) {
+        if (options.overflow == LogOverflow::Drop) {
+            dropped_count.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        wake.notify_one();
+        std::this_thread::yield();
+        if (!running.load(std::memory_order_acquire)) return;
+    }
+
+    LogRecord& rec = ring->slots[tail & ring->mask];
+    rec.time_us = std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+    rec.severity = severity;
+    rec.line = line;
+    rec.file = base_filename;
+    rec.length = static_cast<uint32_t>(std::min(message_len, sizeof(rec.message)));
+    std::memcpy(rec.message, message, rec.length);
+    ring->tail.store(tail + 1, std::memory_order_release);
+
+    // The process is about to die; don't leave the message queued
+    if (severity >= google::GLOG_FATAL) flush();
+}
+
+void AsyncLogSink::writer_loop() {
+    std::unique_lock<std::mutex> lock(mutex);
+    while (running.load(std::memory_order_acquire)) {
+        wake.wait_for(lock, options.flush_interval);
+        lock.unlock();
+        {
+            std::lock_guard<std::mutex> drain_lock(drain_mutex);
+            drain();
+        }
+        lock.lock();
+    }
+}
+
+void AsyncLogSink::drain() {
+    std::vector<std::shared_ptr<LogRing>> snapshot;
+    std::FILE* out;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        snapshot = rings;
+        out = file;
+    }
+    if (!out) return;
+
+    batch.clear();
+    std::vector<LogRing*> finished;
+    std::vector<uint64_t> tails;
+    for (const auto& ring : snapshot) {
+        // Read retired first: once set, every record the owner wrote is visible
+        bool retired = ring->retired.load(std::memory_order_acquire);
+        uint64_t head = ring->head.load(std::memory_order_relaxed);
+        uint64_t tail = ring->tail.load(std::memory_order_acquire);
+        for (uint64_t i = head; i < tail; ++i) batch.push_back(ring->slots[i & ring->mask]);
+        ring->head.store(tail, std::memory_order_release);
+        tails.push_back(tail);
+        if (retired) finished.push_back(ring.get());
+    }
+
+    // Rings are each in order; merge them into one timeline
+    std::stable_sort(batch.begin(), batch.end(),
+                     [](const LogRecord& a, const LogRecord& b) { return a.time_us < b.time_us; });
+
+    static const char kLevels[] = "IWEF";
+    std::string text;
+    text.reserve(batch.size() * 96);
+    for (const auto& rec : batch) {
+        append_line(text, kLevels[std::min(3, std::max(0, rec.severity))], rec.time_us, rec.file ? rec.file : "?",
+                    rec.line, rec.message, rec.length);
+    }
+    uint64_t dropped_now = dropped_count.load(std::memory_order_relaxed);
+    if (dropped_now > dropped_reported) {
+        std::string msg = "Async log dropped " + std::to_string(dropped_now - dropped_reported) + " messages";
+        int64_t now = std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::system_clock::now().time_since_epoch()).count();
+        append_line(text, 'W', now, "async_log.cpp", __LINE__, msg.data(), msg.size());
+        dropped_reported = dropped_now;
+    }
+    if (!text.empty()) {
+        std::fwrite(text.data(), 1, text.size(), out);
+        std::fflush(out);
+    }
+    for (size_t i = 0; i < snapshot.size(); ++i) snapshot[i]->flushed.store(tails[i], std::memory_order_release);
+
+    if (!finished.empty()) {
+        std::lock_guard<std::mutex> lock(mutex);
+        rings.erase(std::remove_if(rings.begin(), rings.end(), [&](const std::shared_ptr<LogRing>& r) {
+            return std::find(finished.begin(), finished.end(), r.get()) != finished.end() && forget_ring(r.get());
+        }), rings.end());
+    }
+}
+
+}  // namespace gearforge
@@ -0,0 +1,506 @@
+#include <sys/resource.h>
+#include <unistd.h>
+
+#include "catalog_ops.h"
+#include "progress.h"
+
+namespace gearforge {
+
+namespace {
+
+constexpr uint64_t kSideB = uint64_t(1) << 40;  // seq = side bit | row number
+
+uint64_t mix(uint64_t z) {
+    z += 0x9e3779b97f4a7c15ULL;
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    return z ^ (z >> 31);
+}
+
+struct GearKey {
+    int n = 0;
+    double log_dp = 0.0;  // Log scale so the DP tolerance is relative
+    double pa = 0.0;
+};
+
+struct Entry {
+    uint64_t seq;      // Output order
+    uint64_t cell;     // Hash of the quantized key
+    bool replica;      // Copy filed under a neighbouring cell; never emitted itself
+    GearKey key;
+    std::string line;  // Original text, written out unchanged
+};
+
+struct OutRow {
+    uint64_t seq;
+    std::string tag;   // Diff only
+    std::string line;
+};
+
+// Parses the 13 GearParams columns straight from the text (no per-cell
+// strings); same acceptance as GearParams::from_csv_row
+bool parse_line(const std::string& line, GearParams& p) {
+    double v[13];
+    const char* c = line.data();
+    const char* last = line.data() + line.size();
+    for (int i = 0; i < 13; ++i) {
+        while (c < last && (*c == ' ' || *c == '\t')) ++c;
+        auto res = std::from_chars(c, last, v[i]);
+        const char* end = res.ptr;
+        if (res.ec != std::errc()) {
+            // from_chars rejects a leading '+'; strtod takes anything stod does
+            char* e;
+            v[i] = std::strtod(c, &e);
+            if (e == c) return false;
+            end = e;
+        }
+        while (end < last && (*end == ' ' || *end == '\t')) ++end;
+        if (i < 12 && (end == last || *end != ',')) return false;
+        c = end + 1;
+    }
+    p.n = static_cast<int>(v[0]);
+    p.dp = v[1]; p.m = v[2]; p.pd = v[3]; p.od = v[4]; p.rd = v[5]; p.a = v[6];
+    p.d = v[7]; p.wd = v[8]; p.cp = v[9]; p.pa = v[10]; p.cd = v[11]; p.backlash = v[12];
+    return true;
+}
+
+bool nearly_equal(double x, double y, double rel) {
+    if (std::isnan(x) || std::isnan(y)) return std::isnan(x) && std::isnan(y);
+    return std::fabs(x - y) <= rel * std::max({std::fabs(x), std::fabs(y), 1e-12});
+}
+
+// Maps keys to hash cells. Cells are wider than twice the tolerance, so two
+// keys within tolerance are in the same cell or in cells sharing an edge
+// that both lie near; filing such keys under the neighbouring cells too
+// lets every lookup probe a single cell.
+class Keyer {
+private:
+    const CatalogOptions& o;
+    double dp_width, pa_width;
+
+    uint64_t cell_hash(int n, int64_t cu, int64_t cv) const {
+        return mix(mix(static_cast<uint64_t>(n)) ^ mix(static_cast<uint64_t>(cu) * 2 + 1) ^ static_cast<uint64_t>(cv));
+    }
+
+public:
+    explicit Keyer(const CatalogOptions& opts)
+        : o(opts), dp_width(8.0 * opts.rel_tolerance), pa_width(8.0 * opts.angle_tolerance) {}
+
+    bool key(const GearParams& p, GearKey& k) const {
+        double dp = std::isnan(p.dp) ? 25.4 / p.m : p.dp;
+        if (!(dp > 0.0) || std::isinf(dp)) return false;
+        k.n = p.n;
+        k.log_dp = std::log(dp);
+        k.pa = std::isnan(p.pa) ? 20.0 : p.pa;
+        return true;
+    }
+
+    bool same_gear(const GearKey& a, const GearKey& b) const {
+        return a.n == b.n && std::fabs(a.log_dp - b.log_dp) <= o.rel_tolerance &&
+               std::fabs(a.pa - b.pa) <= o.angle_tolerance;
+    }
+
+    // Own cell first, then up to three neighbours; returns the count
+    int cells(const GearKey& k, uint64_t out[4]) const {
+        double u = k.log_dp / dp_width, v = k.pa / pa_width;
+        int64_t cu = static_cast<int64_t>(std::floor(u)), cv = static_cast<int64_t>(std::floor(v));
+        double fu = u - cu, fv = v - cv;
+        double tu = o.rel_tolerance / dp_width, tv = o.angle_tolerance / pa_width;
+        int du = fu < tu ? -1 : fu > 1.0 - tu ? 1 : 0;
+        int dv = fv < tv ? -1 : fv > 1.0 - tv ? 1 : 0;
+        int count = 0;
+        out[count++] = cell_hash(k.n, cu, cv);
+        if (du) out[count++] = cell_hash(k.n, cu + du, cv);
+        if (dv) out[count++] = cell_hash(k.n, cu, cv + dv);
+        if (du && dv) out[count++] = cell_hash(k.n, cu + du, cv + dv);
+        return count;
+    }
+};
+
+// Spill files one pass may hold open: the soft RLIMIT_NOFILE less a reserve
+// for stdio, the inputs, the output and each join worker's three files
+size_t open_file_budget(unsigned threads) {
+    rlimit lim{};
+    size_t soft = getrlimit(RLIMIT_NOFILE, &lim) == 0 && lim.rlim_cur != RLIM_INFINITY ? lim.rlim_cur : 4096;
+    size_t reserve = 32 + 3 * size_t(threads);
+    return soft > reserve + 8 ? soft - reserve : 8;
+}
+
+// Removes the spill directory however the run ends
+struct TempDir {
+    std::filesystem::path path;
+    ~TempDir() {
+        std::error_code ec;
+        if (!path.empty()) std::filesystem::remove_all(path, ec);
+    }
+};
+
+// Partitioned entries for sides A and B, in memory or in spill files. With
+// more spill partitions than files may be open at once, rows are first
+// scattered into `fanout` buckets per side and finish() splits each bucket
+// into its partitions in a second pass.
+class PartitionSet {
+private:
+    size_t count;
+    size_t fanout;              // Spill streams per side during the scatter
+    std::filesystem::path dir;  // Empty: in memory
+    std::vector<std::vector<Entry>> mem[2];
+    std::vector<std::unique_ptr<std::ofstream>> files[2];
+    const Keyer& keyer;
+
+    std::filesystem::path file_name(int side, size_t part) const {
+        return dir / ((side ? "b_" : "a_") + std::to_string(part));
+    }
+    std::filesystem::path bucket_name(int side, size_t bucket) const {
+        return fanout == count ? file_name(side, bucket) : dir / ((side ? "bb_" : "ab_") + std::to_string(bucket));
+    }
+
+    static std::unique_ptr<std::ofstream> create(const std::filesystem::path& path) {
+        auto f = std::make_unique<std::ofstream>(path);
+        if (!*f) throw std::runtime_error("Cannot create spill file " + path.string());
+        return f;
+    }
+
+    void close_all(std::vector<std::unique_ptr<std::ofstream>>& streams) const {
+        for (auto& f : streams) {
+            bool ok = f->good();
+            f->close();
+            if (!ok || f->fail()) throw std::runtime_error("Error writing spill files in " + dir.string());
+        }
+        streams.clear();
+    }
+
+    // Second pass: bucket k holds partitions k, k + fanout, ...
+    void split_bucket(int side, size_t bucket) {
+        std::vector<std::unique_ptr<std::ofstream>> outs;
+        for (size_t part = bucket; part < count; part += fanout) outs.push_back(create(file_name(side, part)));
+        std::ifstream in(bucket_name(side, bucket));
+        if (!in) throw std::runtime_error("Cannot read spill file " + bucket_name(side, bucket).string());
+        std::string text;
+        while (std::getline(in, text)) {
+            char* c = &text[0];
+            std::strtoull(c, &c, 10);
+            size_t part = std::strtoull(c, &c, 10) % count;
+            *outs[(part - bucket) / fanout] << text << '\n';
+        }
+        if (in.bad()) throw std::runtime_error("Cannot read spill file " + bucket_name(side, bucket).string());
+        in.close();
+        close_all(outs);
+        std::filesystem::remove(bucket_name(side, bucket));
+    }
+
+public:
+    // open_limit: spill files that may be open at once; caps the partition count
+    PartitionSet(size_t count, const std::filesystem::path& dir, const Keyer& keyer, size_t open_limit)
+        : count(count), fanout(count), dir(dir), keyer(keyer) {
+        if (dir.empty()) {
+            for (auto& side : mem) side.resize(count);
+            return;
+        }
+        open_limit = std::max<size_t>(open_limit, 4);
+        fanout = std::min(count, open_limit / 2);
+        this->count = std::min(count, fanout * (open_limit - 1));
+        for (int side = 0; side < 2; ++side) {
+            for (size_t b = 0; b < fanout; ++b) files[side].push_back(create(bucket_name(side, b)));
+        }
+    }
+
+    size_t size() const { return count; }
+
+    void add(int side, Entry&& e) {
+        size_t part = e.cell % count;
+        if (dir.empty()) {
+            mem[side][part].push_back(std::move(e));
+        } else {
+            *files[side][part % fanout] << e.seq << ' ' << e.cell << ' ' << (e.replica ? 1 : 0) << ' ' << e.line << '\n';
+        }
+    }
+
+    void finish() {
+        for (int side = 0; side < 2; ++side) close_all(files[side]);
+        if (dir.empty() || fanout == count) return;
+        for (int side = 0; side < 2; ++side) {
+            for (size_t b = 0; b < fanout; ++b) split_bucket(side, b);
+        }
+    }
+
+    std::vector<Entry> take(int side, size_t part) {
+        if (dir.empty()) return std::move(mem[side][part]);
+        std::vector<Entry> entries;
+        std::ifstream in(file_name(side, part));
+        if (!in) throw std::runtime_error("Cannot read spill file " + file_name(side, part).string());
+        std::string text;
+        while (std::getline(in, text)) {
+            Entry e;
+            char* p = &text[0];
+            e.seq = std::strtoull(p, &p, 10);
+            e.cell = std::strtoull(p, &p, 10);
+            e.replica = std::strtol(p, &p, 10) != 0;
+            e.line.assign(p + 1, text.data() + text.size());
+            GearParams params;
+            if (parse_line(e.line, params)) keyer.key(params, e.key);
+            entries.push_back(std::move(e));
+        }
+        if (in.bad()) throw std::runtime_error("Cannot read spill file " + file_name(side, part).string());
+        return entries;
+    }
+};
+
+// K-way merge of run files sorted by their leading seq into emit()
+void merge_runs(const std::vector<std::filesystem::path>& files, const std::function<void(const std::string&)>& emit) {
+    std::vector<std::unique_ptr<std::ifstream>> readers;
+    for (const auto& f : files) {
+        readers.push_back(std::make_unique<std::ifstream>(f));
+        if (!*readers.back()) throw std::runtime_error("Cannot read spill file " + f.string());
+    }
+    std::vector<std::string> heads(files.size());
+    using Head = std::pair<uint64_t, size_t>;
+    std::priority_queue<Head, std::vector<Head>, std::greater<Head>> queue;
+    auto next = [&](size_t r) {
+        if (std::getline(*readers[r], heads[r])) queue.push({std::strtoull(heads[r].c_str(), nullptr, 10), r});
+        else if (readers[r]->bad()) throw std::runtime_error("Cannot read spill file " + files[r].string());
+    };
+    for (size_t r = 0; r < files.size(); ++r) next(r);
+    while (!queue.empty()) {
+        size_t r = queue.top().second;
+        queue.pop();
+        emit(heads[r]);
+        next(r);
+    }
+}
+
+// Merges more runs than fit open at once in groups of fan_in, into fewer,
+// longer runs, until a single pass can take them all
+std::vector<std::filesystem::path> reduce_runs(std::vector<std::filesystem::path> files, size_t fan_in,
+                                               const std::filesystem::path& dir) {
+    fan_in = std::max<size_t>(fan_in, 2);
+    for (size_t pass = 0; files.size() > fan_in; ++pass) {
+        std::vector<std::filesystem::path> merged;
+        for (size_t g = 0; g < files.size(); g += fan_in) {
+            std::vector<std::filesystem::path> group(files.begin() + g, files.begin() + std::min(files.size(), g + fan_in));
+            merged.push_back(dir / ("merge_" + std::to_string(pass) + "_" + std::to_string(merged.size())));
+            std::ofstream out(merged.back());
+            if (!out) throw std::runtime_error("Cannot create spill file " + merged.back().string());
+            merge_runs(group, [&](const std::string& text) { out << text << '\n'; });
+            out.close();
+            if (out.fail()) throw std::runtime_error("Error writing spill files in " + dir.string());
+            for (const auto& f : group) std::filesystem::remove(f);
+        }
+        files = std::move(merged);
+    }
+    return files;
+}
+
+// Sorted (cell, index) pairs: one equal_range per probe
+std::vector<std::pair<uint64_t, uint32_t>> build_table(const std::vector<Entry>& entries) {
+    std::vector<std::pair<uint64_t, uint32_t>> table(entries.size());
+    for (size_t i = 0; i < entries.size(); ++i) table[i] = {entries[i].cell, static_cast<uint32_t>(i)};
+    std::sort(table.begin(), table.end());
+    return table;
+}
+
+// Smallest-seq entry of `side` describing the same gear as probe, or -1.
+// Entries are stored in seq order, so the first hit in the range is it.
+long find_match(const std::vector<std::pair<uint64_t, uint32_t>>& table, const std::vector<Entry>& side,
+                const Entry& probe, const Keyer& keyer, bool earlier_only) {
+    auto it = std::lower_bound(table.begin(), table.end(), std::make_pair(probe.cell, uint32_t(0)));
+    for (; it != table.end() && it->first == probe.cell; ++it) {
+        const Entry& e = side[it->second];
+        if (earlier_only && e.seq >= probe.seq) break;
+        if (keyer.same_gear(e.key, probe.key)) return it->second;
+    }
+    return -1;
+}
+
+bool rows_differ(const std::string& a, const std::string& b, double rel) {
+    GearParams x, y;
+    if (!parse_line(a, x) || !parse_line(b, y)) return a != b;
+    const double xs[] = {x.m, x.pd, x.od, x.rd, x.a, x.d, x.wd, x.cp, x.cd, x.backlash};
+    const double ys[] = {y.m, y.pd, y.od, y.rd, y.a, y.d, y.wd, y.cp, y.cd, y.backlash};
+    for (size_t i = 0; i < 10; ++i) {
+        if (!nearly_equal(xs[i], ys[i], rel)) return true;
+    }
+    return false;
+}
+
+void join_partition(CatalogOp op, const std::vector<Entry>& a, const std::vector<Entry>& b, const Keyer& keyer,
+                    double rel, std::vector<OutRow>& out) {
+    auto table_a = build_table(a);
+    auto table_b = build_table(b);
+    for (const Entry& x : a) {
+        if (x.replica) continue;
+        switch (op) {
+            case CatalogOp::Merge:
+                out.push_back({x.seq, "", x.line});
+                break;
+            case CatalogOp::Intersect:
+                if (find_match(table_b, b, x, keyer, false) >= 0) out.push_back({x.seq, "", x.line});
+                break;
+            case CatalogOp::Dedup:
+                if (find_match(table_a, a, x, keyer, true) < 0) out.push_back({x.seq, "", x.line});
+                break;
+            case CatalogOp::Diff: {
+                long m = find_match(table_b, b, x, keyer, false);
+                if (m < 0) out.push_back({x.seq, "removed", x.line});
+                else if (rows_differ(x.line, b[m].line, rel)) out.push_back({x.seq, "changed", b[m].line});
+                break;
+            }
+        }
+    }
+    if (op == CatalogOp::Merge || op == CatalogOp::Diff) {
+        for (const Entry& y : b) {
+            if (y.replica || find_match(table_a, a, y, keyer, false) >= 0) continue;
+            out.push_back({y.seq, op == CatalogOp::Diff ? "added" : "", y.line});
+        }
+    }
+    std::sort(out.begin(), out.end(), [](const OutRow& l, const OutRow& r) { return l.seq < r.seq; });
+}
+
+}  // unnamed namespace
+
+bool CatalogTool::parse_op(const std::string& name, CatalogOp& op) {
+    if (name == "merge") op = CatalogOp::Merge;
+    else if (name == "intersect") op = CatalogOp::Intersect;
+    else if (name == "dedup") op = CatalogOp::Dedup;
+    else if (name == "diff") op = CatalogOp::Diff;
+    else return false;
+    return true;
+}
+
+CatalogStats CatalogTool::run(CatalogOp op, const std::string& a_path, const std::string& b_path, std::ostream& out) const {
+    MemTagScope tag(MemTag::Catalog);
+    const bool two_inputs = op != CatalogOp::Dedup;
+    const Keyer keyer(options);
+    CatalogStats stats;
+
+    // Spill when the inputs (times a rough in-memory overhead) exceed the limit
+    std::error_code ec;
+    uint64_t bytes = std::filesystem::file_size(a_path, ec);
+    if (ec) throw std::runtime_error("Cannot read catalog " + a_path);
+    if (two_inputs) {
+        bytes += std::filesystem::file_size(b_path, ec);
+        if (ec) throw std::runtime_error("Cannot read catalog " + b_path);
+    }
+    const uint64_t need = bytes * 3;
+    unsigned threads = options.threads ? options.threads : std::max(1u, std::thread::hardware_concurrency());
+    stats.spilled = need > options.memory_limit;
+    stats.partitions = std::max<size_t>(1, options.partitions);
+    if (stats.spilled) {
+        // Each worker holds one partition at a time
+        stats.partitions = std::max<size_t>(stats.partitions, need * threads / std::max<size_t>(options.memory_limit, 1) + 1);
+    }
+
+    TempDir spill;
+    if (stats.spilled) {
+        static std::atomic<uint64_t> counter{0};
+        std::filesystem::path base = options.spill_dir.empty() ? std::filesystem::temp_directory_path()
+                                                                : std::filesystem::path(options.spill_dir);
+        spill.path = base / ("gearforge-catalog-" + std::to_string(getpid()) + "-" + std::to_string(counter++));
+        std::filesystem::create_directories(spill.path);
+    }
+    const size_t open_limit = open_file_budget(threads);
+    PartitionSet parts(stats.partitions, spill.path, keyer, open_limit);
+    stats.partitions = parts.size();
+
+    // Scatter: each row goes to its own cell's partition, plus replicas to
+    // the partitions of neighbouring cells it is within tolerance of
+    std::string header;
+    auto scatter = [&](int side, const std::string& path) {
+        std::ifstream in(path);
+        if (!in) throw std::runtime_error("Cannot read catalog " + path);
+        std::error_code size_ec;
+        uint64_t size = std::filesystem::file_size(path, size_ec);
+        ScopedProgress progress("Partitioning " + std::filesystem::path(path).filename().string(), size_ec ? 0 : size);
+        uint64_t offset = 0;
+        std::string line;
+        uint64_t row = 0;
+        bool first = true;
+        while (std::getline(in, line)) {
+            offset += line.size() + 1;
+            progress.set(offset);
+            if (!line.empty() && line.back() == '\r') line.pop_back();
+            if (first) {
+                first = false;
+                if (side == 0) header = line;
+                continue;
+            }
+            if (line.find_first_not_of(" \t") == std::string::npos) continue;
+            GearParams p;
+            GearKey key;
+            if (!parse_line(line, p) || !keyer.key(p, key)) {
+                ++stats.skipped;
+                continue;
+            }
+            uint64_t cells[4];
+            int n = keyer.cells(key, cells);
+            uint64_t seq = (side ? kSideB : 0) | row++;
+            for (int c = 1; c < n; ++c) parts.add(side, {seq, cells[c], true, key, line});
+            parts.add(side, {seq, cells[0], false, key, std::move(line)});
+        }
+        (side ? stats.rows_b : stats.rows_a) = row;
+    };
+    scatter(0, a_path);
+    if (two_inputs) scatter(1, b_path);
+    parts.finish();
+
+    // Join partitions independently; each result run is sorted by seq
+    std::vector<std::vector<OutRow>> runs(parts.size());
+    auto run_file = [&](size_t p) { return spill.path / ("out_" + std::to_string(p)); };
+    std::atomic<bool> failed{false};
+    utils::parallel_for(parts.size(), [&](size_t begin, size_t end) {
+        for (size_t p = begin; p < end; ++p) {
+            std::vector<Entry> a = parts.take(0, p);
+            std::vector<Entry> b = two_inputs ? parts.take(1, p) : std::vector<Entry>();
+            join_partition(op, a, b, keyer, options.rel_tolerance, runs[p]);
+            if (!stats.spilled) continue;
+            std::ofstream f(run_file(p));
+            for (const auto& r : runs[p]) f << r.seq << ' ' << (r.tag.empty() ? "-" : r.tag) << ' ' << r.line << '\n';
+            f.close();
+            if (f.fail()) failed = true;
+            runs[p].clear();
+            runs[p].shrink_to_fit();
+        }
+    }, threads);
+    if (failed) throw std::runtime_error("Error writing spill files in " + spill.path.string());
+
+    // K-way merge of the runs back into input order
+    out << (op == CatalogOp::Diff ? "Change," : "") << header << '\n';
+    if (stats.spilled) {
+        std::vector<std::filesystem::path> files;
+        for (size_t p = 0; p < parts.size(); ++p) files.push_back(run_file(p));
+        merge_runs(reduce_runs(std::move(files), open_limit, spill.path), [&](const std::string& text) {
+            size_t tag_begin = text.find(' ') + 1, tag_end = text.find(' ', tag_begin);
+            if (text.compare(tag_begin, tag_end - tag_begin, "-") != 0) {
+                out.write(text.data() + tag_begin, tag_end - tag_begin) << ',';
+            }
+            out.write(text.data() + tag_end + 1, text.size() - tag_end - 1) << '\n';
+            ++stats.rows_out;
+        });
+        if (!out) throw std::runtime_error("Error writing catalog output");
+        return stats;
+    }
+    std::vector<size_t> pos(parts.size(), 0);
+    std::vector<OutRow> heads(parts.size());
+    auto next = [&](size_t p) {
+        if (pos[p] >= runs[p].size()) return false;
+        heads[p] = std::move(runs[p][pos[p]++]);
+        return true;
+    };
+    using Head = std::pair<uint64_t, size_t>;
+    std::priority_queue<Head, std::vector<Head>, std::greater<Head>> queue;
+    for (size_t p = 0; p < parts.size(); ++p) {
+        if (next(p)) queue.push({heads[p].seq, p});
+    }
+    while (!queue.empty()) {
+        size_t p = queue.top().second;
+        queue.pop();
+        if (!heads[p].tag.empty()) out << heads[p].tag << ',';
+        out << heads[p].line << '\n';
+        ++stats.rows_out;
+        if (next(p)) queue.push({heads[p].seq, p});
+    }
+    if (!out) throw std::runtime_error("Error writing catalog output");
+    return stats;
+}
+
+}  // namespace gearforge
@@ -0,0 +1,567 @@
+#include "catalog_search.h"
+
+namespace gearforge {
+
+namespace {
+
+const char* const kFieldNames[] = {"n", "dp", "m", "pd", "od", "rd", "a", "d", "wd", "cp", "pa", "cd", "backlash"};
+const int kFieldCount = 13;
+const int kTextFields[] = {0, 1, 2, 10, 3, 4};  // N, DP, M, PA, PD, OD get "dp10"-style tokens
+
+std::string format_number(double v) {
+    char buf[32];
+    std::snprintf(buf, sizeof(buf), "%.6g", v);
+    return buf;
+}
+
+bool is_token_char(char c) {
+    return std::isalnum(static_cast<unsigned char>(c)) || c == '.' || c == '-' || c == '_';
+}
+
+void split_tokens(const std::string& text, std::vector<std::string>& out) {
+    std::string cur;
+    for (char c : text) {
+        if (is_token_char(c)) {
+            cur += static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+        } else if (!cur.empty()) {
+            out.push_back(cur);
+            cur.clear();
+        }
+    }
+    if (!cur.empty()) out.push_back(cur);
+}
+
+bool parse_number(const std::string& s, double& out) {
+    if (s.empty()) return false;
+    char* end = nullptr;
+    out = std::strtod(s.c_str(), &end);
+    return end == s.c_str() + s.size();
+}
+
+// "30..40", "30..", "..40" or a single value
+bool parse_range(const std::string& s, double& lo, double& hi) {
+    const double inf = std::numeric_limits<double>::infinity();
+    size_t dots = s.find("..");
+    if (dots == std::string::npos) {
+        double v;
+        if (!parse_number(s, v)) return false;
+        double eps = 1e-9 * std::max(1.0, std::fabs(v));
+        lo = v - eps;
+        hi = v + eps;
+        return true;
+    }
+    std::string left = s.substr(0, dots), right = s.substr(dots + 2);
+    if (left.empty() && right.empty()) return false;
+    lo = -inf;
+    hi = inf;
+    if (!left.empty() && !parse_number(left, lo)) return false;
+    if (!right.empty() && !parse_number(right, hi)) return false;
+    if (lo > hi) std::swap(lo, hi);
+    return true;
+}
+
+// "dp10"-style tokens of a row's text fields
+void field_tokens(const GearParams& p, std::vector<std::string>& out) {
+    for (int f : kTextFields) {
+        double v = CatalogIndex::field_value(p, f);
+        if (!std::isnan(v)) out.push_back(kFieldNames[f] + format_number(v));
+    }
+}
+
+}  // unnamed namespace
+
+double CatalogIndex::field_value(const GearParams& p, int field) {
+    switch (field) {
+        case 0: return p.n;
+        case 1: return p.dp;
+        case 2: return p.m;
+        case 3: return p.pd;
+        case 4: return p.od;
+        case 5: return p.rd;
+        case 6: return p.a;
+        case 7: return p.d;
+        case 8: return p.wd;
+        case 9: return p.cp;
+        case 10: return p.pa;
+        case 11: return p.cd;
+        case 12: return p.backlash;
+    }
+    return NAN;
+}
+
+int CatalogIndex::field_index(const std::string& name) {
+    std::string lower = utils::to_lower(name);
+    if (lower == "bl") return 12;
+    for (int f = 0; f < kFieldCount; ++f) {
+        if (lower == kFieldNames[f]) return f;
+    }
+    return -1;
+}
+
+CatalogIndex::CatalogIndex(const std::vector<GearParams>& gears, const std::vector<std::string>& labels)
+    : labels(labels) {
+    if (!labels.empty() && labels.size() != gears.size()) throw std::runtime_error("CatalogIndex needs one label per row");
+    rows.reserve(gears.size());
+    for (const auto& g : gears) rows.push_back(&g);
+    build();
+}
+
+CatalogIndex::CatalogIndex(std::shared_ptr<const CatalogSnapshot> snapshot) : catalog(std::move(snapshot)) {
+    rows.reserve(catalog->size());
+    for (const auto& chunk : catalog->chunks) {
+        for (const auto& g : chunk->rows) rows.push_back(&g);
+    }
+    build();
+}
+
+void CatalogIndex::build() {
+    MemTagScope tag(MemTag::Catalog);
+
+    // Intern tokens per row, then renumber in sorted order so prefixes are id ranges
+    std::unordered_map<std::string, uint32_t> ids;
+    std::vector<std::string> uniq;
+    std::vector<std::string> words;
+    row_token_offsets.reserve(rows.size() + 1);
+    row_token_offsets.push_back(0);
+    for (size_t r = 0; r < rows.size(); ++r) {
+        words.clear();
+        if (!labels.empty()) split_tokens(labels[r], words);
+        field_tokens(*rows[r], words);
+        for (const auto& w : words) {
+            auto it = ids.emplace(w, static_cast<uint32_t>(uniq.size()));
+            if (it.second) uniq.push_back(w);
+            row_tokens.push_back(it.first->second);
+        }
+        row_token_offsets.push_back(static_cast<uint32_t>(row_tokens.size()));
+    }
+
+    std::vector<uint32_t> order(uniq.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) { return uniq[a] < uniq[b]; });
+    std::vector<uint32_t> remap(uniq.size());
+    tokens.resize(uniq.size());
+    for (uint32_t i = 0; i < order.size(); ++i) {
+        remap[order[i]] = i;
+        tokens[i] = std::move(uniq[order[i]]);
+    }
+    for (size_t r = 0; r < rows.size(); ++r) {
+        auto begin = row_tokens.begin() + row_token_offsets[r], end = row_tokens.begin() + row_token_offsets[r + 1];
+        for (auto it = begin; it != end; ++it) *it = remap[*it];
+        std::sort(begin, end);
+    }
+    post_tokens();
+
+    // Sort (value, row) pairs rather than row ids so comparisons never chase
+    // rows. NaN (not given) matches no range, so those rows are left out.
+    sorted_by_field.resize(kFieldCount);
+    utils::parallel_for(kFieldCount, [&](size_t begin, size_t end) {
+        std::vector<std::pair<double, uint32_t>> keyed;
+        keyed.reserve(rows.size());
+        for (size_t f = begin; f < end; ++f) {
+            keyed.clear();
+            for (size_t r = 0; r < rows.size(); ++r) {
+                double v = field_value(*rows[r], static_cast<int>(f));
+                if (!std::isnan(v)) keyed.push_back({v, static_cast<uint32_t>(r)});
+            }
+            std::sort(keyed.begin(), keyed.end());
+            auto& perm = sorted_by_field[f];
+            perm.resize(keyed.size());
+            for (size_t k = 0; k < keyed.size(); ++k) perm[k] = keyed[k].second;
+        }
+    });
+}
+
+void CatalogIndex::post_tokens() {
+    std::vector<uint32_t> counts(tokens.size() + 1, 0);
+    for (size_t r = 0; r + 1 < row_token_offsets.size(); ++r) {
+        // Duplicates stay in row_tokens (harmless) but are posted once
+        for (uint32_t k = row_token_offsets[r]; k < row_token_offsets[r + 1]; ++k) {
+            if (k == row_token_offsets[r] || row_tokens[k] != row_tokens[k - 1]) ++counts[row_tokens[k] + 1];
+        }
+    }
+    for (size_t t = 0; t < tokens.size(); ++t) counts[t + 1] += counts[t];
+    posting_offsets = counts;
+    postings.resize(counts.back());
+    for (size_t r = 0; r + 1 < row_token_offsets.size(); ++r) {
+        for (uint32_t k = row_token_offsets[r]; k < row_token_offsets[r + 1]; ++k) {
+            if (k == row_token_offsets[r] || row_tokens[k] != row_tokens[k - 1]) {
+                postings[counts[row_tokens[k]]++] = static_cast<uint32_t>(r);
+            }
+        }
+    }
+}
+
+void CatalogIndex::update(std::shared_ptr<const CatalogSnapshot> after, const CatalogReload& reload) {
+    MemTagScope tag(MemTag::Catalog);
+    if (!catalog) throw std::runtime_error("CatalogIndex::update needs an index built from a CatalogSnapshot");
+    if (!after || after == catalog) return;
+    const uint32_t kFresh = std::numeric_limits<uint32_t>::max();
+
+    // Where each row went. A chunk the index already has (matched by content:
+    // a version attached from another session has chunk objects of its own)
+    // keeps its rows' work; a chunk repeated in the file takes the old rows only once
+    std::unordered_map<uint64_t, size_t> old_chunk;
+    old_chunk.reserve(catalog->chunks.size());
+    for (size_t c = 0; c < catalog->chunks.size(); ++c) old_chunk.emplace(catalog->chunks[c]->hash, c);
+    std::vector<bool> parsed(after->chunks.size(), false);
+    for (size_t c : reload.added) {
+        if (c < parsed.size()) parsed[c] = true;
+    }
+    std::vector<const GearParams*> next(after->size());
+    std::vector<uint32_t> old_of(next.size(), kFresh), new_of(rows.size(), kFresh), fresh;
+    for (size_t c = 0; c < after->chunks.size(); ++c) {
+        const CatalogChunk& chunk = *after->chunks[c];
+        auto it = parsed[c] ? old_chunk.end() : old_chunk.find(chunk.hash);
+        if (it != old_chunk.end() && (catalog->chunks[it->second]->bytes != chunk.bytes ||
+                                      catalog->chunks[it->second]->rows.size() != chunk.rows.size())) {
+            it = old_chunk.end();
+        }
+        uint32_t first = static_cast<uint32_t>(after->first_row[c]);
+        uint32_t old = it == old_chunk.end() ? kFresh : static_cast<uint32_t>(catalog->first_row[it->second]);
+        for (uint32_t i = 0; i < chunk.rows.size(); ++i) {
+            next[first + i] = &chunk.rows[i];
+            if (old == kFresh) {
+                fresh.push_back(first + i);
+            } else {
+                old_of[first + i] = old + i;
+                new_of[old + i] = first + i;
+            }
+        }
+        if (it != old_chunk.end()) old_chunk.erase(it);
+    }
+
+    // Tokens of the fresh rows; strings the index lacks are merged into the sorted list
+    std::vector<std::string> words;
+    std::vector<size_t> word_offsets{0};
+    for (uint32_t r : fresh) {
+        field_tokens(*next[r], words);
+        word_offsets.push_back(words.size());
+    }
+    std::vector<std::string> extra;
+    for (const auto& w : words) {
+        if (!std::binary_search(tokens.begin(), tokens.end(), w)) extra.push_back(w);
+    }
+    std::sort(extra.begin(), extra.end());
+    extra.erase(std::unique(extra.begin(), extra.end()), extra.end());
+    std::vector<std::string> merged;
+    merged.reserve(tokens.size() + extra.size());
+    std::vector<uint32_t> merged_id(tokens.size());
+    size_t e = 0;
+    for (size_t t = 0; t < tokens.size(); ++t) {
+        while (e < extra.size() && extra[e] < tokens[t]) merged.push_back(std::move(extra[e++]));
+        merged_id[t] = static_cast<uint32_t>(merged.size());
+        merged.push_back(std::move(tokens[t]));
+    }
+    while (e < extra.size()) merged.push_back(std::move(extra[e++]));
+
+    // Row token lists in the new row order (merging keeps the old lists sorted)
+    std::vector<uint32_t> offsets, list;
+    offsets.reserve(next.size() + 1);
+    offsets.push_back(0);
+    list.reserve(row_tokens.size() + words.size());
+    std::vector<bool> used(merged.size(), false);
+    for (size_t r = 0, f = 0; r < next.size(); ++r) {
+        size_t begin = list.size();
+        if (old_of[r] != kFresh) {
+            for (uint32_t k = row_token_offsets[old_of[r]]; k < row_token_offsets[old_of[r] + 1]; ++k) {
+                list.push_back(merged_id[row_tokens[k]]);
+            }
+        } else {
+            for (size_t w = word_offsets[f]; w < word_offsets[f + 1]; ++w) {
+                list.push_back(static_cast<uint32_t>(std::lower_bound(merged.begin(), merged.end(), words[w]) - merged.begin()));
+            }
+            std::sort(list.begin() + begin, list.end());
+            ++f;
+        }
+        for (size_t k = begin; k < list.size(); ++k) used[list[k]] = true;
+        offsets.push_back(static_cast<uint32_t>(list.size()));
+    }
+
+    // Drop tokens no row has any more, so edits don't grow the list
+    std::vector<uint32_t> compact(merged.size());
+    tokens.clear();
+    for (size_t t = 0; t < merged.size(); ++t) {
+        compact[t] = static_cast<uint32_t>(tokens.size());
+        if (used[t]) tokens.push_back(std::move(merged[t]));
+    }
+    for (auto& id : list) id = compact[id];
+    row_tokens = std::move(list);
+    row_token_offsets = std::move(offsets);
+    post_tokens();
+
+    // Kept rows stay in their sorted order, renumbered; the sorted fresh rows
+    // are spliced in at positions found by binary search over the old order
+    std::vector<std::vector<uint32_t>> sorted(kFieldCount);
+    utils::parallel_for(kFieldCount, [&](size_t begin, size_t end) {
+        std::vector<std::pair<double, uint32_t>> keyed;
+        keyed.reserve(fresh.size());
+        std::vector<size_t> at(fresh.size());
+        for (size_t f = begin; f < end; ++f) {
+            const int field = static_cast<int>(f);
+            keyed.clear();
+            for (uint32_t r : fresh) {
+                double v = field_value(*next[r], field);
+                if (!std::isnan(v)) keyed.push_back({v, r});  // Left out, as in build()
+            }
+            std::sort(keyed.begin(), keyed.end());
+            const auto& perm = sorted_by_field[f];
+            auto from = perm.begin();
+            for (size_t j = 0; j < keyed.size(); ++j) {
+                from = std::partition_point(from, perm.end(), [&](uint32_t r) {
+                    return field_value(*rows[r], field) < keyed[j].first;
+                });
+                at[j] = from - perm.begin();
+            }
+            auto& out = sorted[f];
+            out.reserve(next.size());
+            size_t j = 0;
+            for (size_t i = 0; i < perm.size(); ++i) {
+                while (j < keyed.size() && at[j] == i) out.push_back(keyed[j++].second);
+                if (new_of[perm[i]] != kFresh) out.push_back(new_of[perm[i]]);
+            }
+            while (j < keyed.size()) out.push_back(keyed[j++].second);
+        }
+    });
+    sorted_by_field = std::move(sorted);
+
+    rows = std::move(next);
+    catalog = std::move(after);
+    last_valid = false;
+    last_terms.clear();
+    last_bits.clear();
+}
+
+std::vector<CatalogIndex::Term> CatalogIndex::parse(const std::string& query) const {
+    std::vector<std::string> words;
+    std::string cur;
+    for (char c : query) {
+        // "pa=20" and "pa:20" read the same as "pa 20"
+        if (std::isspace(static_cast<unsigned char>(c)) || c == '=' || c == ':') {
+            if (!cur.empty()) words.push_back(utils::to_lower(cur));
+            cur.clear();
+        } else {
+            cur += c;
+        }
+    }
+    if (!cur.empty()) words.push_back(utils::to_lower(cur));
+
+    std::vector<Term> terms;
+    for (size_t i = 0; i < words.size(); ++i) {
+        Term t;
+        int f = field_index(words[i]);
+        if (f >= 0 && i + 1 < words.size() && parse_range(words[i + 1], t.lo, t.hi)) {
+            t.numeric = true;
+            t.field = f;
+            terms.push_back(t);
+            ++i;
+            continue;
+        }
+        if (f >= 0 && i + 1 == words.size()) break;  // Field name typed, value still coming
+
+        std::vector<std::string> parts;
+        split_tokens(words[i], parts);
+        for (auto& p : parts) {
+            Term text;
+            text.text = p;
+            auto lo = std::lower_bound(tokens.begin(), tokens.end(), p);
+            auto hi = std::partition_point(lo, tokens.end(), [&](const std::string& tok) {
+                return tok.compare(0, p.size(), p) == 0;
+            });
+            text.token_lo = static_cast<uint32_t>(lo - tokens.begin());
+            text.token_hi = static_cast<uint32_t>(hi - tokens.begin());
+            terms.push_back(text);
+        }
+    }
+    return terms;
+}
+
+bool CatalogIndex::row_matches(uint32_t row, const Term& term) const {
+    if (term.numeric) {
+        double v = field_value(*rows[row], term.field);
+        return v >= term.lo && v <= term.hi;
+    }
+    for (uint32_t k = row_token_offsets[row]; k < row_token_offsets[row + 1]; ++k) {
+        if (row_tokens[k] >= term.token_lo && row_tokens[k] < term.token_hi) return true;
+    }
+    return false;
+}
+
+double CatalogIndex::row_score(uint32_t row, const std::vector<Term>& terms) const {
+    double score = 0.0;
+    for (const auto& t : terms) {
+        if (t.numeric) {
+            // Closer to the middle of the range (or to the open bound) ranks higher
+            double v = field_value(*rows[row], t.field);
+            double center = std::isinf(t.lo) ? t.hi : std::isinf(t.hi) ? t.lo : (t.lo + t.hi) / 2.0;
+            double half = std::isinf(t.lo) || std::isinf(t.hi) ? std::max(1.0, std::fabs(center)) : (t.hi - t.lo) / 2.0;
+            score += 1.0 - std::min(1.0, std::fabs(v - center) / std::max(half, 1e-12));
+        } else {
+            bool exact = t.token_lo < t.token_hi && tokens[t.token_lo] == t.text;
+            bool hit_exact = false;
+            for (uint32_t k = row_token_offsets[row]; exact && k < row_token_offsets[row + 1]; ++k) {
+                hit_exact |= row_tokens[k] == t.token_lo;
+            }
+            score += hit_exact ? 1.0 : 0.5;
+        }
+    }
+    return score;
+}
+
+bool CatalogIndex::same_term(const Term& a, const Term& b) const {
+    if (a.numeric != b.numeric) return false;
+    if (a.numeric) return a.field == b.field && a.lo == b.lo && a.hi == b.hi;
+    return a.text == b.text;
+}
+
+bool CatalogIndex::refines(const std::vector<Term>& next, const std::vector<Term>& prev) const {
+    if (next.size() < prev.size()) return false;
+    for (size_t i = 0; i < prev.size(); ++i) {
+        const Term& a = next[i];
+        const Term& b = prev[i];
+        if (a.numeric != b.numeric) return false;
+        if (a.numeric && (a.field != b.field || a.lo < b.lo || a.hi > b.hi)) return false;
+        if (!a.numeric && a.text.compare(0, b.text.size(), b.text) != 0) return false;
+    }
+    return true;
+}
+
+void CatalogIndex::apply(const Term& term, std::vector<uint64_t>& bits, size_t& count) const {
+    size_t lo, hi;
+    term_range(term, lo, hi);
+    if (count * 4 < hi - lo) {
+        // Few survivors left: checking them directly beats building a bitmap
+        for (size_t w = 0; w < bits.size(); ++w) {
+            for (uint64_t word = bits[w]; word; word &= word - 1) {
+                uint32_t row = static_cast<uint32_t>(w * 64 + __builtin_ctzll(word));
+                if (!row_matches(row, term)) {
+                    bits[w] &= ~(1ULL << (row & 63));
+                    --count;
+                }
+            }
+        }
+        return;
+    }
+    std::vector<uint64_t> mask(bits.size(), 0);
+    const uint32_t* ids = term.numeric ? sorted_by_field[term.field].data() : postings.data();
+    for (size_t k = lo; k < hi; ++k) mask[ids[k] >> 6] |= 1ULL << (ids[k] & 63);
+    count = 0;
+    for (size_t w = 0; w < bits.size(); ++w) {
+        bits[w] &= mask[w];
+        count += __builtin_popcountll(bits[w]);
+    }
+}
+
+void CatalogIndex::term_range(const Term& term, size_t& lo, size_t& hi) const {
+    if (!term.numeric) {
+        lo = posting_offsets[term.token_lo];
+        hi = posting_offsets[term.token_hi];
+        return;
+    }
+    const auto& perm = sorted_by_field[term.field];
+    auto value = [&](uint32_t r) { return field_value(*rows[r], term.field); };
+    lo = std::partition_point(perm.begin(), perm.end(), [&](uint32_t r) { return value(r) < term.lo; }) - perm.begin();
+    hi = std::partition_point(perm.begin() + lo, perm.end(), [&](uint32_t r) { return value(r) <= term.hi; }) - perm.begin();
+}
+
+SearchResult CatalogIndex::search(const std::string& query, size_t limit, std::chrono::microseconds budget) {
+    MemTagScope tag(MemTag::Catalog);
+    const auto deadline = std::chrono::steady_clock::now() + budget;
+    SearchResult result;
+    std::vector<Term> terms = parse(query);
+
+    if (terms.empty()) {
+        result.matches = rows.size();
+        for (uint32_t r = 0; r < rows.size() && r < limit; ++r) result.hits.push_back({r, 0.0});
+        last_valid = false;
+        return result;
+    }
+
+    // Start from the previous match set when this query only narrows it and
+    // apply just the terms that changed; otherwise start from everything and
+    // apply the most selective terms first
+    std::vector<uint64_t> bits;
+    size_t count;
+    std::vector<const Term*> pending;
+    if (last_valid && refines(terms, last_terms)) {
+        bits = last_bits;
+        count = last_count;
+        for (size_t i = 0; i < terms.size(); ++i) {
+            if (i >= last_terms.size() || !same_term(terms[i], last_terms[i])) pending.push_back(&terms[i]);
+        }
+    } else {
+        bits.assign((rows.size() + 63) / 64, ~0ULL);
+        if (rows.size() % 64) bits.back() = (1ULL << (rows.size() % 64)) - 1;
+        count = rows.size();
+        std::vector<std::pair<size_t, const Term*>> order;
+        for (const auto& t : terms) {
+            size_t lo, hi;
+            term_range(t, lo, hi);
+            order.push_back({hi - lo, &t});
+        }
+        std::sort(order.begin(), order.end(), [](const auto& a, const auto& b) { return a.first < b.first; });
+        for (const auto& o : order) pending.push_back(o.second);
+    }
+    for (const Term* t : pending) apply(*t, bits, count);
+    result.matches = count;
+
+    // Rank survivors in row order (sequential memory access), keeping only
+    // the best `limit` in a heap; the time budget may cut ranking short
+    auto better = [](const SearchHit& a, const SearchHit& b) {
+        return a.score != b.score ? a.score > b.score : a.row < b.row;
+    };
+    std::vector<SearchHit> heap;
+    size_t seen = 0;
+    for (size_t w = 0; w < bits.size() && limit > 0; ++w) {
+        for (uint64_t word = bits[w]; word; word &= word - 1) {
+            uint32_t row = static_cast<uint32_t>(w * 64 + __builtin_ctzll(word));
+            SearchHit hit{row, row_score(row, terms)};
+            if (heap.size() < limit) {
+                heap.push_back(hit);
+                std::push_heap(heap.begin(), heap.end(), better);
+            } else if (better(hit, heap.front())) {
+                std::pop_heap(heap.begin(), heap.end(), better);
+                heap.back() = hit;
+                std::push_heap(heap.begin(), heap.end(), better);
+            }
+            ++seen;
+        }
+        if ((w & 63) == 63 && std::chrono::steady_clock::now() > deadline) {
+            result.complete = seen == count;
+            break;
+        }
+    }
+    std::sort_heap(heap.begin(), heap.end(), better);
+    result.hits = std::move(heap);
+
+    last_valid = true;
+    last_terms = std::move(terms);
+    last_bits = std::move(bits);
+    last_count = count;
+    return result;
+}
+
+std::vector<uint32_t> CatalogIndex::last_matches() const {
+    std::vector<uint32_t> out;
+    if (!last_valid) {
+        out.resize(rows.size());
+        std::iota(out.begin(), out.end(), 0);
+        return out;
+    }
+    out.reserve(last_count);
+    for (size_t w = 0; w < last_bits.size(); ++w) {
+        for (uint64_t word = last_bits[w]; word; word &= word - 1) {
+            out.push_back(static_cast<uint32_t>(w * 64 + __builtin_ctzll(word)));
+        }
+    }
+    return out;
+}
+
+std::string CatalogIndex::describe(uint32_t row) const {
+    const GearParams& p = *rows[row];
+    std::string out = labels.empty() ? "" : labels[row] + "  ";
+    out += "N " + std::to_string(p.n) + "  DP " + format_number(p.dp) + "  M " + format_number(p.m) +
+           "  PA " + format_number(p.pa) + "  PD " + format_number(p.pd) + "  OD " + format_number(p.od);
+    return out;
+}
+
+}  // namespace gearforge
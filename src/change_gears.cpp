@@ -0,0 +1,278 @@
+#include "change_gears.h"
+#include "shared_state.h"
+
+namespace gearforge {
+
+namespace {
+
+struct Geometry {
+    double pitch_radius;
+    double tip_radius;
+};
+
+Geometry gear_geometry(const LatheProfile& profile, int teeth) {
+    GearParams p = GearParams::spec(teeth, profile.dp, profile.pa);
+    p.m = profile.module;
+    p = GearCalculator().calculate(p);
+    return {p.pd / 2.0, p.od / 2.0};
+}
+
+// Can the banjo place the intermediate stud? For a simple train b is the idler.
+bool fits(const LatheProfile& profile, const Geometry& a, const Geometry& b, const Geometry& c, const Geometry& d,
+          bool simple) {
+    const double L = profile.stud_distance;
+    double to_stud = a.pitch_radius + b.pitch_radius;
+    double to_screw = c.pitch_radius + d.pitch_radius;
+    if (to_stud + to_screw < L || std::fabs(to_stud - to_screw) > L) return false;
+    if (to_screw < profile.slot_min || to_screw > profile.slot_max) return false;
+    if (simple) return a.tip_radius + d.tip_radius <= L;  // A and D turn in one plane
+    // B runs beside D, C beside A: neither may reach the other shaft
+    return to_screw >= b.tip_radius + profile.clearance && to_stud >= c.tip_radius + profile.clearance;
+}
+
+// Simple trains first, then by teeth, so the kept train is stable
+bool simpler(const GearTrain& x, const GearTrain& y) {
+    if (x.simple != y.simple) return x.simple > y.simple;
+    return std::tie(x.a, x.b, x.c, x.d) < std::tie(y.a, y.b, y.c, y.d);
+}
+
+double leadscrew_pitch(const LatheProfile& p) {
+    return std::isnan(p.leadscrew_pitch) ? 25.4 / p.leadscrew_tpi : p.leadscrew_pitch;
+}
+
+}  // unnamed namespace
+
+LatheProfile LatheProfile::load(const std::string& filename) {
+    std::ifstream file(filename);
+    if (!file) throw std::runtime_error("Cannot open lathe profile " + filename);
+    LatheProfile p;
+    std::string line;
+    while (std::getline(file, line)) {
+        line = utils::trim(line);
+        if (line.empty() || line[0] == ';') continue;
+        size_t eq = line.find('=');
+        if (eq == std::string::npos) throw std::runtime_error("Expected key = value in " + filename + ": " + line);
+        std::string key = utils::to_lower(utils::trim(line.substr(0, eq)));
+        std::string value = utils::trim(line.substr(eq + 1));
+        if (key == "name") p.name = value;
+        else if (key == "leadscrew_tpi") p.leadscrew_tpi = utils::safe_stod(value);
+        else if (key == "leadscrew_pitch") p.leadscrew_pitch = utils::safe_stod(value);
+        else if (key == "fixed_ratio") p.fixed_ratio = utils::safe_stod(value);
+        else if (key == "dp") p.dp = utils::safe_stod(value);
+        else if (key == "module") p.module = utils::safe_stod(value);
+        else if (key == "pa") p.pa = utils::safe_stod(value);
+        else if (key == "stud_distance") p.stud_distance = utils::safe_stod(value);
+        else if (key == "slot_min") p.slot_min = utils::safe_stod(value);
+        else if (key == "slot_max") p.slot_max = utils::safe_stod(value);
+        else if (key == "clearance") p.clearance = utils::safe_stod(value);
+        else if (key == "simple_trains") p.simple_trains = utils::to_lower(value) != "no" && value != "0";
+        else if (key == "gears") {
+            p.gears.clear();
+            std::stringstream ss(value);
+            std::string teeth;
+            while (std::getline(ss, teeth, ',')) p.gears.push_back(std::stoi(utils::trim(teeth)));
+        } else {
+            throw std::runtime_error("Unknown lathe profile key: " + key);
+        }
+    }
+    return p;
+}
+
+std::string LatheProfile::key() const {
+    std::vector<int> set = gears;
+    std::sort(set.begin(), set.end());
+    std::string k = "change-gears-v1";
+    for (double v : {leadscrew_tpi, leadscrew_pitch, fixed_ratio, dp, module, pa, stud_distance, slot_min, slot_max,
+                     clearance}) {
+        k += "|" + number_to_string(v);
+    }
+    k += simple_trains ? "|simple" : "|compound";
+    for (int n : set) k += "|" + std::to_string(n);
+    return k;
+}
+
+bool ChangeGearSolver::feasible(int a, int b, int c, int d, bool simple) const {
+    return fits(profile, gear_geometry(profile, a), gear_geometry(profile, b), gear_geometry(profile, c),
+                gear_geometry(profile, d), simple);
+}
+
+ThreadTable ChangeGearSolver::build(unsigned threads) const {
+    if (profile.gears.size() < 2) throw std::runtime_error("A lathe profile needs at least two change gears");
+    if (std::isnan(profile.leadscrew_tpi) == std::isnan(profile.leadscrew_pitch)) {
+        throw std::runtime_error("A lathe profile needs either leadscrew_tpi or leadscrew_pitch");
+    }
+    if (std::isnan(profile.dp) == std::isnan(profile.module)) {
+        throw std::runtime_error("A lathe profile needs either dp or module for its change gears");
+    }
+    if (!(profile.stud_distance > 0.0)) throw std::runtime_error("A lathe profile needs stud_distance");
+
+    // Distinct tooth counts with how many of each the set has, so each train is tried once
+    std::vector<int> teeth, have;
+    for (int n : profile.gears) {
+        auto it = std::find(teeth.begin(), teeth.end(), n);
+        if (it == teeth.end()) {
+            teeth.push_back(n);
+            have.push_back(1);
+        } else {
+            ++have[it - teeth.begin()];
+        }
+    }
+    const size_t n = teeth.size();
+    std::vector<Geometry> geo(n);
+    for (size_t i = 0; i < n; ++i) geo[i] = gear_geometry(profile, teeth[i]);
+    const double lead = leadscrew_pitch(profile) * profile.fixed_ratio;
+
+    // Per first driver: ratio (reduced fraction) -> simplest train and how many trains share it
+    using Found = std::unordered_map<uint64_t, std::pair<GearTrain, int>>;
+    std::vector<Found> found(n);
+    utils::parallel_for(n, [&](size_t begin, size_t end) {
+        std::vector<int> used(n, 0);
+        for (size_t ia = begin; ia < end; ++ia) {
+            Found& out = found[ia];
+            auto add = [&](int num, int den, const GearTrain& t) {
+                int g = std::gcd(num, den);
+                uint64_t key = (static_cast<uint64_t>(num / g) << 32) | static_cast<uint32_t>(den / g);
+                auto it = out.find(key);
+                if (it == out.end()) {
+                    GearTrain kept = t;
+                    kept.pitch = lead * num / den;
+                    out.emplace(key, std::make_pair(kept, 1));
+                } else {
+                    ++it->second.second;
+                    if (simpler(t, it->second.first)) {
+                        double pitch = it->second.first.pitch;
+                        it->second.first = t;
+                        it->second.first.pitch = pitch;
+                    }
+                }
+            };
+            // take/give keep per-count availability while nesting
+            auto take = [&](size_t i) { return used[i] < have[i] ? (++used[i], true) : false; };
+            auto give = [&](size_t i) { --used[i]; };
+            take(ia);
+            for (size_t ib = 0; ib < n; ++ib) {
+                if (!take(ib)) continue;
+                for (size_t ic = 0; ic < n; ++ic) {
+                    if (!take(ic)) continue;
+                    for (size_t id = 0; id < n; ++id) {
+                        if (!take(id)) continue;
+                        if (fits(profile, geo[ia], geo[ib], geo[ic], geo[id], false)) {
+                            add(teeth[ia] * teeth[ic], teeth[ib] * teeth[id], {0.0, teeth[ia], teeth[ib], teeth[ic], teeth[id], 0, 0});
+                        }
+                        give(id);
+                    }
+                    give(ic);
+                }
+                // Simple: ib is the idler
+                if (profile.simple_trains) {
+                    for (size_t id = 0; id < n; ++id) {
+                        if (!take(id)) continue;
+                        if (fits(profile, geo[ia], geo[ib], geo[ib], geo[id], true)) {
+                            add(teeth[ia], teeth[id], {0.0, teeth[ia], teeth[ib], teeth[ib], teeth[id], 1, 0});
+                        }
+                        give(id);
+                    }
+                }
+                give(ib);
+            }
+            give(ia);
+        }
+    }, threads);
+
+    // Merge the partitions in order
+    Found all;
+    for (auto& part : found) {
+        for (auto& [key, entry] : part) {
+            auto it = all.find(key);
+            if (it == all.end()) {
+                all.emplace(key, entry);
+            } else {
+                it->second.second += entry.second;
+                if (simpler(entry.first, it->second.first)) {
+                    double pitch = it->second.first.pitch;
+                    it->second.first = entry.first;
+                    it->second.first.pitch = pitch;
+                }
+            }
+        }
+    }
+    std::vector<GearTrain> trains;
+    trains.reserve(all.size());
+    for (auto& [key, entry] : all) {
+        entry.first.alternatives = entry.second - 1;
+        trains.push_back(entry.first);
+    }
+    std::sort(trains.begin(), trains.end(), [](const GearTrain& x, const GearTrain& y) {
+        return x.pitch != y.pitch ? x.pitch < y.pitch : simpler(x, y);
+    });
+    return ThreadTable(std::move(trains));
+}
+
+std::vector<ThreadMatch> ThreadTable::nearest_pitch(double pitch, size_t count) const {
+    std::vector<ThreadMatch> out;
+    if (!(pitch > 0.0)) return out;
+    auto error = [pitch](const GearTrain& t) { return t.pitch / pitch - 1.0; };
+    size_t hi = std::lower_bound(trains.begin(), trains.end(), pitch,
+                                 [](const GearTrain& t, double p) { return t.pitch < p; }) - trains.begin();
+    size_t lo = hi;  // Candidates below are [0, lo)
+    while (out.size() < count && (lo > 0 || hi < trains.size())) {
+        bool take_hi = lo == 0 || (hi < trains.size() && std::fabs(error(trains[hi])) <= std::fabs(error(trains[lo - 1])));
+        const GearTrain& t = take_hi ? trains[hi++] : trains[--lo];
+        out.push_back({t, error(t)});
+    }
+    return out;
+}
+
+bool ThreadTable::save(const std::string& filename) const {
+    FormatBuffer out(64 + trains.size() * 48);
+    out.append(std::string("# "));
+    out.append(static_cast<long long>(trains.size()));
+    out.append(std::string(" trains\n"));
+    RecordCodec<GearTrain>::write_header(out);
+    for (const auto& t : trains) RecordCodec<GearTrain>::write(out, t);
+    return replace_file(filename, out.str());
+}
+
+ThreadTable ThreadTable::load(const std::string& filename) {
+    CsvLines lines;
+    if (!lines.open(filename)) return ThreadTable();
+    const char* begin;
+    const char* end;
+    size_t expected = 0;
+    bool counted = lines.next(begin, end) && end - begin > 2 && begin[0] == '#' &&
+                   std::from_chars(begin + 2, end, expected).ec == std::errc();
+    if (!counted) throw std::runtime_error("No row count in " + filename);
+    auto trains = read_records<GearTrain>(lines, filename);
+    if (trains.size() != expected) {
+        throw std::runtime_error("Truncated " + filename + ": " + std::to_string(trains.size()) + " of " +
+                                 std::to_string(expected) + " rows");
+    }
+    if (!std::is_sorted(trains.begin(), trains.end(), [](const GearTrain& x, const GearTrain& y) { return x.pitch < y.pitch; })) {
+        std::stable_sort(trains.begin(), trains.end(), [](const GearTrain& x, const GearTrain& y) { return x.pitch < y.pitch; });
+    }
+    return ThreadTable(std::move(trains));
+}
+
+ThreadTable ThreadTable::load_or_build(const LatheProfile& profile, const std::string& cache_dir, unsigned threads) {
+    auto hash = utils::sha256(profile.key());
+    std::stringstream ss;
+    ss << std::hex << std::setw(8) << std::setfill('0') << hash.state[0] << std::setw(8) << hash.state[1];
+    std::string stem;
+    for (char ch : profile.name) stem += std::isalnum(static_cast<unsigned char>(ch)) ? ch : '_';
+    std::filesystem::path path = std::filesystem::path(cache_dir) / (stem + "-" + ss.str() + ".csv");
+
+    if (utils::file_exists(path)) {
+        try {
+            return load(path.string());
+        } catch (const std::exception& e) {
+            LOG(WARNING) << "Rebuilding thread table " << path << ": " << e.what();
+        }
+    }
+    ThreadTable table = ChangeGearSolver(profile).build(threads);
+    std::error_code ec;
+    std::filesystem::create_directories(cache_dir, ec);
+    if (!table.save(path.string())) LOG(WARNING) << "Cannot cache thread table at " << path;
+    return table;
+}
+
+}  // namespace gearforge
@@ -0,0 +1,450 @@
+#include "column_file.h"
+
+namespace gearforge {
+
+namespace {
+
+constexpr char kMagic[8] = {'G', 'F', 'C', 'O', 'L', 'S', '1', '\n'};
+
+enum Encoding : uint8_t { kRaw, kDeltaRuns, kDictionary, kXor };
+
+uint64_t mask(int bits) { return bits >= 64 ? ~uint64_t(0) : (uint64_t(1) << bits) - 1; }
+uint64_t zigzag(int64_t v) { return (uint64_t(v) << 1) ^ uint64_t(v >> 63); }
+int64_t unzigzag(uint64_t v) { return int64_t(v >> 1) ^ -int64_t(v & 1); }
+
+uint64_t to_bits(double v) {
+    uint64_t b;
+    std::memcpy(&b, &v, sizeof b);
+    return b;
+}
+
+double from_bits(uint64_t b) {
+    double v;
+    std::memcpy(&v, &b, sizeof v);
+    return v;
+}
+
+template <typename T>
+void put(std::string& out, T v) {
+    out.append(reinterpret_cast<const char*>(&v), sizeof v);
+}
+
+void put_varint(std::string& out, uint64_t v) {
+    while (v >= 0x80) {
+        out += static_cast<char>(v | 0x80);
+        v >>= 7;
+    }
+    out += static_cast<char>(v);
+}
+
+// Bounds-checked reads from an encoded buffer
+struct Cursor {
+    const char* p;
+    const char* end;
+
+    template <typename T>
+    T get() {
+        if (end - p < static_cast<ptrdiff_t>(sizeof(T))) throw std::runtime_error("Column file truncated");
+        T v;
+        std::memcpy(&v, p, sizeof v);
+        p += sizeof v;
+        return v;
+    }
+
+    uint64_t varint() {
+        uint64_t v = 0;
+        for (int shift = 0; shift < 64; shift += 7) {
+            if (p >= end) break;
+            uint8_t b = static_cast<uint8_t>(*p++);
+            v |= uint64_t(b & 0x7f) << shift;
+            if (!(b & 0x80)) return v;
+        }
+        throw std::runtime_error("Column file: bad varint");
+    }
+
+    std::string bytes(size_t n) {
+        if (static_cast<size_t>(end - p) < n) throw std::runtime_error("Column file truncated");
+        std::string s(p, n);
+        p += n;
+        return s;
+    }
+};
+
+// MSB-first bit packing, at most 32 bits per call
+class BitWriter {
+private:
+    std::string& out;
+    uint64_t acc = 0;
+    int used = 0;
+
+public:
+    explicit BitWriter(std::string& out) : out(out) {}
+
+    void write(uint64_t v, int bits) {
+        if (bits > 32) {
+            write(v >> 32, bits - 32);
+            write(v & mask(32), 32);
+            return;
+        }
+        acc = (acc << bits) | (v & mask(bits));
+        used += bits;
+        while (used >= 8) {
+            used -= 8;
+            out += static_cast<char>(acc >> used);
+        }
+        acc &= mask(used);
+    }
+
+    void flush() {
+        if (used) out += static_cast<char>(acc << (8 - used));
+        acc = 0;
+        used = 0;
+    }
+};
+
+class BitReader {
+private:
+    const uint8_t* p;
+    const uint8_t* end;
+    uint64_t acc = 0;
+    int avail = 0;
+
+public:
+    BitReader(const char* begin, const char* end)
+        : p(reinterpret_cast<const uint8_t*>(begin)), end(reinterpret_cast<const uint8_t*>(end)) {}
+
+    uint64_t read(int bits) {
+        if (bits > 32) {
+            uint64_t high = read(bits - 32);
+            return (high << 32) | read(32);
+        }
+        while (avail < bits) {
+            if (p >= end) throw std::runtime_error("Column file truncated");
+            acc = (acc << 8) | *p++;
+            avail += 8;
+        }
+        avail -= bits;
+        uint64_t v = (acc >> avail) & mask(bits);
+        acc &= mask(avail);
+        return v;
+    }
+};
+
+bool integral(const double* v, size_t n) {
+    for (size_t i = 0; i < n; ++i) {
+        if (!(std::fabs(v[i]) < 4503599627370496.0) || v[i] != std::trunc(v[i])) return false;  // 2^52
+    }
+    return true;
+}
+
+// (zigzag delta, run) pairs after the first value
+void encode_delta_runs(const double* v, size_t n, std::string& out) {
+    out += static_cast<char>(kDeltaRuns);
+    int64_t prev = static_cast<int64_t>(v[0]);
+    put_varint(out, zigzag(prev));
+    size_t i = 1;
+    while (i < n) {
+        int64_t delta = static_cast<int64_t>(v[i]) - prev;
+        size_t run = 1;
+        prev = static_cast<int64_t>(v[i]);
+        while (i + run < n && static_cast<int64_t>(v[i + run]) - prev == delta) prev = static_cast<int64_t>(v[i + run++]);
+        put_varint(out, zigzag(delta));
+        put_varint(out, run);
+        i += run;
+    }
+}
+
+// Up to 255 distinct values, then (index, run) pairs; false if there are more
+bool encode_dictionary(const double* v, size_t n, std::string& out) {
+    std::vector<uint64_t> dict;
+    std::string runs;
+    size_t i = 0;
+    uint8_t index = 0;
+    while (i < n) {
+        uint64_t b = to_bits(v[i]);
+        if (dict.empty() || dict[index] != b) {
+            auto it = std::find(dict.begin(), dict.end(), b);
+            if (it == dict.end()) {
+                if (dict.size() == 255) return false;
+                dict.push_back(b);
+                it = dict.end() - 1;
+            }
+            index = static_cast<uint8_t>(it - dict.begin());
+        }
+        size_t run = 1;
+        while (i + run < n && to_bits(v[i + run]) == b) ++run;
+        runs += static_cast<char>(index);
+        put_varint(runs, run);
+        i += run;
+    }
+    out += static_cast<char>(kDictionary);
+    out += static_cast<char>(dict.size());
+    for (uint64_t b : dict) put(out, b);
+    out += runs;
+    return true;
+}
+
+// XOR with the previous value: 0 = same; 10 = meaningful bits inside the
+// previous window; 11 = new window (5 bits leading zeros, 6 bits length - 1)
+void encode_xor(const double* v, size_t n, std::string& out) {
+    out += static_cast<char>(kXor);
+    BitWriter bits(out);
+    uint64_t prev = to_bits(v[0]);
+    bits.write(prev, 64);
+    int lead = -1, trail = 0;
+    for (size_t i = 1; i < n; ++i) {
+        uint64_t b = to_bits(v[i]);
+        uint64_t x = b ^ prev;
+        prev = b;
+        if (x == 0) {
+            bits.write(0, 1);
+            continue;
+        }
+        int l = std::min(__builtin_clzll(x), 31), t = __builtin_ctzll(x);
+        if (lead >= 0 && l >= lead && t >= trail) {
+            bits.write(2, 2);
+            bits.write(x >> trail, 64 - lead - trail);
+        } else {
+            lead = l;
+            trail = t;
+            int len = 64 - l - t;
+            bits.write(3, 2);
+            bits.write(l, 5);
+            bits.write(len - 1, 6);
+            bits.write(x >> t, len);
+        }
+    }
+    bits.flush();
+}
+
+// Smallest encoding of the column, appended to out
+void encode_column(const double* v, size_t n, std::string& out) {
+    std::string best, candidate;
+    best += static_cast<char>(kRaw);
+    best.append(reinterpret_cast<const char*>(v), n * sizeof(double));
+    auto keep = [&]() {
+        if (candidate.size() < best.size()) best.swap(candidate);
+        candidate.clear();
+    };
+    if (n > 0) {
+        if (integral(v, n)) {
+            encode_delta_runs(v, n, candidate);
+            keep();
+        }
+        if (encode_dictionary(v, n, candidate)) keep();
+        candidate.clear();
+        encode_xor(v, n, candidate);
+        keep();
+    }
+    out += best;
+}
+
+void decode_column(const char* data, size_t size, size_t n, double* out) {
+    Cursor c{data, data + size};
+    uint8_t encoding = c.get<uint8_t>();
+    if (n == 0) return;
+    switch (encoding) {
+        case kRaw:
+            if (size != 1 + n * sizeof(double)) throw std::runtime_error("Column file: bad raw column");
+            std::memcpy(out, data + 1, n * sizeof(double));
+            return;
+        case kDeltaRuns: {
+            int64_t v = unzigzag(c.varint());
+            out[0] = static_cast<double>(v);
+            size_t i = 1;
+            while (i < n) {
+                int64_t delta = unzigzag(c.varint());
+                uint64_t run = c.varint();
+                if (run == 0 || run > n - i) throw std::runtime_error("Column file: bad run");
+                for (uint64_t k = 0; k < run; ++k) out[i++] = static_cast<double>(v += delta);
+            }
+            return;
+        }
+        case kDictionary: {
+            size_t count = c.get<uint8_t>();
+            std::vector<double> dict(count);
+            for (auto& d : dict) d = from_bits(c.get<uint64_t>());
+            size_t i = 0;
+            while (i < n) {
+                uint8_t index = c.get<uint8_t>();
+                uint64_t run = c.varint();
+                if (index >= count || run == 0 || run > n - i) throw std::runtime_error("Column file: bad run");
+                std::fill(out + i, out + i + run, dict[index]);
+                i += run;
+            }
+            return;
+        }
+        case kXor: {
+            BitReader bits(c.p, c.end);
+            uint64_t prev = bits.read(64);
+            out[0] = from_bits(prev);
+            int lead = 0, trail = 0;
+            for (size_t i = 1; i < n; ++i) {
+                if (bits.read(1)) {
+                    if (bits.read(1)) {
+                        lead = static_cast<int>(bits.read(5));
+                        int len = static_cast<int>(bits.read(6)) + 1;
+                        trail = 64 - lead - len;
+                        if (trail < 0) throw std::runtime_error("Column file: bad XOR window");
+                    }
+                    prev ^= bits.read(64 - lead - trail) << trail;
+                }
+                out[i] = from_bits(prev);
+            }
+            return;
+        }
+    }
+    throw std::runtime_error("Column file: unknown encoding " + std::to_string(encoding));
+}
+
+}  // unnamed namespace
+
+ColumnFileWriter::ColumnFileWriter(const std::string& path, const std::vector<std::string>& columns)
+    : file(path, std::ios::binary | std::ios::trunc), path(path), names(columns) {
+    if (!file) throw std::runtime_error("Cannot create " + path);
+    file.write(kMagic, sizeof kMagic);
+    offset = sizeof kMagic;
+}
+
+ColumnFileWriter::~ColumnFileWriter() { close(); }
+
+void ColumnFileWriter::write_chunk(const std::vector<std::vector<double>>& columns) {
+    if (columns.size() != names.size()) throw std::runtime_error("Chunk has the wrong number of columns for " + path);
+    const size_t n = columns.empty() ? 0 : columns[0].size();
+    if (n == 0) return;
+
+    ColumnChunkInfo info;
+    info.rows = static_cast<uint32_t>(n);
+    std::string data;
+    for (const auto& col : columns) {
+        if (col.size() != n) throw std::runtime_error("Chunk columns differ in length for " + path);
+        size_t before = data.size();
+        encode_column(col.data(), n, data);
+        info.sizes.push_back(static_cast<uint32_t>(data.size() - before));
+        double lo = INFINITY, hi = -INFINITY;  // NaNs don't count
+        for (double v : col) {
+            if (v < lo) lo = v;
+            if (v > hi) hi = v;
+        }
+        info.min.push_back(lo <= hi ? lo : NAN);
+        info.max.push_back(lo <= hi ? hi : NAN);
+    }
+
+    std::lock_guard<std::mutex> lock(mutex);
+    if (closed) throw std::runtime_error("Column file already closed: " + path);
+    info.offset = offset;
+    file.write(data.data(), static_cast<std::streamsize>(data.size()));
+    offset += data.size();
+    rows += n;
+    chunks.push_back(std::move(info));
+}
+
+bool ColumnFileWriter::close() {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (closed) return true;
+    closed = true;
+    std::string footer;
+    put(footer, static_cast<uint32_t>(names.size()));
+    for (const auto& name : names) {
+        put(footer, static_cast<uint32_t>(name.size()));
+        footer += name;
+    }
+    put(footer, static_cast<uint64_t>(chunks.size()));
+    for (const auto& c : chunks) {
+        put(footer, c.offset);
+        put(footer, c.rows);
+        for (size_t i = 0; i < names.size(); ++i) {
+            put(footer, c.sizes[i]);
+            put(footer, c.min[i]);
+            put(footer, c.max[i]);
+        }
+    }
+    put(footer, offset);  // Where the footer starts
+    footer.append(kMagic, sizeof kMagic);
+    file.write(footer.data(), static_cast<std::streamsize>(footer.size()));
+    offset += footer.size();
+    file.close();
+    return !file.fail();
+}
+
+ColumnFileReader::ColumnFileReader(const std::string& path) : file(path, std::ios::binary) {
+    if (!file) throw std::runtime_error("Cannot open " + path);
+    file.seekg(0, std::ios::end);
+    const uint64_t size = static_cast<uint64_t>(file.tellg());
+    const uint64_t trailer = sizeof(uint64_t) + sizeof kMagic;
+    char head[sizeof kMagic];
+    std::string tail(trailer, '\0');
+    if (size < sizeof kMagic + trailer) throw std::runtime_error("Not a column file: " + path);
+    file.seekg(0);
+    file.read(head, sizeof head);
+    file.seekg(static_cast<std::streamoff>(size - trailer));
+    file.read(&tail[0], static_cast<std::streamsize>(trailer));
+    if (!file || std::memcmp(head, kMagic, sizeof kMagic) != 0 ||
+        std::memcmp(tail.data() + sizeof(uint64_t), kMagic, sizeof kMagic) != 0) {
+        throw std::runtime_error("Not a column file: " + path);
+    }
+    uint64_t footer_offset;
+    std::memcpy(&footer_offset, tail.data(), sizeof footer_offset);
+    if (footer_offset < sizeof kMagic || footer_offset > size - trailer) throw std::runtime_error("Damaged column file: " + path);
+
+    std::string footer(size - trailer - footer_offset, '\0');
+    file.seekg(static_cast<std::streamoff>(footer_offset));
+    file.read(&footer[0], static_cast<std::streamsize>(footer.size()));
+    if (!file) throw std::runtime_error("Damaged column file: " + path);
+    Cursor c{footer.data(), footer.data() + footer.size()};
+    uint32_t count = c.get<uint32_t>();
+    for (uint32_t i = 0; i < count; ++i) names.push_back(c.bytes(c.get<uint32_t>()));
+    uint64_t chunk_count = c.get<uint64_t>();
+    for (uint64_t k = 0; k < chunk_count; ++k) {
+        ColumnChunkInfo info;
+        info.offset = c.get<uint64_t>();
+        info.rows = c.get<uint32_t>();
+        uint64_t end = info.offset;
+        for (uint32_t i = 0; i < count; ++i) {
+            info.sizes.push_back(c.get<uint32_t>());
+            info.min.push_back(c.get<double>());
+            info.max.push_back(c.get<double>());
+            end += info.sizes.back();
+        }
+        if (info.offset < sizeof kMagic || end > footer_offset) throw std::runtime_error("Damaged column file: " + path);
+        rows += info.rows;
+        chunks.push_back(std::move(info));
+    }
+}
+
+int ColumnFileReader::column(const std::string& name) const {
+    auto it = std::find(names.begin(), names.end(), name);
+    return it == names.end() ? -1 : static_cast<int>(it - names.begin());
+}
+
+void ColumnFileReader::read(size_t chunk, int column, std::vector<double>& out) {
+    if (chunk >= chunks.size() || column < 0 || static_cast<size_t>(column) >= names.size()) {
+        throw std::runtime_error("Column file: no chunk " + std::to_string(chunk) + " column " + std::to_string(column));
+    }
+    const ColumnChunkInfo& info = chunks[chunk];
+    uint64_t at = info.offset;
+    for (int i = 0; i < column; ++i) at += info.sizes[i];
+    scratch.resize(info.sizes[column]);
+    file.clear();
+    file.seekg(static_cast<std::streamoff>(at));
+    file.read(&scratch[0], static_cast<std::streamsize>(scratch.size()));
+    if (!file) throw std::runtime_error("Column file: read failed");
+    out.resize(info.rows);
+    decode_column(scratch.data(), scratch.size(), info.rows, out.data());
+}
+
+std::vector<double> ColumnFileReader::read(size_t chunk, int column) {
+    std::vector<double> out;
+    read(chunk, column, out);
+    return out;
+}
+
+std::vector<size_t> ColumnFileReader::chunks_overlapping(int column, double lo, double hi) const {
+    std::vector<size_t> hits;
+    for (size_t k = 0; k < chunks.size(); ++k) {
+        if (chunks[k].max[column] >= lo && chunks[k].min[column] <= hi) hits.push_back(k);
+    }
+    return hits;
+}
+
+}  // namespace gearforge
@@ -0,0 +1,289 @@
+#include "design_sweep.h"
+#include "profile_shift.h"
+#include "progress.h"
+
+namespace gearforge {
+
+namespace {
+
+double involute(double angle) { return std::tan(angle) - angle; }
+
+enum Column { kN1, kN2, kPitch, kPa, kCd, kBacklash, kRatio, kX1, kX2, kWorkingPa, kContact, kThickness1, kThickness2, kColumns };
+
+std::vector<int> teeth_axis(const std::vector<double>& values, const char* name) {
+    std::vector<int> teeth;
+    for (double v : values) {
+        if (v != std::trunc(v) || v < 3 || v > 100000) {
+            throw std::runtime_error(std::string("Sweep ") + name + " must be whole tooth counts >= 3");
+        }
+        teeth.push_back(static_cast<int>(v));
+    }
+    return teeth;
+}
+
+// Center distance terms for one tooth sum in a cell
+struct SumFit {
+    bool ok = false;
+    double shift_sum = 0.0;   // x1 + x2
+    double working_pa = 0.0;  // rad
+    double shortening = 0.0;  // Addendum reduction keeping the bottom clearance, modules
+    double cd = 0.0;          // Operating center distance, inches
+};
+
+struct Counts {
+    uint64_t written = 0, teeth = 0, order = 0, center = 0, undercut = 0, contact = 0;
+};
+
+}  // unnamed namespace
+
+std::vector<double> SweepSpec::parse_axis(const std::string& text) {
+    std::vector<double> values;
+    size_t dots = text.find("..");
+    if (dots != std::string::npos) {
+        std::string rest = text.substr(dots + 2);
+        double step = 1.0;
+        size_t at = utils::to_lower(rest).find("step");
+        if (at != std::string::npos) {
+            step = utils::safe_stod(utils::trim(rest.substr(at + 4)));
+            rest = rest.substr(0, at);
+        }
+        double lo = utils::safe_stod(utils::trim(text.substr(0, dots)));
+        double hi = utils::safe_stod(utils::trim(rest));
+        if (!(step > 0.0) || !(hi >= lo)) throw std::runtime_error("Bad sweep range: " + text);
+        // Index times step, so long ranges don't accumulate rounding
+        const long count = static_cast<long>(std::floor((hi - lo) / step + 1e-9)) + 1;
+        for (long i = 0; i < count; ++i) values.push_back(lo + i * step);
+    } else {
+        std::stringstream ss(text);
+        std::string item;
+        while (std::getline(ss, item, ',')) {
+            item = utils::trim(item);
+            if (!item.empty()) values.push_back(utils::safe_stod(item));
+        }
+    }
+    std::sort(values.begin(), values.end());
+    values.erase(std::unique(values.begin(), values.end()), values.end());
+    if (values.empty()) throw std::runtime_error("Empty sweep axis: " + text);
+    return values;
+}
+
+void SweepSpec::set(const std::string& key_text, const std::string& value) {
+    std::string key = utils::to_lower(utils::trim(key_text));
+    auto flag = [&]() { std::string v = utils::to_lower(utils::trim(value)); return v != "no" && v != "0" && v != "false"; };
+    if (key == "n1") n1 = parse_axis(value);
+    else if (key == "n2") n2 = parse_axis(value);
+    else if (key == "dp") pitch = parse_axis(value);
+    else if (key == "module") {
+        pitch = parse_axis(value);
+        metric = true;
+    } else if (key == "pa") pa = parse_axis(value);
+    else if (key == "cd") cd = parse_axis(value);
+    else if (key == "backlash") backlash = parse_axis(value);
+    else if (key == "units") metric = utils::to_lower(utils::trim(value)) == "mm";
+    else if (key == "min_teeth") min_teeth = std::stoi(value);
+    else if (key == "max_shift") max_shift = utils::safe_stod(value);
+    else if (key == "cd_tolerance") cd_tolerance = utils::safe_stod(value);
+    else if (key == "min_contact") min_contact = utils::safe_stod(value);
+    else if (key == "allow_undercut") allow_undercut = flag();
+    else if (key == "ordered") ordered = flag();
+    else throw std::runtime_error("Unknown sweep key: " + key);
+}
+
+SweepSpec SweepSpec::load(const std::string& filename) {
+    std::ifstream file(filename);
+    if (!file) throw std::runtime_error("Cannot open sweep spec " + filename);
+    SweepSpec spec;
+    std::string line;
+    while (std::getline(file, line)) {
+        line = utils::trim(line);
+        if (line.empty() || line[0] == ';' || line[0] == '#') continue;
+        size_t eq = line.find('=');
+        if (eq == std::string::npos) throw std::runtime_error("Expected key = value in " + filename + ": " + line);
+        spec.set(line.substr(0, eq), utils::trim(line.substr(eq + 1)));
+    }
+    return spec;
+}
+
+uint64_t SweepSpec::grid_points() const {
+    uint64_t n = 1;
+    for (size_t axis : {n1.size(), n2.empty() ? n1.size() : n2.size(), pitch.size(), pa.size(), cd.size(), backlash.size()}) {
+        n *= axis;
+    }
+    return n;
+}
+
+DesignSweep::DesignSweep(const SweepSpec& s) : spec(s) {
+    if (spec.n2.empty()) spec.n2 = spec.n1;
+    if (spec.n1.empty() || spec.pitch.empty() || spec.cd.empty()) {
+        throw std::runtime_error("A sweep needs n1, dp (or module) and cd");
+    }
+    teeth_axis(spec.n1, "n1");
+    teeth_axis(spec.n2, "n2");
+    for (double p : spec.pitch) {
+        if (!(p > 0.0)) throw std::runtime_error("Sweep pitch must be positive");
+    }
+    for (double a : spec.pa) {
+        if (!(a > 0.0 && a < 45.0)) throw std::runtime_error("Sweep pressure angles must be between 0 and 45 degrees");
+    }
+}
+
+std::vector<std::string> DesignSweep::columns() const {
+    return {"N1", "N2", spec.metric ? "Module" : "DP", "PA", "CD", "Backlash", "Ratio", "X1", "X2",
+            "WorkingPA", "ContactRatio", "Thickness1", "Thickness2"};
+}
+
+SweepStats DesignSweep::run(const std::string& path, unsigned threads, size_t chunk_rows) const {
+    auto start = std::chrono::steady_clock::now();
+    const std::vector<int> n1 = teeth_axis(spec.n1, "n1");
+    const std::vector<int> n2 = teeth_axis(spec.n2, "n2");
+    const int n2_max = n2.back();
+    std::vector<char> is_n2(n2_max + 1, 0);
+    for (int n : n2) is_n2[n] = 1;
+    const int sum_min = n1.front() + n2.front(), sum_max = n1.back() + n2_max;
+
+    const double unit = spec.metric ? 25.4 : 1.0;  // Spec length units per inch
+    const uint64_t per_pinion = n2.size() * spec.backlash.size();
+    const size_t cells = spec.pa.size() * spec.pitch.size() * spec.cd.size();
+
+    ColumnFileWriter writer(path, columns());
+    ScopedProgress progress("Sweeping " + std::to_string(spec.grid_points()) + " points", spec.grid_points());
+    std::atomic<size_t> next_cell{0};
+    std::mutex counts_mutex;
+    Counts total;
+
+    auto worker = [&]() {
+        std::vector<std::vector<double>> block(kColumns);
+        for (auto& col : block) col.reserve(chunk_rows);
+        std::vector<SumFit> fits(sum_max - sum_min + 1);
+        std::vector<int> sums;
+        Counts counts;
+
+        for (size_t cell; (cell = next_cell.fetch_add(1)) < cells;) {
+            const double pa = spec.pa[cell % spec.pa.size()];
+            const double pitch = spec.pitch[cell / spec.pa.size() % spec.pitch.size()];
+            const double cd_spec = spec.cd[cell / (spec.pa.size() * spec.pitch.size())];
+            const double dp = spec.metric ? 25.4 / pitch : pitch;
+            const double m = 1.0 / dp, cd = cd_spec / unit;
+            const double alpha = pa * M_PI / 180.0, cos_a = std::cos(alpha), tan_a = std::tan(alpha);
+
+            // Which tooth sums make this center distance at all
+            sums.clear();
+            for (int s = sum_min; s <= sum_max; ++s) {
+                SumFit& f = fits[s - sum_min];
+                const double standard = s * m / 2.0;
+                f = SumFit();
+                if (spec.max_shift <= 0.0) {
+                    f.ok = std::fabs(standard - cd) * unit <= spec.cd_tolerance;
+                    f.working_pa = alpha;
+                    f.cd = standard;
+                } else {
+                    double c = standard * cos_a / cd;
+                    if (c >= 1.0) continue;
+                    f.working_pa = std::acos(c);
+                    f.shift_sum = (involute(f.working_pa) - involute(alpha)) * s / (2.0 * tan_a);
+                    f.ok = std::fabs(f.shift_sum) <= 2.0 * spec.max_shift;
+                    f.shortening = std::max(0.0, f.shift_sum - (cd - standard) / m);
+                    f.cd = cd;
+                }
+                if (f.ok) sums.push_back(s);
+            }
+
+            for (int a : n1) {
+                if (a < spec.min_teeth) {
+                    counts.teeth += per_pinion;
+                    continue;
+                }
+                const double lo1 = spec.allow_undercut ? -spec.max_shift
+                                                       : std::max(ProfileShiftOptimizer::min_shift(a, pa), -spec.max_shift);
+                if (lo1 > spec.max_shift + 1e-12) {
+                    counts.undercut += per_pinion;
+                    continue;
+                }
+                uint64_t visited = 0;
+                for (int s : sums) {
+                    const int b = s - a;
+                    if (b < 3 || b > n2_max || !is_n2[b]) continue;
+                    ++visited;
+                    const uint64_t points = spec.backlash.size();
+                    if (b < spec.min_teeth) {
+                        counts.teeth += points;
+                        continue;
+                    }
+                    if (spec.ordered && a > b) {
+                        counts.order += points;
+                        continue;
+                    }
+                    const SumFit& f = fits[s - sum_min];
+                    const double lo2 = spec.allow_undercut
+                                           ? -spec.max_shift
+                                           : std::max(ProfileShiftOptimizer::min_shift(b, pa), -spec.max_shift);
+                    const double x_lo = std::max(lo1, f.shift_sum - spec.max_shift);
+                    const double x_hi = std::min(spec.max_shift, f.shift_sum - lo2);
+                    if (x_lo > x_hi + 1e-12) {
+                        counts.undercut += points;
+                        continue;
+                    }
+                    const double x1 = std::clamp(f.shift_sum / 2.0, x_lo, std::max(x_lo, x_hi));
+                    const double x2 = f.shift_sum - x1;
+
+                    const double r1 = a * m / 2.0, r2 = b * m / 2.0;
+                    const double rb1 = r1 * cos_a, rb2 = r2 * cos_a;
+                    const double ra1 = r1 + m * (1.0 + x1 - f.shortening), ra2 = r2 + m * (1.0 + x2 - f.shortening);
+                    const double contact = (std::sqrt(ra1 * ra1 - rb1 * rb1) + std::sqrt(ra2 * ra2 - rb2 * rb2) -
+                                            f.cd * std::sin(f.working_pa)) / (M_PI * m * cos_a);
+                    if (contact < spec.min_contact) {
+                        counts.contact += points;
+                        continue;
+                    }
+
+                    // Circular thickness on the pitch circle; each gear takes half the backlash
+                    const double s1 = m * (M_PI / 2.0 + 2.0 * x1 * tan_a), s2 = m * (M_PI / 2.0 + 2.0 * x2 * tan_a);
+                    for (double backlash : spec.backlash) {
+                        const double values[kColumns] = {double(a), double(b), pitch, pa, cd_spec, backlash,
+                                                         double(b) / a, x1, x2, f.working_pa * 180.0 / M_PI, contact,
+                                                         s1 * unit - backlash / 2.0, s2 * unit - backlash / 2.0};
+                        for (int c = 0; c < kColumns; ++c) block[c].push_back(values[c]);
+                        if (block[0].size() >= chunk_rows) {
+                            writer.write_chunk(block);
+                            for (auto& col : block) col.clear();
+                        }
+                    }
+                    counts.written += points;
+                }
+                counts.center += per_pinion - visited * spec.backlash.size();
+            }
+            progress.add(n1.size() * per_pinion);
+        }
+        if (!block[0].empty()) writer.write_chunk(block);
+
+        std::lock_guard<std::mutex> lock(counts_mutex);
+        total.written += counts.written;
+        total.teeth += counts.teeth;
+        total.order += counts.order;
+        total.center += counts.center;
+        total.undercut += counts.undercut;
+        total.contact += counts.contact;
+    };
+
+    unsigned workers = threads ? threads : std::max(1u, std::thread::hardware_concurrency());
+    workers = static_cast<unsigned>(std::min<size_t>(workers, std::max<size_t>(cells, 1)));
+    utils::parallel_for(workers, [&](size_t begin, size_t end) {
+        for (size_t w = begin; w < end; ++w) worker();
+    }, workers);
+    if (!writer.close()) throw std::runtime_error("Writing " + path + " failed");
+
+    SweepStats stats;
+    stats.grid = spec.grid_points();
+    stats.written = total.written;
+    stats.pruned_teeth = total.teeth;
+    stats.pruned_order = total.order;
+    stats.pruned_center = total.center;
+    stats.pruned_undercut = total.undercut;
+    stats.rejected_contact = total.contact;
+    stats.bytes = writer.bytes();
+    stats.chunks = writer.chunk_count();
+    stats.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return stats;
+}
+
+}  // namespace gearforge
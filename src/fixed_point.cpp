@@ -0,0 +1,37 @@
+#include "fixed_point.h"
+
+namespace gearforge {
+
+namespace {
+
+constexpr Fixed kPi = Fixed::from_double(M_PI);
+constexpr Fixed kHalfPi = Fixed::from_double(M_PI / 2.0);
+constexpr Fixed kTwoPi = Fixed::from_double(2.0 * M_PI);
+
+}  // unnamed namespace
+
+Fixed sin(Fixed x) {
+    if (x.is_nan()) return Fixed::nan();
+
+    // Reduce to [-pi, pi], then fold onto [-pi/2, pi/2] with sin(pi - x) = sin(x)
+    int64_t turns = x.raw() / kTwoPi.raw();
+    x = x - Fixed(static_cast<int>(turns)) * kTwoPi;
+    if (kPi < x) x = x - kTwoPi;
+    if (x < -kPi) x = x + kTwoPi;
+    if (kHalfPi < x) x = kPi - x;
+    if (x < -kHalfPi) x = -kPi - x;
+
+    // Taylor series to x^17/17!, below one ulp on this interval
+    Fixed x2 = x * x;
+    Fixed term = x;
+    Fixed sum = x;
+    for (int k = 1; k <= 8; ++k) {
+        term = -term * x2 / Fixed((2 * k) * (2 * k + 1));
+        sum = sum + term;
+    }
+    return sum;
+}
+
+Fixed cos(Fixed x) { return sin(x + kHalfPi); }
+
+}  // namespace gearforge
@@ -2,54 +2,74 @@
 
 namespace gearforge {
 
-std::vector<std::string> GearParams::to_csv_row() const {
-    return {
-        std::to_string(n), std::to_string(dp), std::to_string(m),
-        std::to_string(pd), std::to_string(od), std::to_string(rd),
-        std::to_string(a), std::to_string(d), std::to_string(wd),
-        std::to_string(cp), std::to_string(pa), std::to_string(cd),
-        std::to_string(backlash)
-    };
+template <typename T>
+std::vector<std::string> BasicGearParams<T>::to_csv_row() const {
+    MemTagScope tag(MemTag::Csv);
+    std::vector<std::string> cells;
+    FormatBuffer cell(kMaxNumberChars);
+    for_each_field<BasicGearParams>([&](const auto& f, size_t) {
+        cell.clear();
+        write_field(cell, this->*(f.member));
+        cells.push_back(cell.str());
+    });
+    return cells;
 }
 
-GearParams GearParams::from_csv_row(const std::vector<std::string>& row) {
-    if (row.size() < 13) throw std::runtime_error("Invalid CSV row for GearParams");
-    GearParams p;
-    p.n = std::stoi(row[0]);
-    p.dp = utils::safe_stod(row[1]);
-    p.m = utils::safe_stod(row[2]);
-    p.pd = utils::safe_stod(row[3]);
-    p.od = utils::safe_stod(row[4]);
-    p.rd = utils::safe_stod(row[5]);
-    p.a = utils::safe_stod(row[6]);
-    p.d = utils::safe_stod(row[7]);
-    p.wd = utils::safe_stod(row[8]);
-    p.cp = utils::safe_stod(row[9]);
-    p.pa = utils::safe_stod(row[10]);
-    p.cd = utils::safe_stod(row[11]);
-    p.backlash = utils::safe_stod(row[12]);
+template <typename T>
+BasicGearParams<T> BasicGearParams<T>::from_csv_row(const std::vector<std::string>& row) {
+    MemTagScope tag(MemTag::Csv);
+    if (row.size() < RecordCodec<BasicGearParams>::kRequiredFields) throw std::runtime_error("Invalid CSV row for GearParams");
+    BasicGearParams p;
+    for_each_field<BasicGearParams>([&](const auto& f, size_t i) {
+        if (i >= row.size()) {
+            p.*(f.member) = {};  // Optional trailing column
+            return;
+        }
+        const std::string& s = row[i];
+        if (!parse_field(s.data(), s.data() + s.size(), p.*(f.member))) throw std::runtime_error("Invalid number: " + s);
+    });
     return p;
 }
 
-GearParams GearCalculator::calculate(const GearParams& input) {
-    GearParams p = input;
-    if (std::isnan(p.dp) && !std::isnan(p.m)) p.dp = 25.4 / p.m;  // Convert module to DP
-    if (std::isnan(p.m) && !std::isnan(p.dp)) p.m = 25.4 / p.dp;
-    p.pd = p.n / p.dp;
-    p.a = 1.0 / p.dp;
-    p.d = 1.157 / p.dp;  // Standard for 14.5/20 deg PA
+template <typename T>
+typename BasicGearCalculator<T>::Params BasicGearCalculator<T>::calculate(const Params& input) {
+    using precision::is_nan;
+    // Constants are converted once per policy at compile time
+    constexpr T mm_per_inch = precision::from_double<T>(25.4);
+    constexpr T one = precision::from_double<T>(1.0);
+    constexpr T two = precision::from_double<T>(2.0);
+    constexpr T dedendum = precision::from_double<T>(1.157);
+    constexpr T pi = precision::from_double<T>(M_PI);
+    constexpr T backlash_ratio = precision::from_double<T>(0.003);
+
+    Params p = input;
+    if (is_nan(p.dp) && !is_nan(p.m)) p.dp = mm_per_inch / p.m;  // Convert module to DP
+    if (is_nan(p.m) && !is_nan(p.dp)) p.m = mm_per_inch / p.dp;
+    p.pd = T(p.n) / p.dp;
+    p.a = (one + p.x) / p.dp;
+    p.d = (dedendum - p.x) / p.dp;  // Standard for 14.5/20 deg PA
     p.wd = p.a + p.d;
-    p.od = p.pd + 2 * p.a;
-    p.rd = p.pd - 2 * p.d;
-    p.cp = M_PI / p.dp;
-    if (std::isnan(p.cd)) p.cd = p.pd / 2.0;  // Single gear; for pair, user input
-    if (std::isnan(p.backlash)) p.backlash = 0.003 * p.pd;  // Mid-range default
+    p.od = p.pd + two * p.a;
+    p.rd = p.pd - two * p.d;
+    p.cp = pi / p.dp;
+    if (is_nan(p.cd)) p.cd = p.pd / two;  // Single gear; for pair, user input
+    if (is_nan(p.backlash)) p.backlash = backlash_ratio * p.pd;  // Mid-range default
     // Adjust for PA if non-standard, but assume 20 deg default if nan
-    if (std::isnan(p.pa)) p.pa = 20.0;
+    if (is_nan(p.pa)) p.pa = precision::from_double<T>(20.0);
     return p;
 }
 
-int GearCalculator::select_cutter(int teeth) {
+template <typename T>
+std::vector<typename BasicGearCalculator<T>::Params> BasicGearCalculator<T>::calculate(const std::vector<Params>& inputs) {
+    std::vector<Params> results(inputs.size());
+    utils::parallel_for(inputs.size(), [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) results[i] = calculate(inputs[i]);
+    });
+    return results;
+}
+
+template <typename T>
+int BasicGearCalculator<T>::select_cutter(int teeth) {
     // Standard involute cutter ranges
     if (teeth >= 135) return 1;
     if (teeth >= 55) return 2;
@@ -61,7 +81,8 @@ int GearCalculator::select_cutter(int teeth) {
     return 8;  // 12-13
 }
 
-std::string GearCalculator::dividing_head_instructions(int teeth) {
+template <typename T>
+std::string BasicGearCalculator<T>::dividing_head_instructions(int teeth) {
     double turns = 40.0 / teeth;
     int full_turns = static_cast<int>(turns);
     double fractional = turns - full_turns;
@@ -70,27 +91,65 @@ std::string GearCalculator::dividing_head_instructions(int teeth) {
            std::to_string(fractional) + " fractional (use hole plate).";
 }
 
-std::pair<double, double> GearCalculator::involute_point(double r_base, double theta) {
-    double x = r_base * (std::cos(theta) + theta * std::sin(theta));
-    double y = r_base * (std::sin(theta) - theta * std::cos(theta));
+template <typename T>
+std::pair<T, T> BasicGearCalculator<T>::involute_point(T r_base, T theta) {
+    using std::cos;
+    using std::sin;
+    T x = r_base * (cos(theta) + theta * sin(theta));
+    T y = r_base * (sin(theta) - theta * cos(theta));
     return {x, y};
 }
 
-std::vector<GearParams> GearCalculator::load_known(const std::string& filename) {
-    auto csv = utils::read_csv(filename);
-    std::vector<GearParams> params;
-    for (size_t i = 1; i < csv.size(); ++i) {  // Skip header
-        params.push_back(GearParams::from_csv_row(csv[i]));
-    }
-    return params;
+template <typename T>
+std::vector<typename BasicGearCalculator<T>::Params> BasicGearCalculator<T>::load_known(const std::string& filename) {
+    return read_records<Params>(filename);
+}
+
+template <typename T>
+bool BasicGearCalculator<T>::save(const Params& params, const std::string& filename) {
+    return save(std::vector<Params>{params}, filename);
 }
 
-bool GearCalculator::save(const GearParams& params, const std::string& filename) {
-    std::vector<std::vector<std::string>> data;
-    // Header
-    data.push_back({"N", "DP", "M", "PD", "OD", "RD", "A", "D", "WD", "CP", "PA", "CD", "Backlash"});
-    data.push_back(params.to_csv_row());
-    return utils::write_csv(filename, data);
+template <typename T>
+bool BasicGearCalculator<T>::save(const std::vector<Params>& params, const std::string& filename) {
+    MemTagScope tag(MemTag::Csv);
+    CsvWriter out(filename, 0);  // Everything goes through write(), which skips its buffer
+    if (!out.is_open()) return false;
+    const size_t block = 16384;
+    const size_t row_bytes = 128;  // Typical row; buffers grow if rows are longer
+    FormatBuffer rows(std::min(block, params.size() + 1) * row_bytes);
+    RecordCodec<Params>::write_header(rows);
+    if (params.size() <= block) {
+        for (const auto& p : params) RecordCodec<Params>::write(rows, p);
+        out.write(rows);
+        return out.close();
+    }
+    out.write(rows);
+
+    // Shortest round-trip formatting, not the disk, is the cost: rows are
+    // formatted in parallel blocks and the blocks written in order
+    const size_t threads = std::min<size_t>(std::max(1u, std::thread::hardware_concurrency()),
+                                            (params.size() + block - 1) / block);
+    std::vector<FormatBuffer> buffers(threads, FormatBuffer(block * row_bytes));
+    for (size_t start = 0; start < params.size(); start += block * threads) {
+        size_t blocks = std::min<size_t>(threads, (params.size() - start + block - 1) / block);
+        utils::parallel_for(blocks, [&](size_t begin, size_t end) {
+            for (size_t b = begin; b < end; ++b) {
+                buffers[b].clear();
+                size_t last = std::min(params.size(), start + (b + 1) * block);
+                for (size_t i = start + b * block; i < last; ++i) RecordCodec<Params>::write(buffers[b], params[i]);
+            }
+        }, threads);
+        for (size_t b = 0; b < blocks; ++b) out.write(buffers[b]);
+    }
+    return out.close();
 }
 
+template struct BasicGearParams<float>;
+template struct BasicGearParams<double>;
+template struct BasicGearParams<Fixed>;
+template class BasicGearCalculator<float>;
+template class BasicGearCalculator<double>;
+template class BasicGearCalculator<Fixed>;
+
 }  // namespace gearforge
@@ -0,0 +1,171 @@
+#include "gear_generation.h"
+#include "vector_math.h"
+
+namespace gearforge {
+
+namespace {
+
+double involute(double angle) { return std::tan(angle) - angle; }
+
+struct RackPoint {
+    double t;  // Depth below the rack reference line, toward the gear center
+    double w;  // Offset from the rack tooth centerline
+};
+
+// Right-hand boundary of one basic rack tooth: straight flank down to the
+// working depth, a tip radius tangent to flank and tip line, then the tip flat.
+std::vector<RackPoint> rack_outline(double m, double alpha, double addendum, double dedendum, double working) {
+    const double tan_a = std::tan(alpha);
+    const double w0 = M_PI * m / 4.0;  // Half tooth width on the reference line
+    const double t_top = -(addendum + 0.5 * m);  // Past the gear tip; never reached
+    double rho = dedendum > working ? (dedendum - working) / (1.0 - std::sin(alpha)) : 0.0;
+    double tc = dedendum - rho;
+    double wc = w0 - tc * tan_a - rho / std::cos(alpha);
+
+    std::vector<RackPoint> pts;
+    pts.push_back({t_top, w0 - t_top * tan_a});
+    const int arc_steps = 8;
+    for (int k = 0; k <= arc_steps; ++k) {
+        double beta = (M_PI / 2.0 - alpha) * (1.0 - static_cast<double>(k) / arc_steps);
+        pts.push_back({tc + rho * std::cos(beta), wc + rho * std::sin(beta)});
+    }
+    pts.push_back({dedendum, -wc});
+    return pts;
+}
+
+}  // unnamed namespace
+
+GenerationResult GearGenerator::simulate(const GearParams& gear, int mate_teeth) const {
+    GearCalculator calc;
+    GearParams p = calc.calculate(gear);
+    if (p.n < 3 || !(p.dp > 0)) throw std::runtime_error("Generating simulation needs N >= 3 and DP or module");
+
+    const int n = p.n;
+    const double m = 1.0 / p.dp;
+    const double alpha = p.pa * M_PI / 180.0;
+    const double rp = p.pd / 2.0;
+    const double rb = rp * std::cos(alpha);
+    const double shift = p.x * m;
+    const double ref = rp + shift;  // Rack reference line distance from gear center
+    const double r_tip = p.od / 2.0;  // calculate() already moved A and D by the shift
+    const double r_root = p.rd / 2.0;
+    const double tol_len = options.tolerance * m;
+
+    // The cutting rack itself is standard: undo the shift calculate() applied
+    const auto rack = rack_outline(m, alpha, p.a - shift, p.d + shift, options.working_depth * m);
+    const int samples = std::max(options.radial_samples, 8);
+    const double dr = (r_tip - r_root) / samples;
+
+    GenerationResult res;
+    res.base_diameter = 2.0 * rb;
+    res.radii.resize(samples);
+    std::vector<double> r2(samples);
+    std::vector<double> beta(samples, -std::numeric_limits<double>::infinity());
+    for (int j = 0; j < samples; ++j) {
+        res.radii[j] = r_root + dr * (j + 1);
+        r2[j] = res.radii[j] * res.radii[j];
+    }
+
+    // Roll the rack across every position where it can still reach the blank
+    const double w_max = rack.front().w;
+    const double phi_max = (std::sqrt(std::max(0.0, r_tip * r_tip - r_root * r_root)) + w_max) / rp;
+    const double dphi = 2.0 * M_PI / (n * std::max(options.steps_per_pitch, 8));
+    const int steps = static_cast<int>(std::ceil(2.0 * phi_max / dphi));
+    const double neg_inf = -std::numeric_limits<double>::infinity();
+
+    for (int s = 0; s <= steps; ++s) {
+        const double phi = -phi_max + s * dphi;
+        const double slide = rp * phi;
+        for (size_t k = 0; k + 1 < rack.size(); ++k) {
+            const double ax = ref - rack[k].t, ay = rack[k].w + slide;
+            const double bx = ref - rack[k + 1].t, by = rack[k + 1].w + slide;
+            const double dx = bx - ax, dy = by - ay;
+            const double dd = dx * dx + dy * dy;
+            if (dd <= 0.0) continue;
+
+            // Only sample radii the segment actually spans
+            double s_near = std::min(1.0, std::max(0.0, -(ax * dx + ay * dy) / dd));
+            double r_near = std::hypot(ax + s_near * dx, ay + s_near * dy);
+            double r_far = std::max(std::hypot(ax, ay), std::hypot(bx, by));
+            if (r_near > r_tip || r_far < r_root) continue;
+            int j0 = std::max(0, static_cast<int>((r_near - r_root) / dr) - 1);
+            int j1 = std::min(samples, static_cast<int>((r_far - r_root) / dr) + 1);
+
+            const double ad = ax * dx + ay * dy;
+            const double aa = ax * ax + ay * ay;
+            const double inv_dd = 1.0 / dd;
+            double* out = beta.data();
+            const double* rr = r2.data();
+            // Both crossings of the circle r = sqrt(rr[j]), kept or dropped by
+            // select, with vec_atan2 in place of libm so the loop vectorizes
+            for (int j = j0; j < j1; ++j) {
+                double disc = ad * ad - dd * (aa - rr[j]);
+                double sq = std::sqrt(std::max(disc, 0.0));
+                double s1 = (-ad - sq) * inv_dd;
+                double s2 = (-ad + sq) * inv_dd;
+                double t1 = vec_atan2(ay + s1 * dy, ax + s1 * dx) - phi;
+                double t2 = vec_atan2(ay + s2 * dy, ax + s2 * dx) - phi;
+                bool ok1 = disc >= 0.0 && s1 >= 0.0 && s1 <= 1.0;
+                bool ok2 = disc >= 0.0 && s2 >= 0.0 && s2 <= 1.0;
+                double best = std::max(ok1 ? t1 : neg_inf, ok2 ? t2 : neg_inf);
+                out[j] = std::max(out[j], best);
+            }
+        }
+    }
+
+    // Compare the envelope with the ideal involute tooth of the same shift
+    const double half_pitch = M_PI / n;
+    const double psi0 = M_PI / (2.0 * n) + 2.0 * p.x * std::tan(alpha) / n + involute(alpha);
+    res.half_thickness.resize(samples);
+    std::vector<double> deviation(samples, 0.0);
+    for (int j = 0; j < samples; ++j) {
+        double r = res.radii[j];
+        res.half_thickness[j] = std::isinf(beta[j]) ? half_pitch : half_pitch - beta[j];
+        // Below the base circle the involute is continued radially; a sound
+        // fillet only widens from there, an undercut tooth necks in
+        double psi = r >= rb ? psi0 - involute(std::acos(rb / r)) : psi0;
+        deviation[j] = r * (psi - res.half_thickness[j]);  // > 0: cut inside the involute
+        res.undercut_depth = std::max(res.undercut_depth, deviation[j]);
+    }
+    res.undercut = res.undercut_depth > tol_len;
+    if (!res.undercut) res.undercut_depth = 0.0;
+    res.pointed_tip = 2.0 * r_tip * res.half_thickness.back() <= tol_len;
+
+    // True form radius: lowest sample from which the profile follows the involute up to the tip
+    double r_form = r_tip;
+    for (int j = samples - 1; j >= 0 && res.radii[j] >= rb; --j) {
+        if (std::fabs(deviation[j]) > tol_len) break;
+        r_form = res.radii[j];
+    }
+    res.form_diameter = 2.0 * std::max(r_form, rb);
+    res.min_profile_shift = options.working_depth - n * std::pow(std::sin(alpha), 2) / 2.0;
+
+    if (mate_teeth > 0) {
+        // Standard (unshifted) mate at the center distance this shift implies
+        const double rp2 = mate_teeth * m / 2.0;
+        const double rb2 = rp2 * std::cos(alpha);
+        const double ra2 = rp2 + m;
+        const double cd = rp + rp2 + shift;
+        const double line = cd * std::sin(std::acos(std::min(1.0, (rb + rb2) / cd)));
+        const double form1 = res.form_diameter / 2.0;
+        double u2 = rp2 * std::sin(alpha) - options.working_depth * m / std::sin(alpha);
+        double form2 = u2 > 0.0 ? std::sqrt(rb2 * rb2 + u2 * u2) : rb2;
+
+        // Either tip reaching past the other gear's form circle runs into the fillet
+        bool mate_tip = std::sqrt(ra2 * ra2 - rb2 * rb2) > line - std::sqrt(std::max(0.0, form1 * form1 - rb * rb)) + tol_len;
+        bool own_tip = std::sqrt(r_tip * r_tip - rb * rb) > line - std::sqrt(std::max(0.0, form2 * form2 - rb2 * rb2)) + tol_len;
+        res.tip_interference = mate_tip || own_tip;
+    }
+    return res;
+}
+
+std::vector<GenerationResult> GearGenerator::screen(const std::vector<GearParams>& gears, int mate_teeth,
+                                                    unsigned threads) const {
+    std::vector<GenerationResult> results(gears.size());
+    utils::parallel_for(gears.size(), [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) results[i] = simulate(gears[i], mate_teeth);
+    }, threads);
+    return results;
+}
+
+}  // namespace gearforge
@@ -0,0 +1,196 @@
+#include "gear_identify.h"
+
+namespace gearforge {
+
+namespace {
+
+const double kMmPerInch = 25.4;
+
+std::string format_number(double v) {
+    char buf[32];
+    std::snprintf(buf, sizeof(buf), "%g", v);
+    return buf;
+}
+
+double involute(double a) { return std::tan(a) - a; }
+
+// Span (base tangent length) over k teeth
+double span_length(int n, double dp, double pa_deg, int k) {
+    double alpha = pa_deg * M_PI / 180.0;
+    return std::cos(alpha) / dp * (M_PI * (k - 0.5) + n * involute(alpha));
+}
+
+template <typename Entry>
+bool by_n_then_key(const Entry& a, const Entry& b) { return a.n != b.n ? a.n < b.n : a.key < b.key; }
+
+}  // unnamed namespace
+
+const std::vector<double>& GearIdentifier::dp_series() {
+    static const std::vector<double> series = {
+        1, 1.25, 1.5, 1.75, 2, 2.25, 2.5, 3, 3.5, 4, 5, 6, 7, 8, 9, 10, 11, 12, 14, 16, 18, 20,
+        22, 24, 26, 28, 30, 32, 36, 40, 42, 44, 48, 56, 64, 72, 80, 96, 120, 128, 150, 180, 200};
+    return series;
+}
+
+const std::vector<double>& GearIdentifier::module_series() {
+    // ISO 54, first and second choice
+    static const std::vector<double> series = {
+        0.3, 0.4, 0.5, 0.6, 0.7, 0.75, 0.8, 0.9, 1, 1.125, 1.25, 1.375, 1.5, 1.75, 2, 2.25, 2.5,
+        2.75, 3, 3.5, 4, 4.5, 5, 5.5, 6, 7, 8, 9, 10, 11, 12, 14, 16, 18, 20, 22, 25};
+    return series;
+}
+
+const std::vector<double>& GearIdentifier::pressure_angles() {
+    static const std::vector<double> angles = {20.0, 14.5, 25.0};  // Most common first; breaks ties
+    return angles;
+}
+
+void GearIdentifier::add_entries(int n, uint32_t spec, double od, double rd) {
+    if (!std::isnan(od)) by_od.push_back({n, od, spec});
+    if (!std::isnan(rd)) by_rd.push_back({n, rd, spec});
+}
+
+GearIdentifier::GearIdentifier(const std::vector<GearParams>& rows) : catalog(rows) {
+    for (double dp : dp_series()) {
+        uint32_t s = static_cast<uint32_t>(specs.size());
+        specs.push_back({dp, NAN, 1.157, -1});
+        for (int n = kMinTeeth; n <= kMaxTeeth; ++n) add_entries(n, s, (n + 2.0) / dp, (n - 2.0 * 1.157) / dp);
+    }
+    for (double m : module_series()) {
+        uint32_t s = static_cast<uint32_t>(specs.size());
+        specs.push_back({kMmPerInch / m, m, 1.25, -1});
+        for (int n = kMinTeeth; n <= kMaxTeeth; ++n) {
+            add_entries(n, s, (n + 2.0) * m / kMmPerInch, (n - 2.5) * m / kMmPerInch);
+        }
+    }
+
+    GearCalculator calc;
+    for (size_t i = 0; i < catalog.size(); ++i) {
+        // Keep the catalog's own OD/RD (they may be non-standard); fill the rest
+        GearParams p = catalog[i];
+        GearParams full = calc.calculate(p);
+        if (!std::isnan(p.od)) full.od = p.od;
+        if (!std::isnan(p.rd)) full.rd = p.rd;
+        if (full.n < 1) continue;
+        catalog[i] = full;
+        uint32_t s = static_cast<uint32_t>(specs.size());
+        specs.push_back({full.dp, NAN, NAN, static_cast<int>(i)});
+        add_entries(full.n, s, full.od, full.rd);
+    }
+
+    std::sort(by_od.begin(), by_od.end(), by_n_then_key<IndexEntry>);
+    std::sort(by_rd.begin(), by_rd.end(), by_n_then_key<IndexEntry>);
+}
+
+GearParams GearIdentifier::geometry(int n, const Spec& spec, double pa) const {
+    if (spec.catalog_row >= 0) return catalog[spec.catalog_row];
+    GearParams p = GearParams::spec(n, spec.dp, pa);
+    p.m = spec.module;
+    p = GearCalculator().calculate(p);
+    if (!std::isnan(spec.module)) {
+        // Metric full-depth dedendum is 1.25 m
+        p.d = spec.dedendum / spec.dp;
+        p.wd = p.a + p.d;
+        p.rd = p.pd - 2.0 * p.d;
+    }
+    return p;
+}
+
+void GearIdentifier::evaluate(const GearMeasurement& m, const Spec& spec, double pa, IdentifyCandidate& c) const {
+    // Only the measured dimensions, straight from the spec; full params are
+    // built later for the candidates that make the cut
+    double od, rd, dp;
+    if (spec.catalog_row >= 0) {
+        const GearParams& p = catalog[spec.catalog_row];
+        od = p.od;
+        rd = p.rd;
+        dp = p.dp;
+        pa = p.pa;
+    } else {
+        dp = spec.dp;
+        od = (m.n + 2.0) / dp;
+        rd = (m.n - 2.0 * spec.dedendum) / dp;
+    }
+
+    double sum = 0.0;
+    int count = 0;
+    auto add = [&](double measured, double predicted, double& residual) {
+        if (std::isnan(measured)) return;
+        residual = measured - predicted;
+        sum += (residual / m.tolerance) * (residual / m.tolerance);
+        ++count;
+    };
+    add(m.od, od, c.od_residual);
+    add(m.rd, rd, c.rd_residual);
+    if (!std::isnan(m.span)) {
+        int k = m.span_teeth > 0 ? m.span_teeth : std::max(1, static_cast<int>(std::lround(m.n * pa / 180.0 + 0.5)));
+        add(m.span, span_length(m.n, dp, pa, k), c.span_residual);
+    }
+    c.score = std::sqrt(sum / std::max(count, 1));
+}
+
+std::vector<IdentifyCandidate> GearIdentifier::identify(const GearMeasurement& m, size_t limit) const {
+    if (m.n < 1) throw std::runtime_error("Identification needs the tooth count");
+    if (std::isnan(m.od) && std::isnan(m.rd)) throw std::runtime_error("Identification needs OD or RD");
+    if (!(m.tolerance > 0.0)) throw std::runtime_error("Measurement tolerance must be positive");
+    // Lengths are optional (NaN), but one that is given must be a real size
+    auto bad_length = [](double v) { return !std::isnan(v) && !(v > 0.0 && std::isfinite(v)); };
+    if (bad_length(m.od) || bad_length(m.rd) || bad_length(m.span)) {
+        throw std::runtime_error("Measured OD, RD and span must be positive");
+    }
+    if (m.span_teeth < 0 || m.span_teeth >= m.n) throw std::runtime_error("The span must cover fewer teeth than N");
+
+    const bool use_od = !std::isnan(m.od);
+    const std::vector<IndexEntry>& index = use_od ? by_od : by_rd;
+    const double value = use_od ? m.od : m.rd;
+
+    // Start at three tolerances and widen until enough specs fall inside;
+    // only the final window is evaluated
+    IndexEntry lo{m.n, 0.0, 0};
+    auto first = index.end(), last = index.end();
+    for (double window = 3.0 * m.tolerance;; window *= 4.0) {
+        lo.key = value - window;
+        first = std::lower_bound(index.begin(), index.end(), lo, by_n_then_key<IndexEntry>);
+        last = first;
+        while (last != index.end() && last->n == m.n && last->key <= value + window) ++last;
+        if (static_cast<size_t>(last - first) >= limit || window > value) break;
+    }
+
+    struct Scored {
+        IdentifyCandidate c;
+        uint32_t spec;
+        double pa;
+    };
+    std::vector<Scored> scored;
+    for (auto it = first; it != last; ++it) {
+        const Spec& spec = specs[it->spec];
+        if (spec.catalog_row >= 0) {
+            scored.push_back({IdentifyCandidate(), it->spec, catalog[spec.catalog_row].pa});
+            evaluate(m, spec, scored.back().pa, scored.back().c);
+            continue;
+        }
+        // OD and RD don't depend on PA; span does
+        for (double pa : pressure_angles()) {
+            scored.push_back({IdentifyCandidate(), it->spec, pa});
+            evaluate(m, spec, pa, scored.back().c);
+        }
+    }
+    std::stable_sort(scored.begin(), scored.end(), [](const Scored& a, const Scored& b) { return a.c.score < b.c.score; });
+    if (scored.size() > limit) scored.resize(limit);
+
+    std::vector<IdentifyCandidate> out;
+    for (auto& s : scored) {
+        const Spec& spec = specs[s.spec];
+        s.c.params = geometry(m.n, spec, s.pa);
+        if (spec.catalog_row >= 0) {
+            s.c.source = "Catalog row " + std::to_string(spec.catalog_row + 1);
+        } else {
+            s.c.source = (std::isnan(spec.module) ? "DP " + format_number(spec.dp) : "Module " + format_number(spec.module)) +
+                         ", PA " + format_number(s.pa);
+        }
+        out.push_back(std::move(s.c));
+    }
+    return out;
+}
+
+}  // namespace gearforge
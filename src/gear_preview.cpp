@@ -0,0 +1,335 @@
+#include <poll.h>
+#include <sys/ioctl.h>
+#include <termios.h>
+#include <unistd.h>
+
+#include "gear_preview.h"
+#include "number_format.h"
+
+namespace gearforge {
+
+namespace {
+
+// Braille dot bit for subpixel (x % 2, y % 4)
+constexpr uint8_t kDotBits[4][2] = {{0x01, 0x08}, {0x02, 0x10}, {0x04, 0x20}, {0x40, 0x80}};
+
+// UTF-8 of U+2800 + bits, for every cell value
+struct BrailleGlyphs {
+    char bytes[256][3];
+    BrailleGlyphs() {
+        for (int b = 0; b < 256; ++b) {
+            unsigned cp = 0x2800 + b;
+            bytes[b][0] = static_cast<char>(0xE0 | (cp >> 12));
+            bytes[b][1] = static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+            bytes[b][2] = static_cast<char>(0x80 | (cp & 0x3F));
+        }
+    }
+};
+
+const BrailleGlyphs glyphs;
+
+struct Edge {
+    int y0, y1;  // Scanlines [y0, y1) whose centers the edge spans
+    double x;    // Crossing at the current scanline's center
+    double dx;   // Per scanline
+};
+
+std::mutex outline_mutex;
+std::map<std::tuple<int, long, long>, std::shared_ptr<const std::vector<PreviewPoint>>> outlines;
+
+// Stdin without line buffering or echo while alive; output processing is left alone
+class RawInput {
+private:
+    termios saved{};
+    bool active = false;
+
+public:
+    RawInput() {
+        if (tcgetattr(STDIN_FILENO, &saved) != 0) return;
+        termios raw = saved;
+        raw.c_lflag &= ~(ICANON | ECHO);
+        raw.c_cc[VMIN] = 0;
+        raw.c_cc[VTIME] = 0;
+        active = tcsetattr(STDIN_FILENO, TCSANOW, &raw) == 0;
+    }
+    ~RawInput() {
+        if (active) tcsetattr(STDIN_FILENO, TCSANOW, &saved);
+    }
+};
+
+void write_all(int fd, const std::string& s) {
+    size_t done = 0;
+    while (done < s.size()) {
+        ssize_t n = ::write(fd, s.data() + done, s.size() - done);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return;
+        done += static_cast<size_t>(n);
+    }
+}
+
+}  // unnamed namespace
+
+BrailleCanvas::BrailleCanvas(int cols, int rows)
+    : cols(std::max(cols, 1)), rows(std::max(rows, 1)),
+      dots(size_t(this->cols) * this->rows), layers(size_t(this->cols) * this->rows) {}
+
+void BrailleCanvas::clear() {
+    std::fill(dots.begin(), dots.end(), 0);
+    std::fill(layers.begin(), layers.end(), 0);
+}
+
+void BrailleCanvas::set(int x, int y, uint8_t layer) {
+    if (x < 0 || y < 0 || x >= width() || y >= height()) return;
+    size_t c = size_t(y / 4) * cols + x / 2;
+    dots[c] |= kDotBits[y % 4][x % 2];
+    layers[c] = layer;
+}
+
+bool BrailleCanvas::dot(int x, int y) const {
+    if (x < 0 || y < 0 || x >= width() || y >= height()) return false;
+    return dots[size_t(y / 4) * cols + x / 2] & kDotBits[y % 4][x % 2];
+}
+
+size_t BrailleCanvas::count() const {
+    size_t n = 0;
+    for (uint8_t d : dots) n += __builtin_popcount(d);
+    return n;
+}
+
+void BrailleCanvas::fill_span(int y, int x0, int x1, uint8_t layer) {
+    if (y < 0 || y >= height()) return;
+    x0 = std::max(x0, 0);
+    x1 = std::min(x1, width() - 1);
+    if (x0 > x1) return;
+    const uint8_t left = kDotBits[y % 4][0], right = kDotBits[y % 4][1];
+    uint8_t* d = dots.data() + size_t(y / 4) * cols;
+    uint8_t* l = layers.data() + size_t(y / 4) * cols;
+    int c0 = x0 / 2, c1 = x1 / 2;
+    if (c0 == c1) {
+        d[c0] |= (x0 % 2 ? 0 : left) | (x1 % 2 ? right : 0);
+        l[c0] = layer;
+        return;
+    }
+    d[c0] |= x0 % 2 ? right : left | right;
+    d[c1] |= x1 % 2 ? left | right : left;
+    for (int c = c0 + 1; c < c1; ++c) d[c] |= left | right;
+    std::fill(l + c0, l + c1 + 1, layer);
+}
+
+void BrailleCanvas::fill_polygon(const std::vector<std::vector<PreviewPoint>>& contours, uint8_t layer) {
+    std::vector<Edge> edges;
+    for (const auto& c : contours) {
+        for (size_t i = 0; i < c.size(); ++i) {
+            PreviewPoint a = c[i], b = c[(i + 1) % c.size()];
+            if (a.y == b.y) continue;
+            if (a.y > b.y) std::swap(a, b);
+            int y0 = std::max(0, static_cast<int>(std::ceil(a.y - 0.5)));
+            int y1 = std::min(height(), static_cast<int>(std::ceil(b.y - 0.5)));
+            if (y0 >= y1) continue;
+            double dx = (b.x - a.x) / (b.y - a.y);
+            edges.push_back({y0, y1, a.x + (y0 + 0.5 - a.y) * dx, dx});
+        }
+    }
+    if (edges.empty()) return;
+    std::sort(edges.begin(), edges.end(), [](const Edge& a, const Edge& b) { return a.y0 < b.y0; });
+
+    std::vector<Edge> active;
+    std::vector<double> xs;
+    size_t next = 0;
+    int y = edges.front().y0;
+    while (next < edges.size() || !active.empty()) {
+        if (active.empty() && edges[next].y0 > y) y = edges[next].y0;
+        while (next < edges.size() && edges[next].y0 == y) active.push_back(edges[next++]);
+        active.erase(std::remove_if(active.begin(), active.end(), [y](const Edge& e) { return e.y1 <= y; }),
+                     active.end());
+
+        xs.clear();
+        for (const Edge& e : active) xs.push_back(e.x);
+        std::sort(xs.begin(), xs.end());
+        // Pixels whose centers lie between each pair of crossings
+        for (size_t i = 0; i + 1 < xs.size(); i += 2) {
+            fill_span(y, static_cast<int>(std::ceil(xs[i] - 0.5)), static_cast<int>(std::ceil(xs[i + 1] - 0.5)) - 1,
+                      layer);
+        }
+        for (Edge& e : active) e.x += e.dx;
+        ++y;
+    }
+}
+
+void BrailleCanvas::render(std::string& out) const {
+    out.reserve(out.size() + size_t(cols) * rows * 3 + rows * 16);
+    for (int r = 0; r < rows; ++r) {
+        int color = 0;
+        for (int c = 0; c < cols; ++c) {
+            size_t i = size_t(r) * cols + c;
+            if (!dots[i]) {
+                out += ' ';
+                continue;
+            }
+            if (layers[i] != color) {
+                color = layers[i];
+                out += color ? utils::COLOR_YELLOW : utils::COLOR_RESET;
+            }
+            out.append(glyphs.bytes[dots[i]], 3);
+        }
+        if (color) out += utils::COLOR_RESET;
+        out += "\033[K\n";
+    }
+}
+
+std::shared_ptr<const std::vector<PreviewPoint>> GearPreview::outline(int n, double pa, double x) {
+    auto key = std::make_tuple(n, std::lround(pa * 100.0), std::lround(x * 1e4));
+    {
+        std::lock_guard<std::mutex> lock(outline_mutex);
+        auto it = outlines.find(key);
+        if (it != outlines.end()) return it->second;
+    }
+
+    // Coarse generation is plenty at terminal resolution
+    GenerationOptions options;
+    options.radial_samples = 48;
+    options.steps_per_pitch = 48;
+    GenerationResult gen = GearGenerator(options).simulate(GearParams::spec(n, 1.0, pa, x));
+
+    const double pitch = 2.0 * M_PI / n;
+    const double r_root = 2.0 * gen.radii[0] - gen.radii[1];
+    std::vector<double> psi(gen.half_thickness.size());
+    for (size_t j = 0; j < psi.size(); ++j) psi[j] = std::min(gen.half_thickness[j], pitch / 2.0);
+    auto polar = [](double r, double a) { return PreviewPoint{r * std::cos(a), r * std::sin(a)}; };
+
+    // Each tooth root to tip on one flank, back down the other, then the root circle to the next
+    auto points = std::make_shared<std::vector<PreviewPoint>>();
+    const int root_steps = 4;
+    for (int k = 0; k < n; ++k) {
+        double center = k * pitch;
+        for (size_t j = 0; j < psi.size(); ++j) {
+            if (psi[j] > 0.0) points->push_back(polar(gen.radii[j], center - psi[j]));
+        }
+        for (size_t j = psi.size(); j-- > 0;) {
+            if (psi[j] > 0.0) points->push_back(polar(gen.radii[j], center + psi[j]));
+        }
+        double from = center + std::max(psi[0], 0.0), to = center + pitch - std::max(psi[0], 0.0);
+        for (int s = 0; s <= root_steps; ++s) points->push_back(polar(r_root, from + (to - from) * s / root_steps));
+    }
+
+    std::lock_guard<std::mutex> lock(outline_mutex);
+    return outlines.emplace(key, points).first->second;
+}
+
+size_t GearPreview::cached_outlines() {
+    std::lock_guard<std::mutex> lock(outline_mutex);
+    return outlines.size();
+}
+
+GearPreview::GearPreview(const GearParams& g, int mate_teeth, int cols, int rows)
+    : canvas(cols, rows) {
+    if (cols <= 0 || rows <= 0) {
+        winsize ws{};
+        bool tty = ioctl(STDOUT_FILENO, TIOCGWINSZ, &ws) == 0 && ws.ws_col > 0 && ws.ws_row > 1;
+        canvas = BrailleCanvas(cols > 0 ? cols : tty ? ws.ws_col : 80, rows > 0 ? rows : tty ? ws.ws_row - 1 : 23);
+    }
+    GearCalculator calc;
+    gear = calc.calculate(g);
+    if (gear.n < 3 || !(gear.dp > 0)) throw std::runtime_error("Preview needs N >= 3 and DP or module");
+    if (!(gear.pa > 0.0 && gear.pa < 90.0)) throw std::runtime_error("Preview needs a pressure angle between 0 and 90 degrees");
+    outline1 = outline(gear.n, gear.pa, gear.x);
+    meshing = mate_teeth >= 3;
+
+    const double w = canvas.width(), h = canvas.height();
+    const double ra1 = gear.od / 2.0;
+    bore1 = 0.3 * gear.rd / 2.0;
+    if (!meshing) {
+        scale = 0.95 * std::min(w, h) / (2.0 * ra1);
+        center1 = {w / 2.0, h / 2.0};
+        return;
+    }
+
+    mate = GearParams::spec(mate_teeth, gear.dp, gear.pa, g.x);
+    mate = calc.calculate(mate);
+    outline2 = outline(mate.n, mate.pa, mate.x);
+    const double ra2 = mate.od / 2.0;
+    bore2 = 0.3 * mate.rd / 2.0;
+    const double cd = (gear.pd + mate.pd) / 2.0 + (gear.x + mate.x) / gear.dp;
+    const double span = ra1 + cd + ra2;
+    scale = 0.95 * std::min(w / span, h / (2.0 * std::max(ra1, ra2)));
+    center1 = {(w - span * scale) / 2.0 + ra1 * scale, h / 2.0};
+    center2 = {center1.x + cd * scale, h / 2.0};
+}
+
+void GearPreview::place(const std::vector<PreviewPoint>& unit, double angle, PreviewPoint center, double module,
+                        double bore, uint8_t layer) {
+    const double s = scale * module, c = std::cos(angle) * s, sn = std::sin(angle) * s;
+    contours.resize(2);
+    auto& body = contours[0];
+    body.resize(unit.size());
+    for (size_t i = 0; i < unit.size(); ++i) {
+        // Screen y points down
+        body[i] = {center.x + unit[i].x * c - unit[i].y * sn, center.y - (unit[i].x * sn + unit[i].y * c)};
+    }
+    auto& hole = contours[1];
+    const int steps = 24;
+    hole.resize(steps);
+    for (int k = 0; k < steps; ++k) {
+        double a = 2.0 * M_PI * k / steps;
+        hole[k] = {center.x + bore * scale * std::cos(a), center.y + bore * scale * std::sin(a)};
+    }
+    canvas.fill_polygon(contours, layer);
+}
+
+const std::string& GearPreview::frame(double angle, const std::string& status) {
+    canvas.clear();
+    place(*outline1, angle, center1, 1.0 / gear.dp, bore1, 0);
+    if (meshing) {
+        // A tooth space of the mate faces the gear's tooth at angle 0
+        double mate_angle = M_PI - M_PI / mate.n - angle * gear.n / mate.n;
+        place(*outline2, mate_angle, center2, 1.0 / mate.dp, bore2, 1);
+    }
+    // Synchronized update (terminals without it ignore the mode) and no clear: nothing to tear
+    buffer.assign("\033[?2026h\033[H");
+    canvas.render(buffer);
+    buffer += status;
+    buffer += "\033[K\033[?2026l";
+    return buffer;
+}
+
+double GearPreview::play(double fps, double seconds) {
+    RawInput input;
+    write_all(STDOUT_FILENO, "\033[?25l" + utils::CLEAR_SCREEN);
+
+    using clock = std::chrono::steady_clock;
+    const auto period = std::chrono::duration<double>(1.0 / std::max(fps, 1.0));
+    const double speed = 2.0 * M_PI / 10.0;  // One turn in 10 s
+    const auto start = clock::now();
+    std::string label = "N " + std::to_string(gear.n) + (meshing ? ":" + std::to_string(mate.n) : "") +
+                        "  DP " + number_to_string(gear.dp) + "  PA " + number_to_string(gear.pa);
+    bool watch_keys = true;
+    double achieved = 0.0;
+    for (long k = 0;; ++k) {
+        auto now = clock::now();
+        double elapsed = std::chrono::duration<double>(now - start).count();
+        if (seconds > 0.0 && elapsed >= seconds) break;
+        if (k > 0) achieved = k / elapsed;
+        write_all(STDOUT_FILENO, frame(speed * elapsed, label + "  " + number_to_string(achieved, 1) +
+                                                            " fps  (any key stops)"));
+
+        auto deadline = start + std::chrono::duration_cast<clock::duration>(period * (k + 1));
+        int wait_ms = static_cast<int>(std::chrono::duration_cast<std::chrono::milliseconds>(deadline - clock::now()).count());
+        if (!watch_keys) {
+            std::this_thread::sleep_until(deadline);
+            continue;
+        }
+        pollfd pfd{STDIN_FILENO, POLLIN, 0};
+        if (poll(&pfd, 1, std::max(wait_ms, 0)) > 0) {
+            if (pfd.revents & POLLIN) {
+                char c;
+                if (::read(STDIN_FILENO, &c, 1) == 1) break;
+            }
+            watch_keys = false;  // Closed or unreadable stdin: run for `seconds`
+            if (seconds <= 0.0) break;
+        }
+    }
+    write_all(STDOUT_FILENO, utils::COLOR_RESET + "\033[?25h\n");
+    return achieved;
+}
+
+}  // namespace gearforge
@@ -0,0 +1,279 @@
+#include "gear_rating.h"
+#include "number_format.h"
+#include "vector_math.h"
+
+namespace gearforge {
+
+namespace {
+
+constexpr double kShiftScale = 1e4;
+constexpr int64_t kShiftBias = int64_t(1) << 27;
+
+// DP of a row, from the module when only that is given
+double diametral_pitch(const GearParams& g) {
+    return std::isnan(g.dp) ? 25.4 / g.m : g.dp;
+}
+
+// Tooth form key: N, PA in hundredths of a degree, x in 1e-4; 0 for rows that can't be rated
+uint64_t form_key(const GearParams& g) {
+    double pa = std::round(g.pa * 100.0);
+    double x = std::round(g.x * kShiftScale);
+    if (g.n < 3 || g.n >= (1 << 20) || !(diametral_pitch(g) > 0.0) || !(pa > 0.0 && pa < 9000.0) ||
+        !(std::fabs(x) < kShiftBias)) {
+        return 0;
+    }
+    return (uint64_t(g.n) << 44) | (uint64_t(pa) << 28) | uint64_t(int64_t(x) + kShiftBias);
+}
+
+GeometryFactors form_factors(const GenerationOptions& options, uint64_t key) {
+    const int n = static_cast<int>(key >> 44);
+    const double pa = double((key >> 28) & 0xffff) / 100.0;
+    const double x = double(int64_t(key & 0xfffffff) - kShiftBias) / kShiftScale;
+
+    // Unit module: every length below is in modules
+    GearParams g = GearParams::spec(n, 1.0, pa, x);
+    GearParams p = GearCalculator().calculate(g);
+    GenerationResult gen = GearGenerator(options).simulate(g);
+    if (gen.radii.empty()) return GeometryFactors();
+
+    const double alpha = pa * M_PI / 180.0;
+    const double rb = gen.base_diameter / 2.0;
+    const double ra = gen.radii.back();
+    const double tip_angle = std::acos(std::min(1.0, rb / ra));
+    const double load_angle = tip_angle - std::max(0.0, gen.half_thickness.back());
+    const double load_radius = rb / std::cos(load_angle);  // Where the load line crosses the tooth center
+
+    // Lewis parabola: the weakest section below the load point
+    GeometryFactors f;
+    double section = NAN, height = NAN;
+    for (size_t j = 0; j < gen.radii.size(); ++j) {
+        double psi = gen.half_thickness[j];
+        if (!(psi > 0.0)) continue;
+        double t = 2.0 * gen.radii[j] * std::sin(psi);
+        double h = load_radius - gen.radii[j] * std::cos(psi);
+        if (h <= 0.0) continue;
+        double y = t * t * std::cos(alpha) / (6.0 * h * std::cos(load_angle));
+        if (!(y >= f.lewis_y)) {
+            f.lewis_y = y;
+            section = t;
+            height = h;
+        }
+    }
+
+    // Dolan-Broghamer stress concentration with the fillet the rack tip radius generates
+    const double dedendum = p.d;
+    const double rack_tip = std::max(0.0, (p.d + x - options.working_depth) / (1.0 - std::sin(alpha)));
+    const double b = dedendum - rack_tip;
+    const double fillet = rack_tip + b * b / (p.pd / 2.0 + b);
+    const double blend = std::clamp((pa - 14.5) / 5.5, 0.0, 1.0);  // 14.5 to 20 degree constants
+    const double H = 0.22 - 0.04 * blend, L = 0.20 - 0.05 * blend, M = 0.40 + 0.05 * blend;
+    double kf = H + std::pow(section / fillet, L) * std::pow(section / height, M);
+    f.j = f.lewis_y / kf;
+    f.contact = std::cos(alpha) * std::sin(alpha) / 2.0;
+    return f;
+}
+
+// What GearRater::rate's row loop needs from the conditions, with the
+// optional ones folded into plain coefficients
+struct RatingPass {
+    double rpm, power, load, st, sc, cp;
+    double kv_a, kv_b;         // Kv = ((kv_a + sqrt(V)) / kv_a)^kv_b
+    double face, face_per_dp;  // Face width: face + face_per_dp / DP
+    double mate, mate_self;    // Mate teeth: mate + mate_self * N
+};
+
+// Stresses and power for a block of rows. Every column is its own array and
+// __restrict says so; otherwise GCC would have to check each pair of the
+// eleven streams for overlap at run time, and it gives up past ten pairs.
+// With pow from vector_math.h and no per-row branches the loop vectorizes.
+void rate_rows(const RatingPass& k, size_t rows, const double* __restrict teeth, const double* __restrict dp,
+               const double* __restrict contact, const double* __restrict y, const double* __restrict j,
+               double* __restrict geo_i, double* __restrict sb, double* __restrict sh, double* __restrict pb,
+               double* __restrict ph, double* __restrict rated) {
+    for (size_t i = 0; i < rows; ++i) {
+        double d = teeth[i] / dp[i];
+        double face = k.face + k.face_per_dp / dp[i];
+        double v = M_PI * d * k.rpm / 12.0;  // Pitch line velocity, ft/min
+        double wt = 33000.0 * k.power / v;
+        double kv = vec_pow((k.kv_a + std::sqrt(v)) / k.kv_a, k.kv_b);
+        double ks = std::max(1.0, 1.192 * vec_pow(face * std::sqrt(y[i]) / dp[i], 0.0535));
+
+        // The smaller gear of the mesh is the pinion
+        double other = k.mate + k.mate_self * teeth[i];
+        double small = std::min(teeth[i], other);
+        double ratio = std::max(teeth[i], other) / small;
+        double pinion_d = small / dp[i];
+        double geometry_i = contact[i] * ratio / (ratio + 1.0);
+        geo_i[i] = geometry_i;
+
+        double w = wt * k.load * kv * ks;
+        double bending = w * dp[i] / (face * j[i]);
+        double hertz = k.cp * std::sqrt(w / (pinion_d * face * geometry_i));
+        double q = k.sc / hertz;
+        sb[i] = bending;
+        sh[i] = hertz;
+        pb[i] = k.power * k.st / bending;
+        ph[i] = k.power * q * q;
+        rated[i] = std::min(pb[i], ph[i]);
+    }
+}
+
+}  // unnamed namespace
+
+GearMaterial GearMaterial::steel(double brinell) {
+    GearMaterial m;
+    m.name = "steel:" + number_to_string(brinell, 0);
+    m.bending_allowable = 77.3 * brinell + 12800.0;
+    m.contact_allowable = 322.0 * brinell + 29100.0;
+    m.elastic_coefficient = 2300.0;
+    return m;
+}
+
+GearMaterial GearMaterial::cast_iron() {
+    GearMaterial m;
+    m.name = "cast-iron";
+    m.bending_allowable = 8500.0;   // Class 30
+    m.contact_allowable = 65000.0;
+    m.elastic_coefficient = 1960.0;
+    return m;
+}
+
+GearMaterial GearMaterial::bronze() {
+    GearMaterial m;
+    m.name = "bronze";
+    m.bending_allowable = 5700.0;   // Tin bronze
+    m.contact_allowable = 30000.0;
+    m.elastic_coefficient = 1650.0;
+    return m;
+}
+
+GearMaterial GearMaterial::parse(const std::string& spec) {
+    std::string s = utils::to_lower(utils::trim(spec));
+    if (s == "steel") return steel(250.0);
+    if (s.rfind("steel:", 0) == 0) {
+        double hb = utils::safe_stod(s.substr(6));
+        if (!(hb >= 100.0 && hb <= 700.0)) throw std::runtime_error("Steel hardness out of range: " + spec);
+        return steel(hb);
+    }
+    if (s == "cast-iron" || s == "castiron" || s == "ci") return cast_iron();
+    if (s == "bronze") return bronze();
+    throw std::runtime_error("Unknown gear material: " + spec);
+}
+
+void RatingColumns::resize(size_t n) {
+    for (auto* c : {&lewis_y, &geometry_j, &geometry_i, &bending_stress, &contact_stress, &bending_power,
+                    &contact_power, &rated_power}) {
+        c->resize(n);
+    }
+}
+
+std::vector<size_t> RatingColumns::at_least(double power) const {
+    std::vector<size_t> rows;
+    for (size_t i = 0; i < rated_power.size(); ++i) {
+        if (rated_power[i] >= power) rows.push_back(i);
+    }
+    return rows;
+}
+
+GeometryFactors GearRater::geometry(int n, double pa, double x) const {
+    uint64_t key = form_key(GearParams::spec(n, 1.0, pa, x));
+    if (key == 0) return GeometryFactors();
+    {
+        std::lock_guard<std::mutex> lock(cache_mutex);
+        auto it = cache.find(key);
+        if (it != cache.end()) return it->second;
+    }
+    GeometryFactors f = form_factors(generation, key);
+    std::lock_guard<std::mutex> lock(cache_mutex);
+    cache.emplace(key, f);
+    return f;
+}
+
+size_t GearRater::cached_forms() const {
+    std::lock_guard<std::mutex> lock(cache_mutex);
+    return cache.size();
+}
+
+RatingColumns GearRater::rate(const std::vector<GearParams>& gears, unsigned threads) const {
+    const size_t count = gears.size();
+
+    // Distinct tooth forms of the batch; catalogs are mostly sorted, so runs share a lookup
+    std::vector<uint32_t> slot(count);
+    std::vector<uint64_t> keys{0};
+    std::unordered_map<uint64_t, uint32_t> slots{{0, 0}};
+    uint64_t last_key = 0;
+    uint32_t last_slot = 0;
+    for (size_t i = 0; i < count; ++i) {
+        uint64_t key = form_key(gears[i]);
+        if (key != last_key) {
+            auto it = slots.emplace(key, static_cast<uint32_t>(keys.size())).first;
+            if (it->second == keys.size()) keys.push_back(key);
+            last_key = key;
+            last_slot = it->second;
+        }
+        slot[i] = last_slot;
+    }
+
+    // Cached forms first, the rest generated in parallel
+    std::vector<GeometryFactors> forms(keys.size());
+    std::vector<size_t> missing;
+    {
+        std::lock_guard<std::mutex> lock(cache_mutex);
+        for (size_t k = 1; k < keys.size(); ++k) {
+            auto it = cache.find(keys[k]);
+            if (it != cache.end()) forms[k] = it->second;
+            else missing.push_back(k);
+        }
+    }
+    utils::parallel_for(missing.size(), [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) forms[missing[i]] = form_factors(generation, keys[missing[i]]);
+    }, threads);
+    {
+        std::lock_guard<std::mutex> lock(cache_mutex);
+        for (size_t k : missing) cache.emplace(keys[k], forms[k]);
+    }
+
+    // Invariants of the row loop; the optional face width and mate become coefficients
+    const RatingConditions& c = conditions;
+    const double qv = std::clamp(c.quality, 5, 11);
+    RatingPass pass;
+    pass.rpm = c.rpm;
+    pass.power = c.power;
+    pass.load = c.overload * c.load_distribution;
+    pass.st = c.material.bending_allowable / c.bending_safety;
+    pass.sc = c.material.contact_allowable / c.contact_safety;
+    pass.cp = c.material.elastic_coefficient;
+    pass.kv_b = 0.25 * std::pow(12.0 - qv, 2.0 / 3.0);
+    pass.kv_a = 50.0 + 56.0 * (1.0 - pass.kv_b);
+    const bool default_face = std::isnan(c.face_width);
+    pass.face = default_face ? 0.0 : c.face_width;
+    pass.face_per_dp = default_face ? 10.0 : 0.0;
+    pass.mate = c.mate_teeth > 0 ? c.mate_teeth : 0.0;
+    pass.mate_self = c.mate_teeth > 0 ? 0.0 : 1.0;
+
+    RatingColumns out;
+    out.resize(count);
+    utils::parallel_for(count, [&](size_t begin, size_t end) {
+        const size_t rows = end - begin;
+        std::vector<double> teeth(rows), dp(rows), contact(rows);
+        double* y = out.lewis_y.data() + begin;
+        double* j = out.geometry_j.data() + begin;
+        for (size_t i = 0; i < rows; ++i) {
+            const GearParams& g = gears[begin + i];
+            const GeometryFactors& f = forms[slot[begin + i]];
+            teeth[i] = g.n;
+            dp[i] = diametral_pitch(g);
+            y[i] = f.lewis_y;
+            j[i] = f.j;
+            contact[i] = f.contact;
+        }
+
+        rate_rows(pass, rows, teeth.data(), dp.data(), contact.data(), y, j, out.geometry_i.data() + begin,
+                  out.bending_stress.data() + begin, out.contact_stress.data() + begin,
+                  out.bending_power.data() + begin, out.contact_power.data() + begin,
+                  out.rated_power.data() + begin);
+    }, threads);
+    return out;
+}
+
+}  // namespace gearforge
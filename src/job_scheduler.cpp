@@ -0,0 +1,284 @@
+#include "job_scheduler.h"
+
+namespace gearforge {
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+// What a job needs mounted, and how long it runs
+struct JobSetup {
+    int cutter;
+    double dp, pa;
+    int arbor;
+    int plate;          // Plate number; differential indexing is keyed by tooth count
+    int group;          // Same cutter, DP and PA
+    int machine;        // -1: any
+    double minutes;
+    double due;         // Minutes
+};
+
+class Planner {
+private:
+    const ScheduleOptions& o;
+    const std::vector<JobSetup>& jobs;
+
+public:
+    Planner(const ScheduleOptions& o, const std::vector<JobSetup>& jobs) : o(o), jobs(jobs) {}
+
+    // Setup minutes between consecutive jobs; prev < 0 is an empty machine
+    double setup(int prev, int next) const {
+        const JobSetup& b = jobs[next];
+        if (prev < 0) return o.cutter_change + o.arbor_change + (b.plate != 0 ? o.plate_change : 0.0);
+        const JobSetup& a = jobs[prev];
+        double t = 0.0;
+        if (a.group != b.group) t += o.cutter_change;
+        if (a.arbor != b.arbor) t += o.arbor_change;
+        if (a.plate != b.plate && b.plate != 0) t += o.plate_change;
+        return t;
+    }
+
+    double cost(const std::vector<int>& seq) const {
+        double t = 0.0, c = 0.0;
+        int prev = -1;
+        for (int j : seq) {
+            double s = setup(prev, j);
+            t += s + jobs[j].minutes;
+            c += s + o.tardiness_weight * std::max(0.0, t - jobs[j].due);
+            prev = j;
+        }
+        return c;
+    }
+
+    bool allowed(int job, size_t machine) const {
+        return jobs[job].machine < 0 || jobs[job].machine == static_cast<int>(machine);
+    }
+};
+
+}  // unnamed namespace
+
+IndexPlate JobScheduler::dividing_plate(int teeth) {
+    static const int plates[3][6] = {{15, 16, 17, 18, 19, 20}, {21, 23, 27, 29, 31, 33}, {37, 39, 41, 43, 47, 49}};
+    IndexPlate r;
+    if (teeth < 1) return r;
+    r.turns = 40 / teeth;
+    int rem = 40 % teeth;
+    if (rem == 0) return r;
+    int g = std::gcd(rem, teeth);
+    int num = rem / g, den = teeth / g;
+    for (int p = 0; p < 3; ++p) {
+        for (int circle : plates[p]) {
+            if (circle % den == 0) {
+                r.plate = p + 1;
+                r.circle = circle;
+                r.holes = num * circle / den;
+                return r;
+            }
+        }
+    }
+    r.plate = -1;
+    return r;
+}
+
+int JobScheduler::arbor(double dp) {
+    if (dp <= 4.0) return 1;
+    if (dp <= 10.0) return 2;
+    return 3;
+}
+
+SchedulePlan JobScheduler::schedule(const std::vector<CutJob>& input) const {
+    auto start_time = Clock::now();
+    SchedulePlan plan;
+
+    // Machines: as given, else the ones the jobs name
+    std::vector<std::string> machines = options.machines;
+    auto names_any = [](const std::string& m) { return m.empty() || utils::to_lower(m) == "any"; };
+    if (machines.empty()) {
+        for (const auto& job : input) {
+            if (!names_any(job.machine) && std::find(machines.begin(), machines.end(), job.machine) == machines.end()) {
+                machines.push_back(job.machine);
+            }
+        }
+        if (machines.empty()) machines.push_back("M1");
+    }
+
+    GearCalculator calc;
+    std::map<std::tuple<int, double, double>, int> groups;
+    std::vector<JobSetup> jobs;
+    jobs.reserve(input.size());
+    for (const auto& job : input) {
+        if (job.teeth < 1 || !(job.dp > 0.0) || job.quantity < 1) {
+            throw std::runtime_error("Invalid job " + job.id + ": needs teeth, DP and a quantity above zero");
+        }
+        JobSetup s;
+        s.cutter = calc.select_cutter(job.teeth);
+        s.dp = job.dp;
+        s.pa = job.pa;
+        s.arbor = arbor(job.dp);
+        IndexPlate plate = dividing_plate(job.teeth);
+        s.plate = plate.plate >= 0 ? plate.plate : 1000 + job.teeth;
+        s.group = groups.emplace(std::make_tuple(s.cutter, s.dp, s.pa), static_cast<int>(groups.size())).first->second;
+        s.machine = -1;
+        if (!names_any(job.machine)) {
+            auto it = std::find(machines.begin(), machines.end(), job.machine);
+            if (it == machines.end()) throw std::runtime_error("Job " + job.id + " needs unknown machine " + job.machine);
+            s.machine = static_cast<int>(it - machines.begin());
+        }
+        s.minutes = job.quantity * (options.load_minutes + job.teeth * options.minutes_per_tooth * 10.0 / job.dp);
+        s.due = job.due * 60.0;
+        jobs.push_back(s);
+    }
+    Planner planner(options, jobs);
+    const size_t m_count = machines.size();
+    std::vector<std::vector<int>> seq(m_count);
+
+    // Greedy: groups earliest-due first, each job onto the machine that finishes it soonest
+    std::vector<int> order(jobs.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::vector<double> group_due(groups.size(), std::numeric_limits<double>::infinity());
+    for (const auto& j : jobs) group_due[j.group] = std::min(group_due[j.group], j.due);
+    std::stable_sort(order.begin(), order.end(), [&](int a, int b) {
+        const JobSetup& x = jobs[a];
+        const JobSetup& y = jobs[b];
+        if (group_due[x.group] != group_due[y.group]) return group_due[x.group] < group_due[y.group];
+        if (x.group != y.group) return x.group < y.group;
+        if (x.plate != y.plate) return x.plate < y.plate;
+        return x.due < y.due;
+    });
+    std::vector<double> finish(m_count, 0.0);
+    for (int j : order) {
+        size_t best = m_count;
+        double best_end = 0.0;
+        for (size_t m = 0; m < m_count; ++m) {
+            if (!planner.allowed(j, m)) continue;
+            double end = finish[m] + planner.setup(seq[m].empty() ? -1 : seq[m].back(), j) + jobs[j].minutes;
+            if (best == m_count || end < best_end) {
+                best = m;
+                best_end = end;
+            }
+        }
+        seq[best].push_back(j);
+        finish[best] = best_end;
+    }
+
+    std::vector<double> cost(m_count);
+    for (size_t m = 0; m < m_count; ++m) cost[m] = planner.cost(seq[m]);
+    plan.initial_cost = std::accumulate(cost.begin(), cost.end(), 0.0);
+
+    // Local search: random moves, kept when the cost doesn't rise
+    std::mt19937_64 rng(options.seed);
+    auto pick = [&rng](size_t n) { return static_cast<size_t>(rng() % n); };
+    std::vector<std::pair<size_t, size_t>> where(jobs.size());  // job -> (machine, position), refreshed on demand
+    auto locate = [&]() {
+        for (size_t m = 0; m < m_count; ++m) {
+            for (size_t i = 0; i < seq[m].size(); ++i) where[seq[m][i]] = {m, i};
+        }
+    };
+    std::vector<int> saved_a, saved_b;
+    size_t iter = 0;
+    for (; iter < options.max_iterations && jobs.size() > 1; ++iter) {
+        if ((iter & 255) == 0 && Clock::now() - start_time >= options.budget) break;
+        locate();
+        int job = static_cast<int>(pick(jobs.size()));
+        size_t a = where[job].first, i = where[job].second;
+        int move = static_cast<int>(pick(4));
+
+        // Block: the run of same-group jobs around i (moves 2 and 3), else just the job
+        size_t lo = i, hi = i + 1;
+        if (move >= 2) {
+            while (lo > 0 && jobs[seq[a][lo - 1]].group == jobs[job].group) --lo;
+            while (hi < seq[a].size() && jobs[seq[a][hi]].group == jobs[job].group) ++hi;
+        }
+
+        size_t b;
+        size_t k;
+        if (move == 1) {
+            // Swap with another job
+            int other = static_cast<int>(pick(jobs.size()));
+            if (other == job) continue;
+            b = where[other].first;
+            k = where[other].second;
+            if (!planner.allowed(job, b) || !planner.allowed(other, a)) continue;
+            saved_a = seq[a];
+            saved_b = seq[b];
+            std::swap(seq[a][i], seq[b][k]);
+        } else {
+            std::vector<int> block(seq[a].begin() + lo, seq[a].begin() + hi);
+            if (move == 3) {
+                // Next to a job of the same group elsewhere
+                int mate = static_cast<int>(pick(jobs.size()));
+                if (jobs[mate].group != jobs[job].group || (where[mate].first == a && where[mate].second >= lo &&
+                                                            where[mate].second < hi)) {
+                    continue;
+                }
+                b = where[mate].first;
+                k = where[mate].second + 1;
+            } else {
+                b = pick(m_count);
+                k = pick(seq[b].size() + 1);
+            }
+            bool ok = true;
+            for (int j : block) ok = ok && planner.allowed(j, b);
+            if (!ok) continue;
+            saved_a = seq[a];
+            saved_b = seq[b];
+            seq[a].erase(seq[a].begin() + lo, seq[a].begin() + hi);
+            if (b == a && k > lo) k -= std::min(k, hi) - lo;
+            seq[b].insert(seq[b].begin() + std::min(k, seq[b].size()), block.begin(), block.end());
+        }
+
+        double new_a = planner.cost(seq[a]);
+        double new_b = b == a ? new_a : planner.cost(seq[b]);
+        double delta = new_a - cost[a] + (b == a ? 0.0 : new_b - cost[b]);
+        if (delta <= 1e-9) {
+            cost[a] = new_a;
+            cost[b] = new_b;
+        } else {
+            seq[a] = saved_a;
+            if (b != a) seq[b] = saved_b;
+        }
+    }
+    plan.iterations = iter;
+
+    // Report
+    for (size_t m = 0; m < m_count; ++m) {
+        MachinePlan mp;
+        mp.machine = machines[m];
+        double t = 0.0;
+        int prev = -1;
+        for (int j : seq[m]) {
+            ScheduledJob sj;
+            sj.job = static_cast<size_t>(j);
+            sj.setup = planner.setup(prev, j);
+            const JobSetup& s = jobs[j];
+            std::vector<std::string> changes;
+            if (prev < 0 || jobs[prev].group != s.group) {
+                changes.push_back("cutter " + std::to_string(s.cutter) + " " + number_to_string(s.dp) + "DP " +
+                                  number_to_string(s.pa) + "PA");
+            }
+            if (prev < 0 || jobs[prev].arbor != s.arbor) changes.push_back("arbor " + std::to_string(s.arbor));
+            if (s.plate != 0 && (prev < 0 || jobs[prev].plate != s.plate)) {
+                changes.push_back(s.plate < 1000 ? "plate " + std::to_string(s.plate) : "differential");
+            }
+            for (size_t c = 0; c < changes.size(); ++c) sj.changes += (c ? "; " : "") + changes[c];
+            t += sj.setup;
+            sj.start = t;
+            t += s.minutes;
+            sj.end = t;
+            sj.lateness = std::max(0.0, t - s.due);
+            mp.setup += sj.setup;
+            plan.tardiness += sj.lateness;
+            if (sj.lateness > 0.0) ++plan.late_jobs;
+            mp.jobs.push_back(sj);
+            prev = j;
+        }
+        mp.finish = t;
+        plan.setup += mp.setup;
+        plan.makespan = std::max(plan.makespan, t);
+        plan.machines.push_back(std::move(mp));
+    }
+    plan.cost = plan.setup + options.tardiness_weight * plan.tardiness;
+    return plan;
+}
+
+}  // namespace gearforge
@@ -0,0 +1,138 @@
+#include "list_view.h"
+
+namespace gearforge {
+
+namespace {
+
+const char* const kClearLine = "\033[2K";
+
+void pad_cell(std::string& out, const std::string& text, size_t width) {
+    if (text.size() >= width) {
+        out.append(text, 0, width);
+    } else {
+        out.append(width - text.size(), ' ');  // Right-aligned: tables here are numeric
+        out += text;
+    }
+    out += ' ';
+}
+
+}  // unnamed namespace
+
+ListView::ListView(std::vector<ListColumn> cols, size_t rows, size_t height)
+    : columns(std::move(cols)), rows(rows), height(std::max<size_t>(1, height)), permutations(columns.size()) {}
+
+size_t ListView::row_at(size_t pos) const {
+    if (sort_column < 0) return pos;
+    const auto& perm = permutations[sort_column];
+    return descending ? perm[rows - 1 - pos] : perm[pos];
+}
+
+void ListView::follow_cursor() {
+    if (cursor < top) top = cursor;
+    if (cursor >= top + height) top = cursor - height + 1;
+    // Keep the cache bounded to a few viewports' worth of rows
+    if (line_cache.size() > 8 * height) line_cache.clear();
+}
+
+void ListView::move(long delta) {
+    if (rows == 0) return;
+    long target = static_cast<long>(cursor) + delta;
+    cursor = static_cast<size_t>(std::max(0L, std::min(target, static_cast<long>(rows) - 1)));
+    follow_cursor();
+}
+
+void ListView::page(long pages) {
+    if (rows == 0) return;
+    long step = pages * static_cast<long>(height);
+    long new_top = std::max(0L, std::min(static_cast<long>(top) + step, static_cast<long>(rows > height ? rows - height : 0)));
+    long new_cursor = std::max(0L, std::min(static_cast<long>(cursor) + step, static_cast<long>(rows) - 1));
+    top = static_cast<size_t>(new_top);
+    cursor = static_cast<size_t>(new_cursor);
+    follow_cursor();
+}
+
+void ListView::jump(size_t pos) {
+    if (rows == 0) return;
+    cursor = std::min(pos, rows - 1);
+    follow_cursor();
+}
+
+void ListView::sort_by(int column) {
+    if (column < 0 || column >= static_cast<int>(columns.size()) || !columns[column].sort_key) return;
+    if (column == sort_column) {
+        descending = !descending;
+    } else {
+        sort_column = column;
+        descending = false;
+        auto& perm = permutations[column];
+        if (perm.empty() && rows > 0) {
+            // Sort (key, row) pairs so comparisons never call back into the data
+            std::vector<std::pair<double, uint32_t>> keyed(rows);
+            for (size_t r = 0; r < rows; ++r) {
+                double k = columns[column].sort_key(r);
+                keyed[r] = {std::isnan(k) ? std::numeric_limits<double>::infinity() : k, static_cast<uint32_t>(r)};
+            }
+            std::sort(keyed.begin(), keyed.end());
+            perm.resize(rows);
+            for (size_t r = 0; r < rows; ++r) perm[r] = keyed[r].second;
+        }
+    }
+    // The selection stays at the same position; the rows under it change
+    follow_cursor();
+}
+
+const std::string& ListView::line_for(size_t row) const {
+    auto it = line_cache.find(row);
+    if (it != line_cache.end()) return it->second;
+    std::string line;
+    for (const auto& col : columns) pad_cell(line, col.format ? col.format(row) : "", col.width);
+    return line_cache.emplace(row, std::move(line)).first->second;
+}
+
+std::string ListView::render() const {
+    std::string out = "\033[H";  // Home; every line below is cleared as it is rewritten
+    out += kClearLine;
+    out += utils::COLOR_BLUE;
+    for (size_t c = 0; c < columns.size(); ++c) {
+        std::string title = columns[c].title;
+        if (static_cast<int>(c) == sort_column) title += descending ? "v" : "^";
+        pad_cell(out, title, columns[c].width);
+    }
+    out += utils::COLOR_RESET;
+    out += '\n';
+
+    for (size_t i = 0; i < height; ++i) {
+        size_t pos = top + i;
+        out += kClearLine;
+        if (pos < rows) {
+            if (pos == cursor) out += utils::INVERSE_ON;
+            out += line_for(row_at(pos));
+            if (pos == cursor) out += utils::INVERSE_OFF;
+        }
+        out += '\n';
+    }
+
+    out += kClearLine;
+    out += "Row " + std::to_string(rows ? cursor + 1 : 0) + " of " + std::to_string(rows) +
+           "  w/s: move  a/d: page  g/b: top/bottom  1-" + std::to_string(std::min<size_t>(columns.size(), 9)) +
+           ": sort  Enter: select  q: back\n";
+    return out;
+}
+
+bool ListView::handle_key(char key) {
+    switch (key) {
+        case 'w': case 'i': move(-1); return true;
+        case 's': case 'k': move(1); return true;
+        case 'a': case 'j': page(-1); return true;
+        case 'd': case 'l': page(1); return true;
+        case 'g': jump(0); return true;
+        case 'b': jump_end(); return true;
+    }
+    if (key >= '1' && key <= '9') {
+        sort_by(key - '1');
+        return true;
+    }
+    return false;
+}
+
+}  // namespace gearforge
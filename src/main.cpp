@@ -7,32 +7,646 @@
 #include <glog/logging.h>
 #include <gtest/gtest.h>
 
+#include "async_log.h"
+#include "catalog_ops.h"
+#include "design_sweep.h"
+#include "change_gears.h"
 #include "gear_calculator.h"
+#include "gear_generation.h"
+#include "gear_identify.h"
+#include "gear_preview.h"
+#include "gear_rating.h"
+#include "job_scheduler.h"
+#include "mem_stats.h"
+#include "mesh_simulation.h"
+#include "planetary.h"
+#include "profile_shift.h"
+#include "tolerance_analysis.h"
 #include "ui.h"
 #include "user_manager.h"
 #include "settings_manager.h"
 #include "utils.h"
+#include "watched_catalog.h"
 
 using namespace gearforge;
 
+// Comma-separated fields of a flag value, trimmed
+static std::vector<std::string> split_fields(const std::string& spec) {
+    std::vector<std::string> parts;
+    std::stringstream ss(spec);
+    std::string part;
+    while (std::getline(ss, part, ',')) parts.push_back(utils::trim(part));
+    return parts;
+}
+
+static bool has_field(const std::vector<std::string>& parts, size_t i) {
+    return i < parts.size() && !utils::trim(parts[i]).empty();
+}
+
+// Field i as a number, or fallback when it is missing or blank; throws on anything else
+static double optional_field(const std::vector<std::string>& parts, size_t i, double fallback) {
+    return has_field(parts, i) ? utils::safe_stod(parts[i]) : fallback;
+}
+
+// Field i as a count (a whole number in [0, INT_MAX]), or fallback when it is
+// missing or blank; throws on anything else, so NaN never reaches the cast
+static int count_field(const std::vector<std::string>& parts, size_t i, int fallback) {
+    if (!has_field(parts, i)) return fallback;
+    double v = utils::safe_stod(parts[i]);
+    if (!(std::isfinite(v) && v == std::floor(v) && v >= 0 && v <= std::numeric_limits<int>::max())) {
+        throw std::runtime_error("Invalid count: " + utils::trim(parts[i]));
+    }
+    return static_cast<int>(v);
+}
+
+// Batch undercut/interference screening of a catalog, CSV to stdout
+static int run_screen(const std::string& filename) {
+    GearCalculator calc;
+    auto gears = calc.load_known(filename);
+    if (gears.empty()) {
+        std::cerr << "No gears loaded from " << filename << std::endl;
+        return 1;
+    }
+    GearGenerator generator;
+    auto results = generator.screen(gears);
+    std::cout << "N,DP,PA,Undercut,UndercutDepth,FormDiameter,MinProfileShift,PointedTip" << std::endl;
+    for (size_t i = 0; i < gears.size(); ++i) {
+        const auto& r = results[i];
+        std::cout << gears[i].n << "," << gears[i].dp << "," << gears[i].pa << ","
+                  << (r.undercut ? "yes" : "no") << "," << r.undercut_depth << ","
+                  << r.form_diameter << "," << r.min_profile_shift << ","
+                  << (r.pointed_tip ? "yes" : "no") << std::endl;
+    }
+    return 0;
+}
+
+// Recalculate a catalog in one precision policy and save it; the load,
+// calculation and formatting all run in T
+template <typename T>
+static size_t solve_catalog(const std::string& in, const std::string& out) {
+    BasicGearCalculator<T> calc;
+    auto gears = calc.calculate(calc.load_known(in));
+    if (!gears.empty() && !calc.save(gears, out)) throw std::runtime_error("Cannot write " + out);
+    return gears.size();
+}
+
+// "catalog.csv,out.csv[,float|double|fixed]"
+static int run_solve(const std::string& spec) {
+    auto parts = split_fields(spec);
+    std::string policy = has_field(parts, 2) ? parts[2] : "double";
+    if (parts.size() < 2 || parts.size() > 3 || parts[0].empty() || parts[1].empty() ||
+        (policy != "float" && policy != "double" && policy != "fixed")) {
+        std::cerr << "Invalid --solve=" << spec << std::endl
+                  << "Usage: --solve=<catalog.csv>,<out.csv>[,float|double|fixed]" << std::endl;
+        return 1;
+    }
+    size_t rows = policy == "float"   ? solve_catalog<float>(parts[0], parts[1])
+                  : policy == "fixed" ? solve_catalog<Fixed>(parts[0], parts[1])
+                                      : solve_catalog<double>(parts[0], parts[1]);
+    if (rows == 0) {
+        std::cerr << "No gears loaded from " << parts[0] << std::endl;
+        return 1;
+    }
+    std::cerr << rows << " gears calculated in " << policy << std::endl;
+    return 0;
+}
+
+// "catalog merge|intersect|dedup|diff A.csv [B.csv] [--out=file] [--memory-mb=N] [--spill-dir=dir]"
+static int run_catalog(int argc, char** argv) {
+    const char* usage = "Usage: gearforge catalog merge|intersect|dedup|diff <a.csv> [<b.csv>] "
+                        "[--out=file.csv] [--memory-mb=N] [--spill-dir=dir]";
+    CatalogOp op;
+    if (argc < 4 || !CatalogTool::parse_op(argv[2], op)) {
+        std::cerr << usage << std::endl;
+        return 1;
+    }
+    CatalogOptions options;
+    std::vector<std::string> inputs;
+    std::string out_path;
+    for (int i = 3; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg.find("--out=") == 0) {
+            out_path = arg.substr(6);
+        } else if (arg.find("--memory-mb=") == 0) {
+            options.memory_limit = static_cast<size_t>(utils::safe_stod(arg.substr(12)) * (1 << 20));
+        } else if (arg.find("--spill-dir=") == 0) {
+            options.spill_dir = arg.substr(12);
+        } else if (arg.find("--") != 0) {
+            inputs.push_back(arg);
+        }
+    }
+    if (inputs.size() != (op == CatalogOp::Dedup ? 1u : 2u)) {
+        std::cerr << usage << std::endl;
+        return 1;
+    }
+
+    std::ofstream file;
+    if (!out_path.empty()) {
+        file.open(out_path);
+        if (!file) {
+            std::cerr << "Cannot write " << out_path << std::endl;
+            return 1;
+        }
+    }
+    std::ostream& out = out_path.empty() ? std::cout : file;
+    CatalogStats stats = CatalogTool(options).run(op, inputs[0], inputs.size() > 1 ? inputs[1] : "", out);
+    LOG(INFO) << "catalog " << argv[2] << ": " << stats.rows_a << " + " << stats.rows_b << " rows in, "
+              << stats.rows_out << " out, " << stats.skipped << " skipped, " << stats.partitions << " partitions"
+              << (stats.spilled ? " (spilled)" : "");
+    if (stats.skipped > 0) std::cerr << stats.skipped << " unparseable rows skipped" << std::endl;
+    return 0;
+}
+
+// Reverse identification from measurements: "N,OD[,RD[,span,k]]" (blank fields skipped)
+static int run_identify(const std::string& spec) {
+    auto parts = split_fields(spec);
+    const char* usage = "Usage: --identify=<N>,<OD>[,<RD>[,<span>,<teeth spanned>]]";
+    if (parts.size() < 2) {
+        std::cerr << usage << std::endl;
+        return 1;
+    }
+    GearMeasurement m;
+    try {
+        m.n = count_field(parts, 0, 0);
+        m.span_teeth = count_field(parts, 4, 0);
+        m.od = optional_field(parts, 1, NAN);
+        m.rd = optional_field(parts, 2, NAN);
+        m.span = optional_field(parts, 3, NAN);
+    } catch (const std::exception&) {
+        m.n = 0;  // Bad numbers get the usage line below
+    }
+    if (m.n < 1) {
+        std::cerr << "Invalid --identify=" << spec << std::endl << usage << std::endl;
+        return 1;
+    }
+
+    GearIdentifier identifier(WatchedCatalog("data/known_values.csv").snapshot()->rows());
+    auto candidates = identifier.identify(m);
+    std::cout << "Candidate,Score,OD residual,RD residual,Span residual,DP,M,PA,OD,RD" << std::endl;
+    for (const auto& c : candidates) {
+        std::cout << '"' << c.source << "\"," << c.score << "," << c.od_residual << "," << c.rd_residual << ","
+                  << c.span_residual << "," << c.params.dp << "," << c.params.m << "," << c.params.pa << ","
+                  << c.params.od << "," << c.params.rd << std::endl;
+    }
+    return 0;
+}
+
+// One mesh design from "N1,N2,DP[,PA[,x1,x2[,tip relief[,load]]]]" fields (blank fields take defaults)
+static MeshDesign parse_mesh_design(const std::vector<std::string>& parts) {
+    double dp = optional_field(parts, 2, NAN), pa = optional_field(parts, 3, 20.0);
+    MeshDesign d;
+    d.pinion.params = GearParams::spec(count_field(parts, 0, 0), dp, pa, optional_field(parts, 4, 0.0));
+    d.gear.params = GearParams::spec(count_field(parts, 1, 0), dp, pa, optional_field(parts, 5, 0.0));
+    d.pinion.tip_relief = d.gear.tip_relief = optional_field(parts, 6, 0.0);
+    d.load = optional_field(parts, 7, 0.0);
+    return d;
+}
+
+static void print_mesh_summary(std::ostream& out, const MeshResult& r) {
+    out << "Center distance: " << r.center_distance << ", working PA: " << r.working_pressure_angle
+        << ", contact ratio: " << r.contact_ratio << std::endl;
+    out << "TE peak-to-peak: " << r.te_peak_to_peak << " unloaded, " << r.loaded_te_peak_to_peak << " loaded" << std::endl;
+    out << "Mesh stiffness: mean " << r.mean_stiffness << ", min " << r.min_stiffness << ", max " << r.max_stiffness << std::endl;
+}
+
+// Transmission error over one mesh cycle: curve as CSV to stdout, summary to stderr
+static int run_mesh(const std::string& spec) {
+    auto parts = split_fields(spec);
+    if (parts.size() < 3) {
+        std::cerr << "Usage: --mesh=<pinion teeth>,<gear teeth>,<DP>[,<PA>[,<x1>,<x2>[,<tip relief>[,<load>]]]]" << std::endl;
+        return 1;
+    }
+    MeshOptions options;
+    options.steps_per_pitch = 256;
+    MeshResult r = MeshSimulator(options).simulate(parse_mesh_design(parts));
+    std::cout << "Angle,TE,LoadedTE,Stiffness,Pairs" << std::endl;
+    for (const auto& s : r.samples) {
+        std::cout << s.angle * 180.0 / M_PI << "," << s.te << "," << s.loaded_te << "," << s.stiffness << ","
+                  << s.pairs << std::endl;
+    }
+    print_mesh_summary(std::cerr, r);
+    return 0;
+}
+
+// Design variants from a CSV (N1,N2,DP,PA,x1,x2,TipRelief,Load per row), one summary row each
+static int run_mesh_batch(const std::string& filename) {
+    auto rows = utils::read_csv(filename);
+    if (rows.size() < 2) {
+        std::cerr << "No designs loaded from " << filename << std::endl;
+        return 1;
+    }
+    std::vector<MeshDesign> designs;
+    for (size_t i = 1; i < rows.size(); ++i) designs.push_back(parse_mesh_design(rows[i]));  // Skip header
+    auto results = MeshSimulator().batch(designs);
+    std::cout << "N1,N2,DP,PA,x1,x2,TipRelief,Load,CenterDistance,ContactRatio,TE,LoadedTE,MeanStiffness,StiffnessVariation" << std::endl;
+    for (size_t i = 0; i < designs.size(); ++i) {
+        const auto& d = designs[i];
+        const auto& r = results[i];
+        std::cout << d.pinion.params.n << "," << d.gear.params.n << "," << d.pinion.params.dp << ","
+                  << d.pinion.params.pa << "," << d.pinion.params.x << "," << d.gear.params.x << ","
+                  << d.pinion.tip_relief << "," << d.load << "," << r.center_distance << "," << r.contact_ratio << ","
+                  << r.te_peak_to_peak << "," << r.loaded_te_peak_to_peak << "," << r.mean_stiffness << ","
+                  << (r.max_stiffness - r.min_stiffness) / r.mean_stiffness << std::endl;
+    }
+    return 0;
+}
+
+// Planetary stages for a ratio: "ratio[,tolerance %[,max ring diameter mm[,module]]]", best first as CSV
+static int run_planetary(const std::string& spec) {
+    auto parts = split_fields(spec);
+    if (parts.empty() || parts[0].empty()) {
+        std::cerr << "Usage: --planetary=<ratio>[,<tolerance %>[,<max ring diameter mm>[,<module>]]]" << std::endl;
+        return 1;
+    }
+    PlanetaryOptions options;
+    options.target_ratio = optional_field(parts, 0, NAN);
+    if (has_field(parts, 1)) options.ratio_tolerance = optional_field(parts, 1, NAN) / 100.0;
+    options.max_ring_diameter = optional_field(parts, 2, NAN);
+    options.module = optional_field(parts, 3, NAN);
+
+    std::cout << "Sun,Planet,Ring,Planets,Module,Ratio,RatioError,CenterDistance,PlanetGap,RingDiameter" << std::endl;
+    size_t found = PlanetaryEnumerator(options).enumerate([](const PlanetaryConfig& c) {
+        std::cout << c.sun << "," << c.planet << "," << c.ring << "," << c.planets << "," << c.module << ","
+                  << c.ratio << "," << c.ratio_error << "," << c.center_distance << "," << c.planet_gap << ","
+                  << c.ring_diameter << std::endl;
+    });
+    std::cerr << found << " valid configurations" << (found > options.limit ? ", best " + std::to_string(options.limit) + " shown" : "") << std::endl;
+    return 0;
+}
+
+// Profile shifts for "N1,N2,DP[,PA[,CD]]" or every pair of a bill of materials CSV, as CSV
+static int run_shift(const std::string& spec) {
+    std::vector<ShiftPair> pairs;
+    if (spec.size() > 4 && utils::to_lower(spec.substr(spec.size() - 4)) == ".csv") {
+        pairs = read_records<ShiftPair>(spec);
+        if (pairs.empty()) {
+            std::cerr << "No pairs loaded from " << spec << std::endl;
+            return 1;
+        }
+    } else {
+        auto parts = split_fields(spec);
+        if (parts.size() < 3) {
+            std::cerr << "Usage: --shift=<N1>,<N2>,<DP>[,<PA>[,<center distance>]] or --shift=<pairs.csv>" << std::endl;
+            return 1;
+        }
+        ShiftPair p;
+        p.id = parts[0] + ":" + parts[1];
+        p.n1 = count_field(parts, 0, 0);
+        p.n2 = count_field(parts, 1, 0);
+        p.dp = optional_field(parts, 2, NAN);
+        p.pa = optional_field(parts, 3, p.pa);
+        p.cd = optional_field(parts, 4, p.cd);
+        pairs.push_back(p);
+    }
+    auto results = ProfileShiftOptimizer().optimize(pairs);
+    FormatBuffer out;
+    RecordCodec<ShiftResult>::write_header(out);
+    size_t infeasible = 0;
+    for (const auto& r : results) {
+        RecordCodec<ShiftResult>::write(out, r);
+        if (!r.feasible) ++infeasible;
+    }
+    std::cout << out.str();
+    if (infeasible > 0) std::cerr << infeasible << " of " << results.size() << " pairs break a constraint (see Note)" << std::endl;
+    return 0;
+}
+
+// AGMA rating of a catalog: "catalog.csv[,rpm[,face[,material[,min hp]]]]", CSV of the gears that qualify
+static int run_rate(const std::string& spec) {
+    auto parts = split_fields(spec);
+    const char* usage = "Usage: --rate=<catalog.csv>[,<rpm>[,<face width>[,<material>[,<min hp>]]]]";
+    if (parts.empty() || parts[0].empty()) {
+        std::cerr << usage << std::endl;
+        return 1;
+    }
+    RatingConditions conditions;
+    conditions.rpm = optional_field(parts, 1, conditions.rpm);
+    conditions.face_width = optional_field(parts, 2, conditions.face_width);
+    if (has_field(parts, 3)) conditions.material = GearMaterial::parse(parts[3]);
+    double min_power = optional_field(parts, 4, 0.0);
+    // Speed, face and power divide the stresses; zero, negative or infinite ones rate nothing
+    auto positive = [](double v) { return std::isfinite(v) && v > 0.0; };
+    if (!positive(conditions.rpm) || (has_field(parts, 2) && !positive(conditions.face_width)) ||
+        (has_field(parts, 4) && !positive(min_power))) {
+        std::cerr << "Invalid --rate=" << spec << std::endl << usage << std::endl;
+        return 1;
+    }
+
+    auto gears = GearCalculator().load_known(parts[0]);
+    if (gears.empty()) {
+        std::cerr << "No gears loaded from " << parts[0] << std::endl;
+        return 1;
+    }
+    GearRater rater(conditions);
+    auto r = rater.rate(gears);
+    auto rows = r.at_least(min_power);
+    FormatBuffer out;
+    out.append(std::string("N,DP,PA,Y,J,I,BendingStress,ContactStress,BendingHP,ContactHP,RatedHP\n"));
+    for (size_t i : rows) {
+        const GearParams& g = gears[i];
+        out.append(g.n); out.append(',');
+        out.append(g.dp); out.append(',');
+        out.append(g.pa); out.append(',');
+        out.append(r.lewis_y[i], 4); out.append(',');
+        out.append(r.geometry_j[i], 4); out.append(',');
+        out.append(r.geometry_i[i], 4); out.append(',');
+        out.append(r.bending_stress[i], 0); out.append(',');
+        out.append(r.contact_stress[i], 0); out.append(',');
+        out.append(r.bending_power[i], 3); out.append(',');
+        out.append(r.contact_power[i], 3); out.append(',');
+        out.append(r.rated_power[i], 3); out.append('\n');
+    }
+    std::cout << out.str();
+    std::cerr << rows.size() << " of " << gears.size() << " gears rated for at least " << min_power << " hp ("
+              << conditions.material.name << ", " << conditions.rpm << " rpm)" << std::endl;
+    return 0;
+}
+
+// Animated braille preview: "N1,N2,DP[,PA]" (N2 = 0 for the gear alone)
+static int run_preview(const std::string& spec) {
+    auto parts = split_fields(spec);
+    const char* usage = "Usage: --preview=<N1>,<N2>,<DP>[,<PA>] (N2 = 0: no mate)";
+    if (parts.size() < 3) {
+        std::cerr << usage << std::endl;
+        return 1;
+    }
+    double pa = optional_field(parts, 3, 20.0);
+    if (!(pa > 0.0 && pa < 90.0)) {  // NaN would quietly become the 20 degree default
+        std::cerr << "Invalid --preview=" << spec << std::endl << usage << std::endl;
+        return 1;
+    }
+    GearParams p = GearParams::spec(count_field(parts, 0, 0), optional_field(parts, 2, NAN), pa);
+    double fps = GearPreview(p, count_field(parts, 1, 0), 0, 0).play();
+    std::cerr << number_to_string(fps, 1) << " fps" << std::endl;
+    return 0;
+}
+
+// Design sweep: "spec.ini,out.gfc"; the grid is pruned and written as a column file
+static int run_sweep(const std::string& spec) {
+    size_t comma = spec.find(',');
+    if (comma == std::string::npos) {
+        std::cerr << "Usage: --sweep=<spec.ini>,<out.gfc>" << std::endl;
+        return 1;
+    }
+    std::string out = utils::trim(spec.substr(comma + 1));
+    auto stats = DesignSweep(SweepSpec::load(utils::trim(spec.substr(0, comma)))).run(out);
+    std::cerr << stats.grid << " grid points, " << stats.written << " written to " << out << " (" << stats.chunks
+              << " chunks, " << stats.bytes << " bytes) in " << number_to_string(stats.seconds, 2) << " s" << std::endl;
+    std::cerr << "Pruned: " << stats.pruned_center << " center distance, " << stats.pruned_undercut << " undercut, "
+              << stats.pruned_teeth << " tooth count, " << stats.pruned_order << " N1 > N2; " << stats.rejected_contact
+              << " below the contact ratio" << std::endl;
+    return 0;
+}
+
+// Rows of a sweep file as CSV: "out.gfc[,<column>=<lo>..<hi>]"; chunks outside the range aren't read
+static int run_sweep_read(const std::string& spec) {
+    auto parts = split_fields(spec);
+    if (parts.empty() || parts[0].empty()) {
+        std::cerr << "Usage: --sweep-read=<out.gfc>[,<column>=<lo>..<hi>]" << std::endl;
+        return 1;
+    }
+    ColumnFileReader reader(parts[0]);
+    int filter = -1;
+    double lo = -INFINITY, hi = INFINITY;
+    if (parts.size() > 1) {
+        size_t eq = parts[1].find('='), dots = parts[1].find("..");
+        if (eq == std::string::npos || dots == std::string::npos || dots < eq) {
+            std::cerr << "Filter must be <column>=<lo>..<hi>" << std::endl;
+            return 1;
+        }
+        filter = reader.column(parts[1].substr(0, eq));
+        if (filter < 0) {
+            std::cerr << "No column " << parts[1].substr(0, eq) << " in " << parts[0] << std::endl;
+            return 1;
+        }
+        lo = utils::safe_stod_or(parts[1].substr(eq + 1, dots - eq - 1), -INFINITY);
+        hi = utils::safe_stod_or(parts[1].substr(dots + 2), INFINITY);
+    }
+
+    const auto& names = reader.columns();
+    FormatBuffer out;
+    for (size_t c = 0; c < names.size(); ++c) {
+        if (c) out.append(',');
+        out.append(names[c]);
+    }
+    out.append('\n');
+    auto chunks = filter < 0 ? std::vector<size_t>() : reader.chunks_overlapping(filter, lo, hi);
+    if (filter < 0) for (size_t k = 0; k < reader.chunk_count(); ++k) chunks.push_back(k);
+    std::vector<std::vector<double>> cols(names.size());
+    uint64_t rows = 0;
+    for (size_t k : chunks) {
+        for (size_t c = 0; c < names.size(); ++c) reader.read(k, static_cast<int>(c), cols[c]);
+        for (size_t i = 0; i < cols[0].size(); ++i) {
+            if (filter >= 0 && !(cols[filter][i] >= lo && cols[filter][i] <= hi)) continue;
+            for (size_t c = 0; c < names.size(); ++c) {
+                if (c) out.append(',');
+                out.append(cols[c][i]);
+            }
+            out.append('\n');
+            ++rows;
+        }
+        std::cout.write(out.data(), static_cast<std::streamsize>(out.size()));
+        out.clear();
+    }
+    std::cout.write(out.data(), static_cast<std::streamsize>(out.size()));
+    std::cerr << rows << " rows from " << chunks.size() << " of " << reader.chunk_count() << " chunks" << std::endl;
+    return 0;
+}
+
+// Change gears for a thread: "profile.ini,<pitch mm | N tpi>", nearest trains first
+static int run_thread(const std::string& spec) {
+    size_t comma = spec.rfind(',');
+    if (comma == std::string::npos) {
+        std::cerr << "Usage: --thread=<lathe profile>,<pitch in mm>|<N>tpi" << std::endl;
+        return 1;
+    }
+    auto profile = LatheProfile::load(spec.substr(0, comma));
+    std::string want = utils::to_lower(utils::trim(spec.substr(comma + 1)));
+    bool tpi = want.size() > 3 && want.compare(want.size() - 3, 3, "tpi") == 0;
+    if (tpi) want.resize(want.size() - 3);
+    else if (want.size() > 2 && want.compare(want.size() - 2, 2, "mm") == 0) want.resize(want.size() - 2);
+    double value = utils::safe_stod(want);
+
+    auto table = ThreadTable::load_or_build(profile);
+    auto matches = tpi ? table.nearest_tpi(value) : table.nearest_pitch(value);
+    std::cout << "A,B,C,D,Train,Pitch,TPI,Error%,Alternatives" << std::endl;
+    for (const auto& m : matches) {
+        const GearTrain& t = m.train;
+        std::cout << t.a << "," << t.b << "," << t.c << "," << t.d << "," << (t.simple ? "simple" : "compound") << ","
+                  << number_to_string(t.pitch, 4) << "," << number_to_string(t.tpi(), 3) << ","
+                  << number_to_string(m.error * 100.0, 3) << "," << t.alternatives << std::endl;
+    }
+    std::cerr << table.size() << " distinct ratios for " << profile.name << std::endl;
+    return 0;
+}
+
+// Cutting plan for a job list: "jobs.csv[,machine,...]", CSV per machine in run order
+static int run_schedule(const std::string& spec) {
+    auto parts = split_fields(spec);
+    if (parts.empty() || parts[0].empty()) {
+        std::cerr << "Usage: --schedule=<jobs.csv>[,<machine>,...]" << std::endl;
+        return 1;
+    }
+    auto jobs = read_records<CutJob>(parts[0]);
+    if (jobs.empty()) {
+        std::cerr << "No jobs loaded from " << parts[0] << std::endl;
+        return 1;
+    }
+    ScheduleOptions options;
+    options.machines.assign(parts.begin() + 1, parts.end());
+    auto plan = JobScheduler(options).schedule(jobs);
+
+    std::cout << "Machine,Job,Teeth,DP,Start,End,Setup,Changes,Late" << std::endl;
+    for (const auto& m : plan.machines) {
+        for (const auto& sj : m.jobs) {
+            const CutJob& j = jobs[sj.job];
+            std::cout << m.machine << "," << j.id << "," << j.teeth << "," << j.dp << "," << sj.start << "," << sj.end
+                      << "," << sj.setup << "," << sj.changes << "," << sj.lateness << std::endl;
+        }
+    }
+    std::cerr << jobs.size() << " jobs: setup " << plan.setup << " min (greedy plan cost " << plan.initial_cost
+              << ", optimized " << plan.cost << "), " << plan.late_jobs << " late, makespan " << plan.makespan
+              << " min" << std::endl;
+    return 0;
+}
+
+// Follows a catalog file and reports each reload until Enter is pressed
+static int run_watch(const std::string& filename) {
+    WatchedCatalog catalog(filename);
+    catalog.on_update([](const CatalogSnapshot&, const CatalogSnapshot& after, const CatalogReload& r) {
+        std::cout << "v" << r.version << ": " << after.size() << " rows, re-parsed " << r.reparsed_chunks << " of "
+                  << r.chunks << " chunks (" << r.reparsed_rows << " rows) in " << r.milliseconds << " ms ("
+                  << r.scan_milliseconds << " ms reading)" << (r.attached ? ", shared by another session" : "")
+                  << std::endl;
+    });
+    if (!catalog.start()) {
+        std::cerr << "Cannot watch " << filename << std::endl;
+        return 1;
+    }
+    auto snap = catalog.snapshot();
+    std::cout << "Watching " << filename << ": " << snap->size() << " rows in " << snap->chunks.size()
+              << " chunks (Enter to stop)" << std::endl;
+    std::string line;
+    std::getline(std::cin, line);
+    catalog.stop();
+    if (!catalog.last_error().empty()) std::cerr << "Last reload failed: " << catalog.last_error() << std::endl;
+    return 0;
+}
+
+// Monte Carlo backlash/contact-ratio stack-up: "N1,N2,DP[,trials]"
+static int run_tolerance(const std::string& spec) {
+    auto parts = split_fields(spec);
+    const char* usage = "Usage: --tolerance=<pinion teeth>,<gear teeth>,<DP>[,<trials>]";
+    if (parts.size() < 3) {
+        std::cerr << usage << std::endl;
+        return 1;
+    }
+
+    int n1 = 0, n2 = 0;
+    double dp = NAN;
+    uint64_t trials = 0;
+    try {
+        n1 = count_field(parts, 0, 0);
+        n2 = count_field(parts, 1, 0);
+        dp = optional_field(parts, 2, NAN);
+        double t = optional_field(parts, 3, 1000000.0);
+        if (t >= 1 && t == std::floor(t) && t < std::ldexp(1.0, 64)) trials = static_cast<uint64_t>(t);
+    } catch (const std::exception&) {
+        // Bad numbers get the usage line below
+    }
+    if (n1 <= 0 || n2 <= 0 || !(dp > 0) || trials == 0) {
+        std::cerr << "Invalid --tolerance=" << spec << std::endl << usage << std::endl;
+        return 1;
+    }
+    GearParams pinion = GearParams::spec(n1, dp, 20.0);
+    GearParams gear = GearParams::spec(n2, dp, 20.0);
+
+    auto report = ToleranceAnalyzer().analyze(pinion, gear, ToleranceInputs(), trials);
+    auto print = [](const std::string& name, const DistributionSummary& d) {
+        std::cout << name << ": mean " << d.mean << ", stddev " << d.stddev << ", min " << d.min
+                  << ", p1 " << d.p01 << ", p5 " << d.p05 << ", p50 " << d.p50
+                  << ", p95 " << d.p95 << ", p99 " << d.p99 << ", max " << d.max << std::endl;
+    };
+    std::cout << "Trials: " << report.trials << std::endl;
+    std::cout << "Nominal backlash: " << report.nominal_backlash
+              << ", nominal contact ratio: " << report.nominal_contact_ratio << std::endl;
+    print("Backlash", report.backlash);
+    print("Contact ratio", report.contact_ratio);
+    std::cout << "Binding probability: " << report.binding_probability << std::endl;
+    return 0;
+}
+
 int main(int argc, char** argv) {
     
     google::ParseCommandLineFlags(&argc, &argv, true);
     
     google::InitGoogleLogging(argv[0]);
 
-    // Command-line flags
+    // Async logging is set up before any other flag does work
+    AsyncLogOptions log_options;
+    bool async_log = false;
     for (int i = 1; i < argc; ++i) {
         std::string arg = argv[i];
-        if (arg == "--help") {
-            std::cout << "Usage: gearforge [--version] [--load=file.csv]" << std::endl;
-            return 0;
-        } else if (arg == "--version") {
-            std::cout << "GearForge v0.0.1" << std::endl;
-            return 0;
-        } else if (arg.find("--load=") == 0) {
-            // Load CSV; handle in UI
+        if (arg.find("--async-log=") == 0) {
+            async_log = true;
+            log_options.path = arg.substr(12);
+        } else if (arg == "--log-overflow=block") {
+            log_options.overflow = LogOverflow::Block;
+        } else if (arg == "--mem-stats") {
+            std::atexit([] { MemStats::report(std::cerr); });
+        }
+    }
+    if (async_log && !AsyncLogSink::instance().start(log_options)) {
+        std::cerr << "Cannot open log file " << log_options.path << std::endl;
+    }
+
+    // Command-line flags; one handler reports every command's errors
+    try {
+        if (argc > 1 && std::string(argv[1]) == "catalog") return run_catalog(argc, argv);
+        for (int i = 1; i < argc; ++i) {
+            std::string arg = argv[i];
+            if (arg == "--help") {
+                std::cout << "Usage: gearforge [--version] [--load=file.csv] [--screen=catalog.csv] [--solve=catalog.csv,out.csv[,float|double|fixed]] [--tolerance=N1,N2,DP[,trials]] [--identify=N,OD[,RD[,span,k]]] [--mesh=N1,N2,DP[,PA[,x1,x2[,relief[,load]]]]] [--mesh-batch=designs.csv] [--planetary=ratio[,tol%[,max ring mm[,module]]]] [--watch=catalog.csv] [--schedule=jobs.csv[,machine,...]] [--thread=lathe.ini,pitch|Ntpi] [--shift=N1,N2,DP[,PA[,CD]]|pairs.csv] [--rate=catalog.csv[,rpm[,face[,material[,min hp]]]]] [--preview=N1,N2,DP[,PA]] [--sweep=spec.ini,out.gfc] [--sweep-read=out.gfc[,column=lo..hi]] [--async-log=file] [--log-overflow=drop|block] [--mem-stats]" << std::endl;
+                std::cout << "       gearforge catalog merge|intersect|dedup|diff <a.csv> [<b.csv>] [--out=file.csv] [--memory-mb=N] [--spill-dir=dir]" << std::endl;
+                return 0;
+            } else if (arg == "--version") {
+                std::cout << "GearForge v0.0.1" << std::endl;
+                return 0;
+            } else if (arg.find("--load=") == 0) {
+                // Load CSV; handle in UI
+            } else if (arg.find("--screen=") == 0) {
+                return run_screen(arg.substr(9));
+            } else if (arg.find("--solve=") == 0) {
+                return run_solve(arg.substr(8));
+            } else if (arg.find("--tolerance=") == 0) {
+                return run_tolerance(arg.substr(12));
+            } else if (arg.find("--identify=") == 0) {
+                return run_identify(arg.substr(11));
+            } else if (arg.find("--planetary=") == 0) {
+                return run_planetary(arg.substr(12));
+            } else if (arg.find("--shift=") == 0) {
+                return run_shift(arg.substr(8));
+            } else if (arg.find("--rate=") == 0) {
+                return run_rate(arg.substr(7));
+            } else if (arg.find("--preview=") == 0) {
+                return run_preview(arg.substr(10));
+            } else if (arg.find("--sweep=") == 0 || arg.find("--sweep-read=") == 0) {
+                bool read = arg.find("--sweep-read=") == 0;
+                return read ? run_sweep_read(arg.substr(13)) : run_sweep(arg.substr(8));
+            } else if (arg.find("--thread=") == 0) {
+                return run_thread(arg.substr(9));
+            } else if (arg.find("--schedule=") == 0) {
+                return run_schedule(arg.substr(11));
+            } else if (arg.find("--watch=") == 0) {
+                return run_watch(arg.substr(8));
+            } else if (arg.find("--mesh=") == 0 || arg.find("--mesh-batch=") == 0) {
+                bool batch = arg.find("--mesh-batch=") == 0;
+                return batch ? run_mesh_batch(arg.substr(13)) : run_mesh(arg.substr(7));
+            }
         }
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
     }
 
     // Ensure data dir
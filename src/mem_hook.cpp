@@ -0,0 +1,53 @@
+#include "mem_stats.h"
+
+// Linking this file turns on MemStats: every global operator new/delete
+// goes through here. Each block carries its size and tag in a header, so
+// a free is charged to the tag that allocated it. Aligned (over-aligned
+// type) allocations keep the library's own operators and are not counted.
+
+namespace {
+
+constexpr size_t kHeader = alignof(std::max_align_t);  // Keeps the block aligned like malloc's
+static_assert(kHeader > sizeof(size_t), "header needs room for the size and tag");
+
+struct Install {
+    Install() { gearforge::MemStats::install(); }
+} install;
+
+void* allocate(size_t size) noexcept {
+    auto* raw = static_cast<unsigned char*>(std::malloc(size + kHeader));
+    if (!raw) return nullptr;
+    gearforge::MemTag tag = gearforge::MemStats::on_allocate(size);
+    std::memcpy(raw, &size, sizeof(size));
+    raw[sizeof(size)] = static_cast<unsigned char>(tag);
+    return raw + kHeader;
+}
+
+void* allocate_or_throw(size_t size) {
+    void* p = allocate(size);
+    if (!p) throw std::bad_alloc();
+    return p;
+}
+
+void release(void* p) noexcept {
+    if (!p) return;
+    unsigned char* raw = static_cast<unsigned char*>(p) - kHeader;
+    size_t size;
+    std::memcpy(&size, raw, sizeof(size));
+    gearforge::MemStats::on_free(static_cast<gearforge::MemTag>(raw[sizeof(size)]), size);
+    std::free(raw);
+}
+
+}  // unnamed namespace
+
+void* operator new(size_t size) { return allocate_or_throw(size); }
+void* operator new[](size_t size) { return allocate_or_throw(size); }
+void* operator new(size_t size, const std::nothrow_t&) noexcept { return allocate(size); }
+void* operator new[](size_t size, const std::nothrow_t&) noexcept { return allocate(size); }
+
+void operator delete(void* p) noexcept { release(p); }
+void operator delete[](void* p) noexcept { release(p); }
+void operator delete(void* p, size_t) noexcept { release(p); }
+void operator delete[](void* p, size_t) noexcept { release(p); }
+void operator delete(void* p, const std::nothrow_t&) noexcept { release(p); }
+void operator delete[](void* p, const std::nothrow_t&) noexcept { release(p); }
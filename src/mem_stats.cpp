@@ -0,0 +1,90 @@
+#include "mem_stats.h"
+
+namespace gearforge {
+
+namespace {
+
+// Constant-initialized, so allocations made before main are counted too
+struct Counters {
+    std::atomic<uint64_t> allocations{0};
+    std::atomic<uint64_t> frees{0};
+    std::atomic<uint64_t> bytes{0};
+    std::atomic<int64_t> live{0};
+    std::atomic<int64_t> peak{0};
+};
+
+Counters counters[kMemTagCount];
+std::atomic<bool> installed{false};
+thread_local MemTag current_tag = MemTag::Other;
+
+}  // unnamed namespace
+
+const char* mem_tag_name(MemTag tag) {
+    static const char* const names[kMemTagCount] = {"other", "catalog", "csv", "ui", "auth", "hash"};
+    return names[static_cast<size_t>(tag)];
+}
+
+MemTagScope::MemTagScope(MemTag tag) : previous(current_tag) { current_tag = tag; }
+
+MemTagScope::~MemTagScope() { current_tag = previous; }
+
+MemTag MemTagScope::current() { return current_tag; }
+
+void MemStats::install() { installed.store(true, std::memory_order_relaxed); }
+
+bool MemStats::enabled() { return installed.load(std::memory_order_relaxed); }
+
+MemTag MemStats::on_allocate(size_t bytes) {
+    MemTag tag = current_tag;
+    Counters& c = counters[static_cast<size_t>(tag)];
+    c.allocations.fetch_add(1, std::memory_order_relaxed);
+    c.bytes.fetch_add(bytes, std::memory_order_relaxed);
+    int64_t live = c.live.fetch_add(static_cast<int64_t>(bytes), std::memory_order_relaxed) + static_cast<int64_t>(bytes);
+    int64_t peak = c.peak.load(std::memory_order_relaxed);
+    while (live > peak && !c.peak.compare_exchange_weak(peak, live, std::memory_order_relaxed)) {
+    }
+    return tag;
+}
+
+void MemStats::on_free(MemTag tag, size_t bytes) {
+    Counters& c = counters[static_cast<size_t>(tag)];
+    c.frees.fetch_add(1, std::memory_order_relaxed);
+    c.live.fetch_sub(static_cast<int64_t>(bytes), std::memory_order_relaxed);
+}
+
+MemTagStats MemStats::get(MemTag tag) {
+    const Counters& c = counters[static_cast<size_t>(tag)];
+    MemTagStats s;
+    s.allocations = c.allocations.load(std::memory_order_relaxed);
+    s.frees = c.frees.load(std::memory_order_relaxed);
+    s.bytes = c.bytes.load(std::memory_order_relaxed);
+    s.live = c.live.load(std::memory_order_relaxed);
+    s.peak = c.peak.load(std::memory_order_relaxed);
+    return s;
+}
+
+std::array<MemTagStats, kMemTagCount> MemStats::snapshot() {
+    std::array<MemTagStats, kMemTagCount> all;
+    for (size_t t = 0; t < kMemTagCount; ++t) all[t] = get(static_cast<MemTag>(t));
+    return all;
+}
+
+void MemStats::reset_peaks() {
+    for (auto& c : counters) c.peak.store(c.live.load(std::memory_order_relaxed), std::memory_order_relaxed);
+}
+
+void MemStats::report(std::ostream& out) {
+    if (!enabled()) {
+        out << "Allocation tracking is not built in (configure with -DGEARFORGE_MEM_STATS=ON or make MEM_STATS=1)" << std::endl;
+        return;
+    }
+    auto all = snapshot();  // Before any formatting allocates
+    out << "Tag,Allocations,Frees,Bytes,Live,Peak" << std::endl;
+    for (size_t t = 0; t < kMemTagCount; ++t) {
+        const MemTagStats& s = all[t];
+        out << mem_tag_name(static_cast<MemTag>(t)) << "," << s.allocations << "," << s.frees << "," << s.bytes << ","
+            << s.live << "," << s.peak << std::endl;
+    }
+}
+
+}  // namespace gearforge
@@ -0,0 +1,315 @@
+#include "mesh_simulation.h"
+
+namespace gearforge {
+
+namespace {
+
+double involute(double angle) { return std::tan(angle) - angle; }
+
+// Angle whose involute is v (Newton from a good start)
+double inverse_involute(double v) {
+    double a = std::cbrt(3.0 * v);
+    for (int i = 0; i < 20; ++i) {
+        double t = std::tan(a);
+        double step = (t - a - v) / (t * t);
+        a -= step;
+        if (std::fabs(step) < 1e-15) break;
+    }
+    return a;
+}
+
+// One gear's drive flank in its own frame: half tooth thickness angle psi(r)
+// over the active profile, tabulated on a uniform radius grid so a radius
+// maps straight to its cell
+struct Flank {
+    int n = 0;
+    double pitch = 0.0;           // Angular pitch
+    double rb = 0.0, r_form = 0.0, r_tip = 0.0;
+    double r0 = 0.0, inv_dr = 0.0;
+    std::vector<double> table;
+    std::vector<double> sample_r, sample_psi;   // Points checked against the mate
+
+    double psi(double r) const {
+        double t = (r - r0) * inv_dr;
+        size_t i = std::min(static_cast<size_t>(std::max(t, 0.0)), table.size() - 2);
+        double f = t - static_cast<double>(i);
+        return table[i] + f * (table[i + 1] - table[i]);
+    }
+    bool active(double r) const { return r >= r_form && r <= r_tip; }
+};
+
+Flank build_flank(const GearParams& p, const MeshGear& g, double relief_roll, int points) {
+    const double m = 1.0 / p.dp;
+    const double alpha = p.pa * M_PI / 180.0;
+    const double rp = p.pd / 2.0;
+    const double x = p.x;
+
+    Flank f;
+    f.n = p.n;
+    f.pitch = 2.0 * M_PI / p.n;
+    f.rb = rp * std::cos(alpha);
+    f.r_tip = p.od / 2.0;  // calculate() already moved the addendum by x
+    // The straight rack flank reaches (1 - x) modules below the pitch line
+    double u_form = rp * std::sin(alpha) - (1.0 - x) * m / std::sin(alpha);
+    f.r_form = u_form > 0.0 ? std::hypot(f.rb, u_form) : f.rb;
+
+    const double psi0 = M_PI / (2.0 * p.n) + 2.0 * x * std::tan(alpha) / p.n + involute(alpha);
+    const double u_tip = std::sqrt(f.r_tip * f.r_tip - f.rb * f.rb);
+    const double u_start = std::min(relief_roll, u_tip);
+    // Relief is normal to the profile, i.e. along the base tangent: angle = depth / rb
+    auto exact = [&](double r) {
+        double u = std::sqrt(std::max(0.0, r * r - f.rb * f.rb));
+        double relief = g.tip_relief > 0.0 && u > u_start && u_tip > u_start
+                        ? g.tip_relief * (u - u_start) / (u_tip - u_start) : 0.0;
+        return psi0 - involute(std::acos(std::min(1.0, f.rb / r))) - relief / f.rb;
+    };
+
+    const int cells = 4 * std::max(points, 8);
+    const double dr = (f.r_tip - f.r_form) / cells;
+    f.r0 = f.r_form;
+    f.inv_dr = 1.0 / dr;
+    f.table.resize(cells + 1);
+    for (int i = 0; i <= cells; ++i) f.table[i] = exact(f.r_form + dr * i);
+    for (int i = 0; i < points; ++i) {
+        double r = f.r_form + (f.r_tip - f.r_form) * i / (points - 1);
+        f.sample_r.push_back(r);
+        f.sample_psi.push_back(exact(r));
+    }
+    return f;
+}
+
+struct PairGap {
+    int driver;                   // Pinion tooth
+    int driven;                   // Gear tooth
+    double gap;                   // Rotation to close, as length along the line of action
+};
+
+void add_gap(std::vector<PairGap>& gaps, int k, int j, double gap) {
+    for (auto& g : gaps) {
+        if (g.driver == k && g.driven == j) {
+            g.gap = std::min(g.gap, gap);
+            return;
+        }
+    }
+    gaps.push_back({k, j, gap});
+}
+
+int wrap(long i, int n) { return static_cast<int>(((i % n) + n) % n); }
+
+// Samples of `from` (tooth `tooth` at frame angle `base`) against the drive
+// flanks of `to`, whose tooth t sits at to_base + t * pitch. Points are
+// mapped into the other gear's frame by `place`; the gap at each point is
+// the angle the other flank must turn to reach it, refined between samples
+// by a parabola through the local minimum.
+template <typename Place>
+void flank_gaps(const Flank& from, const Flank& to, int tooth, double base, double to_base, double scale,
+                bool from_driver, Place place, std::vector<PairGap>& gaps) {
+    const size_t count = from.sample_r.size();
+    std::vector<double> gap(count, NAN);
+    std::vector<long> index(count, 0);
+    for (size_t s = 0; s < count; ++s) {
+        double r, a;
+        place(from.sample_r[s], base + from.sample_psi[s], r, a);
+        if (!to.active(r)) continue;
+        double psi = to.psi(r);
+        double raw = a - psi - to_base;
+        long t = static_cast<long>(std::floor(raw / to.pitch));
+        double rem = raw - t * to.pitch;
+        // Past the next tooth's back flank means inside that tooth: negative gap
+        if (rem > to.pitch - 2.0 * psi) {
+            rem -= to.pitch;
+            ++t;
+        }
+        gap[s] = rem * scale;
+        index[s] = t;
+    }
+    for (size_t s = 0; s < count; ++s) {
+        if (std::isnan(gap[s])) continue;
+        double g = gap[s];
+        if (s > 0 && s + 1 < count && !std::isnan(gap[s - 1]) && !std::isnan(gap[s + 1]) &&
+            index[s - 1] == index[s] && index[s + 1] == index[s] && g <= gap[s - 1] && g <= gap[s + 1]) {
+            double curve = gap[s - 1] - 2.0 * g + gap[s + 1];
+            if (curve > 0.0) g -= (gap[s - 1] - gap[s + 1]) * (gap[s - 1] - gap[s + 1]) / (8.0 * curve);
+        }
+        int other = wrap(index[s], to.n);
+        if (from_driver) add_gap(gaps, tooth, other, g);
+        else add_gap(gaps, other, tooth, g);
+    }
+}
+
+}  // unnamed namespace
+
+MeshResult MeshSimulator::run(const MeshDesign& design, unsigned threads) const {
+    GearCalculator calc;
+    const GearParams p1 = calc.calculate(design.pinion.params);
+    const GearParams p2 = calc.calculate(design.gear.params);
+    if (p1.n < 3 || p2.n < 3 || !(p1.dp > 0) || !(p2.dp > 0)) {
+        throw std::runtime_error("Mesh simulation needs N >= 3 and DP or module for both gears");
+    }
+    if (std::fabs(p1.dp - p2.dp) > 1e-9 * p1.dp || std::fabs(p1.pa - p2.pa) > 1e-9) {
+        throw std::runtime_error("Meshing gears need the same pitch and pressure angle");
+    }
+    if (options.steps_per_pitch < 1 || options.pitches < 1 || options.profile_points < 3) {
+        throw std::runtime_error("Mesh simulation needs at least one step and three profile points");
+    }
+
+    const double m = 1.0 / p1.dp;
+    const double alpha = p1.pa * M_PI / 180.0;
+    const double rb1 = p1.pd / 2.0 * std::cos(alpha), rb2 = p2.pd / 2.0 * std::cos(alpha);
+    const double x_sum = p1.x + p2.x;
+
+    MeshResult result;
+    double alpha_w;
+    if (std::isnan(design.center_distance)) {
+        // Strong negative shifts leave no working pressure angle at all
+        const double inv_w = involute(alpha) + 2.0 * x_sum * std::tan(alpha) / (p1.n + p2.n);
+        if (!(inv_w > 0.0)) throw std::invalid_argument("Profile shifts too negative to mesh: x1 + x2 = " + number_to_string(x_sum));
+        alpha_w = inverse_involute(inv_w);
+        if (!(alpha_w > 0.0 && alpha_w < M_PI / 2.0)) {
+            throw std::invalid_argument("No working pressure angle for x1 + x2 = " + number_to_string(x_sum));
+        }
+        result.center_distance = (rb1 + rb2) / std::cos(alpha_w);
+    } else {
+        result.center_distance = design.center_distance;
+        if (!(design.center_distance > rb1 + rb2)) throw std::runtime_error("Center distance too small to mesh");
+        alpha_w = std::acos((rb1 + rb2) / design.center_distance);
+    }
+    const double cd = result.center_distance;
+    result.working_pressure_angle = alpha_w * 180.0 / M_PI;
+
+    // Path of contact on the line of action, measured from the pinion's base tangent point
+    const double line = cd * std::sin(alpha_w);
+    const double base_pitch = 2.0 * M_PI * rb1 / p1.n;
+    const double tip1 = p1.od / 2.0, tip2 = p2.od / 2.0;
+    const double u_tip1 = std::sqrt(tip1 * tip1 - rb1 * rb1), u_tip2 = std::sqrt(tip2 * tip2 - rb2 * rb2);
+    const double start = line - u_tip2, end = u_tip1;  // Contact begins at the gear tip, ends at the pinion tip
+    result.contact_ratio = (end - start) / base_pitch;
+    if (!(result.contact_ratio > 0.0)) throw std::runtime_error("Gears do not reach each other at this center distance");
+
+    // Default relief starts at each gear's highest point of single tooth contact
+    auto relief_roll = [](const MeshGear& g, double rb, double hpstc) {
+        return std::isnan(g.relief_start) ? hpstc : std::sqrt(std::max(0.0, g.relief_start * g.relief_start / 4.0 - rb * rb));
+    };
+    const Flank f1 = build_flank(p1, design.pinion, relief_roll(design.pinion, rb1, start + base_pitch), options.profile_points);
+    const Flank f2 = build_flank(p2, design.gear, relief_roll(design.gear, rb2, line - end + base_pitch), options.profile_points);
+
+    // Teeth that can reach the mesh: those within the angle where the tip circles cross
+    auto reach = [&](double r_own, double r_mate, double pitch) {
+        double c = (r_own * r_own + cd * cd - r_mate * r_mate) / (2.0 * r_own * cd);
+        return static_cast<long>(std::ceil(std::acos(std::max(-1.0, std::min(1.0, c))) / pitch)) + 1;
+    };
+    const long reach1 = reach(tip1, tip2, f1.pitch), reach2 = reach(tip2, tip1, f2.pitch);
+    const double ratio = static_cast<double>(p1.n) / p2.n;
+
+    // Pinion at the origin turning counterclockwise by t1, tooth k centered at
+    // t1 + k p1 with its drive flank on the + side. Gear at (cd, 0) turning
+    // clockwise by t2, tooth j centered at pi + (j + 1/2) p2 - t2 with its drive
+    // flank on the + side (facing the pinion's).
+    auto pair_gaps = [&](double t1, double t2, std::vector<PairGap>& gaps) {
+        gaps.clear();
+        const double gear_base = M_PI + 0.5 * f2.pitch - t2;
+        long k0 = std::lround(-t1 / f1.pitch);
+        for (long k = k0 - reach1; k <= k0 + reach1; ++k) {
+            auto to_gear = [&](double r, double a, double& r2, double& a2) {
+                double qx = r * std::cos(a) - cd, qy = r * std::sin(a);
+                r2 = std::hypot(qx, qy);
+                a2 = std::atan2(qy, qx);
+            };
+            flank_gaps(f1, f2, wrap(k, f1.n), t1 + k * f1.pitch, gear_base, rb2, true, to_gear, gaps);
+        }
+        long j0 = std::lround(t2 / f2.pitch - 0.5);
+        for (long j = j0 - reach2; j <= j0 + reach2; ++j) {
+            auto to_pinion = [&](double r, double a, double& r1, double& a1) {
+                double px = cd + r * std::cos(a), py = r * std::sin(a);
+                r1 = std::hypot(px, py);
+                a1 = std::atan2(py, px);
+            };
+            flank_gaps(f2, f1, wrap(j, f2.n), gear_base + j * f2.pitch, t1, rb1, false, to_pinion, gaps);
+        }
+    };
+
+    // Phase the gear so the first position just touches
+    std::vector<PairGap> gaps;
+    double t2_0 = 0.0;
+    for (int pass = 0; pass < 2; ++pass) {
+        pair_gaps(0.0, t2_0, gaps);
+        double closest = std::numeric_limits<double>::infinity();
+        for (const auto& g : gaps) closest = std::min(closest, g.gap);
+        if (std::isinf(closest)) throw std::runtime_error("No tooth pair in contact");
+        t2_0 -= closest / rb2;
+    }
+
+    const int steps = options.steps_per_pitch * options.pitches;
+    const double pair_stiffness = options.tooth_stiffness * design.face_width;
+    const double touching = options.contact_tolerance * m;
+    result.samples.resize(steps);
+    utils::parallel_for(static_cast<size_t>(steps), [&](size_t begin, size_t end) {
+        std::vector<PairGap> local;
+        std::vector<double> rel;
+        for (size_t s = begin; s < end; ++s) {
+            double t1 = f1.pitch * static_cast<double>(s) / options.steps_per_pitch;
+            pair_gaps(t1, t2_0 + t1 * ratio, local);
+            rel.clear();
+            for (const auto& g : local) rel.push_back(g.gap);
+            std::sort(rel.begin(), rel.end());
+            MeshSample& out = result.samples[s];
+            out.angle = t1;
+            out.te = rel.empty() ? NAN : -rel.front();
+            // Load sharing: deflection e with sum k (e - gap_i) = load over the pairs with gap_i < e
+            double deflection = 0.0;
+            int loaded = 0;
+            if (design.load > 0.0) {
+                double sum = 0.0;
+                for (size_t i = 0; i < rel.size(); ++i) {
+                    sum += rel[i] - rel.front();
+                    double e = (design.load / pair_stiffness + sum) / (i + 1);
+                    deflection = e;
+                    loaded = static_cast<int>(i + 1);
+                    if (i + 1 == rel.size() || e <= rel[i + 1] - rel.front()) break;
+                }
+            } else {
+                for (double g : rel) loaded += g - rel.front() <= touching ? 1 : 0;
+            }
+            out.loaded_te = out.te - deflection;
+            out.pairs = loaded;
+            out.stiffness = loaded * pair_stiffness;
+        }
+    }, threads);
+
+    double te_min = std::numeric_limits<double>::infinity(), te_max = -te_min;
+    double lo_min = te_min, lo_max = -te_min, k_sum = 0.0;
+    result.min_stiffness = te_min;
+    for (const auto& s : result.samples) {
+        te_min = std::min(te_min, s.te);
+        te_max = std::max(te_max, s.te);
+        lo_min = std::min(lo_min, s.loaded_te);
+        lo_max = std::max(lo_max, s.loaded_te);
+        k_sum += s.stiffness;
+        result.min_stiffness = std::min(result.min_stiffness, s.stiffness);
+        result.max_stiffness = std::max(result.max_stiffness, s.stiffness);
+    }
+    result.te_peak_to_peak = te_max - te_min;
+    result.loaded_te_peak_to_peak = lo_max - lo_min;
+    result.mean_stiffness = k_sum / steps;
+    return result;
+}
+
+MeshResult MeshSimulator::simulate(const MeshDesign& design, unsigned threads) const {
+    return run(design, threads);
+}
+
+std::vector<MeshResult> MeshSimulator::batch(const std::vector<MeshDesign>& designs, unsigned threads) const {
+    std::vector<MeshResult> results(designs.size());
+    if (threads == 0) threads = std::max(1u, std::thread::hardware_concurrency());
+    if (designs.size() < threads) {
+        // Too few designs to keep every thread busy; parallelize inside each
+        for (size_t i = 0; i < designs.size(); ++i) results[i] = run(designs[i], threads);
+        return results;
+    }
+    utils::parallel_for(designs.size(), [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) results[i] = run(designs[i], 1);
+    }, threads);
+    return results;
+}
+
+}  // namespace gearforge
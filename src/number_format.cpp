@@ -0,0 +1,60 @@
+#include "number_format.h"
+
+namespace gearforge {
+
+namespace {
+
+template <typename V>
+char* format_any(char* out, V v, int decimals) {
+    char* last = out + kMaxNumberChars;
+    if (v != v) {
+        std::memcpy(out, "nan", 3);  // Same as std::to_string, and std::stod reads it back
+        return out + 3;
+    }
+    if (decimals < 0) return std::to_chars(out, last, v).ptr;
+    auto res = std::to_chars(out, last, v, std::chars_format::fixed, decimals);
+    // Too long in fixed notation (huge magnitudes): same digits in general form
+    if (res.ec != std::errc()) res = std::to_chars(out, last, v, std::chars_format::general, std::min(decimals + 1, 17));
+    return res.ptr;
+}
+
+}  // unnamed namespace
+
+char* format_number(char* out, double v, int decimals) { return format_any(out, v, decimals); }
+char* format_number(char* out, float v, int decimals) { return format_any(out, v, decimals); }
+
+std::string number_to_string(double v, int decimals) {
+    char buf[kMaxNumberChars];
+    return std::string(buf, format_number(buf, v, decimals));
+}
+
+CsvWriter::CsvWriter(const std::string& filename, size_t buffer_bytes)
+    : file(filename, std::ios::binary), buffer(buffer_bytes) {}
+
+void CsvWriter::flush() {
+    if (buffer.size() == 0) return;
+    file.write(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+    buffer.clear();
+}
+
+void CsvWriter::end_row() {
+    buffer.append('\n');
+    row_start = true;
+    if (buffer.size() >= kFlushBytes) flush();
+}
+
+void CsvWriter::write(const FormatBuffer& rows) {
+    if (!row_start) end_row();
+    flush();
+    file.write(rows.data(), static_cast<std::streamsize>(rows.size()));
+}
+
+bool CsvWriter::close() {
+    if (!file.is_open()) return false;
+    if (!row_start) end_row();
+    flush();
+    file.close();
+    return !file.fail();
+}
+
+}  // namespace gearforge
@@ -0,0 +1,148 @@
+#include "gear_identify.h"
+#include "planetary.h"
+
+namespace gearforge {
+
+namespace {
+
+const double kMmPerInch = 25.4;
+
+GearParams metric_gear(int n, double module, double pa) {
+    GearParams p = GearParams::spec(n, NAN, pa);
+    p.m = module;
+    return GearCalculator().calculate(p);
+}
+
+}  // unnamed namespace
+
+bool PlanetaryEnumerator::better(const PlanetaryConfig& a, const PlanetaryConfig& b) {
+    double ea = std::fabs(a.ratio_error), eb = std::fabs(b.ratio_error);
+    if (ea != eb) return ea < eb;
+    if (a.ring != b.ring) return a.ring < b.ring;  // Smaller stage, or coarser teeth in a given envelope
+    if (a.planets != b.planets) return a.planets > b.planets;
+    return a.sun < b.sun;
+}
+
+bool PlanetaryEnumerator::build(int sun, int ring, int planets, PlanetaryConfig& out) const {
+    const int planet = (ring - sun) / 2;
+    const double dedendum = 1.157;  // Modules, as GearCalculator uses
+
+    double module = options.module;
+    if (std::isnan(module)) {
+        module = 1.0;
+        if (!std::isnan(options.max_ring_diameter)) {
+            // Largest standard module whose ring still fits the envelope
+            double fit = options.max_ring_diameter / (ring + 2.0 * dedendum);
+            const auto& series = GearIdentifier::module_series();
+            auto it = std::upper_bound(series.begin(), series.end(), fit * (1.0 + 1e-12));
+            if (it == series.begin()) return false;
+            module = *(it - 1);
+        }
+    }
+
+    out.sun = sun;
+    out.planet = planet;
+    out.ring = ring;
+    out.planets = planets;
+    out.module = module;
+    out.sun_params = metric_gear(sun, module, options.pressure_angle);
+    out.planet_params = metric_gear(planet, module, options.pressure_angle);
+    out.ring_params = metric_gear(ring, module, options.pressure_angle);
+    const GearParams& s = out.sun_params;
+    const GearParams& p = out.planet_params;
+    const GearParams& r = out.ring_params;
+
+    // Coaxial: sun-planet and planet-ring center distances agree
+    double outer = (r.pd - p.pd) / 2.0;
+    out.center_distance = (s.pd + p.pd) / 2.0;
+    if (std::fabs(outer - out.center_distance) > 1e-9 * r.pd) return false;
+    out.center_distance *= kMmPerInch;
+
+    // Neighbour clearance: chord between planet centers less one tip diameter
+    out.planet_gap = 2.0 * out.center_distance * std::sin(M_PI / planets) - p.od * kMmPerInch;
+    if (out.planet_gap < options.min_tip_gap * module * (1.0 - 1e-9)) return false;
+
+    // Internal gear: the root circle is outside the pitch circle
+    out.ring_diameter = (r.pd + 2.0 * r.d) * kMmPerInch;
+    if (!std::isnan(options.max_ring_diameter) && out.ring_diameter > options.max_ring_diameter * (1.0 + 1e-9)) {
+        return false;
+    }
+
+    out.ratio = 1.0 + static_cast<double>(ring) / sun;
+    out.ratio_error = out.ratio / options.target_ratio - 1.0;
+    return std::fabs(out.ratio_error) <= options.ratio_tolerance * (1.0 + 1e-12);
+}
+
+size_t PlanetaryEnumerator::enumerate(const std::function<void(const PlanetaryConfig&)>& emit, unsigned threads) const {
+    if (!(options.target_ratio > 2.0)) throw std::runtime_error("A planetary stage with fixed ring needs a ratio above 2");
+    if (options.min_planets < 2 || options.max_planets < options.min_planets) {
+        throw std::runtime_error("Planet count range is empty");
+    }
+
+    const double alpha = options.pressure_angle * M_PI / 180.0;
+    const int min_teeth = options.min_teeth > 0
+                          ? options.min_teeth
+                          : static_cast<int>(std::ceil(2.0 / std::pow(std::sin(alpha), 2) - 1e-9));
+    const int max_teeth = options.max_teeth;
+    if (max_teeth < min_teeth) return 0;
+    const double lo = options.target_ratio * (1.0 - options.ratio_tolerance) - 1.0;
+    const double hi = options.target_ratio * (1.0 + options.ratio_tolerance) - 1.0;
+
+    // One sorted, truncated list per sun count
+    const size_t suns = static_cast<size_t>(max_teeth - min_teeth + 1);
+    std::vector<std::vector<PlanetaryConfig>> lists(suns);
+    std::vector<size_t> found(suns, 0);
+    utils::parallel_for(suns, [&](size_t begin, size_t end) {
+        PlanetaryConfig config;
+        for (size_t i = begin; i < end; ++i) {
+            const int sun = min_teeth + static_cast<int>(i);
+            auto& list = lists[i];
+            // Ratio window -> ring; planet bounds and internal-gear difference narrow it
+            long ring_lo = static_cast<long>(std::ceil(sun * lo - 1e-9));
+            long ring_hi = static_cast<long>(std::floor(sun * hi + 1e-9));
+            ring_lo = std::max({ring_lo, static_cast<long>(sun) + 2L * min_teeth,
+                                2L * options.min_ring_planet_difference - sun});
+            ring_hi = std::min(ring_hi, static_cast<long>(sun) + 2L * max_teeth);
+            if ((ring_lo - sun) % 2 != 0) ++ring_lo;  // Coaxial: ring - sun = 2 planet
+            for (long ring = ring_lo; ring <= ring_hi; ring += 2) {
+                const int planet = static_cast<int>((ring - sun) / 2);
+                // sin(pi / Np) >= (planet + 2 + gap) / (sun + planet) bounds Np from above
+                double q = (planet + 2.0 + options.min_tip_gap) / (sun + planet);
+                if (q >= 1.0) continue;
+                int max_planets = std::min(options.max_planets, static_cast<int>(std::floor(M_PI / std::asin(q) + 1e-9)));
+                for (int np = options.min_planets; np <= max_planets; ++np) {
+                    if ((sun + ring) % np != 0) continue;  // Equally spaced planets can't be assembled
+                    if (!build(sun, static_cast<int>(ring), np, config)) continue;
+                    ++found[i];
+                    list.push_back(config);
+                }
+            }
+            std::sort(list.begin(), list.end(), better);
+            if (list.size() > options.limit) list.resize(options.limit);
+        }
+    }, threads);
+
+    // Every sun is done: k-way merge of the per-sun lists, emitting in rank order
+    auto worse = [&](const std::pair<size_t, size_t>& a, const std::pair<size_t, size_t>& b) {
+        return better(lists[b.first][b.second], lists[a.first][a.second]);
+    };
+    std::priority_queue<std::pair<size_t, size_t>, std::vector<std::pair<size_t, size_t>>, decltype(worse)> heads(worse);
+    for (size_t i = 0; i < suns; ++i) {
+        if (!lists[i].empty()) heads.push({i, 0});
+    }
+    for (size_t emitted = 0; emitted < options.limit && !heads.empty(); ++emitted) {
+        auto top = heads.top();
+        heads.pop();
+        emit(lists[top.first][top.second]);
+        if (top.second + 1 < lists[top.first].size()) heads.push({top.first, top.second + 1});
+    }
+    return std::accumulate(found.begin(), found.end(), size_t(0));
+}
+
+std::vector<PlanetaryConfig> PlanetaryEnumerator::enumerate(unsigned threads) const {
+    std::vector<PlanetaryConfig> out;
+    enumerate([&out](const PlanetaryConfig& c) { out.push_back(c); }, threads);
+    return out;
+}
+
+}  // namespace gearforge
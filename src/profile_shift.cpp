@@ -0,0 +1,186 @@
+#include "profile_shift.h"
+#include "vector_math.h"
+
+namespace gearforge {
+
+namespace {
+
+double involute(double angle) { return std::tan(angle) - angle; }
+
+// Everything scored about one x1 candidate
+struct Candidate {
+    double cost, sliding1, sliding2, contact, tip1, tip2, form1, form2;
+};
+
+// Everything about a pair that doesn't depend on how x1 + x2 is split
+struct PairGeometry {
+    const ShiftOptions& o;
+    double z1, z2, m, alpha, tan_a, inv_a;
+    double r1, r2, rb1, rb2;
+    double cd, alpha_w, line;      // line: base tangent points T1 to T2 along the line of action
+    double sum, shortening;        // x1 + x2, and the tip shortening both addenda lose
+    double xmin1, xmin2;
+
+    PairGeometry(const ShiftOptions& o, const ShiftPair& p) : o(o) {
+        z1 = p.n1;
+        z2 = p.n2;
+        m = 1.0 / p.dp;
+        alpha = p.pa * M_PI / 180.0;
+        tan_a = std::tan(alpha);
+        inv_a = involute(alpha);
+        r1 = z1 * m / 2.0;
+        r2 = z2 * m / 2.0;
+        rb1 = r1 * std::cos(alpha);
+        rb2 = r2 * std::cos(alpha);
+        const double standard = r1 + r2;
+        if (std::isnan(p.cd) || p.cd <= 0.0) {
+            cd = standard;
+            alpha_w = alpha;
+            sum = 0.0;
+        } else {
+            cd = p.cd;
+            double c = (rb1 + rb2) / cd;
+            alpha_w = c < 1.0 ? std::acos(c) : NAN;
+            sum = (involute(alpha_w) - inv_a) * (z1 + z2) / (2.0 * tan_a);
+        }
+        line = cd * std::sin(alpha_w);
+        shortening = sum - (cd - standard) / m;
+        xmin1 = ProfileShiftOptimizer::min_shift(p.n1, p.pa);
+        xmin2 = ProfileShiftOptimizer::min_shift(p.n2, p.pa);
+    }
+
+    // Straight-line math, selects and max/min only (acos and log come from
+    // vector_math.h), and always inlined: inside score() the fields other
+    // than cost are dead and the grid loop vectorizes
+    [[gnu::always_inline]] Candidate evaluate(double xa) const {
+        const double sin_a = std::sin(alpha), u = z2 / z1, eps = 1e-3 * m;  // eps: floors the slidings at interference
+        const double pitch_base = M_PI * m * std::cos(alpha);
+        Candidate c;
+        double xb = sum - xa;
+        double ra1 = r1 + m * (1.0 + xa - shortening);
+        double ra2 = r2 + m * (1.0 + xb - shortening);
+        double g1 = std::sqrt(std::max(0.0, ra1 * ra1 - rb1 * rb1));
+        double g2 = std::sqrt(std::max(0.0, ra2 * ra2 - rb2 * rb2));
+
+        // Contact runs from A (gear tip on the pinion root) to E (pinion tip on the gear root),
+        // as distances from each gear's base tangent point
+        double rho1_a = line - g2, rho2_e = line - g1;
+        c.sliding1 = std::fabs(1.0 - g2 / (std::max(rho1_a, eps) * u));
+        c.sliding2 = std::fabs(1.0 - g1 * u / std::max(rho2_e, eps));
+        c.contact = (g1 + g2 - line) / pitch_base;
+
+        // Where the generated involute starts; contact below it is interference
+        c.form1 = (rho1_a - std::max(0.0, r1 * sin_a - (1.0 - xa) * m / sin_a)) / m;
+        c.form2 = (rho2_e - std::max(0.0, r2 * sin_a - (1.0 - xb) * m / sin_a)) / m;
+
+        // Involute at the tip, tan - angle for the angle whose cosine is cos1;
+        // at cos1 >= 1 (tip inside the base circle) sin1 is 0 and so is the angle
+        double half1 = M_PI / (2.0 * z1) + 2.0 * xa * tan_a / z1 + inv_a;
+        double half2 = M_PI / (2.0 * z2) + 2.0 * xb * tan_a / z2 + inv_a;
+        double cos1 = rb1 / ra1, cos2 = rb2 / ra2;
+        double sin1 = std::sqrt(std::max(0.0, 1.0 - cos1 * cos1));
+        double sin2 = std::sqrt(std::max(0.0, 1.0 - cos2 * cos2));
+        c.tip1 = 2.0 * ra1 * (half1 - (sin1 / cos1 - vec_atan2(sin1, cos1))) / m;
+        c.tip2 = 2.0 * ra2 * (half2 - (sin2 / cos2 - vec_atan2(sin2, cos2))) / m;
+        double base_ratio = vec_log(std::max(rb1 * half1, eps) / std::max(rb2 * half2, eps));
+
+        double violation = std::max(0.0, xmin1 - xa) + std::max(0.0, xmin2 - xb) +
+                           std::max(0.0, o.min_tip - c.tip1) + std::max(0.0, o.min_tip - c.tip2) +
+                           std::max(0.0, o.min_contact - c.contact) + std::max(0.0, -c.form1) +
+                           std::max(0.0, -c.form2);
+        c.cost = std::max(c.sliding1, c.sliding2) + o.strength_weight * std::fabs(base_ratio) + 1e3 * violation;
+        return c;
+    }
+
+    // Costs of a grid of candidates: one stream in, one out, so a single
+    // alias check guards the vector loop
+    void score(const double* x1, size_t n, double* cost) const {
+        for (size_t i = 0; i < n; ++i) cost[i] = evaluate(x1[i]).cost;
+    }
+};
+
+}  // unnamed namespace
+
+double ProfileShiftOptimizer::min_shift(int n, double pa) {
+    double s = std::sin(pa * M_PI / 180.0);
+    return 1.0 - n * s * s / 2.0;
+}
+
+std::pair<GearParams, GearParams> ShiftResult::gears(const ShiftPair& pair) const {
+    GearCalculator calc;
+    auto make = [&](int n, double x) {
+        GearParams p = GearParams::spec(n, pair.dp, pair.pa, x);
+        p.cd = cd;
+        p = calc.calculate(p);
+        p.a -= tip_shortening / p.dp;
+        p.wd -= tip_shortening / p.dp;
+        p.od -= 2.0 * tip_shortening / p.dp;
+        return p;
+    };
+    return {make(pair.n1, x1), make(pair.n2, x2)};
+}
+
+ShiftResult ProfileShiftOptimizer::optimize(const ShiftPair& pair) const {
+    if (pair.n1 < 5 || pair.n2 < 5 || !(pair.dp > 0.0) || !(pair.pa > 0.0 && pair.pa < 45.0)) {
+        throw std::runtime_error("Invalid pair " + pair.id + ": needs teeth of at least 5, DP above zero and a PA");
+    }
+    ShiftResult r;
+    r.id = pair.id;
+    PairGeometry g(options, pair);
+    r.cd = g.cd;
+    r.working_pa = g.alpha_w * 180.0 / M_PI;
+    r.tip_shortening = g.shortening;
+    r.x1 = r.x2 = r.sliding1 = r.sliding2 = r.contact_ratio = r.tip1 = r.tip2 = r.cost = NAN;
+    if (std::isnan(g.alpha_w)) {
+        r.note = "center distance below the base circles";
+        return r;
+    }
+    const double lo0 = std::max(options.x_min, g.sum - options.x_max);
+    const double hi0 = std::min(options.x_max, g.sum - options.x_min);
+    if (lo0 > hi0) {
+        r.note = "center distance needs x1 + x2 = " + number_to_string(g.sum, 3);
+        return r;
+    }
+
+    // Grid, then narrow to the best candidate's neighbours
+    const size_t n = std::max<size_t>(options.grid, 3);
+    std::vector<double> x(n), cost(n);
+    double lo = lo0, hi = hi0, best = lo0;
+    for (int pass = 0; pass <= options.refine_passes; ++pass) {
+        double step = (hi - lo) / (n - 1);
+        for (size_t i = 0; i < n; ++i) x[i] = lo + step * i;
+        g.score(x.data(), n, cost.data());
+        best = x[std::min_element(cost.begin(), cost.end()) - cost.begin()];
+        lo = std::max(lo0, best - step);
+        hi = std::min(hi0, best + step);
+        if (hi - lo < 1e-9) break;
+    }
+
+    Candidate c = g.evaluate(best);
+    r.x1 = best;
+    r.x2 = g.sum - best;
+    r.sliding1 = c.sliding1;
+    r.sliding2 = c.sliding2;
+    r.contact_ratio = c.contact;
+    r.tip1 = c.tip1;
+    r.tip2 = c.tip2;
+    r.cost = c.cost;
+    if (r.x1 < g.xmin1) r.note = "pinion undercut";
+    else if (r.x2 < g.xmin2) r.note = "gear undercut";
+    else if (c.form1 < 0.0 || c.form2 < 0.0) r.note = "interference";
+    else if (r.tip1 < options.min_tip) r.note = "pinion tip pointed";
+    else if (r.tip2 < options.min_tip) r.note = "gear tip pointed";
+    else if (r.contact_ratio < options.min_contact) r.note = "contact ratio low";
+    r.feasible = r.note.empty();
+    return r;
+}
+
+std::vector<ShiftResult> ProfileShiftOptimizer::optimize(const std::vector<ShiftPair>& pairs, unsigned threads) const {
+    std::vector<ShiftResult> results(pairs.size());
+    utils::parallel_for(pairs.size(), [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) results[i] = optimize(pairs[i]);
+    }, threads);
+    return results;
+}
+
+}  // namespace gearforge
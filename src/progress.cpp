@@ -0,0 +1,111 @@
+#include <unistd.h>
+
+#include "progress.h"
+
+namespace gearforge {
+
+ProgressReporter::ProgressReporter() : enabled(isatty(fileno(stdout)) != 0) {}
+
+ProgressReporter::~ProgressReporter() {
+    std::unique_lock<std::mutex> lock(mutex);
+    stop_renderer(lock);
+}
+
+ProgressReporter& ProgressReporter::instance() {
+    static ProgressReporter reporter;
+    return reporter;
+}
+
+std::shared_ptr<ProgressTask> ProgressReporter::begin(const std::string& label, uint64_t total) {
+    auto task = std::make_shared<ProgressTask>();
+    task->label = label;
+    task->total.store(total, std::memory_order_relaxed);
+
+    std::lock_guard<std::mutex> lock(mutex);
+    tasks.push_back(task);
+    if (enabled && !renderer.joinable()) {
+        renderer = std::thread(&ProgressReporter::render_loop, this, generation);
+    }
+    return task;
+}
+
+void ProgressReporter::end(const std::shared_ptr<ProgressTask>& task) {
+    task->done.store(task->total.load(std::memory_order_relaxed), std::memory_order_relaxed);
+    task->finished.store(true, std::memory_order_relaxed);
+
+    std::unique_lock<std::mutex> lock(mutex);
+    // Last task out draws the final 100% frame and parks the renderer
+    if (enabled && tasks.size() == 1 && tasks[0] == task) render_frame();
+    tasks.erase(std::remove(tasks.begin(), tasks.end(), task), tasks.end());
+    if (tasks.empty()) {
+        stop_renderer(lock);
+        lines_drawn = 0;
+    }
+}
+
+void ProgressReporter::set_enabled(bool on) {
+    std::unique_lock<std::mutex> lock(mutex);
+    enabled = on;
+    if (!enabled) {
+        stop_renderer(lock);
+    } else if (!tasks.empty() && !renderer.joinable()) {
+        renderer = std::thread(&ProgressReporter::render_loop, this, generation);
+    }
+}
+
+void ProgressReporter::set_refresh_interval(std::chrono::milliseconds ms) {
+    std::lock_guard<std::mutex> lock(mutex);
+    interval = ms;
+}
+
+void ProgressReporter::render_loop(uint64_t gen) {
+    std::unique_lock<std::mutex> lock(mutex);
+    while (generation == gen) {
+        wake.wait_for(lock, interval, [this, gen] { return generation != gen; });
+        if (generation == gen) render_frame();
+    }
+}
+
+void ProgressReporter::render_frame() {
+    const int bar_width = 50;
+    std::string frame;
+    // Move back over the previous frame so concurrent tasks redraw in place
+    if (lines_drawn > 0) frame += "\033[" + std::to_string(lines_drawn) + "A";
+    for (const auto& task : tasks) {
+        uint64_t done = task->done.load(std::memory_order_relaxed);
+        uint64_t total = task->total.load(std::memory_order_relaxed);
+        double frac = total == 0 ? 1.0 : std::min(1.0, static_cast<double>(done) / total);
+        int width = static_cast<int>(frac * bar_width);
+
+        frame += "\r\033[2K" + task->label + " [" + utils::COLOR_GREEN;
+        frame.append(width, '=');
+        frame += ">" + utils::COLOR_RESET;
+        frame.append(bar_width - width, ' ');
+        char pct[8];
+        std::snprintf(pct, sizeof(pct), "%3d%%", static_cast<int>(frac * 100));
+        frame += "] " + std::string(pct) + "\n";
+    }
+    frame += "\033[J";  // Clear lines left over from tasks that ended
+    lines_drawn = tasks.size();
+    std::cout << frame << std::flush;
+}
+
+void ProgressReporter::stop_renderer(std::unique_lock<std::mutex>& lock) {
+    if (!renderer.joinable()) return;
+    // Bumping the generation retires this renderer without racing a new one
+    std::thread worker = std::move(renderer);
+    ++generation;
+    wake.notify_all();
+    lock.unlock();
+    worker.join();
+    lock.lock();
+}
+
+ScopedProgress::ScopedProgress(const std::string& label, uint64_t total)
+    : task(ProgressReporter::instance().begin(label, total)) {}
+
+ScopedProgress::~ScopedProgress() {
+    ProgressReporter::instance().end(task);
+}
+
+}  // namespace gearforge
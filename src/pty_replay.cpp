@@ -0,0 +1,253 @@
+#include <fcntl.h>
+#include <poll.h>
+#include <pty.h>
+#include <signal.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "pty_replay.h"
+
+namespace gearforge {
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+double ms_since(Clock::time_point start, Clock::time_point end) {
+    return std::chrono::duration<double, std::milli>(end - start).count();
+}
+
+// Bytes a terminal sends for a named key; empty if the name is unknown
+std::string key_bytes(const std::string& name) {
+    static const std::map<std::string, std::string> named = {
+        {"up", "\033[A"}, {"down", "\033[B"}, {"right", "\033[C"}, {"left", "\033[D"},
+        {"enter", "\r"}, {"tab", "\t"}, {"backspace", "\x7f"}, {"esc", "\033"}, {"space", " "}};
+    if (name.size() == 1) return name;
+    auto it = named.find(name);
+    return it == named.end() ? "" : it->second;
+}
+
+std::string key_name(const std::string& bytes) {
+    static const std::map<std::string, std::string> names = {
+        {"\033[A", "up"}, {"\033[B", "down"}, {"\033[C", "right"}, {"\033[D", "left"},
+        {"\r", "enter"}, {"\t", "tab"}, {"\x7f", "backspace"}, {"\033", "esc"}, {" ", "space"}};
+    auto it = names.find(bytes);
+    return it == names.end() ? bytes : it->second;
+}
+
+}  // unnamed namespace
+
+std::vector<ReplayStep> parse_trace(std::istream& in) {
+    std::vector<ReplayStep> steps;
+    std::string line;
+    int number = 0;
+    while (std::getline(in, line)) {
+        ++number;
+        if (!line.empty() && line.back() == '\r') line.pop_back();
+        std::string trimmed = utils::trim(line);
+        if (trimmed.empty() || trimmed[0] == '#') continue;
+
+        size_t space = trimmed.find(' ');
+        std::string command = trimmed.substr(0, space);
+        // Text arguments keep inner spaces; only the separator is dropped
+        std::string arg = space == std::string::npos ? "" : trimmed.substr(space + 1);
+        auto fail = [&](const std::string& what) {
+            throw std::runtime_error("Trace line " + std::to_string(number) + ": " + what);
+        };
+
+        ReplayStep step;
+        step.line = number;
+        if (command == "key") {
+            step.bytes = key_bytes(arg);
+            if (step.bytes.empty()) fail("unknown key '" + arg + "'");
+            steps.push_back(step);
+        } else if (command == "type") {
+            if (arg.empty()) fail("type needs text");
+            for (char c : arg) {
+                step.bytes = std::string(1, c);
+                steps.push_back(step);
+            }
+        } else if (command == "expect") {
+            if (arg.empty()) fail("expect needs text");
+            step.kind = ReplayStep::Expect;
+            step.bytes = arg;
+            steps.push_back(step);
+        } else if (command == "wait") {
+            step.kind = ReplayStep::Wait;
+            try {
+                step.wait_ms = std::stoi(arg);
+            } catch (const std::exception&) {
+                fail("wait needs milliseconds");
+            }
+            steps.push_back(step);
+        } else {
+            fail("unknown command '" + command + "'");
+        }
+    }
+    return steps;
+}
+
+LatencySummary PtyReplay::summarize(std::vector<double> samples) {
+    samples.erase(std::remove_if(samples.begin(), samples.end(), [](double v) { return std::isnan(v); }),
+                  samples.end());
+    LatencySummary s;
+    s.frames = samples.size();
+    if (samples.empty()) return s;
+    std::sort(samples.begin(), samples.end());
+    // Nearest rank, so p99 of a short trace is its worst frame rather than an interpolation
+    auto rank = [&](double p) {
+        size_t r = static_cast<size_t>(std::ceil(p * samples.size()));
+        return samples[std::min(samples.size(), std::max<size_t>(r, 1)) - 1];
+    };
+    s.p50 = rank(0.50);
+    s.p90 = rank(0.90);
+    s.p99 = rank(0.99);
+    s.max = samples.back();
+    return s;
+}
+
+bool PtyReplay::start(ReplayReport& report) {
+    if (options.argv.empty()) {
+        report.error = "No program to run";
+        return false;
+    }
+    struct winsize size = {};
+    size.ws_row = options.rows;
+    size.ws_col = options.cols;
+    child = forkpty(&master, nullptr, nullptr, &size);
+    if (child < 0) {
+        report.error = std::string("forkpty failed: ") + std::strerror(errno);
+        return false;
+    }
+    if (child == 0) {
+        if (!options.workdir.empty() && chdir(options.workdir.c_str()) != 0) _exit(127);
+        setenv("TERM", "xterm", 1);
+        std::vector<char*> args;
+        for (const auto& a : options.argv) args.push_back(const_cast<char*>(a.c_str()));
+        args.push_back(nullptr);
+        execvp(args[0], args.data());
+        _exit(127);
+    }
+    fcntl(master, F_SETFL, fcntl(master, F_GETFL) | O_NONBLOCK);
+    return true;
+}
+
+void PtyReplay::stop() {
+    if (master >= 0) {
+        close(master);  // The program sees a hangup
+        master = -1;
+    }
+    if (child > 0) {
+        int status = 0;
+        // Give it a moment to leave on SIGHUP before forcing the issue
+        for (int i = 0; i < 50 && waitpid(child, &status, WNOHANG) == 0; ++i) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+            if (i == 20) kill(child, SIGTERM);
+        }
+        if (waitpid(child, &status, WNOHANG) == 0) {
+            kill(child, SIGKILL);
+            waitpid(child, &status, 0);
+        }
+        child = -1;
+    }
+}
+
+long PtyReplay::read_chunk(int timeout_ms) {
+    if (exited) return -1;
+    struct pollfd pfd = {master, POLLIN, 0};
+    int ready = poll(&pfd, 1, std::max(0, timeout_ms));
+    if (ready < 0 && errno == EINTR) return 0;
+    if (ready <= 0) return ready == 0 ? 0 : -1;
+    char buf[16384];
+    ssize_t got = read(master, buf, sizeof(buf));
+    if (got > 0) {
+        screen.append(buf, static_cast<size_t>(got));
+        return got;
+    }
+    if (got < 0 && (errno == EAGAIN || errno == EINTR)) return 0;
+    // EIO on Linux once the last slave descriptor closes
+    exited = true;
+    return -1;
+}
+
+ReplayReport PtyReplay::run(const std::vector<ReplayStep>& steps) {
+    ReplayReport report;
+    screen.clear();
+    exited = false;
+    if (!start(report)) {
+        report.ok = false;
+        return report;
+    }
+
+    for (const auto& step : steps) {
+        auto fail = [&](const std::string& what) {
+            report.ok = false;
+            report.error = "Trace line " + std::to_string(step.line) + ": " + what;
+        };
+
+        if (step.kind == ReplayStep::Wait) {
+            auto until = Clock::now() + std::chrono::milliseconds(step.wait_ms);
+            for (auto now = Clock::now(); now < until; now = Clock::now()) {
+                long left = static_cast<long>(std::ceil(ms_since(now, until)));
+                if (read_chunk(static_cast<int>(left)) < 0) break;
+            }
+            continue;
+        }
+
+        if (step.kind == ReplayStep::Expect) {
+            auto deadline = Clock::now() + std::chrono::milliseconds(options.expect_timeout_ms);
+            size_t found;
+            while ((found = screen.find(step.bytes)) == std::string::npos) {
+                auto now = Clock::now();
+                if (now >= deadline || read_chunk(static_cast<int>(std::ceil(ms_since(now, deadline)))) < 0) break;
+            }
+            if (found == std::string::npos) {
+                fail(exited ? "program exited before \"" + step.bytes + "\""
+                            : "timed out waiting for \"" + step.bytes + "\"");
+                break;
+            }
+            screen.erase(0, found + step.bytes.size());
+            continue;
+        }
+
+        // Anything still arriving belongs to the previous frame
+        while (read_chunk(0) > 0) {}
+        if (exited) {
+            fail("program exited before key " + key_name(step.bytes));
+            break;
+        }
+
+        FrameSample frame{key_name(step.bytes), NAN, NAN, 0};
+        auto sent = Clock::now();
+        if (write(master, step.bytes.data(), step.bytes.size()) != static_cast<ssize_t>(step.bytes.size())) {
+            fail(std::string("write failed: ") + std::strerror(errno));
+            break;
+        }
+        // First byte within frame_timeout_ms, then the frame ends once the
+        // output has been quiet for settle_ms
+        long got = read_chunk(options.frame_timeout_ms);
+        if (got > 0) frame.first_byte_ms = ms_since(sent, Clock::now());
+        while (got > 0) {
+            frame.settle_ms = ms_since(sent, Clock::now());
+            frame.bytes += static_cast<size_t>(got);
+            got = read_chunk(options.settle_ms);
+        }
+        report.frames.push_back(frame);
+    }
+    stop();
+
+    std::vector<double> first, settle;
+    size_t total = 0;
+    for (const auto& f : report.frames) {
+        first.push_back(f.first_byte_ms);
+        settle.push_back(f.settle_ms);
+        total += f.bytes;
+        report.max_bytes = std::max(report.max_bytes, f.bytes);
+    }
+    report.first_byte = summarize(first);
+    report.settle = summarize(settle);
+    report.mean_bytes = report.frames.empty() ? 0.0 : static_cast<double>(total) / report.frames.size();
+    return report;
+}
+
+}  // namespace gearforge
@@ -0,0 +1,70 @@
+#include "record_codec.h"
+
+namespace gearforge {
+
+namespace {
+
+template <typename V>
+bool parse_number(const char* begin, const char* end, V& out) {
+    // from_chars rejects a leading '+', which std::stod accepted
+    if (begin < end && *begin == '+' && end - begin > 1 && begin[1] != '-') ++begin;
+    if (begin == end) return false;
+    auto res = std::from_chars(begin, end, out);
+    return res.ec == std::errc() && res.ptr == end;
+}
+
+}  // unnamed namespace
+
+bool parse_field(const char* begin, const char* end, int& out) { return parse_number(begin, end, out); }
+bool parse_field(const char* begin, const char* end, double& out) { return parse_number(begin, end, out); }
+bool parse_field(const char* begin, const char* end, float& out) { return parse_number(begin, end, out); }
+
+bool parse_field(const char* begin, const char* end, Fixed& out) {
+    double v;
+    if (!parse_number(begin, end, v)) return false;
+    out = Fixed::from_double(v);
+    return true;
+}
+
+bool parse_field(const char* begin, const char* end, std::string& out) {
+    out.assign(begin, end);
+    return true;
+}
+
+bool CsvLines::open(const std::string& filename) {
+    std::ifstream file(filename, std::ios::binary);
+    if (!file) return false;
+    std::error_code ec;
+    uint64_t size = std::filesystem::file_size(filename, ec);
+    if (ec) return false;
+    text.resize(size);
+    file.read(&text[0], static_cast<std::streamsize>(size));
+    text.resize(static_cast<size_t>(file.gcount()));
+    assign(text);
+    return true;
+}
+
+void CsvLines::assign(std::string_view contents) {
+    bytes = contents;
+    pos = 0;
+    line_number = 0;
+}
+
+bool CsvLines::next(const char*& begin, const char*& end) {
+    while (pos < bytes.size()) {
+        const char* start = bytes.data() + pos;
+        const char* last = bytes.data() + bytes.size();
+        const char* stop = static_cast<const char*>(std::memchr(start, '\n', last - start));
+        if (!stop) stop = last;
+        pos = stop - bytes.data() + (stop < last ? 1 : 0);
+        ++line_number;
+        if (stop > start && stop[-1] == '\r') --stop;
+        if (std::all_of(start, stop, [](char c) { return c == ' ' || c == '\t'; })) continue;
+        begin = start;
+        end = stop;
+        return true;
+    }
+    return false;
+}
+
+}  // namespace gearforge
@@ -0,0 +1,114 @@
+#include <unistd.h>
+
+#include "pty_replay.h"
+#include "utils.h"
+
+using namespace gearforge;
+
+namespace {
+
+// Fresh working directory per trace so runs can't see each other's data;
+// single_user skips the login screen
+std::string make_workdir(const std::string& data_dir, size_t index) {
+    namespace fs = std::filesystem;
+    fs::path dir = fs::temp_directory_path() /
+                   ("gearforge-replay-" + std::to_string(getpid()) + "-" + std::to_string(index));
+    fs::remove_all(dir);
+    fs::create_directories(dir / "data");
+    if (!data_dir.empty()) {
+        for (const auto& entry : fs::directory_iterator(data_dir)) {
+            if (entry.is_regular_file()) fs::copy_file(entry.path(), dir / "data" / entry.path().filename());
+        }
+    }
+    if (!fs::exists(dir / "data" / "settings.ini")) {
+        std::ofstream(dir / "data" / "settings.ini") << "single_user = true" << std::endl;
+    }
+    return dir.string();
+}
+
+void print_summary(const std::string& name, const LatencySummary& s) {
+    std::cout << "  " << name << " (ms): p50 " << s.p50 << ", p90 " << s.p90 << ", p99 " << s.p99
+              << ", max " << s.max << " over " << s.frames << " frames" << std::endl;
+}
+
+}  // unnamed namespace
+
+// Replays keystroke traces against gearforge on a pseudo-terminal and
+// reports keypress-to-frame latency; exits non-zero when a trace fails or
+// a frame budget is exceeded
+int main(int argc, char** argv) {
+    const char* usage = "Usage: gearforge_replay [--binary=build/gearforge] [--data=dir] [--settle-ms=30] "
+                        "[--max-p99-ms=N] [--verbose] <trace>...";
+    ReplayOptions options;
+    std::string binary = "build/gearforge";
+    std::string data_dir;
+    double max_p99 = NAN;
+    bool verbose = false;
+    std::vector<std::string> traces;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--help") {
+            std::cout << usage << std::endl;
+            return 0;
+        } else if (arg.find("--binary=") == 0) {
+            binary = arg.substr(9);
+        } else if (arg.find("--data=") == 0) {
+            data_dir = arg.substr(7);
+        } else if (arg.find("--settle-ms=") == 0) {
+            options.settle_ms = std::stoi(arg.substr(12));
+        } else if (arg.find("--max-p99-ms=") == 0) {
+            max_p99 = utils::safe_stod(arg.substr(13));
+        } else if (arg == "--verbose") {
+            verbose = true;
+        } else if (arg.find("--") != 0) {
+            traces.push_back(arg);
+        }
+    }
+    if (traces.empty()) {
+        std::cerr << usage << std::endl;
+        return 1;
+    }
+    // The program runs in its own working directory
+    options.argv = {std::filesystem::absolute(binary).string()};
+
+    bool passed = true;
+    for (size_t t = 0; t < traces.size(); ++t) {
+        std::ifstream file(traces[t]);
+        if (!file) {
+            std::cerr << "Cannot read " << traces[t] << std::endl;
+            passed = false;
+            continue;
+        }
+        std::vector<ReplayStep> steps;
+        try {
+            steps = parse_trace(file);
+        } catch (const std::exception& e) {
+            std::cerr << traces[t] << ": " << e.what() << std::endl;
+            passed = false;
+            continue;
+        }
+
+        options.workdir = make_workdir(data_dir, t);
+        ReplayReport report = PtyReplay(options).run(steps);
+        std::filesystem::remove_all(options.workdir);
+
+        std::cout << traces[t] << ": " << report.frames.size() << " keys" << std::endl;
+        if (verbose) {
+            for (const auto& f : report.frames) {
+                std::cout << "  key " << f.key << ": first byte " << f.first_byte_ms << " ms, settled "
+                          << f.settle_ms << " ms, " << f.bytes << " bytes" << std::endl;
+            }
+        }
+        print_summary("First byte", report.first_byte);
+        print_summary("Frame", report.settle);
+        std::cout << "  Bytes per frame: mean " << report.mean_bytes << ", max " << report.max_bytes << std::endl;
+        if (!report.ok) {
+            std::cout << "  FAILED: " << report.error << std::endl;
+            passed = false;
+        } else if (!std::isnan(max_p99) && report.settle.p99 > max_p99) {
+            std::cout << "  FAILED: frame p99 " << report.settle.p99 << " ms over budget " << max_p99 << " ms" << std::endl;
+            passed = false;
+        }
+    }
+    return passed ? 0 : 1;
+}
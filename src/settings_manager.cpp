@@ -1,22 +1,73 @@
+#include "progress.h"
 #include "settings_manager.h"
 
 namespace gearforge {
 
-SettingsManager::SettingsManager() {
-    load();
+SettingsManager::SettingsManager(const std::string& filename) : file(filename) {}
+
+const SettingsManager::Map& SettingsManager::current() const {
+    // Read the version first: a publish racing the view only costs another parse next time
+    uint64_t version = file.version();
+    if (version != parsed_version) {
+        parsed = file.view([](std::string_view text) { return parse_ini(text); });
+        parsed_version = version;
+    }
+    return parsed;
+}
+
+std::string SettingsManager::get(const std::string& key, const std::string& fallback) const {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = pending.find(key);
+    if (it != pending.end()) return it->second;
+    if (erased.count(key) > 0) return fallback;
+    const Map& data = current();
+    auto found = data.find(key);
+    return found == data.end() ? fallback : found->second;
+}
+
+bool SettingsManager::has(const std::string& key) const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return pending.count(key) > 0 || (erased.count(key) == 0 && current().count(key) > 0);
+}
+
+std::map<std::string, std::string> SettingsManager::all() {
+    std::lock_guard<std::mutex> lock(mutex);
+    file.refresh();  // Hand edits to the file
+    const Map& data = current();
+    std::map<std::string, std::string> out(data.begin(), data.end());
+    for (const auto& key : erased) out.erase(key);
+    for (const auto& pair : pending) out[pair.first] = pair.second;
+    return out;
+}
+
+void SettingsManager::set(const std::string& key, const std::string& value) {
+    std::lock_guard<std::mutex> lock(mutex);
+    pending[key] = value;
+    erased.erase(key);
 }
 
-void SettingsManager::load() {
+void SettingsManager::erase(const std::string& key) {
     std::lock_guard<std::mutex> lock(mutex);
-    data = read_ini(filename);
+    pending.erase(key);
+    erased.insert(key);
 }
 
 void SettingsManager::save() {
     std::lock_guard<std::mutex> lock(mutex);
-    std::ofstream file(filename);
-    for (auto pair : data) {
-        file << pair.first << " = " << pair.second << std::endl;
-    }
+    file.update([&](std::string& text) {
+        Map merged = parse_ini(text);
+        for (const auto& key : erased) merged.erase(key);
+        for (const auto& pair : pending) merged[pair.first] = pair.second;
+        std::map<std::string, std::string> sorted(merged.begin(), merged.end());
+        std::ostringstream out;
+        for (const auto& pair : sorted) {
+            out << pair.first << " = " << pair.second << std::endl;
+        }
+        text = out.str();
+        return true;
+    });
+    pending.clear();
+    erased.clear();
 }
 
 void SettingsManager::add_setting(std::string& line) {
@@ -26,24 +77,23 @@ void SettingsManager::add_setting(std::string& line) {
     } else {
         const size_t p = line.find(':');
         if (p == std::string::npos) {
-            data[line] = "";
+            set(line, "");
         } else {
-            std::string key = utils::trim(line.substr(0, p));
-            std::string value = utils::trim(line.substr(p + 1));
-            data[key] = value;
+            set(utils::trim(line.substr(0, p)), utils::trim(line.substr(p + 1)));
         }
     }
 }
 
-std::unordered_map<std::string, std::string> SettingsManager::read_ini(const std::string& filename) {
-    std::unordered_map<std::string, std::string> data;
-    std::ifstream file(filename);
-
-    if (!file) return data;
-
-    std::string line;
-    while (std::getline(file, line)) {
-        line = utils::trim(line);
+SettingsManager::Map SettingsManager::parse_ini(std::string_view text) {
+    Map data;
+    ScopedProgress progress("Loading settings", text.size());
+    size_t offset = 0;
+    while (offset < text.size()) {
+        size_t stop = text.find('\n', offset);
+        if (stop == std::string_view::npos) stop = text.size();
+        std::string line = utils::trim(std::string(text.substr(offset, stop - offset)));
+        offset = stop + 1;
+        progress.set(std::min(offset, text.size()));
         if (line.empty() || line[0] == ';') {
                 continue;
         } else {
@@ -0,0 +1,404 @@
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "shared_state.h"
+
+namespace gearforge {
+
+namespace {
+
+constexpr char kMagic[8] = {'G', 'F', 'S', 'H', 'M', '2', '\0', '\0'};
+
+// Segment names must be stable across builds, so no std::hash
+uint64_t fnv1a(const std::string& text) {
+    uint64_t h = 0xcbf29ce484222325ULL;
+    for (unsigned char c : text) h = (h ^ c) * 0x100000001b3ULL;
+    return h;
+}
+
+std::string segment_name(const std::string& path) {
+    std::error_code ec;
+    auto absolute = std::filesystem::weakly_canonical(std::filesystem::absolute(path, ec), ec);
+    char name[32];
+    std::snprintf(name, sizeof name, "/gearforge-%016llx", static_cast<unsigned long long>(fnv1a(absolute.string())));
+    return name;
+}
+
+// "" when the file does not exist
+std::string read_file(const std::string& path) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file) return "";
+    return std::string(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+}
+
+// Segments are created 0600. One that another user made, or that others
+// could write to, may hold forged contents (a users.csv with an extra
+// Admin, say) and is never used.
+bool trusted_segment(int fd) {
+    struct stat st;
+    return ::fstat(fd, &st) == 0 && st.st_uid == ::geteuid() && (st.st_mode & (S_IWGRP | S_IWOTH)) == 0;
+}
+
+// Whether name still links to the segment open on fd
+bool still_linked(int fd, const std::string& name) {
+    int again = ::shm_open(name.c_str(), O_RDONLY | O_CLOEXEC, 0);
+    if (again < 0) return false;
+    struct stat mine, now;
+    bool same = ::fstat(fd, &mine) == 0 && ::fstat(again, &now) == 0 && mine.st_ino == now.st_ino &&
+                mine.st_dev == now.st_dev;
+    ::close(again);
+    return same;
+}
+
+// Opens name and holds a shared flock on it while fd stays open. The
+// kernel drops the lock however the process ends (SIGKILL, a crash, a
+// closed terminal), so a segment that no process holds is stale. -1 if it
+// can't be opened or isn't trusted; errno is then shm_open's.
+int hold_segment(const std::string& name, int flags) {
+    static std::once_flag swept;
+    std::call_once(swept, [] { remove_stale_segments(); });
+    for (int attempt = 0; attempt < 8; ++attempt) {
+        int fd = ::shm_open(name.c_str(), O_RDWR | O_CLOEXEC | flags, 0600);
+        if (fd < 0) return -1;
+        int rc = -1;
+        if (trusted_segment(fd)) {
+            while ((rc = ::flock(fd, LOCK_SH)) != 0 && errno == EINTR) {}
+        }
+        if (rc != 0) {
+            ::close(fd);
+            return -1;
+        }
+        if (still_linked(fd, name)) return fd;
+        // Unlinked as stale between the open and the lock: start over with whatever the name is now
+        ::close(fd);
+    }
+    return -1;
+}
+
+// Unlinks name if no other process holds the segment, then closes fd
+void release_segment(int fd, const std::string& name) {
+    if (::flock(fd, LOCK_EX | LOCK_NB) == 0 && still_linked(fd, name)) ::shm_unlink(name.c_str());
+    ::close(fd);
+}
+
+bool write_all(int fd, const char* p, size_t n) {
+    while (n > 0) {
+        ssize_t w = ::write(fd, p, n);
+        if (w < 0 && errno == EINTR) continue;
+        if (w <= 0) return false;
+        p += w;
+        n -= static_cast<size_t>(w);
+    }
+    return true;
+}
+
+}  // unnamed namespace
+
+FileLock::FileLock(const std::string& path) {
+    std::string lock_path = path + ".lock";
+    fd = ::open(lock_path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0666);
+    if (fd < 0 && errno == ENOENT) {
+        std::error_code ec;
+        std::filesystem::create_directories(std::filesystem::path(lock_path).parent_path(), ec);
+        fd = ::open(lock_path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0666);
+    }
+    if (fd < 0) return;
+    int rc;
+    while ((rc = ::flock(fd, LOCK_EX)) != 0 && errno == EINTR) {}
+    if (rc != 0) {
+        ::close(fd);
+        fd = -1;
+    }
+}
+
+FileLock::~FileLock() {
+    if (fd >= 0) ::close(fd);  // Releases the lock
+}
+
+bool replace_file(const std::string& path, const std::string& contents) {
+    std::string temp = path + ".tmp." + std::to_string(::getpid());
+    int fd = ::open(temp.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0666);
+    if (fd < 0) return false;
+    struct stat st;
+    if (::stat(path.c_str(), &st) == 0) ::fchmod(fd, st.st_mode & 07777);  // Keep the old file's permissions
+    bool ok = write_all(fd, contents.data(), contents.size()) && ::fsync(fd) == 0;
+    ok = ::close(fd) == 0 && ok;
+    if (!ok || ::rename(temp.c_str(), path.c_str()) != 0) {
+        ::unlink(temp.c_str());
+        return false;
+    }
+    // The rename itself is only durable once the directory is synced
+    std::string dir = std::filesystem::path(path).parent_path().string();
+    int dir_fd = ::open(dir.empty() ? "." : dir.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (dir_fd >= 0) {
+        ::fsync(dir_fd);
+        ::close(dir_fd);
+    }
+    return true;
+}
+
+SharedFile::SharedFile(const std::string& p, size_t capacity) : path(p), name(segment_name(p)) {
+    // Setting up the segment needs the lock; without it this process keeps a private copy
+    FileLock lock(path);
+    if (lock.locked()) fd = hold_segment(name, O_CREAT);
+    struct stat st;
+    if (fd >= 0 && ::fstat(fd, &st) == 0) {
+        bool fresh = static_cast<size_t>(st.st_size) < sizeof(Header);
+        if (!fresh || ::ftruncate(fd, sizeof(Header) + capacity) == 0) {
+            std::lock_guard<std::mutex> map_lock(map_mutex);
+            try {
+                ensure_mapped(sizeof(Header));
+            } catch (const std::runtime_error&) {
+                // Falls back to a private copy below
+            }
+        }
+    }
+    if (!header) {
+        // No shared memory here: a private copy, still locked and replaced like the shared one
+        if (fd >= 0) ::close(fd);
+        fd = -1;
+        publish(read_file(path));
+        return;
+    }
+    if (std::memcmp(header->magic, kMagic, sizeof kMagic) != 0) {
+        // New segment (ftruncate zeroed it); the -2 stamp makes it load below
+        header->capacity.store(mapped - sizeof(Header));
+        header->file_mtime.store(-2);
+        std::memcpy(header->magic, kMagic, sizeof kMagic);
+    }
+    if (file_changed()) publish(read_file(path));
+}
+
+SharedFile::~SharedFile() {
+    for (auto& m : retired) ::munmap(m.first, m.second);
+    if (header) {
+        ::munmap(header, mapped);
+        FileLock lock(path);
+        release_segment(fd, name);
+    }
+}
+
+void SharedFile::ensure_mapped(size_t bytes) const {
+    struct stat st;
+    if (::fstat(fd, &st) != 0 || static_cast<size_t>(st.st_size) < bytes) {
+        throw std::runtime_error("Shared segment for " + path + " is smaller than its contents");
+    }
+    size_t length = static_cast<size_t>(st.st_size);
+    void* p = ::mmap(nullptr, length, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (p == MAP_FAILED) throw std::runtime_error("Could not map shared segment for " + path);
+    if (header) retired.emplace_back(header, mapped);
+    header = static_cast<Header*>(p);
+    mapped = length;
+}
+
+SharedFile::Stamp SharedFile::recorded() const {
+    if (!header) return local_stamp;
+    Stamp s;
+    s.inode = header->file_inode.load(std::memory_order_relaxed);
+    s.size = header->file_size.load(std::memory_order_relaxed);
+    s.mtime = header->file_mtime.load(std::memory_order_relaxed);
+    return s;
+}
+
+bool SharedFile::file_changed() const {
+    Stamp want = recorded();
+    struct stat st;
+    if (::stat(path.c_str(), &st) != 0) return want.mtime != -1;
+    return want.inode != static_cast<uint64_t>(st.st_ino) || want.size != static_cast<uint64_t>(st.st_size) ||
+           want.mtime != static_cast<int64_t>(st.st_mtim.tv_sec) * 1000000000 + st.st_mtim.tv_nsec;
+}
+
+void SharedFile::publish(const std::string& contents) {
+    Stamp now;
+    struct stat st;
+    if (::stat(path.c_str(), &st) == 0) {
+        now.inode = st.st_ino;
+        now.size = st.st_size;
+        now.mtime = static_cast<int64_t>(st.st_mtim.tv_sec) * 1000000000 + st.st_mtim.tv_nsec;
+    } else {
+        now.mtime = -1;
+    }
+    if (!header) {
+        std::lock_guard<std::mutex> lock(map_mutex);
+        local = contents;
+        local_stamp = now;
+        ++local_version;
+        return;
+    }
+
+    size_t need = sizeof(Header) + contents.size();
+    if (need > mapped) {
+        std::lock_guard<std::mutex> lock(map_mutex);
+        size_t grown = std::max(need, sizeof(Header) + 2 * header->capacity.load());
+        if (::ftruncate(fd, grown) != 0) throw std::runtime_error("Could not grow shared segment for " + path);
+        ensure_mapped(grown);
+        header->capacity.store(grown - sizeof(Header));
+    }
+
+    // Odd while the bytes change; a leftover odd count (a writer died here) is reused
+    uint64_t odd = header->sequence.load(std::memory_order_relaxed) | 1;
+    header->sequence.store(odd, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    std::memcpy(header->data(), contents.data(), contents.size());
+    header->size.store(contents.size(), std::memory_order_relaxed);
+    header->file_inode.store(now.inode, std::memory_order_relaxed);
+    header->file_size.store(now.size, std::memory_order_relaxed);
+    header->file_mtime.store(now.mtime, std::memory_order_relaxed);
+    header->sequence.store(odd + 1, std::memory_order_release);
+}
+
+std::string SharedFile::read_locked() const {
+    FileLock lock(path);
+    return read_file(path);
+}
+
+uint64_t SharedFile::version() const {
+    if (!header) {
+        std::lock_guard<std::mutex> lock(map_mutex);
+        return local_version;
+    }
+    return header->sequence.load(std::memory_order_acquire) / 2;
+}
+
+std::string SharedFile::read() const {
+    return view([](std::string_view bytes) { return std::string(bytes); });
+}
+
+bool SharedFile::update(const std::function<bool(std::string& contents)>& edit) {
+    FileLock lock(path);
+    if (!lock.locked()) throw std::runtime_error("Could not lock " + path + ".lock; not writing " + path);
+    std::string contents = read_file(path);
+    if (!edit(contents)) {
+        if (file_changed()) publish(read_file(path));
+        return false;
+    }
+    if (!replace_file(path, contents)) throw std::runtime_error("Could not write " + path);
+    publish(contents);
+    return true;
+}
+
+bool SharedFile::refresh() {
+    if (!file_changed()) return false;
+    FileLock lock(path);
+    if (!lock.locked() && header) return false;  // Publishing unlocked could race a writer
+    if (!file_changed()) return false;  // Another process got there first
+    publish(read_file(path));
+    return true;
+}
+
+void SharedFile::remove(const std::string& path) {
+    ::shm_unlink(segment_name(path).c_str());
+}
+
+size_t remove_stale_segments() {
+    size_t removed = 0;
+    std::error_code ec;
+    std::filesystem::directory_iterator it("/dev/shm", ec), end;
+    for (; !ec && it != end; it.increment(ec)) {
+        std::string file = it->path().filename().string();
+        if (file.rfind("gearforge-", 0) != 0) continue;
+        std::string name = "/" + file;
+        int fd = ::shm_open(name.c_str(), O_RDONLY | O_CLOEXEC, 0);
+        if (fd < 0) continue;
+        struct stat st;
+        // Any live holder (this process included, on its own descriptor) keeps its shared lock
+        if (::fstat(fd, &st) == 0 && st.st_uid == ::geteuid() && ::flock(fd, LOCK_EX | LOCK_NB) == 0 &&
+            still_linked(fd, name)) {
+            ::shm_unlink(name.c_str());
+            ++removed;
+        }
+        ::close(fd);
+    }
+    return removed;
+}
+
+struct SharedBlock::Header {
+    char magic[8];
+    std::atomic<uint32_t> ready;     // Set once the creator has filled the data
+    uint32_t unused;
+    uint64_t size;
+    char pad[40];                    // Data starts a cache line in
+
+    char* data() { return reinterpret_cast<char*>(this + 1); }
+};
+
+namespace {
+
+constexpr char kBlockMagic[8] = {'G', 'F', 'B', 'L', 'K', '2', '\0', '\0'};
+
+}  // unnamed namespace
+
+SharedBlock::SharedBlock(std::string n, int f, Header* h, size_t length)
+    : shm_name(std::move(n)), fd(f), header(h), mapped(length) {}
+
+SharedBlock::~SharedBlock() {
+    ::munmap(header, mapped);
+    release_segment(fd, shm_name);
+}
+
+std::shared_ptr<const SharedBlock> SharedBlock::attach(const std::string& name) {
+    int fd = hold_segment(name, 0);
+    if (fd < 0) return nullptr;
+    struct stat st;
+    void* p = MAP_FAILED;
+    if (::fstat(fd, &st) == 0 && static_cast<size_t>(st.st_size) >= sizeof(Header)) {
+        p = ::mmap(nullptr, st.st_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    }
+    if (p == MAP_FAILED) {
+        ::close(fd);
+        return nullptr;
+    }
+    auto* h = static_cast<Header*>(p);
+    size_t length = static_cast<size_t>(st.st_size);
+    // The creator sets the magic before it fills; a block that never becomes ready was abandoned
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+    while (std::memcmp(h->magic, kBlockMagic, sizeof kBlockMagic) != 0 || !h->ready.load(std::memory_order_acquire)) {
+        if (std::chrono::steady_clock::now() > deadline) {
+            ::shm_unlink(name.c_str());
+            ::munmap(p, length);
+            ::close(fd);
+            return nullptr;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    if (h->size + sizeof(Header) > length) {
+        ::munmap(p, length);
+        ::close(fd);
+        return nullptr;
+    }
+    return std::shared_ptr<const SharedBlock>(new SharedBlock(name, fd, h, length));
+}
+
+std::shared_ptr<const SharedBlock> SharedBlock::create(const std::string& name, size_t size,
+                                                       const std::function<void(char* data)>& fill) {
+    int fd = hold_segment(name, O_CREAT | O_EXCL);
+    if (fd < 0) return errno == EEXIST ? attach(name) : nullptr;
+    size_t length = sizeof(Header) + size;
+    void* p = ::ftruncate(fd, length) == 0 ? ::mmap(nullptr, length, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0)
+                                           : MAP_FAILED;
+    if (p == MAP_FAILED) {
+        ::shm_unlink(name.c_str());
+        ::close(fd);
+        return nullptr;
+    }
+    auto* h = static_cast<Header*>(p);  // Zeroed by ftruncate
+    h->size = size;
+    std::memcpy(h->magic, kBlockMagic, sizeof kBlockMagic);
+    auto block = std::shared_ptr<const SharedBlock>(new SharedBlock(name, fd, h, length));
+    fill(h->data());
+    h->ready.store(1, std::memory_order_release);
+    return block;
+}
+
+const char* SharedBlock::data() const {
+    return header->data();
+}
+
+size_t SharedBlock::size() const {
+    return header->size;
+}
+
+}  // namespace gearforge
@@ -0,0 +1,193 @@
+#include "tolerance_analysis.h"
+#include "vector_math.h"
+
+namespace gearforge {
+
+namespace {
+
+constexpr size_t kBlock = 4096;  // Reduction unit; fixed so results never depend on threads
+
+enum Dim : uint32_t { Pitch1, Pitch2, Angle1, Angle2, Runout1, Runout2, Center, Thick1, Thick2 };
+
+uint64_t mix(uint64_t z) {
+    z += 0x9e3779b97f4a7c15ULL;
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    return z ^ (z >> 31);
+}
+
+struct Moments {
+    uint64_t count = 0;
+    double mean = 0.0;
+    double m2 = 0.0;
+    double min = std::numeric_limits<double>::infinity();
+    double max = -std::numeric_limits<double>::infinity();
+
+    void merge(const Moments& o) {
+        if (o.count == 0) return;
+        uint64_t n = count + o.count;
+        double delta = o.mean - mean;
+        mean += delta * o.count / n;
+        m2 += o.m2 + delta * delta * (static_cast<double>(count) * o.count / n);
+        min = std::min(min, o.min);
+        max = std::max(max, o.max);
+        count = n;
+    }
+};
+
+Moments block_moments(const float* v, size_t n) {
+    Moments m;
+    m.count = n;
+    double sum = 0.0;
+    for (size_t i = 0; i < n; ++i) sum += v[i];
+    m.mean = sum / n;
+    for (size_t i = 0; i < n; ++i) {
+        double d = v[i] - m.mean;
+        m.m2 += d * d;
+        m.min = std::min(m.min, static_cast<double>(v[i]));
+        m.max = std::max(m.max, static_cast<double>(v[i]));
+    }
+    return m;
+}
+
+DistributionSummary summarize(const Moments& m, std::vector<float>& values) {
+    DistributionSummary s;
+    s.mean = m.mean;
+    s.stddev = m.count > 1 ? std::sqrt(m.m2 / (m.count - 1)) : 0.0;
+    s.min = m.min;
+    s.max = m.max;
+
+    // Increasing ranks let each selection work on the remaining tail only
+    const double qs[] = {0.01, 0.05, 0.50, 0.95, 0.99};
+    double* outs[] = {&s.p01, &s.p05, &s.p50, &s.p95, &s.p99};
+    size_t lo = 0;
+    for (int k = 0; k < 5; ++k) {
+        size_t rank = static_cast<size_t>(qs[k] * (values.size() - 1));
+        std::nth_element(values.begin() + lo, values.begin() + rank, values.end());
+        *outs[k] = values[rank];
+        lo = rank;
+    }
+    return s;
+}
+
+}  // unnamed namespace
+
+double ToleranceAnalyzer::uniform(uint64_t trial, uint32_t dim) const {
+    uint64_t x = mix(mix(trial * 64 + dim) ^ seed);
+    return (x >> 11) * (1.0 / 9007199254740992.0);  // 53 random bits
+}
+
+ToleranceReport ToleranceAnalyzer::analyze(const GearParams& pinion, const GearParams& gear, const ToleranceInputs& tol,
+                                           uint64_t trials, unsigned threads) const {
+    GearCalculator calc;
+    const GearParams p1 = calc.calculate(pinion);
+    const GearParams p2 = calc.calculate(gear);
+    if (p1.n < 1 || p2.n < 1 || !(p1.dp > 0)) throw std::runtime_error("Tolerance analysis needs N and DP or module for both gears");
+    if (trials == 0) throw std::runtime_error("Tolerance analysis needs at least one trial");
+
+    const double n1 = p1.n, n2 = p2.n;
+    const double dp = p1.dp;
+    const double pa = p1.pa;
+    const double add1 = p1.a, add2 = p2.a;
+    const double cd_nominal = (p1.pd + p2.pd) / 2.0;
+    const double design_backlash = p1.backlash;
+
+    auto draw = [this](const ToleranceSpec& spec, uint64_t trial, uint32_t dim) {
+        double u1 = uniform(trial, 2 * dim);
+        if (spec.kind == Distribution::Uniform) return spec.mean + spec.spread * (2.0 * u1 - 1.0);
+        double u2 = uniform(trial, 2 * dim + 1);
+        return spec.mean + spec.spread * std::sqrt(-2.0 * std::log(1.0 - u1)) * std::cos(2.0 * M_PI * u2);
+    };
+
+    // One block of trials in structure-of-arrays form: draw every input
+    // column first (scalar; the draws branch on the distribution), then run
+    // the mesh geometry over the columns, which vectorizes with the trig
+    // from vector_math.h
+    auto evaluate = [&](uint64_t first, size_t count, bool perturb, float* backlash, float* contact) {
+        std::vector<double> e1(count), e2(count), a1(count), a2(count), cd(count), t1(count), t2(count);
+        for (size_t i = 0; i < count; ++i) {
+            uint64_t trial = first + i;
+            if (!perturb) {
+                e1[i] = e2[i] = t1[i] = t2[i] = 0.0;
+                a1[i] = a2[i] = pa;
+                cd[i] = cd_nominal;
+                continue;
+            }
+            e1[i] = draw(tol.pitch_error, trial, Pitch1);
+            e2[i] = draw(tol.pitch_error, trial, Pitch2);
+            a1[i] = pa + draw(tol.pressure_angle, trial, Angle1);
+            a2[i] = pa + draw(tol.pressure_angle, trial, Angle2);
+            // Backlash is tightest where both eccentricities point at the mesh
+            double runout = std::max(0.0, draw(tol.runout, trial, Runout1)) + std::max(0.0, draw(tol.runout, trial, Runout2));
+            cd[i] = cd_nominal + draw(tol.center_distance, trial, Center) - runout / 2.0;
+            t1[i] = draw(tol.tooth_thickness, trial, Thick1);
+            t2[i] = draw(tol.tooth_thickness, trial, Thick2);
+        }
+
+        const double deg = M_PI / 180.0;
+        for (size_t i = 0; i < count; ++i) {
+            double dp1 = dp * (1.0 + e1[i]), dp2 = dp * (1.0 + e2[i]);
+            double alpha1 = a1[i] * deg, alpha2 = a2[i] * deg;
+            double sin1, cos1, sin2, cos2;
+            vec_sincos(alpha1, sin1, cos1);
+            vec_sincos(alpha2, sin2, cos2);
+            double r1 = n1 / (2.0 * dp1), r2 = n2 / (2.0 * dp2);
+            double rb1 = r1 * cos1, rb2 = r2 * cos2;
+            double ra1 = r1 + add1 * dp / dp1, ra2 = r2 + add2 * dp / dp2;
+            double c = cd[i];
+
+            // Working pressure angle from its cosine; tan - angle is the involute
+            double cos_w = std::min(1.0, (rb1 + rb2) / c);
+            double sin_w = std::sqrt(std::max(0.0, 1.0 - cos_w * cos_w));
+            double inv_w = sin_w / cos_w - vec_atan2(sin_w, cos_w);
+            double s1 = M_PI / (2.0 * dp1) - design_backlash / 2.0 + t1[i];
+            double s2 = M_PI / (2.0 * dp2) - design_backlash / 2.0 + t2[i];
+            double rw1 = rb1 / cos_w, rw2 = rb2 / cos_w;
+            double sw1 = 2.0 * rw1 * (s1 / (2.0 * r1) + sin1 / cos1 - alpha1 - inv_w);
+            double sw2 = 2.0 * rw2 * (s2 / (2.0 * r2) + sin2 / cos2 - alpha2 - inv_w);
+            double pw = 2.0 * M_PI * rw1 / n1;
+            backlash[i] = static_cast<float>(pw - sw1 - sw2);
+
+            double path = std::sqrt(ra1 * ra1 - rb1 * rb1) + std::sqrt(ra2 * ra2 - rb2 * rb2) - c * sin_w;
+            contact[i] = static_cast<float>(path / (2.0 * M_PI * rb1 / n1));
+        }
+    };
+
+    ToleranceReport report;
+    report.trials = trials;
+    float nominal_b, nominal_c;
+    evaluate(0, 1, false, &nominal_b, &nominal_c);
+    report.nominal_backlash = nominal_b;
+    report.nominal_contact_ratio = nominal_c;
+
+    std::vector<float> backlash(trials), contact(trials);
+    const size_t blocks = (trials + kBlock - 1) / kBlock;
+    std::vector<Moments> block_b(blocks), block_c(blocks);
+    std::vector<uint64_t> block_binding(blocks, 0);
+
+    utils::parallel_for(blocks, [&](size_t begin, size_t end) {
+        for (size_t b = begin; b < end; ++b) {
+            uint64_t first = b * kBlock;
+            size_t count = static_cast<size_t>(std::min<uint64_t>(kBlock, trials - first));
+            evaluate(first, count, true, &backlash[first], &contact[first]);
+            block_b[b] = block_moments(&backlash[first], count);
+            block_c[b] = block_moments(&contact[first], count);
+            for (size_t i = 0; i < count; ++i) block_binding[b] += backlash[first + i] <= 0.0f;
+        }
+    }, threads);
+
+    // Merge in block order: the same floating-point sequence for any thread count
+    Moments mb, mc;
+    uint64_t binding = 0;
+    for (size_t b = 0; b < blocks; ++b) {
+        mb.merge(block_b[b]);
+        mc.merge(block_c[b]);
+        binding += block_binding[b];
+    }
+    report.backlash = summarize(mb, backlash);
+    report.contact_ratio = summarize(mc, contact);
+    report.binding_probability = static_cast<double>(binding) / trials;
+    return report;
+}
+
+}  // namespace gearforge
@@ -3,6 +3,7 @@
 namespace gearforge {
 
 void Ui::draw_box(const std::string& title, const std::vector<std::string>& lines) {
+    MemTagScope tag(MemTag::Ui);
     size_t max_len = title.length();
     for (const auto& l : lines) max_len = std::max(max_len, l.length());
     max_len += 4;  // Padding
@@ -34,7 +35,7 @@ void Ui::show_main_screen() {
 }
 
 bool Ui::show_login_register() {
-    if (settings_manager.data.count("single_user") > 0 && settings_manager.data["single_user"] == "true") {
+    if (settings_manager.get("single_user") == "true") {
         return true;
     }
 
@@ -57,13 +58,16 @@ bool Ui::show_login_register() {
             return show_login_register();
         }
     } else {
-        if (user_manager.register_user(username, password)) {
-            LOG(INFO) << "User " << username << " registered.";
-            return true;
-        } else {
+        try {
+            if (user_manager.register_user(username, password)) {
+                LOG(INFO) << "User " << username << " registered.";
+                return true;
+            }
             handle_error("Registration failed (username exists?).");
-            return show_login_register();
+        } catch (const std::exception& e) {
+            handle_error(std::string("Registration failed: ") + e.what());
         }
+        return show_login_register();
     }
 }
 
@@ -88,23 +92,26 @@ void Ui::show_main_menu() {
                     // Involute example
                     double r_base = params.pd / 2.0 * std::cos(params.pa * M_PI / 180.0);
                     auto point = gear_calc.involute_point(r_base, 0.1);  // Sample
+                    auto gen = GearGenerator().simulate(params);
+                    std::string undercut = gen.undercut
+                        ? "Undercut: yes, depth " + format_value("Undercut", gen.undercut_depth) +
+                          " (profile shift x >= " + format_value("X", gen.min_profile_shift) + " avoids it)"
+                        : "Undercut: no";
                     display_results(params);
                     draw_box("Recommendations", {
                         "Cutter #: " + std::to_string(cutter),
                         div_inst,
-                        "Sample Involute Point: x=" + std::to_string(point.first) + ", y=" + std::to_string(point.second)
+                        "Sample Involute Point: x=" + format_value("Involute", point.first) +
+                            ", y=" + format_value("Involute", point.second),
+                        undercut,
+                        "True Form Diameter: " + format_value("TFD", gen.form_diameter)
                     });
                 } catch (const std::exception& e) {
                     handle_error(e.what());
                 }
                 break;
             }
-            case 1: {
-                auto known = gear_calc.load_known("data/known_values.csv");
-                // Display list, select one, etc.
-                if (!known.empty()) display_results(known[0]);  // Example
-                break;
-            }
+            case 1: show_catalog_search(); break;
             case 2: {
                 // Assume current params; save
                 GearParams dummy;  // Replace with actual
@@ -114,8 +121,125 @@ void Ui::show_main_menu() {
             case 3: show_settings(); break;
             case 4: running = false; break;
         }
-        std::cout << "Press enter to continue...";
-        std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
+        // The preview hangs off this prompt rather than the menu, so menu positions never move
+        bool offer_preview = running && has_gear;
+        std::cout << (offer_preview ? "Press enter to continue, or p and enter to preview the gear..."
+                                    : "Press enter to continue...");
+        std::string reply;
+        std::getline(std::cin, reply);
+        if (offer_preview && utils::to_lower(utils::trim(reply)) == "p") {
+            show_preview();
+            std::cout << "Press enter to continue...";
+            std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
+        }
+    }
+}
+
+bool Ui::open_known_catalog() {
+    try {
+        if (!known) {
+            auto catalog = std::make_unique<WatchedCatalog>("data/known_values.csv");
+            catalog->on_update([this](const CatalogSnapshot&, const CatalogSnapshot&, const CatalogReload& reload) {
+                std::lock_guard<std::mutex> lock(known_mutex);
+                known_index->update(known->snapshot(), reload);
+            });
+            known_index = std::make_unique<CatalogIndex>(catalog->snapshot());
+            known = std::move(catalog);
+            known->start();
+        } else if (!known->is_watching()) {
+            known->reload();  // No inotify here: pick up edits on each visit instead
+        }
+    } catch (const std::exception& e) {
+        handle_error(e.what());
+        return false;
+    }
+    std::lock_guard<std::mutex> lock(known_mutex);
+    if (known_index->size() == 0) {
+        handle_error("No known values loaded.");
+        return false;
+    }
+    return true;
+}
+
+void Ui::show_catalog_search() {
+    if (!open_known_catalog()) return;
+
+    // Re-query on every keystroke; Enter shows the top match, Enter on an empty query leaves.
+    // The catalog can change between keys, so Enter and Tab search again before picking.
+    std::string query;
+    while (true) {
+        std::cout << utils::CLEAR_SCREEN;
+        {
+            std::lock_guard<std::mutex> lock(known_mutex);
+            SearchResult result = known_index->search(query, 10);
+            std::vector<std::string> lines;
+            for (const auto& hit : result.hits) lines.push_back(known_index->describe(hit.row));
+            if (lines.empty()) lines.push_back("No matches");
+            draw_box("Search: " + query + "_", lines);
+            std::cout << result.matches << " of " << known_index->size() << " gears"
+                      << (result.complete ? "" : " (ranking partial)") << std::endl;
+        }
+        std::cout << "Type to filter (e.g. \"n 30..40 m 2\"), Enter to select, Tab to browse all matches, Enter on empty to go back" << std::endl;
+
+        char key = utils::get_key();
+        if (key == '\n' || key == '\r') {
+            if (query.empty()) return;
+            GearParams top;
+            {
+                std::lock_guard<std::mutex> lock(known_mutex);
+                SearchResult result = known_index->search(query, 1);
+                if (result.hits.empty()) continue;
+                top = known_index->row(result.hits.front().row);
+            }
+            std::cout << utils::CLEAR_SCREEN;
+            display_results(top);
+            return;
+        } else if (key == '\t') {
+            // The snapshot keeps the rows alive while browsing, whatever the watcher does
+            std::shared_ptr<const CatalogSnapshot> snapshot;
+            std::vector<const GearParams*> matches;
+            {
+                std::lock_guard<std::mutex> lock(known_mutex);
+                known_index->search(query, 0);
+                snapshot = known_index->snapshot();
+                for (uint32_t r : known_index->last_matches()) matches.push_back(&known_index->row(r));
+            }
+            int picked = browse_gears(matches);
+            if (picked < 0) continue;
+            std::cout << utils::CLEAR_SCREEN;
+            display_results(*matches[picked]);
+            return;
+        } else if (key == 127 || key == 8) {
+            if (!query.empty()) query.pop_back();
+        } else if (std::isprint(static_cast<unsigned char>(key))) {
+            query += key;
+        }
+    }
+}
+
+// Scrollable, sortable table over *gears[i]; returns the chosen index into gears, or -1
+int Ui::browse_gears(const std::vector<const GearParams*>& gears) {
+    auto column = [&](const std::string& title, size_t width, int field) {
+        auto value = [&gears, field](size_t i) { return CatalogIndex::field_value(*gears[i], field); };
+        auto text = [value](size_t i) {
+            char buf[32];
+            std::snprintf(buf, sizeof(buf), "%.6g", value(i));
+            return std::string(buf);
+        };
+        return ListColumn{title, width, text, value};
+    };
+    ListView view({column("N", 5, 0), column("DP", 9, 1), column("M", 9, 2), column("PA", 6, 10),
+                   column("PD", 9, 3), column("OD", 9, 4), column("RD", 9, 5), column("CP", 9, 9),
+                   column("Backlash", 9, 12)},
+                  gears.size(), 20);
+
+    std::cout << utils::CLEAR_SCREEN;
+    while (true) {
+        std::cout << view.render() << std::flush;
+        char key = utils::get_key();
+        if (key == '\n' || key == '\r') return gears.empty() ? -1 : static_cast<int>(view.selected_row());
+        if (key == 'q') return -1;
+        view.handle_key(key);
     }
 }
 
@@ -123,10 +247,11 @@ void Ui::show_settings() {
     // TODO: Implement settings menu (e.g., change colors, but fixed for now)
     std::vector<std::string> ls;
     ls.push_back("");
-    if (settings_manager.data.empty()) {
+    auto settings = settings_manager.all();
+    if (settings.empty()) {
         ls.push_back("None");
     } else {
-        for (const auto& pair : settings_manager.data) {
+        for (const auto& pair : settings) {
             ls.push_back(pair.first + ": " + pair.second);
         }
     }
@@ -136,7 +261,11 @@ void Ui::show_settings() {
     std::cout << "Enter <key> : <value> to enter a setting, or 'save' to save settings: ";
     std::getline(std::cin, input);
     if (input == "save") {
-        settings_manager.save();
+        try {
+            settings_manager.save();
+        } catch (const std::exception& e) {
+            handle_error(e.what());
+        }
     } else {
         settings_manager.add_setting(input);
     }
@@ -169,24 +298,63 @@ GearParams Ui::input_gear_params() {
 }
 
 void Ui::display_results(const GearParams& params) {
+    MemTagScope tag(MemTag::Ui);
+    last_gear = params;
+    has_gear = true;
+    auto line = [&](const std::string& field, double v) { return field + ": " + format_value(field, v); };
     std::vector<std::string> lines = {
         "N: " + std::to_string(params.n),
-        "DP: " + std::to_string(params.dp),
-        "M: " + std::to_string(params.m),
-        "PD: " + std::to_string(params.pd),
-        "OD: " + std::to_string(params.od),
-        "RD: " + std::to_string(params.rd),
-        "A: " + std::to_string(params.a),
-        "D: " + std::to_string(params.d),
-        "WD: " + std::to_string(params.wd),
-        "CP: " + std::to_string(params.cp),
-        "PA: " + std::to_string(params.pa),
-        "CD: " + std::to_string(params.cd),
-        "Backlash: " + std::to_string(params.backlash)
+        line("DP", params.dp),
+        line("M", params.m),
+        line("PD", params.pd),
+        line("OD", params.od),
+        line("RD", params.rd),
+        line("A", params.a),
+        line("D", params.d),
+        line("WD", params.wd),
+        line("CP", params.cp),
+        line("PA", params.pa),
+        line("CD", params.cd),
+        line("Backlash", params.backlash)
     };
+    if (params.x != 0.0) lines.push_back(line("X", params.x));  // Shifted teeth only
     draw_box("Gear Parameters", lines);
 }
 
+// Shortest text that reads back exactly, unless settings fix the decimals:
+// "precision.<field> = <decimals>", or "precision = <decimals>" for every field.
+// A setting that isn't a whole number keeps the shortest form; others are
+// clamped to kMaxDecimals.
+std::string Ui::format_value(const std::string& field, double v) {
+    std::string key = settings_manager.has("precision." + field) ? "precision." + field : "precision";
+    int decimals = utils::safe_stoi_or(settings_manager.get(key, "-1"), -1);
+    return number_to_string(v, std::clamp(decimals, -1, kMaxDecimals));
+}
+
+// Animated braille picture of the last gear, alone or meshing with a mate
+void Ui::show_preview() {
+    if (!has_gear) {
+        handle_error("Calculate or look up a gear first.");
+        return;
+    }
+    std::cout << "Mate teeth (Enter for none): ";
+    std::string input;
+    std::getline(std::cin, input);
+    int mate = 0;
+    if (!utils::trim(input).empty()) {
+        mate = utils::safe_stoi_or(input, 0);
+        if (mate < 1) {
+            handle_error("Mate teeth must be a whole number of at least 1.");
+            return;
+        }
+    }
+    try {
+        GearPreview(last_gear, mate, 0, 0).play();
+    } catch (const std::exception& e) {
+        handle_error(e.what());
+    }
+}
+
 void Ui::handle_error(const std::string& msg) {
     std::cout << utils::COLOR_RED << "Error: " << msg << utils::COLOR_RESET << std::endl;
     LOG(ERROR) << msg;
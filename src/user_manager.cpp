@@ -2,70 +2,89 @@
 
 namespace gearforge {
 
-std::vector<std::string> User::to_csv_row() const {
-    return {username, password_hash, role == UserRole::Admin ? "Admin" : "User"};
+bool parse_field(const char* begin, const char* end, UserRole& out) {
+    out = std::string_view(begin, end - begin) == "Admin" ? UserRole::Admin : UserRole::User;
+    return true;
 }
 
-User User::from_csv_row(const std::vector<std::string>& row) {
-    if (row.size() < 3) throw std::runtime_error("Invalid user CSV");
-    User u;
-    u.username = row[0];
-    u.password_hash = row[1];
-    u.role = row[2] == "Admin" ? UserRole::Admin : UserRole::User;
-    return u;
+void write_field(FormatBuffer& out, UserRole role) {
+    out.append(std::string(role == UserRole::Admin ? "Admin" : "User"));
 }
 
-UserManager::UserManager() {
-    load_users();
+std::vector<std::string> User::to_csv_row() const {
+    std::vector<std::string> cells;
+    FormatBuffer cell;
+    for_each_field<User>([&](const auto& f, size_t) {
+        cell.clear();
+        write_field(cell, this->*(f.member));
+        cells.push_back(cell.str());
+    });
+    return cells;
 }
 
-void UserManager::load_users() {
-    std::lock_guard<std::mutex> lock(mutex);
-    auto csv = utils::read_csv(filename);
-    users.clear();
-    for (size_t i = 1; i < csv.size(); ++i) {
-        users.push_back(User::from_csv_row(csv[i]));
-    }
+User User::from_csv_row(const std::vector<std::string>& row) {
+    if (row.size() < RecordCodec<User>::kFields) throw std::runtime_error("Invalid user CSV");
+    User u;
+    for_each_field<User>([&](const auto& f, size_t i) {
+        parse_field(row[i].data(), row[i].data() + row[i].size(), u.*(f.member));
+    });
+    return u;
 }
 
-void UserManager::save_users() {
-    std::lock_guard<std::mutex> lock(mutex);
-    std::vector<std::vector<std::string>> data;
-    data.push_back({"Username", "PasswordHash", "Role"});
-    for (const auto& u : users) {
-        data.push_back(u.to_csv_row());
-    }
-    utils::write_csv(filename, data);
-}
+UserManager::UserManager(const std::string& filename) : file(filename) {}
 
 bool UserManager::register_user(const std::string& username, const std::string& password, UserRole role) {
+    MemTagScope tag(MemTag::Auth);
     auto hash = utils::sha256(password);
     // Convert hash to string (e.g., hex)
     std::stringstream ss;
     for (auto v : hash.state) ss << std::hex << std::setw(8) << std::setfill('0') << v;
     std::string hash_str = ss.str();
 
-    for (const auto& u : users) {
-        if (u.username == username) return false;  // Exists
-    }
-    users.push_back({username, hash_str, role});
-    save_users();
-    return true;
+    // Checked against the file as it is now, not as this session loaded it
+    return file.update([&](std::string& text) {
+        CsvLines lines;
+        lines.assign(text);
+        for (const auto& u : read_records<User>(lines, file.filename())) {
+            if (u.username == username) return false;  // Exists
+        }
+        FormatBuffer row;
+        if (text.empty()) RecordCodec<User>::write_header(row);
+        else if (text.back() != '\n') row.append('\n');
+        RecordCodec<User>::write(row, User{username, hash_str, role});
+        text += row.str();
+        return true;
+    });
 }
 
 bool UserManager::login(const std::string& username, const std::string& password) {
+    MemTagScope tag(MemTag::Auth);
     auto hash = utils::sha256(password);
     std::stringstream ss;
     for (auto v : hash.state) ss << std::hex << std::setw(8) << std::setfill('0') << v;
     std::string hash_str = ss.str();
 
-    for (const auto& u : users) {
-        if (u.username == username && u.password_hash == hash_str) {
-            current_user = u;
-            return true;
+    file.refresh();  // Hand edits to the file
+    auto found = file.view([&](std::string_view text) {
+        std::pair<bool, User> match{false, User{}};
+        CsvLines lines;
+        lines.assign(text);
+        const char* begin;
+        const char* end;
+        if (!lines.next(begin, end)) return match;
+        RecordCodec<User> codec(std::string_view(begin, end - begin));
+        while (lines.next(begin, end)) {
+            if (codec.parse(begin, end, match.second) && match.second.username == username &&
+                match.second.password_hash == hash_str) {
+                match.first = true;
+                return match;
+            }
         }
-    }
-    return false;
+        return match;
+    });
+    if (!found.first) return false;
+    current_user = found.second;
+    return true;
 }
 
 const User& UserManager::get_current_user() const {
@@ -5,6 +5,9 @@
 #include <cstdint>  // Only for test harness
 #define TEST_SHA256
 
+#include "mem_stats.h"
+#include "number_format.h"
+#include "progress.h"
 #include "utils.h"
 
 namespace gearforge {
@@ -34,6 +37,7 @@ Sha256Hash sha256(const std::string& input) {
         0x748f82ee,0x78a5636f,0x84c87814,0x8cc70208,0x90befffa,0xa4506ceb,0xbef9a3f7,0xc67178f2
     };
 
+    MemTagScope tag(MemTag::Hash);
     Sha256Hash hash;
     std::vector<uint8_t> bytes(input.begin(), input.end());
     uint64_t bit_len = bytes.size() * 8;
@@ -73,29 +77,22 @@ Sha256Hash sha256(const std::string& input) {
     return hash;
 }
 
-void show_progress(int progress, int total, const std::string& label) {
-    int bar_width = 50;
-    float frac = static_cast<float>(progress) / total;
-    int width = static_cast<int>(frac * bar_width);
-    std::cout << label << " [" << COLOR_GREEN;
-    for (int i = 0; i < width; ++i) std::cout << "=";
-    std::cout << ">" << COLOR_RESET;
-    for (int i = width; i < bar_width; ++i) std::cout << " ";
-    std::cout << "] " << std::setw(3) << static_cast<int>(frac * 100) << "%\r" << std::flush;
-}
-
 bool file_exists(const std::filesystem::path& p) {
     return std::filesystem::exists(p);
 }
 
 std::vector<std::vector<std::string>> read_csv(const std::string& filename) {
+    MemTagScope tag(MemTag::Csv);
     std::vector<std::vector<std::string>> data;
     std::ifstream file(filename);
     if (!file) return data;
+    std::error_code ec;
+    uint64_t size = std::filesystem::file_size(filename, ec);
+    ScopedProgress progress("Loading " + std::filesystem::path(filename).filename().string(), ec ? 0 : size);
+    uint64_t offset = 0;
     std::string line;
-    int row = 0;
-    show_progress(0, 100, "Loading CSV");  // Dummy progress
     while (std::getline(file, line)) {
+        offset += line.size() + 1;
         std::vector<std::string> row_data;
         std::stringstream ss(line);
         std::string cell;
@@ -103,23 +100,20 @@ std::vector<std::vector<std::string>> read_csv(const std::string& filename) {
             row_data.push_back(trim(cell));
         }
         data.push_back(row_data);
-        show_progress(++row % 100, 100, "Loading CSV");
+        progress.set(offset);
     }
-    std::cout << std::endl;
     return data;
 }
 
 bool write_csv(const std::string& filename, const std::vector<std::vector<std::string>>& data) {
-    std::ofstream file(filename);
-    if (!file) return false;
+    MemTagScope tag(MemTag::Csv);
+    CsvWriter out(filename);
+    if (!out.is_open()) return false;
     for (const auto& row : data) {
-        for (size_t i = 0; i < row.size(); ++i) {
-            file << row[i];
-            if (i < row.size() - 1) file << ",";
-        }
-        file << "\n";
+        for (const auto& cell : row) out.cell(cell);
+        out.end_row();
     }
-    return true;
+    return out.close();
 }
 
 std::string trim(const std::string& str) {
@@ -152,6 +146,42 @@ char get_key() {
     return tolower(c);  // Support ijkl too via mapping if needed
 }
 
+void parallel_for(size_t count, const std::function<void(size_t, size_t)>& body, unsigned threads) {
+    if (count == 0) return;
+    if (threads == 0) threads = std::max(1u, std::thread::hardware_concurrency());
+    threads = static_cast<unsigned>(std::min<size_t>(threads, count));
+    if (threads == 1) {
+        body(0, count);
+        return;
+    }
+
+    // Small chunks handed out through one atomic keep uneven work balanced
+    size_t chunk = std::max<size_t>(1, count / (threads * 8));
+    std::atomic<size_t> next{0};
+    std::exception_ptr error;
+    std::mutex error_mutex;
+    const MemTag caller_tag = MemTagScope::current();
+    auto worker = [&]() {
+        MemTagScope tag(caller_tag);
+        try {
+            for (;;) {
+                size_t begin = next.fetch_add(chunk);
+                if (begin >= count) break;
+                body(begin, std::min(count, begin + chunk));
+            }
+        } catch (...) {
+            std::lock_guard<std::mutex> lock(error_mutex);
+            if (!error) error = std::current_exception();
+            next.store(count);
+        }
+    };
+    std::vector<std::thread> pool;
+    for (unsigned i = 1; i < threads; ++i) pool.emplace_back(worker);
+    worker();
+    for (auto& t : pool) t.join();
+    if (error) std::rethrow_exception(error);
+}
+
 std::string current_date() {
     std::time_t now = std::time(nullptr);
     std::tm* local = std::localtime(&now);
@@ -180,6 +210,13 @@ double safe_stod_or(const std::string& str, const double default_value) {
     }
 }
 
+int safe_stoi_or(const std::string& str, const int default_value) {
+    std::string s = trim(str);
+    int value = 0;
+    auto res = std::from_chars(s.data(), s.data() + s.size(), value);
+    return res.ec == std::errc() && res.ptr == s.data() + s.size() && !s.empty() ? value : default_value;
+}
+
 double input_double_or(const std::string& prompt, const double default_value) {
     std::cout << prompt;
     std::string input;
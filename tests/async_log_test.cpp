@@ -0,0 +1,108 @@
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <csignal>
+
+#include <gtest/gtest.h>
+#include "async_log.h"
+
+namespace {
+
+std::vector<std::string> read_lines(const std::string& path) {
+    std::ifstream in(path);
+    std::vector<std::string> lines;
+    std::string line;
+    while (std::getline(in, line)) lines.push_back(line);
+    return lines;
+}
+
+void log_line(gearforge::AsyncLogSink& sink, int line, const std::string& msg) {
+    sink.send(google::GLOG_INFO, __FILE__, "async_log_test.cpp", line, nullptr, msg.data(), msg.size());
+}
+
+}  // namespace
+
+TEST(AsyncLogSinkTest, WritesEveryThreadsRecordsOnStop) {
+    std::string path = (std::filesystem::temp_directory_path() / "gearforge_async_log_test.log").string();
+    std::filesystem::remove(path);
+    auto& sink = gearforge::AsyncLogSink::instance();
+    gearforge::AsyncLogOptions opts;
+    opts.path = path;
+    opts.ring_capacity = 64;
+    opts.overflow = gearforge::LogOverflow::Block;
+    ASSERT_TRUE(sink.start(opts));
+
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; ++t) {
+        threads.emplace_back([&sink, t] {
+            for (int i = 0; i < 500; ++i) log_line(sink, t, "message " + std::to_string(i));
+        });
+    }
+    for (auto& th : threads) th.join();
+    sink.stop();
+
+    auto lines = read_lines(path);
+    EXPECT_EQ(lines.size(), 2000u);  // Block policy never loses a record
+    ASSERT_FALSE(lines.empty());
+    EXPECT_EQ(lines[0][0], 'I');
+    EXPECT_NE(lines[0].find("async_log_test.cpp:"), std::string::npos);
+    EXPECT_EQ(sink.dropped(), 0u);
+    std::filesystem::remove(path);
+}
+
+TEST(AsyncLogSinkTest, DropPolicyCountsAndReportsOverflow) {
+    std::string path = (std::filesystem::temp_directory_path() / "gearforge_async_log_drop.log").string();
+    std::filesystem::remove(path);
+    auto& sink = gearforge::AsyncLogSink::instance();
+    gearforge::AsyncLogOptions opts;
+    opts.path = path;
+    opts.ring_capacity = 8;
+    opts.overflow = gearforge::LogOverflow::Drop;
+    opts.flush_interval = std::chrono::milliseconds(60000);  // Only stop() drains
+    ASSERT_TRUE(sink.start(opts));
+
+    for (int i = 0; i < 100; ++i) log_line(sink, i, "x");
+    EXPECT_EQ(sink.dropped(), 92u);
+    sink.stop();
+
+    auto lines = read_lines(path);
+    ASSERT_EQ(lines.size(), 9u);
+    EXPECT_NE(lines.back().find("dropped 92 messages"), std::string::npos);
+    std::filesystem::remove(path);
+}
+
+TEST(AsyncLogSinkTest, CrashSignalWritesQueuedRecords) {
+    std::string path = (std::filesystem::temp_directory_path() / "gearforge_async_log_crash.log").string();
+    std::filesystem::remove(path);
+    pid_t pid = ::fork();
+    if (pid == 0) {
+        auto& sink = gearforge::AsyncLogSink::instance();
+        gearforge::AsyncLogOptions opts;
+        opts.path = path;
+        opts.flush_interval = std::chrono::milliseconds(60000);
+        if (!sink.start(opts)) ::_exit(1);
+        for (int i = 0; i < 10; ++i) log_line(sink, i, "flushed " + std::to_string(i));
+        sink.flush();
+        std::thread other([&sink] {
+            for (int i = 0; i < 20; ++i) log_line(sink, 100 + i, "other " + std::to_string(i));
+        });
+        other.join();
+        for (int i = 0; i < 20; ++i) log_line(sink, -i, "queued " + std::to_string(i));
+        std::raise(SIGSEGV);
+        ::_exit(2);
+    }
+    int status = 0;
+    ::waitpid(pid, &status, 0);
+    ASSERT_TRUE(WIFSIGNALED(status));
+    EXPECT_EQ(WTERMSIG(status), SIGSEGV);
+
+    // Flushed records once, then the queued ones from the handler, in the same format
+    auto lines = read_lines(path);
+    ASSERT_EQ(lines.size(), 50u);
+    std::regex format(R"(I\d{4} \d{2}:\d{2}:\d{2}\.\d{6} async_log_test\.cpp:-?\d+\] \w+ \d+)");
+    for (const auto& line : lines) EXPECT_TRUE(std::regex_match(line, format)) << line;
+    EXPECT_EQ(lines[9].substr(0, 5), lines[49].substr(0, 5));  // Same local date
+    EXPECT_NE(lines[10].find("other 0"), std::string::npos);
+    EXPECT_NE(lines[49].find(":-19] queued 19"), std::string::npos);
+    std::filesystem::remove(path);
+}
@@ -0,0 +1,155 @@
+#include <gtest/gtest.h>
+#include <signal.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include "catalog_ops.h"
+
+namespace {
+
+const char* kHeader = "N,DP,M,PD,OD,RD,A,D,WD,CP,PA,CD,Backlash,X";
+
+std::string row(int n, double dp, double pa = 20.0, double backlash = NAN) {
+    auto p = gearforge::GearParams::spec(n, dp, pa);
+    p.backlash = backlash;
+    p = gearforge::GearCalculator().calculate(p);
+    auto cells = p.to_csv_row();
+    std::string line;
+    for (size_t i = 0; i < cells.size(); ++i) line += (i ? "," : "") + cells[i];
+    return line;
+}
+
+std::string write_catalog(const std::string& name, const std::vector<std::string>& rows) {
+    std::string path = (std::filesystem::temp_directory_path() / name).string();
+    std::ofstream out(path);
+    out << kHeader << '\n';
+    for (const auto& r : rows) out << r << '\n';
+    return path;
+}
+
+std::vector<std::string> run(gearforge::CatalogOp op, const std::string& a, const std::string& b,
+                             gearforge::CatalogOptions opts = gearforge::CatalogOptions()) {
+    std::ostringstream out;
+    gearforge::CatalogTool(opts).run(op, a, b, out);
+    std::vector<std::string> lines;
+    std::istringstream in(out.str());
+    std::string line;
+    std::getline(in, line);  // Header
+    while (std::getline(in, line)) lines.push_back(line);
+    return lines;
+}
+
+}  // namespace
+
+TEST(CatalogToolTest, SetOperationsKeepInputOrder) {
+    auto a = write_catalog("gf_ops_a.csv", {row(20, 10), row(30, 10), row(40, 12)});
+    auto b = write_catalog("gf_ops_b.csv", {row(50, 8), row(30, 10.00001), row(20, 10, 14.5)});
+
+    auto merged = run(gearforge::CatalogOp::Merge, a, b);
+    EXPECT_EQ(merged, (std::vector<std::string>{row(20, 10), row(30, 10), row(40, 12), row(50, 8), row(20, 10, 14.5)}));
+
+    auto common = run(gearforge::CatalogOp::Intersect, a, b);
+    EXPECT_EQ(common, (std::vector<std::string>{row(30, 10)}));  // DP within tolerance; PA 14.5 is another gear
+}
+
+TEST(CatalogToolTest, DiffReportsRemovedAddedAndChanged) {
+    auto a = write_catalog("gf_diff_a.csv", {row(20, 10), row(30, 10), row(40, 12)});
+    auto b = write_catalog("gf_diff_b.csv", {row(30, 10, 20.0, 0.01), row(40, 12), row(60, 12)});
+    auto diff = run(gearforge::CatalogOp::Diff, a, b);
+    ASSERT_EQ(diff.size(), 3u);
+    EXPECT_EQ(diff[0], "removed," + row(20, 10));
+    EXPECT_EQ(diff[1], "changed," + row(30, 10, 20.0, 0.01));
+    EXPECT_EQ(diff[2], "added," + row(60, 12));
+}
+
+TEST(CatalogToolTest, DedupMatchesAcrossCellEdges) {
+    // Near-duplicates spread over many quantization cells must all collapse
+    std::vector<std::string> rows;
+    for (int i = 0; i < 200; ++i) {
+        double dp = 4.0 + i * 0.37;
+        rows.push_back(row(24, dp));
+        rows.push_back(row(24, dp * (1.0 + 0.9e-4)));
+        rows.push_back(row(24, dp, 20.0 + 0.009));
+    }
+    auto a = write_catalog("gf_dedup.csv", rows);
+    auto unique = run(gearforge::CatalogOp::Dedup, a, "");
+    ASSERT_EQ(unique.size(), 200u);
+    EXPECT_EQ(unique.front(), row(24, 4.0));
+}
+
+TEST(CatalogToolTest, SpilledRunMatchesInMemory) {
+    std::vector<std::string> ra, rb;
+    for (int i = 0; i < 3000; ++i) {
+        ra.push_back(row(12 + i % 150, 2.0 + (i / 150) * 0.5));
+        if (i % 3) rb.push_back(row(12 + i % 150, 2.0 + (i / 150) * 0.5, 20.0, i % 7 ? NAN : 0.02));
+        else rb.push_back(row(12 + i % 150, 40.0 + i));
+    }
+    auto a = write_catalog("gf_spill_a.csv", ra);
+    auto b = write_catalog("gf_spill_b.csv", rb);
+    gearforge::CatalogOptions spill;
+    spill.memory_limit = 1 << 16;
+    spill.threads = 2;
+    for (auto op : {gearforge::CatalogOp::Merge, gearforge::CatalogOp::Intersect, gearforge::CatalogOp::Diff}) {
+        std::ostringstream out;
+        auto stats = gearforge::CatalogTool(spill).run(op, a, b, out);
+        EXPECT_TRUE(stats.spilled);
+        EXPECT_EQ(run(op, a, b), run(op, a, b, spill));
+    }
+}
+
+TEST(CatalogToolTest, SpillStaysWithinOpenFileLimit) {
+    std::vector<std::string> ra, rb;
+    for (int i = 0; i < 2000; ++i) {
+        ra.push_back(row(12 + i % 100, 2.0 + (i / 100) * 0.5));
+        rb.push_back(row(12 + i % 100, 2.0 + (i / 100) * 0.5, i % 5 ? 20.0 : 14.5));
+    }
+    auto a = write_catalog("gf_nofile_a.csv", ra);
+    auto b = write_catalog("gf_nofile_b.csv", rb);
+    gearforge::CatalogOptions spill;
+    spill.memory_limit = 1 << 16;
+    spill.partitions = 300;
+    spill.threads = 2;
+    auto expected = run(gearforge::CatalogOp::Diff, a, b);
+
+    // 64 descriptors cannot hold 2 x 300 spill files: two passes each way
+    pid_t pid = fork();
+    ASSERT_GE(pid, 0);
+    if (pid == 0) {
+        rlimit lim{64, 64};
+        setrlimit(RLIMIT_NOFILE, &lim);
+        std::ostringstream out;
+        auto stats = gearforge::CatalogTool(spill).run(gearforge::CatalogOp::Diff, a, b, out);
+        bool ok = stats.spilled && stats.partitions > 32 && run(gearforge::CatalogOp::Diff, a, b, spill) == expected;
+        _exit(ok ? 0 : 1);
+    }
+    int status = 0;
+    waitpid(pid, &status, 0);
+    EXPECT_TRUE(WIFEXITED(status) && WEXITSTATUS(status) == 0);
+}
+
+TEST(CatalogToolTest, FailedSpillWritesThrow) {
+    std::vector<std::string> ra;
+    for (int i = 0; i < 3000; ++i) ra.push_back(row(12 + i % 150, 2.0 + (i / 150) * 0.5));
+    auto a = write_catalog("gf_fsize_a.csv", ra);
+    gearforge::CatalogOptions spill;
+    spill.memory_limit = 1 << 12;
+    spill.partitions = 4;
+
+    // Spill files may not grow past 1 KB: writes fail with EFBIG
+    pid_t pid = fork();
+    ASSERT_GE(pid, 0);
+    if (pid == 0) {
+        signal(SIGXFSZ, SIG_IGN);
+        rlimit lim{1024, RLIM_INFINITY};
+        setrlimit(RLIMIT_FSIZE, &lim);
+        std::ostringstream out;
+        try {
+            gearforge::CatalogTool(spill).run(gearforge::CatalogOp::Dedup, a, a, out);
+        } catch (const std::runtime_error&) {
+            _exit(0);
+        }
+        _exit(1);
+    }
+    int status = 0;
+    waitpid(pid, &status, 0);
+    EXPECT_TRUE(WIFEXITED(status) && WEXITSTATUS(status) == 0);
+}
@@ -0,0 +1,128 @@
+#include <gtest/gtest.h>
+#include "catalog_search.h"
+#include "test_gears.h"
+
+namespace {
+
+std::vector<gearforge::GearParams> make_catalog() {
+    std::vector<gearforge::GearParams> rows;
+    for (double dp : {8.0, 10.0, 12.0}) {
+        for (int n = 12; n <= 60; ++n) rows.push_back(spur(n, dp, n % 2 ? 14.5 : 20.0));
+    }
+    return rows;
+}
+
+std::string catalog_text(const std::vector<gearforge::GearParams>& rows) {
+    gearforge::FormatBuffer out;
+    gearforge::RecordCodec<gearforge::GearParams>::write_header(out);
+    for (const auto& p : rows) gearforge::RecordCodec<gearforge::GearParams>::write(out, p);
+    return out.str();
+}
+
+}  // namespace
+
+TEST(CatalogIndexTest, NumericRangeAndExactValue) {
+    auto rows = make_catalog();
+    gearforge::CatalogIndex index(rows);
+    auto result = index.search("N 30..40 dp 10", 100);
+    EXPECT_TRUE(result.complete);
+    EXPECT_EQ(result.matches, 11u);
+    for (const auto& hit : result.hits) {
+        EXPECT_GE(rows[hit.row].n, 30);
+        EXPECT_LE(rows[hit.row].n, 40);
+        EXPECT_DOUBLE_EQ(rows[hit.row].dp, 10.0);
+    }
+    // Ranked toward the middle of the range
+    EXPECT_EQ(rows[result.hits[0].row].n, 35);
+}
+
+TEST(CatalogIndexTest, TextPrefixAndLabels) {
+    auto rows = make_catalog();
+    std::vector<std::string> labels;
+    for (size_t i = 0; i < rows.size(); ++i) labels.push_back(i == 5 ? "Bridgeport feed gear" : "stock");
+    gearforge::CatalogIndex index(rows, labels);
+    auto result = index.search("bridge");
+    ASSERT_EQ(result.matches, 1u);
+    EXPECT_EQ(result.hits[0].row, 5u);
+    EXPECT_EQ(index.search("pa14").matches, 72u);  // Prefix of "pa14.5"
+}
+
+TEST(CatalogIndexTest, ExtendedQueryNarrowsPreviousResult) {
+    auto rows = make_catalog();
+    gearforge::CatalogIndex index(rows);
+    auto wide = index.search("pa 20");
+    auto narrow = index.search("pa 20 m 2.54");
+    auto fresh = gearforge::CatalogIndex(rows).search("pa 20 m 2.54");
+    EXPECT_LT(narrow.matches, wide.matches);
+    EXPECT_EQ(narrow.matches, fresh.matches);
+    // A field name still waiting for its value does not filter anything
+    EXPECT_EQ(index.search("pa 20 n").matches, wide.matches);
+}
+
+TEST(CatalogIndexTest, RowsWithoutAValueNeverMatchRanges) {
+    auto rows = make_catalog();
+    size_t given = 0;
+    for (size_t i = 0; i < rows.size(); ++i) {
+        if (i % 3 == 0) rows[i].backlash = NAN;
+        else ++given;
+    }
+    // Open ranges reach the end where NaN used to sort; a fresh scan and a
+    // narrowed previous result must agree
+    gearforge::CatalogIndex index(rows);
+    EXPECT_EQ(index.search("bl 0..", 1000).matches, given);
+    auto fresh = gearforge::CatalogIndex(rows).search("pa 20 bl 0..", 1000);
+    index.search("pa 20", 1000);
+    auto narrowed = index.search("pa 20 bl 0..", 1000);
+    EXPECT_EQ(narrowed.matches, fresh.matches);
+    for (const auto& hit : fresh.hits) EXPECT_FALSE(std::isnan(rows[hit.row].backlash));
+    for (const auto& hit : narrowed.hits) EXPECT_FALSE(std::isnan(rows[hit.row].backlash));
+}
+
+TEST(CatalogIndexTest, EmptyAndUnknownQueries) {
+    auto rows = make_catalog();
+    gearforge::CatalogIndex index(rows);
+    EXPECT_EQ(index.search("", 5).hits.size(), 5u);
+    EXPECT_EQ(index.search("zzz").matches, 0u);
+    EXPECT_EQ(index.search("od 100..").matches, 0u);
+}
+
+TEST(CatalogIndexTest, UpdateMatchesRebuild) {
+    std::vector<gearforge::GearParams> rows;
+    for (int i = 0; i < 20000; ++i) rows.push_back(spur(10 + i % 190, 4.0 + (i / 190) * 0.25, i % 3 ? 20.0 : 14.5));
+    std::string path = (std::filesystem::temp_directory_path() / "gearforge_index_update.csv").string();
+    std::ofstream(path, std::ios::binary) << catalog_text(rows);
+    gearforge::WatchedCatalog catalog(path);
+    gearforge::CatalogIndex index(catalog.snapshot());
+    EXPECT_EQ(index.search("pa 14.5").matches, 6667u);
+
+    // Edit a row to a value nothing else has, drop every 14.5 degree row
+    // from one stretch, and insert copies of another stretch
+    rows[700] = spur(33, 7.0, 25.0);
+    rows.erase(rows.begin() + 9000, rows.begin() + 9600);
+    rows.insert(rows.begin() + 15000, rows.begin() + 100, rows.begin() + 400);
+    for (auto& p : rows) {
+        if (p.dp == 4.0 + 3 * 0.25 && p.pa == 14.5) p = spur(p.n, p.dp, 20.0);
+    }
+    std::ofstream(path, std::ios::binary) << catalog_text(rows);
+    auto reload = catalog.reload();
+    ASSERT_TRUE(reload.changed);
+    EXPECT_LT(reload.reparsed_rows, rows.size() / 2);
+    index.update(catalog.snapshot(), reload);
+    ASSERT_EQ(index.size(), rows.size());
+
+    gearforge::CatalogIndex rebuilt(catalog.snapshot());
+    for (const char* query : {"pa25", "pa 14.5", "dp4.75 pa14", "n 30..40 dp 5..6", "od ..1", "backlash 0.01..", "m 2",
+                              "pa 20 n 33", ""}) {
+        auto a = index.search(query, 50), b = rebuilt.search(query, 50);
+        EXPECT_EQ(a.matches, b.matches) << query;
+        ASSERT_EQ(a.hits.size(), b.hits.size()) << query;
+        for (size_t i = 0; i < a.hits.size(); ++i) {
+            EXPECT_EQ(a.hits[i].row, b.hits[i].row) << query;
+            EXPECT_EQ(a.hits[i].score, b.hits[i].score) << query;
+        }
+        EXPECT_EQ(index.last_matches(), rebuilt.last_matches()) << query;
+    }
+    EXPECT_EQ(index.search("pa25").matches, 1u);
+    EXPECT_EQ(index.row(index.search("pa25").hits[0].row).n, 33);
+    std::filesystem::remove(path);
+}
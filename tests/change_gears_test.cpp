@@ -0,0 +1,120 @@
+#include <gtest/gtest.h>
+#include "change_gears.h"
+
+namespace {
+
+// A 9" bench lathe: 8 TPI leadscrew, 20 DP gears, two 40s in the set
+gearforge::LatheProfile bench_lathe() {
+    gearforge::LatheProfile p;
+    p.name = "bench 9in";
+    p.leadscrew_tpi = 8.0;
+    p.gears = {20, 24, 28, 30, 32, 36, 40, 40, 44, 46, 48, 52, 54, 56, 64, 72};
+    p.dp = 20.0;
+    p.stud_distance = 3.2;
+    p.slot_min = 1.6;
+    p.slot_max = 3.6;
+    p.clearance = 0.4;
+    return p;
+}
+
+}  // unnamed namespace
+
+TEST(ChangeGearsTest, TableMatchesBruteForce) {
+    auto profile = bench_lathe();
+    gearforge::ChangeGearSolver solver(profile);
+    auto table = solver.build(2);
+    ASSERT_GT(table.size(), 100u);
+
+    // Every (A, B, C, D) by gear position, checked one at a time
+    std::set<std::pair<int, int>> ratios;
+    const auto& g = profile.gears;
+    for (size_t a = 0; a < g.size(); ++a) {
+        for (size_t b = 0; b < g.size(); ++b) {
+            for (size_t c = 0; c < g.size(); ++c) {
+                for (size_t d = 0; d < g.size(); ++d) {
+                    if (a == b || a == c || a == d || b == c || b == d || c == d) continue;
+                    if (!solver.feasible(g[a], g[b], g[c], g[d], false)) continue;
+                    int num = g[a] * g[c], den = g[b] * g[d], k = std::gcd(num, den);
+                    ratios.insert({num / k, den / k});
+                }
+                if (c == 0) {
+                    for (size_t d = 0; d < g.size(); ++d) {
+                        if (a == b || a == d || b == d || !solver.feasible(g[a], g[b], g[b], g[d], true)) continue;
+                        int k = std::gcd(g[a], g[d]);
+                        ratios.insert({g[a] / k, g[d] / k});
+                    }
+                }
+            }
+        }
+    }
+    EXPECT_EQ(table.size(), ratios.size());
+
+    for (size_t i = 0; i < table.size(); ++i) {
+        const auto& t = table.entries()[i];
+        if (i > 0) {
+            EXPECT_LT(table.entries()[i - 1].pitch, t.pitch);
+        }
+        double ratio = t.simple ? double(t.a) / t.d : double(t.a) * t.c / (double(t.b) * t.d);
+        EXPECT_NEAR(t.pitch, 25.4 / 8.0 * ratio, 1e-12);
+        EXPECT_TRUE(solver.feasible(t.a, t.b, t.c, t.d, t.simple));
+    }
+}
+
+TEST(ChangeGearsTest, NearestThreads) {
+    auto table = gearforge::ChangeGearSolver(bench_lathe()).build();
+    // 16 TPI is half the leadscrew: 20 -> idler -> 40
+    auto m = table.nearest_tpi(16.0, 3);
+    ASSERT_EQ(m.size(), 3u);
+    EXPECT_NEAR(m[0].error, 0.0, 1e-12);
+    EXPECT_NEAR(m[0].train.tpi(), 16.0, 1e-9);
+    EXPECT_LE(std::fabs(m[0].error), std::fabs(m[1].error));
+    EXPECT_LE(std::fabs(m[1].error), std::fabs(m[2].error));
+    EXPECT_EQ(m[0].train.simple, 1);
+
+    // Metric on an inch leadscrew is approximate: nearest alternatives come back sorted by error
+    auto metric = table.nearest_pitch(1.25, 5);
+    ASSERT_EQ(metric.size(), 5u);
+    EXPECT_LT(std::fabs(metric[0].error), 0.01);
+    for (size_t i = 1; i < metric.size(); ++i) EXPECT_LE(std::fabs(metric[i - 1].error), std::fabs(metric[i].error));
+}
+
+TEST(ChangeGearsTest, TableIsCachedPerProfile) {
+    std::string dir = (std::filesystem::temp_directory_path() / "gearforge_thread_tables").string();
+    std::filesystem::remove_all(dir);
+    auto profile = bench_lathe();
+    auto built = gearforge::ThreadTable::load_or_build(profile, dir);
+    ASSERT_EQ(std::distance(std::filesystem::directory_iterator(dir), std::filesystem::directory_iterator()), 1);
+    auto cached = gearforge::ThreadTable::load_or_build(profile, dir);
+    ASSERT_EQ(cached.size(), built.size());
+    for (size_t i = 0; i < built.size(); ++i) {
+        EXPECT_EQ(cached.entries()[i].pitch, built.entries()[i].pitch);
+        EXPECT_EQ(cached.entries()[i].d, built.entries()[i].d);
+    }
+
+    // A save cut short is rebuilt, not served
+    auto path = std::filesystem::directory_iterator(dir)->path();
+    std::filesystem::resize_file(path, std::filesystem::file_size(path) / 2);
+    EXPECT_THROW(gearforge::ThreadTable::load(path.string()), std::runtime_error);
+    EXPECT_EQ(gearforge::ThreadTable::load_or_build(profile, dir).size(), built.size());
+    EXPECT_EQ(gearforge::ThreadTable::load(path.string()).size(), built.size());
+
+    profile.gears.push_back(60);  // A different set is a different table
+    auto other = gearforge::ThreadTable::load_or_build(profile, dir);
+    EXPECT_GT(other.size(), built.size());
+    EXPECT_EQ(std::distance(std::filesystem::directory_iterator(dir), std::filesystem::directory_iterator()), 2);
+    std::filesystem::remove_all(dir);
+}
+
+TEST(ChangeGearsTest, LoadsProfiles) {
+    std::string path = (std::filesystem::temp_directory_path() / "gearforge_lathe.ini").string();
+    std::ofstream(path) << "; South Bend 9\nname = SB9\nleadscrew_tpi = 8\ngears = 24, 32, 40, 40\ndp = 20\n"
+                           "stud_distance = 3.2\nsimple_trains = no\n";
+    auto p = gearforge::LatheProfile::load(path);
+    EXPECT_EQ(p.name, "SB9");
+    EXPECT_EQ(p.gears, (std::vector<int>{24, 32, 40, 40}));
+    EXPECT_FALSE(p.simple_trains);
+    EXPECT_DOUBLE_EQ(p.stud_distance, 3.2);
+    std::ofstream(path, std::ios::app) << "bogus = 1\n";
+    EXPECT_THROW(gearforge::LatheProfile::load(path), std::runtime_error);
+    std::filesystem::remove(path);
+}
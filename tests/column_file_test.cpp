@@ -0,0 +1,92 @@
+#include <gtest/gtest.h>
+#include "column_file.h"
+
+namespace {
+
+std::string temp_path(const std::string& name) {
+    return (std::filesystem::temp_directory_path() / name).string();
+}
+
+}  // unnamed namespace
+
+TEST(ColumnFileTest, RoundTripsEveryEncoding) {
+    std::string path = temp_path("gearforge_column_file.gfc");
+    std::mt19937_64 rng(7);
+    std::uniform_real_distribution<double> noise(-1.0, 1.0);
+    std::vector<std::vector<std::vector<double>>> written;
+    {
+        gearforge::ColumnFileWriter writer(path, {"Teeth", "PA", "Smooth", "Noise", "Odd"});
+        for (int chunk = 0; chunk < 3; ++chunk) {
+            std::vector<std::vector<double>> cols(5);
+            for (int i = 0; i < 5000; ++i) {
+                cols[0].push_back(12 + (i + chunk * 5000) % 90);       // Integer ramps: delta runs
+                cols[1].push_back(i < 2500 ? 14.5 : 20.0);             // Two values: dictionary
+                cols[2].push_back(std::sin(i * 1e-3) * 0.25 + chunk);  // Slowly varying: XOR
+                cols[3].push_back(noise(rng));
+                cols[4].push_back(i % 100 == 0 ? NAN : i == 7 ? -0.0 : 1e300 * (i % 3));
+            }
+            writer.write_chunk(cols);
+            written.push_back(cols);
+        }
+        EXPECT_EQ(writer.row_count(), 15000u);
+        ASSERT_TRUE(writer.close());
+        // Compressible columns shrink well below 8 bytes a value
+        EXPECT_LT(writer.bytes(), 15000u * 8 * 3);
+    }
+
+    gearforge::ColumnFileReader reader(path);
+    ASSERT_EQ(reader.columns().size(), 5u);
+    EXPECT_EQ(reader.column("Noise"), 3);
+    EXPECT_EQ(reader.column("Nope"), -1);
+    ASSERT_EQ(reader.chunk_count(), 3u);
+    EXPECT_EQ(reader.row_count(), 15000u);
+    for (size_t k = 0; k < 3; ++k) {
+        for (int c = 0; c < 5; ++c) {
+            auto values = reader.read(k, c);
+            ASSERT_EQ(values.size(), 5000u);
+            for (size_t i = 0; i < values.size(); ++i) {
+                double want = written[k][c][i];
+                if (std::isnan(want)) ASSERT_TRUE(std::isnan(values[i]));
+                else ASSERT_EQ(std::memcmp(&values[i], &want, sizeof want), 0) << k << "," << c << "," << i;
+            }
+        }
+    }
+    EXPECT_LT(reader.chunk(0).sizes[1], 64u);
+    EXPECT_LT(reader.chunk(0).sizes[0], 1000u);
+    EXPECT_LT(reader.chunk(0).sizes[2], 5000u * 8);
+    std::filesystem::remove(path);
+}
+
+TEST(ColumnFileTest, ZoneMapsSkipChunks) {
+    std::string path = temp_path("gearforge_column_zones.gfc");
+    {
+        gearforge::ColumnFileWriter writer(path, {"N", "Value"});
+        for (int chunk = 0; chunk < 10; ++chunk) {
+            std::vector<std::vector<double>> cols(2);
+            for (int i = 0; i < 100; ++i) {
+                cols[0].push_back(chunk * 100 + i);
+                cols[1].push_back(i == 50 && chunk == 4 ? NAN : 0.5 * i);
+            }
+            writer.write_chunk(cols);
+        }
+    }
+    gearforge::ColumnFileReader reader(path);
+    auto hits = reader.chunks_overlapping(0, 250, 420);
+    EXPECT_EQ(hits, (std::vector<size_t>{2, 3, 4}));
+    EXPECT_DOUBLE_EQ(reader.chunk(4).max[1], 49.5);
+    EXPECT_DOUBLE_EQ(reader.read(7, 0)[3], 703.0);
+    std::filesystem::remove(path);
+}
+
+TEST(ColumnFileTest, RejectsDamagedFiles) {
+    std::string path = temp_path("gearforge_column_bad.gfc");
+    {
+        gearforge::ColumnFileWriter writer(path, {"A"});
+        writer.write_chunk({{1.0, 2.0, 3.0}});
+    }
+    auto size = std::filesystem::file_size(path);
+    std::filesystem::resize_file(path, size - 3);
+    EXPECT_THROW(gearforge::ColumnFileReader reader(path), std::runtime_error);
+    EXPECT_THROW(gearforge::ColumnFileReader reader(temp_path("gearforge_no_such.gfc")), std::runtime_error);
+    std::filesystem::remove(path);
+}
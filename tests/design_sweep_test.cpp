@@ -0,0 +1,155 @@
+#include <gtest/gtest.h>
+#include "design_sweep.h"
+#include "profile_shift.h"
+
+namespace {
+
+std::string temp_path(const std::string& name) {
+    return (std::filesystem::temp_directory_path() / name).string();
+}
+
+uint64_t accounted(const gearforge::SweepStats& s) {
+    return s.written + s.pruned_teeth + s.pruned_order + s.pruned_center + s.pruned_undercut + s.rejected_contact;
+}
+
+// All rows of a sweep file, one vector per column
+std::vector<std::vector<double>> read_all(gearforge::ColumnFileReader& reader) {
+    std::vector<std::vector<double>> cols(reader.columns().size());
+    std::vector<double> part;
+    for (size_t k = 0; k < reader.chunk_count(); ++k) {
+        for (size_t c = 0; c < cols.size(); ++c) {
+            reader.read(k, static_cast<int>(c), part);
+            cols[c].insert(cols[c].end(), part.begin(), part.end());
+        }
+    }
+    return cols;
+}
+
+}  // unnamed namespace
+
+TEST(DesignSweepTest, ParsesAxes) {
+    using gearforge::SweepSpec;
+    EXPECT_EQ(SweepSpec::parse_axis("12..15"), (std::vector<double>{12, 13, 14, 15}));
+    EXPECT_EQ(SweepSpec::parse_axis("20, 14.5, 20"), (std::vector<double>{14.5, 20}));
+    auto cd = SweepSpec::parse_axis("1.0..2.0 step 0.1");
+    ASSERT_EQ(cd.size(), 11u);
+    EXPECT_DOUBLE_EQ(cd[10], 2.0);
+    EXPECT_THROW(SweepSpec::parse_axis("5..1"), std::runtime_error);
+
+    SweepSpec spec;
+    spec.set("n1", "12..20");
+    spec.set("module", "1, 1.5");
+    spec.set("cd", "20..40");
+    EXPECT_TRUE(spec.metric);
+    EXPECT_EQ(spec.grid_points(), 9u * 9u * 2u * 1u * 21u * 1u);
+    EXPECT_THROW(spec.set("teeth", "12"), std::runtime_error);
+}
+
+TEST(DesignSweepTest, StandardTeethMatchBruteForce) {
+    gearforge::SweepSpec spec;
+    spec.n1 = gearforge::SweepSpec::parse_axis("10..60");
+    spec.pitch = {8, 10, 12};
+    spec.pa = {14.5, 20};
+    spec.cd = gearforge::SweepSpec::parse_axis("1.5..4.0 step 0.125");
+    spec.backlash = {0.0, 0.004};
+    spec.min_teeth = 12;
+    std::string path = temp_path("gearforge_sweep_standard.gfc");
+    auto stats = gearforge::DesignSweep(spec).run(path, 3, 500);
+    EXPECT_EQ(stats.grid, spec.grid_points());
+    EXPECT_EQ(accounted(stats), stats.grid);
+
+    // The same conditions, point by point
+    uint64_t expected = 0;
+    for (double pa : spec.pa) {
+        double a = pa * M_PI / 180.0;
+        for (double dp : spec.pitch) {
+            for (double cd : spec.cd) {
+                for (double n1 : spec.n1) {
+                    for (double n2 : spec.n1) {
+                        if (n1 < 12 || n2 < 12 || n1 > n2) continue;
+                        if (std::fabs((n1 + n2) / (2 * dp) - cd) > spec.cd_tolerance) continue;
+                        if (gearforge::ProfileShiftOptimizer::min_shift(n1, pa) > 0) continue;
+                        double m = 1 / dp, r1 = n1 * m / 2, r2 = n2 * m / 2;
+                        double contact = (std::sqrt(std::pow(r1 + m, 2) - std::pow(r1 * std::cos(a), 2)) +
+                                          std::sqrt(std::pow(r2 + m, 2) - std::pow(r2 * std::cos(a), 2)) -
+                                          (r1 + r2) * std::sin(a)) / (M_PI * m * std::cos(a));
+                        if (contact >= spec.min_contact) expected += spec.backlash.size();
+                    }
+                }
+            }
+        }
+    }
+    ASSERT_GT(expected, 0u);
+    EXPECT_EQ(stats.written, expected);
+
+    gearforge::ColumnFileReader reader(path);
+    EXPECT_EQ(reader.row_count(), expected);
+    EXPECT_GT(reader.chunk_count(), 1u);
+    auto cols = read_all(reader);
+    for (size_t i = 0; i < cols[0].size(); ++i) {
+        EXPECT_LE(cols[0][i], cols[1][i]);
+        EXPECT_NEAR((cols[0][i] + cols[1][i]) / (2 * cols[2][i]), cols[4][i], spec.cd_tolerance);
+        EXPECT_EQ(cols[7][i], 0.0);
+        EXPECT_NEAR(cols[11][i], M_PI / (2 * cols[2][i]) - cols[5][i] / 2, 1e-12);
+    }
+    std::filesystem::remove(path);
+}
+
+TEST(DesignSweepTest, ShiftedTeethReachTheCenterDistance) {
+    gearforge::SweepSpec spec;
+    spec.n1 = gearforge::SweepSpec::parse_axis("8..40");
+    spec.pitch = {10};
+    spec.cd = {1.6, 2.05, 2.5};
+    spec.max_shift = 0.6;
+    std::string path = temp_path("gearforge_sweep_shifted.gfc");
+    auto stats = gearforge::DesignSweep(spec).run(path, 2, 64);
+    EXPECT_EQ(accounted(stats), stats.grid);
+    EXPECT_GT(stats.pruned_undercut + stats.pruned_center, 0u);
+
+    gearforge::ColumnFileReader reader(path);
+    auto cols = read_all(reader);
+    ASSERT_GT(cols[0].size(), 0u);
+    const double a = 20.0 * M_PI / 180.0;
+    auto inv = [](double x) { return std::tan(x) - x; };
+    bool shifted = false;
+    for (size_t i = 0; i < cols[0].size(); ++i) {
+        double n1 = cols[0][i], n2 = cols[1][i], x1 = cols[7][i], x2 = cols[8][i];
+        double aw = cols[9][i] * M_PI / 180.0;
+        // Working pressure angle from the center distance, and the shift sum it needs
+        EXPECT_NEAR(std::cos(aw), (n1 + n2) / 20.0 * std::cos(a) / cols[4][i], 1e-12);
+        EXPECT_NEAR(x1 + x2, (inv(aw) - inv(a)) * (n1 + n2) / (2 * std::tan(a)), 1e-9);
+        EXPECT_GE(x1, gearforge::ProfileShiftOptimizer::min_shift(static_cast<int>(n1), 20.0) - 1e-9);
+        EXPECT_GE(x2, gearforge::ProfileShiftOptimizer::min_shift(static_cast<int>(n2), 20.0) - 1e-9);
+        EXPECT_LE(std::fabs(x1), 0.6 + 1e-12);
+        EXPECT_LE(std::fabs(x2), 0.6 + 1e-12);
+        EXPECT_GE(cols[10][i], 1.2);
+        shifted = shifted || x1 != 0.0;
+    }
+    EXPECT_TRUE(shifted);
+
+    // Partial read: only the chunks that can hold N1 = 8
+    for (size_t k : reader.chunks_overlapping(0, 8, 8)) {
+        auto n1 = reader.read(k, 0);
+        EXPECT_LE(*std::min_element(n1.begin(), n1.end()), 8.0);
+    }
+    std::filesystem::remove(path);
+}
+
+TEST(DesignSweepTest, LargeGridsPruneInBulk) {
+    // 4 billion grid points; nearly all fall to the center distance prune without being visited
+    gearforge::SweepSpec spec;
+    spec.n1 = gearforge::SweepSpec::parse_axis("12..211");
+    spec.pitch = gearforge::SweepSpec::parse_axis("4..28");
+    spec.pa = {14.5, 20, 25, 30};
+    spec.cd = gearforge::SweepSpec::parse_axis("1..10.95 step 0.05");
+    spec.backlash = {0.0, 0.001, 0.002, 0.003, 0.004};
+    spec.cd_tolerance = 1e-6;
+    ASSERT_EQ(spec.grid_points(), 200ull * 200 * 25 * 4 * 200 * 5);
+    std::string path = temp_path("gearforge_sweep_large.gfc");
+    auto stats = gearforge::DesignSweep(spec).run(path);
+    EXPECT_EQ(accounted(stats), stats.grid);
+    EXPECT_GT(stats.written, 100000u);
+    EXPECT_LT(stats.seconds, 30.0);
+    EXPECT_LT(double(stats.bytes) / stats.written, 20.0);  // Bytes per row of 13 columns
+    std::filesystem::remove(path);
+}
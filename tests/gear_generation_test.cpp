@@ -0,0 +1,70 @@
+#include <gtest/gtest.h>
+#include "gear_generation.h"
+#include "test_gears.h"
+
+TEST(GearGeneratorTest, SmallPinionIsUndercut) {
+    gearforge::GearGenerator gen;
+    auto result = gen.simulate(spur(10, 10.0, 20.0));
+    EXPECT_TRUE(result.undercut);
+    EXPECT_GT(result.undercut_depth, 0.0);
+    EXPECT_GT(result.form_diameter, result.base_diameter);
+    EXPECT_NEAR(result.min_profile_shift, 1.0 - 10 * std::pow(std::sin(20.0 * M_PI / 180.0), 2) / 2.0, 1e-12);
+}
+
+TEST(GearGeneratorTest, ProfileShiftRemovesUndercut) {
+    gearforge::GearGenerator gen;
+    auto plain = gen.simulate(spur(10, 10.0, 20.0));
+    auto shifted = gen.simulate(spur(10, 10.0, 20.0, plain.min_profile_shift + 0.02));
+    EXPECT_FALSE(shifted.undercut);
+    EXPECT_FALSE(shifted.pointed_tip);
+}
+
+TEST(GearGeneratorTest, FormDiameterMatchesRackTheory) {
+    // Without undercut the involute ends where the straight rack flank stops
+    gearforge::GearGenerator gen;
+    auto result = gen.simulate(spur(30, 1.0, 20.0));
+    double alpha = 20.0 * M_PI / 180.0;
+    double rb = 15.0 * std::cos(alpha);
+    double u = 15.0 * std::sin(alpha) - 1.0 / std::sin(alpha);
+    EXPECT_FALSE(result.undercut);
+    EXPECT_NEAR(result.form_diameter, 2.0 * std::sqrt(rb * rb + u * u), 0.05);
+}
+
+TEST(GearGeneratorTest, SolvedShiftedGearIsShiftedOnce) {
+    // calculate() already moved OD and RD by x; the generator must not add it again
+    gearforge::GearGenerator gen;
+    auto gear = spur(30, 1.0, 20.0, 0.3);
+    auto result = gen.simulate(gear);
+    double alpha = 20.0 * M_PI / 180.0;
+    double rb = 15.0 * std::cos(alpha);
+    double u = 15.0 * std::sin(alpha) - (1.0 - 0.3) / std::sin(alpha);
+    EXPECT_DOUBLE_EQ(result.radii.back(), gear.od / 2.0);
+    EXPECT_NEAR(result.radii.front(), gear.rd / 2.0, (gear.od - gear.rd) / result.radii.size());
+    EXPECT_FALSE(result.undercut);
+    EXPECT_NEAR(result.form_diameter, 2.0 * std::sqrt(rb * rb + u * u), 0.05);
+}
+
+TEST(GearGeneratorTest, LargeShiftPointsTheTip) {
+    gearforge::GearGenerator gen;
+    EXPECT_TRUE(gen.simulate(spur(10, 1.0, 20.0, 1.5)).pointed_tip);
+}
+
+TEST(GearGeneratorTest, ScreenMatchesSingleRuns) {
+    gearforge::GearGenerator gen;
+    std::vector<gearforge::GearParams> gears = {spur(8, 8.0, 20.0), spur(40, 8.0, 20.0), spur(12, 8.0, 14.5)};
+    auto results = gen.screen(gears, 0, 3);
+    ASSERT_EQ(results.size(), gears.size());
+    for (size_t i = 0; i < gears.size(); ++i) {
+        auto single = gen.simulate(gears[i]);
+        EXPECT_EQ(results[i].undercut, single.undercut);
+        EXPECT_DOUBLE_EQ(results[i].form_diameter, single.form_diameter);
+    }
+    EXPECT_TRUE(results[0].undercut);
+    EXPECT_FALSE(results[1].undercut);
+}
+
+TEST(GearGeneratorTest, TinyPinionInterferesWithLargeMate) {
+    gearforge::GearGenerator gen;
+    EXPECT_TRUE(gen.simulate(spur(10, 1.0, 14.5), 60).tip_interference);
+    EXPECT_FALSE(gen.simulate(spur(40, 1.0, 20.0), 40).tip_interference);
+}
@@ -0,0 +1,65 @@
+#include <gtest/gtest.h>
+#include "gear_identify.h"
+
+TEST(GearIdentifierTest, FindsDiametralPitchFromOD) {
+    gearforge::GearIdentifier id;
+    gearforge::GearMeasurement m;
+    m.n = 24;
+    m.od = 2.6005;  // 26 / DP 10, slightly worn
+    auto hits = id.identify(m, 5);
+    ASSERT_FALSE(hits.empty());
+    EXPECT_EQ(hits[0].source, "DP 10, PA 20");
+    EXPECT_NEAR(hits[0].od_residual, 0.0005, 1e-9);
+    EXPECT_LT(hits[0].score, 1.0);
+    for (size_t i = 1; i < hits.size(); ++i) EXPECT_LE(hits[i - 1].score, hits[i].score);
+}
+
+TEST(GearIdentifierTest, FindsModuleAndUsesRootAndSpan) {
+    gearforge::GearIdentifier id;
+    gearforge::GearMeasurement m;
+    m.n = 30;
+    m.od = 32.0 * 2.0 / 25.4;            // Module 2
+    m.rd = (30 - 2.5) * 2.0 / 25.4;
+    double alpha = 14.5 * M_PI / 180.0;  // Span over 2 teeth at 14.5 degrees
+    m.span = std::cos(alpha) * 2.0 / 25.4 * (M_PI * 1.5 + 30 * (std::tan(alpha) - alpha));
+    m.span_teeth = 2;
+    auto hits = id.identify(m);
+    ASSERT_FALSE(hits.empty());
+    EXPECT_EQ(hits[0].source, "Module 2, PA 14.5");
+    EXPECT_NEAR(hits[0].score, 0.0, 1e-6);
+    EXPECT_NEAR(hits[0].params.m, 2.0, 1e-9);
+}
+
+TEST(GearIdentifierTest, CatalogGearAndWideningSearch) {
+    auto odd = gearforge::GearParams::spec(18, 9.5, 20.0);
+    odd.od = 2.13;
+    gearforge::GearIdentifier id({odd});
+    gearforge::GearMeasurement m;
+    m.n = 18;
+    m.od = 2.1301;
+    auto hits = id.identify(m, 3);
+    ASSERT_EQ(hits.size(), 3u);  // Widened past the tolerance to fill the list
+    EXPECT_EQ(hits[0].source, "Catalog row 1");
+    EXPECT_GT(hits[1].score, 1.0);
+
+    m.od = NAN;
+    EXPECT_THROW(id.identify(m), std::runtime_error);
+
+    // Measurements that can't be real
+    for (double bad : {0.0, -2.13, HUGE_VAL}) {
+        m.od = bad;
+        EXPECT_THROW(id.identify(m), std::runtime_error) << bad;
+        m.od = 2.1301;
+        m.rd = bad;
+        EXPECT_THROW(id.identify(m), std::runtime_error) << bad;
+        m.rd = NAN;
+        m.span = bad;
+        EXPECT_THROW(id.identify(m), std::runtime_error) << bad;
+        m.span = NAN;
+    }
+    m.span = 0.7;
+    m.span_teeth = 18;
+    EXPECT_THROW(id.identify(m), std::runtime_error);
+    m.span_teeth = 3;
+    EXPECT_NO_THROW(id.identify(m));
+}
@@ -0,0 +1,88 @@
+#include <gtest/gtest.h>
+#include "gear_preview.h"
+#include "test_gears.h"
+
+TEST(GearPreviewTest, BrailleCells) {
+    gearforge::BrailleCanvas canvas(3, 1);
+    canvas.set(0, 0);
+    canvas.set(3, 3);
+    canvas.fill_span(0, 4, 5);
+    canvas.fill_span(1, 4, 5);
+    canvas.fill_span(2, 4, 5);
+    canvas.fill_span(3, 4, 5);
+    EXPECT_EQ(canvas.cell(0, 0), 0x01);
+    EXPECT_EQ(canvas.cell(1, 0), 0x80);
+    EXPECT_EQ(canvas.cell(2, 0), 0xFF);
+    EXPECT_TRUE(canvas.dot(3, 3));
+    EXPECT_FALSE(canvas.dot(2, 3));
+    std::string out;
+    canvas.render(out);
+    EXPECT_EQ(out, "⠁⢀⣿\033[K\n");
+}
+
+TEST(GearPreviewTest, ScanlineFill) {
+    gearforge::BrailleCanvas canvas(20, 10);  // 40 x 40 subpixels
+    // 10 x 20 rectangle on pixel edges: exactly 200 dots
+    canvas.fill_polygon({{{5, 5}, {15, 5}, {15, 25}, {5, 25}}});
+    EXPECT_EQ(canvas.count(), 200u);
+    EXPECT_TRUE(canvas.dot(5, 5));
+    EXPECT_FALSE(canvas.dot(15, 5));
+
+    // A square with a square hole, even-odd
+    canvas.clear();
+    canvas.fill_polygon({{{0, 0}, {30, 0}, {30, 30}, {0, 30}}, {{10, 10}, {20, 10}, {20, 20}, {10, 20}}});
+    EXPECT_EQ(canvas.count(), 800u);
+    EXPECT_FALSE(canvas.dot(15, 15));
+
+    // Partly off the canvas: clipped, area about right
+    canvas.clear();
+    canvas.fill_polygon({{{-10, 20}, {20, -10}, {50, 20}, {20, 50}}});
+    EXPECT_NEAR(double(canvas.count()), 40.0 * 40.0 - 4 * 50.0, 20.0);
+}
+
+TEST(GearPreviewTest, GearFillsItsOutline) {
+    size_t before = gearforge::GearPreview::cached_outlines();
+    gearforge::GearPreview preview(spur(24, 6.0), 0, 60, 30);  // 120 x 120 subpixels
+    preview.frame(0.0);
+    const auto& canvas = preview.raster();
+    // Between the root and tip circles, less the bore, in subpixels
+    double scale = 0.95 * 120.0 / (26.0 / 6.0);
+    double root = 0.5 * (24.0 - 2.314) / 6.0 * scale, tip = 0.5 * 26.0 / 6.0 * scale;
+    double bore = 0.3 * root;
+    double dots = canvas.count();
+    EXPECT_GT(dots, M_PI * (root * root - bore * bore));
+    EXPECT_LT(dots, M_PI * (tip * tip - bore * bore));
+    EXPECT_FALSE(canvas.dot(60, 60));  // Bore
+    EXPECT_TRUE(canvas.dot(60, 60 - static_cast<int>(0.5 * (root + bore))));
+
+    // Turning by one tooth gives (nearly) the same picture
+    std::vector<bool> first;
+    for (int y = 0; y < 120; ++y) for (int x = 0; x < 120; ++x) first.push_back(canvas.dot(x, y));
+    preview.frame(2.0 * M_PI / 24.0);
+    size_t differ = 0, i = 0;
+    for (int y = 0; y < 120; ++y) for (int x = 0; x < 120; ++x) differ += first[i++] != canvas.dot(x, y);
+    EXPECT_LT(differ, 40u);
+
+    // Same tooth form again: the outline is shared
+    gearforge::GearPreview again(spur(24, 12.0), 0, 60, 30);
+    EXPECT_EQ(gearforge::GearPreview::cached_outlines(), before + 1);
+
+    // No outline for pressure angles outside (0, 90)
+    for (double pa : {0.0, -20.0, 90.0, 120.0}) {
+        EXPECT_THROW(gearforge::GearPreview(gearforge::GearParams::spec(24, 6.0, pa), 0, 60, 30), std::runtime_error) << pa;
+    }
+}
+
+TEST(GearPreviewTest, MeshingPairFramesAreFast) {
+    gearforge::GearPreview preview(spur(18, 8.0), 42, 120, 40);
+    const std::string& f = preview.frame(0.1, "status");
+    EXPECT_EQ(f.rfind("\033[?2026h\033[H", 0), 0u);
+    EXPECT_NE(f.find(gearforge::utils::COLOR_YELLOW), std::string::npos);  // The mate
+    EXPECT_NE(f.find("status"), std::string::npos);
+
+    auto t0 = std::chrono::steady_clock::now();
+    const int frames = 300;
+    for (int k = 0; k < frames; ++k) preview.frame(k * 0.01);
+    double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count() / frames;
+    EXPECT_LT(ms, 10.0) << ms << " ms per frame";  // 30 fps leaves 33 ms
+}
@@ -0,0 +1,98 @@
+#include <gtest/gtest.h>
+#include "gear_rating.h"
+#include "test_gears.h"
+
+TEST(GearRatingTest, GeometryFactorsFromToothForm) {
+    gearforge::GearRater rater;
+    // Tip-loaded Lewis form factors of full-depth teeth
+    auto f20 = rater.geometry(20, 20.0);
+    EXPECT_NEAR(f20.lewis_y, 0.33, 0.02);
+    EXPECT_NEAR(rater.geometry(12, 20.0).lewis_y, 0.26, 0.02);
+    EXPECT_NEAR(rater.geometry(100, 20.0).lewis_y, 0.45, 0.02);
+    EXPECT_LT(rater.geometry(20, 14.5).lewis_y, f20.lewis_y);
+    // The fillet concentrates stress; J a bit under 0.25 at 20 teeth, tip loaded
+    EXPECT_GT(f20.j, 0.20);
+    EXPECT_LT(f20.j, 0.27);
+    // A positive shift thickens the root
+    EXPECT_GT(rater.geometry(20, 20.0, 0.4).j, f20.j);
+    EXPECT_NEAR(f20.contact, std::cos(M_PI / 9) * std::sin(M_PI / 9) / 2.0, 1e-12);
+    EXPECT_EQ(rater.cached_forms(), 5u);
+}
+
+TEST(GearRatingTest, HandWorkedExample) {
+    // 20 teeth, 8 DP, 2 in face, 1800 rpm, 10 hp, against 60 teeth
+    gearforge::RatingConditions c;
+    c.face_width = 2.0;
+    c.power = 10.0;
+    c.mate_teeth = 60;
+    gearforge::GearRater rater(c);
+    auto r = rater.rate({spur(20, 8.0)}, 1);
+    ASSERT_EQ(r.size(), 1u);
+
+    double v = M_PI * 2.5 * 1800.0 / 12.0;
+    double wt = 33000.0 * 10.0 / v;
+    double b = 0.25 * std::pow(5.0, 2.0 / 3.0), a = 50.0 + 56.0 * (1.0 - b);
+    double kv = std::pow((a + std::sqrt(v)) / a, b);
+    double ks = std::max(1.0, 1.192 * std::pow(2.0 * std::sqrt(r.lewis_y[0]) / 8.0, 0.0535));
+    EXPECT_NEAR(r.bending_stress[0], wt * kv * ks * 8.0 / 2.0 * 1.6 / r.geometry_j[0], 1e-6);
+    double i = std::cos(M_PI / 9) * std::sin(M_PI / 9) / 2.0 * 3.0 / 4.0;
+    EXPECT_NEAR(r.geometry_i[0], i, 1e-12);
+    EXPECT_NEAR(r.contact_stress[0], 2300.0 * std::sqrt(wt * kv * ks * 1.6 / (2.5 * 2.0 * i)), 1e-6);
+
+    // Power scales the stresses: rated power is the same at any transmitted power
+    EXPECT_NEAR(r.bending_power[0], 10.0 * (77.3 * 250.0 + 12800.0) / r.bending_stress[0], 1e-9);
+    EXPECT_DOUBLE_EQ(r.rated_power[0], std::min(r.bending_power[0], r.contact_power[0]));
+    c.power = 1.0;
+    auto one = gearforge::GearRater(c).rate({spur(20, 8.0)}, 1);
+    EXPECT_NEAR(one.rated_power[0], r.rated_power[0], 1e-9 * r.rated_power[0]);
+}
+
+TEST(GearRatingTest, BatchMatchesSingleRowsAndFilters) {
+    std::vector<gearforge::GearParams> gears;
+    for (int i = 0; i < 5000; ++i) gears.push_back(spur(12 + i % 60, 4.0 + (i / 60) % 16, i % 7 ? 20.0 : 14.5));
+    gears.push_back(spur(2, 8.0));    // Can't be rated
+    gears.push_back(spur(30, 0.0));
+
+    gearforge::GearRater rater;
+    auto batch = rater.rate(gears, 4);
+    ASSERT_EQ(batch.size(), gears.size());
+    EXPECT_EQ(rater.cached_forms(), 120u);
+    for (size_t i : {size_t(0), size_t(61), size_t(777), size_t(4999)}) {
+        auto one = gearforge::GearRater().rate({gears[i]}, 1);
+        EXPECT_DOUBLE_EQ(batch.rated_power[i], one.rated_power[0]) << i;
+        EXPECT_DOUBLE_EQ(batch.contact_stress[i], one.contact_stress[0]) << i;
+    }
+    EXPECT_TRUE(std::isnan(batch.rated_power[5000]));
+    EXPECT_TRUE(std::isnan(batch.rated_power[5001]));
+
+    auto rows = batch.at_least(5.0);
+    ASSERT_FALSE(rows.empty());
+    EXPECT_LT(rows.size(), gears.size() - 2);
+    for (size_t i : rows) EXPECT_GE(batch.rated_power[i], 5.0);
+    EXPECT_TRUE(std::is_sorted(rows.begin(), rows.end()));
+}
+
+TEST(GearRatingTest, ModuleOnlyRowsUseTheirModule) {
+    gearforge::GearParams metric = spur(20, 8.0);
+    metric.dp = NAN;  // As loaded from a catalog that gives only M
+    gearforge::GearRater rater;
+    auto r = rater.rate({metric, spur(20, 8.0)}, 1);
+    ASSERT_FALSE(std::isnan(r.rated_power[0]));
+    EXPECT_NEAR(r.rated_power[0], r.rated_power[1], 1e-9 * r.rated_power[1]);
+    EXPECT_NEAR(r.bending_stress[0], r.bending_stress[1], 1e-9 * r.bending_stress[1]);
+    EXPECT_EQ(rater.cached_forms(), 1u);
+}
+
+TEST(GearRatingTest, Materials) {
+    auto steel = gearforge::GearMaterial::parse("Steel:300");
+    EXPECT_DOUBLE_EQ(steel.bending_allowable, 77.3 * 300.0 + 12800.0);
+    EXPECT_EQ(steel.name, "steel:300");
+    EXPECT_EQ(gearforge::GearMaterial::parse("bronze").name, "bronze");
+    EXPECT_THROW(gearforge::GearMaterial::parse("unobtainium"), std::runtime_error);
+
+    gearforge::RatingConditions c;
+    c.material = gearforge::GearMaterial::cast_iron();
+    auto iron = gearforge::GearRater(c).rate({spur(24, 6.0)}, 1);
+    auto hard = gearforge::GearRater().rate({spur(24, 6.0)}, 1);
+    EXPECT_LT(iron.rated_power[0], hard.rated_power[0]);
+}
@@ -0,0 +1,97 @@
+#include <gtest/gtest.h>
+#include "job_scheduler.h"
+
+namespace {
+
+gearforge::CutJob job(const std::string& id, int teeth, double dp, double due, int quantity = 1,
+                      const std::string& machine = "") {
+    gearforge::CutJob j;
+    j.id = id; j.teeth = teeth; j.dp = dp; j.due = due; j.quantity = quantity; j.machine = machine;
+    return j;
+}
+
+// Every job exactly once, on an allowed machine, without overlaps
+void expect_valid(const gearforge::SchedulePlan& plan, const std::vector<gearforge::CutJob>& jobs) {
+    std::vector<int> seen(jobs.size(), 0);
+    for (const auto& m : plan.machines) {
+        double t = 0.0;
+        for (const auto& sj : m.jobs) {
+            ASSERT_LT(sj.job, jobs.size());
+            ++seen[sj.job];
+            const auto& j = jobs[sj.job];
+            if (!j.machine.empty() && j.machine != "any") {
+                EXPECT_EQ(j.machine, m.machine);
+            }
+            EXPECT_NEAR(sj.start, t + sj.setup, 1e-9);
+            EXPECT_GT(sj.end, sj.start);
+            EXPECT_NEAR(sj.lateness, std::max(0.0, sj.end - j.due * 60.0), 1e-9);
+            t = sj.end;
+        }
+        EXPECT_NEAR(m.finish, t, 1e-9);
+    }
+    for (size_t i = 0; i < jobs.size(); ++i) EXPECT_EQ(seen[i], 1) << jobs[i].id;
+}
+
+}  // unnamed namespace
+
+TEST(JobSchedulerTest, DividingPlates) {
+    auto p = gearforge::JobScheduler::dividing_plate(30);  // 1 1/3 turns
+    EXPECT_EQ(p.plate, 1);
+    EXPECT_EQ(p.circle, 15);
+    EXPECT_EQ(p.turns, 1);
+    EXPECT_EQ(p.holes, 5);
+    EXPECT_EQ(gearforge::JobScheduler::dividing_plate(40).plate, 0);
+    EXPECT_EQ(gearforge::JobScheduler::dividing_plate(47).plate, 3);
+    EXPECT_EQ(gearforge::JobScheduler::dividing_plate(51).plate, -1);  // 3 x 17: differential
+}
+
+TEST(JobSchedulerTest, GroupsInterleavedJobsByCutter) {
+    // Three cutters (20, 40 and 10 teeth at 10 DP: cutters 5, 3, 8), all on whole
+    // turns of the head and the same arbor, with no deadline pressure
+    std::vector<gearforge::CutJob> jobs;
+    for (int i = 0; i < 30; ++i) jobs.push_back(job("J" + std::to_string(i), i % 3 == 0 ? 20 : i % 3 == 1 ? 40 : 10, 10.0, 1000.0));
+    gearforge::ScheduleOptions options;
+    options.budget = std::chrono::milliseconds(2000);
+    options.max_iterations = 20000;
+    auto plan = gearforge::JobScheduler(options).schedule(jobs);
+    expect_valid(plan, jobs);
+    // First mount (cutter and arbor) plus two cutter changes
+    EXPECT_DOUBLE_EQ(plan.setup, 15.0 + 20.0 + 2 * 15.0);
+    EXPECT_EQ(plan.late_jobs, 0u);
+}
+
+TEST(JobSchedulerTest, UrgentJobsGoFirstAndMachinesAreRespected) {
+    std::vector<gearforge::CutJob> jobs = {
+        job("slow", 90, 4.0, 100.0, 20), job("rush", 24, 12.0, 2.0, 2), job("fixed", 36, 8.0, 50.0, 3, "Hobber"),
+        job("any1", 24, 12.0, 100.0, 5), job("any2", 30, 10.0, 100.0, 5, "any"),
+    };
+    gearforge::ScheduleOptions options;
+    options.machines = {"Mill", "Hobber"};
+    options.max_iterations = 20000;
+    auto plan = gearforge::JobScheduler(options).schedule(jobs);
+    expect_valid(plan, jobs);
+    EXPECT_EQ(plan.late_jobs, 0u);
+    EXPECT_LE(plan.cost, plan.initial_cost);
+
+    jobs.push_back(job("lost", 20, 10.0, 10.0, 1, "Shaper"));
+    EXPECT_THROW(gearforge::JobScheduler(options).schedule(jobs), std::runtime_error);
+}
+
+TEST(JobSchedulerTest, HundredsOfJobsWithinBudget) {
+    std::mt19937 rng(7);
+    const double dps[] = {4, 6, 8, 10, 12, 16, 20};
+    std::vector<gearforge::CutJob> jobs;
+    for (int i = 0; i < 400; ++i) {
+        jobs.push_back(job("J" + std::to_string(i), 12 + static_cast<int>(rng() % 120), dps[rng() % 7],
+                           8.0 + rng() % 160, 1 + static_cast<int>(rng() % 4), i % 10 == 0 ? "M" + std::to_string(rng() % 4 + 1) : ""));
+    }
+    gearforge::ScheduleOptions options;
+    options.machines = {"M1", "M2", "M3", "M4"};
+    options.budget = std::chrono::milliseconds(300);
+    auto start = std::chrono::steady_clock::now();
+    auto plan = gearforge::JobScheduler(options).schedule(jobs);
+    EXPECT_LT(std::chrono::steady_clock::now() - start, std::chrono::seconds(1));
+    expect_valid(plan, jobs);
+    EXPECT_GT(plan.iterations, 1000u);
+    EXPECT_LT(plan.cost, plan.initial_cost);
+}
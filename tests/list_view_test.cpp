@@ -0,0 +1,72 @@
+#include <gtest/gtest.h>
+#include "list_view.h"
+
+namespace {
+
+// 1M rows whose value is derived from the row number; counts format calls
+struct Table {
+    size_t formats = 0;
+    std::vector<gearforge::ListColumn> columns() {
+        return {
+            {"Row", 8, [](size_t r) { return std::to_string(r); }, nullptr},
+            {"Value", 8,
+             [this](size_t r) { ++formats; return std::to_string((r * 7919) % 1000003); },
+             [](size_t r) { return static_cast<double>((r * 7919) % 1000003); }},
+        };
+    }
+};
+
+}  // namespace
+
+TEST(ListViewTest, NavigationIsClampedAndFollowsCursor) {
+    Table t;
+    gearforge::ListView view(t.columns(), 1000000, 10);
+    view.move(-5);
+    EXPECT_EQ(view.position(), 0u);
+    view.move(12);
+    EXPECT_EQ(view.position(), 12u);
+    EXPECT_EQ(view.first_visible(), 3u);
+    view.page(2);
+    EXPECT_EQ(view.position(), 32u);
+    EXPECT_EQ(view.first_visible(), 23u);
+    view.jump_end();
+    EXPECT_EQ(view.position(), 999999u);
+    EXPECT_EQ(view.first_visible(), 999990u);
+    view.page(1);
+    EXPECT_EQ(view.position(), 999999u);
+    EXPECT_TRUE(view.handle_key('g'));
+    EXPECT_EQ(view.position(), 0u);
+    EXPECT_FALSE(view.handle_key('x'));
+}
+
+TEST(ListViewTest, RendersOnlyTheViewportAndCachesLines) {
+    Table t;
+    gearforge::ListView view(t.columns(), 1000000, 10);
+    std::string frame = view.render();
+    EXPECT_EQ(t.formats, 10u);
+    EXPECT_NE(frame.find("Row 1 of 1000000"), std::string::npos);
+    view.render();
+    EXPECT_EQ(t.formats, 10u);  // Second frame comes from the cache
+    view.move(10);               // Scroll by one line: one new row formatted
+    view.render();
+    EXPECT_EQ(t.formats, 11u);
+}
+
+TEST(ListViewTest, SortUsesPermutationBothWays) {
+    Table t;
+    gearforge::ListView view(t.columns(), 1000, 5);
+    view.sort_by(0);  // No sort key: ignored
+    EXPECT_EQ(view.row_at(0), 0u);
+
+    view.sort_by(1);
+    double prev = -1.0;
+    for (size_t pos = 0; pos < view.size(); ++pos) {
+        double v = static_cast<double>((view.row_at(pos) * 7919) % 1000003);
+        EXPECT_GE(v, prev);
+        prev = v;
+    }
+    size_t smallest = view.row_at(0);
+    view.sort_by(1);  // Same column again: descending
+    EXPECT_EQ(view.row_at(view.size() - 1), smallest);
+    EXPECT_NE(view.render().find("Valuev"), std::string::npos);
+}
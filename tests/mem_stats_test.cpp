@@ -0,0 +1,110 @@
+#include <gtest/gtest.h>
+#include "gear_calculator.h"
+#include "mem_stats.h"
+
+namespace {
+
+uint64_t total_allocations() {
+    uint64_t n = 0;
+    for (const auto& s : gearforge::MemStats::snapshot()) n += s.allocations;
+    return n;
+}
+
+std::vector<gearforge::GearParams> gear_inputs(size_t count) {
+    std::vector<gearforge::GearParams> in;
+    for (size_t i = 0; i < count; ++i) {
+        in.push_back(gearforge::GearParams::spec(12 + static_cast<int>(i % 150), 4.0 + (i % 29) * 0.5, 20.0));
+    }
+    return in;
+}
+
+}  // unnamed namespace
+
+// The tests binary links src/mem_hook.cpp, so counting is always on here
+TEST(MemStatsTest, ScopesChargeTheirTag) {
+    ASSERT_TRUE(gearforge::MemStats::enabled());
+    using gearforge::MemTag;
+    auto csv = gearforge::MemStats::get(MemTag::Csv);
+    auto hash = gearforge::MemStats::get(MemTag::Hash);
+    void* outer;
+    void* inner;
+    {
+        gearforge::MemTagScope a(MemTag::Csv);
+        outer = ::operator new(1000);
+        {
+            gearforge::MemTagScope b(MemTag::Hash);
+            inner = ::operator new(24);
+            EXPECT_EQ(gearforge::MemTagScope::current(), MemTag::Hash);
+        }
+        EXPECT_EQ(gearforge::MemTagScope::current(), MemTag::Csv);
+    }
+    EXPECT_EQ(gearforge::MemTagScope::current(), MemTag::Other);
+    EXPECT_EQ(gearforge::MemStats::get(MemTag::Csv).allocations, csv.allocations + 1);
+    EXPECT_EQ(gearforge::MemStats::get(MemTag::Csv).bytes, csv.bytes + 1000);
+    EXPECT_EQ(gearforge::MemStats::get(MemTag::Hash).allocations, hash.allocations + 1);
+
+    // Freed outside any scope, still charged to the allocating tag
+    ::operator delete(outer);
+    ::operator delete(inner);
+    EXPECT_EQ(gearforge::MemStats::get(MemTag::Csv).live, csv.live);
+    EXPECT_EQ(gearforge::MemStats::get(MemTag::Csv).frees, csv.frees + 1);
+    EXPECT_EQ(gearforge::MemStats::get(MemTag::Hash).live, hash.live);
+}
+
+TEST(MemStatsTest, PeaksAndWorkerThreads) {
+    using gearforge::MemTag;
+    gearforge::MemStats::reset_peaks();
+    auto before = gearforge::MemStats::get(MemTag::Catalog);
+    EXPECT_EQ(before.peak, before.live);
+    {
+        gearforge::MemTagScope tag(MemTag::Catalog);
+        void* block = ::operator new(1 << 20);
+        ::operator delete(block);
+        // Workers inherit the caller's tag
+        gearforge::utils::parallel_for(16, [](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; ++i) ::operator delete(::operator new(64));
+        }, 4);
+    }
+    auto after = gearforge::MemStats::get(MemTag::Catalog);
+    EXPECT_GE(after.peak, before.live + (1 << 20));
+    EXPECT_EQ(after.live, before.live);
+    EXPECT_GE(after.allocations, before.allocations + 17);
+}
+
+// Allocation budgets for the gear pipeline: raise them only on purpose
+TEST(MemStatsTest, AllocationsPerCalculatedGear) {
+    const size_t count = 20000;
+    auto in = gear_inputs(count);
+    std::vector<gearforge::GearParams> out(count);
+    gearforge::GearCalculator calc;
+
+    uint64_t start = total_allocations();
+    for (size_t i = 0; i < count; ++i) out[i] = calc.calculate(in[i]);
+    EXPECT_EQ(total_allocations() - start, 0u) << "calculate allocates";
+
+    std::string path = (std::filesystem::temp_directory_path() / "gearforge_mem_stats.csv").string();
+    start = total_allocations();
+    ASSERT_TRUE(calc.save(out, path));
+    double per_gear = double(total_allocations() - start) / count;
+    EXPECT_LT(per_gear, 0.01) << "save: " << per_gear << " allocations per gear";
+
+    start = total_allocations();
+    auto loaded = calc.load_known(path);
+    per_gear = double(total_allocations() - start) / count;
+    ASSERT_EQ(loaded.size(), count);
+    EXPECT_LT(per_gear, 0.01) << "load_known: " << per_gear << " allocations per gear";
+
+    // One gear costs about one row, not a block per core
+    gearforge::MemStats::reset_peaks();
+    auto csv = gearforge::MemStats::get(gearforge::MemTag::Csv);
+    ASSERT_TRUE(calc.save(out[0], path));
+    EXPECT_LT(gearforge::MemStats::get(gearforge::MemTag::Csv).peak - csv.live, 64 << 10) << "saving one gear";
+    std::filesystem::remove(path);
+
+    start = total_allocations();
+    size_t cells = 0;
+    for (size_t i = 0; i < 1000; ++i) cells += out[i].to_csv_row().size();
+    per_gear = double(total_allocations() - start) / 1000;
+    EXPECT_EQ(cells, 1000 * gearforge::RecordCodec<gearforge::GearParams>::kFields);
+    EXPECT_LE(per_gear, 16.0) << "to_csv_row: " << per_gear << " allocations per gear";
+}
@@ -0,0 +1,104 @@
+#include <gtest/gtest.h>
+#include "mesh_simulation.h"
+#include "test_gears.h"
+
+namespace {
+
+gearforge::MeshDesign pair(int n1, int n2, double dp) {
+    gearforge::MeshDesign d;
+    d.pinion.params = spur(n1, dp);
+    d.gear.params = spur(n2, dp);
+    return d;
+}
+
+double double_contact_fraction(const gearforge::MeshResult& r) {
+    size_t two = 0;
+    for (const auto& s : r.samples) two += s.pairs == 2 ? 1 : 0;
+    return static_cast<double>(two) / r.samples.size();
+}
+
+}  // namespace
+
+TEST(MeshSimulatorTest, ConjugateInvolutesRunWithoutError) {
+    gearforge::MeshSimulator sim;
+    auto r = sim.simulate(pair(20, 40, 10.0));
+    double alpha = 20.0 * M_PI / 180.0;
+    double rb1 = 1.0 * std::cos(alpha), rb2 = 2.0 * std::cos(alpha);
+    double path = std::sqrt(1.1 * 1.1 - rb1 * rb1) + std::sqrt(2.1 * 2.1 - rb2 * rb2) - 3.0 * std::sin(alpha);
+    EXPECT_NEAR(r.center_distance, 3.0, 1e-12);
+    EXPECT_NEAR(r.contact_ratio, path / (M_PI * 0.1 * std::cos(alpha)), 1e-9);
+    EXPECT_LT(r.te_peak_to_peak, 1e-6);
+    // Stiffness steps between one and two pairs, two for (contact ratio - 1) of the cycle
+    EXPECT_DOUBLE_EQ(r.min_stiffness, 2.0e6);
+    EXPECT_DOUBLE_EQ(r.max_stiffness, 4.0e6);
+    EXPECT_NEAR(double_contact_fraction(r), r.contact_ratio - 1.0, 0.05);
+}
+
+TEST(MeshSimulatorTest, TipReliefMatchedToLoadFlattensLoadedError) {
+    gearforge::MeshSimulator sim;
+    auto plain = pair(20, 40, 10.0);
+    plain.load = 1000.0;
+    auto r = sim.simulate(plain);
+    // Deflection of one pair vs two: load / k - load / 2k
+    EXPECT_NEAR(r.loaded_te_peak_to_peak, 1000.0 / 2.0e6 / 2.0, 2e-5);
+
+    auto relieved = plain;
+    relieved.pinion.tip_relief = relieved.gear.tip_relief = 1000.0 / 2.0e6;
+    auto rr = sim.simulate(relieved);
+    EXPECT_GT(rr.te_peak_to_peak, 1e-4);
+    EXPECT_LT(rr.loaded_te_peak_to_peak, 0.1 * r.loaded_te_peak_to_peak);
+}
+
+TEST(MeshSimulatorTest, ProfileShiftSetsCenterDistance) {
+    gearforge::MeshSimulator sim;
+    gearforge::MeshDesign balanced;
+    balanced.pinion.params = spur(14, 8.0, 20.0, 0.3);
+    balanced.gear.params = spur(40, 8.0, 20.0, -0.3);
+    auto r = sim.simulate(balanced);
+    EXPECT_NEAR(r.center_distance, 54.0 / 16.0, 1e-12);
+    EXPECT_LT(r.te_peak_to_peak, 1e-6);
+
+    // Solved, shifted tips enter the contact ratio once: OD already holds the shift
+    double alpha = 20.0 * M_PI / 180.0;
+    double rb1 = 14.0 / 16.0 * std::cos(alpha), rb2 = 40.0 / 16.0 * std::cos(alpha);
+    double ra1 = balanced.pinion.params.od / 2.0, ra2 = balanced.gear.params.od / 2.0;
+    double path = std::sqrt(ra1 * ra1 - rb1 * rb1) + std::sqrt(ra2 * ra2 - rb2 * rb2) - r.center_distance * std::sin(alpha);
+    EXPECT_NEAR(r.contact_ratio, path / (M_PI / 8.0 * std::cos(alpha)), 1e-9);
+
+    auto spread = balanced;
+    spread.gear.params = spur(40, 8.0, 20.0, 0.3);
+    auto s = sim.simulate(spread);
+    EXPECT_GT(s.center_distance, 54.0 / 16.0);
+    EXPECT_GT(s.working_pressure_angle, 20.0);
+    EXPECT_LT(s.te_peak_to_peak, 1e-6);
+
+    auto mismatched = balanced;
+    mismatched.gear.params.dp = 10.0;
+    EXPECT_THROW(sim.simulate(mismatched), std::runtime_error);
+
+    // inv(20 deg) + 2 (x1 + x2) tan(20 deg) / 40 < 0: no working pressure angle
+    gearforge::MeshDesign undercut;
+    undercut.pinion.params = spur(20, 10.0, 20.0, -0.5);
+    undercut.gear.params = spur(20, 10.0, 20.0, -0.5);
+    EXPECT_THROW(sim.simulate(undercut), std::invalid_argument);
+}
+
+TEST(MeshSimulatorTest, BatchMatchesSingleRuns) {
+    gearforge::MeshOptions options;
+    options.steps_per_pitch = 16;
+    options.pitches = 2;
+    gearforge::MeshSimulator sim(options);
+    std::vector<gearforge::MeshDesign> designs = {pair(18, 36, 12.0), pair(25, 25, 6.0), pair(12, 60, 10.0)};
+    designs[1].load = 200.0;
+    designs[2].pinion.tip_relief = 0.0004;
+    auto results = sim.batch(designs, 2);
+    ASSERT_EQ(results.size(), designs.size());
+    for (size_t i = 0; i < designs.size(); ++i) {
+        auto single = sim.simulate(designs[i], 3);
+        ASSERT_EQ(results[i].samples.size(), 32u);
+        for (size_t s = 0; s < single.samples.size(); ++s) {
+            EXPECT_DOUBLE_EQ(results[i].samples[s].te, single.samples[s].te);
+            EXPECT_DOUBLE_EQ(results[i].samples[s].loaded_te, single.samples[s].loaded_te);
+        }
+    }
+}
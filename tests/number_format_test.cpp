@@ -0,0 +1,65 @@
+#include <gtest/gtest.h>
+#include "gear_calculator.h"
+#include "number_format.h"
+#include "test_gears.h"
+
+TEST(NumberFormatTest, ShortestTextRoundTrips) {
+    EXPECT_EQ(gearforge::number_to_string(2.0), "2");
+    EXPECT_EQ(gearforge::number_to_string(2.54), "2.54");
+    EXPECT_EQ(gearforge::number_to_string(0.1 + 0.2), "0.30000000000000004");
+    EXPECT_EQ(gearforge::number_to_string(NAN), "nan");
+
+    std::mt19937_64 rng(42);
+    std::uniform_real_distribution<double> exponent(-30.0, 30.0);
+    for (int i = 0; i < 100000; ++i) {
+        double v = std::pow(10.0, exponent(rng)) * (i % 2 ? 1 : -1);
+        EXPECT_EQ(std::stod(gearforge::number_to_string(v)), v);
+    }
+
+    char buf[gearforge::kMaxNumberChars];
+    EXPECT_EQ(std::string(buf, gearforge::format_number(buf, 0.1f)), "0.1");
+}
+
+TEST(NumberFormatTest, FixedDecimals) {
+    EXPECT_EQ(gearforge::number_to_string(3.14159, 2), "3.14");
+    EXPECT_EQ(gearforge::number_to_string(2.0, 3), "2.000");
+    EXPECT_EQ(gearforge::number_to_string(NAN, 3), "nan");
+    // Too wide for fixed notation: falls back to exponent form instead of failing
+    EXPECT_EQ(gearforge::number_to_string(1e300, 2), "1e+300");
+}
+
+TEST(NumberFormatTest, BufferKeepsStorageAcrossClear) {
+    gearforge::FormatBuffer buffer(8);
+    for (int round = 0; round < 2; ++round) {
+        buffer.clear();
+        for (int i = 0; i < 100; ++i) {
+            buffer.append(i);
+            buffer.append(',');
+            buffer.append(i * 0.5);
+            buffer.append('\n');
+        }
+    }
+    std::string text = buffer.str();
+    EXPECT_EQ(text.substr(0, 12), "0,0\n1,0.5\n2,");
+    EXPECT_EQ(std::count(text.begin(), text.end(), '\n'), 100);
+}
+
+TEST(NumberFormatTest, SavedCatalogReloadsExactly) {
+    std::string path = (std::filesystem::temp_directory_path() / "gearforge_number_format_test.csv").string();
+    gearforge::GearCalculator calc;
+    std::vector<gearforge::GearParams> gears;
+    for (int n = 7; n < 500; n += 13) {
+        gears.push_back(spur(n, 10.0 / 3.0, 14.5));
+    }
+    ASSERT_TRUE(calc.save(gears, path));
+    auto loaded = calc.load_known(path);
+    ASSERT_EQ(loaded.size(), gears.size());
+    for (size_t i = 0; i < gears.size(); ++i) {
+        EXPECT_EQ(loaded[i].n, gears[i].n);
+        EXPECT_EQ(loaded[i].dp, gears[i].dp);
+        EXPECT_EQ(loaded[i].pd, gears[i].pd);
+        EXPECT_EQ(loaded[i].cp, gears[i].cp);
+        EXPECT_EQ(loaded[i].backlash, gears[i].backlash);
+    }
+    std::filesystem::remove(path);
+}
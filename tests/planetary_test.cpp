@@ -0,0 +1,80 @@
+#include <gtest/gtest.h>
+#include "planetary.h"
+
+TEST(PlanetaryTest, ResultsSatisfyEveryConstraint) {
+    gearforge::PlanetaryOptions options;
+    options.target_ratio = 4.0;
+    options.ratio_tolerance = 0.02;
+    options.limit = 1000;
+    auto configs = gearforge::PlanetaryEnumerator(options).enumerate(2);
+    ASSERT_FALSE(configs.empty());
+    EXPECT_DOUBLE_EQ(configs.front().ratio_error, 0.0);
+    for (size_t i = 0; i < configs.size(); ++i) {
+        const auto& c = configs[i];
+        EXPECT_EQ(c.ring, c.sun + 2 * c.planet);
+        EXPECT_EQ((c.sun + c.ring) % c.planets, 0);
+        EXPECT_GE(c.sun, 18);  // No undercut at 20 degrees
+        EXPECT_GE(c.planet, 18);
+        EXPECT_GE(c.planet_gap, 0.5 * c.module);
+        EXPECT_LE(std::fabs(c.ratio / 4.0 - 1.0), 0.02 + 1e-12);
+        EXPECT_NEAR(c.center_distance, (c.sun + c.planet) * c.module / 2.0, 1e-9);
+        if (i > 0) {
+            EXPECT_FALSE(gearforge::PlanetaryEnumerator::better(c, configs[i - 1]));
+        }
+    }
+}
+
+TEST(PlanetaryTest, MatchesBruteForce) {
+    gearforge::PlanetaryOptions options;
+    options.target_ratio = 5.5;
+    options.ratio_tolerance = 0.03;
+    options.max_teeth = 80;
+    options.limit = 100000;
+    size_t found = gearforge::PlanetaryEnumerator(options).enumerate([](const gearforge::PlanetaryConfig&) {}, 3);
+
+    size_t expected = 0;
+    for (int s = 18; s <= 80; ++s) {
+        for (int p = 18; p <= 80; ++p) {
+            int r = s + 2 * p;
+            if (r - p < 12 || std::fabs((1.0 + static_cast<double>(r) / s) / 5.5 - 1.0) > 0.03) continue;
+            for (int np = 3; np <= 8; ++np) {
+                double gap = (s + p) * std::sin(M_PI / np) - (p + 2);
+                if ((s + r) % np == 0 && gap >= 0.5) ++expected;
+            }
+        }
+    }
+    EXPECT_GT(expected, 0u);
+    EXPECT_EQ(found, expected);
+}
+
+TEST(PlanetaryTest, PicksLargestStandardModuleForEnvelope) {
+    gearforge::PlanetaryOptions options;
+    options.target_ratio = 4.0;
+    options.max_ring_diameter = 150.0;
+    options.limit = 1000;
+    auto configs = gearforge::PlanetaryEnumerator(options).enumerate();
+    ASSERT_FALSE(configs.empty());
+    for (const auto& c : configs) {
+        EXPECT_LE(c.ring_diameter, 150.0 + 1e-9);
+        EXPECT_NEAR(c.ring_diameter, c.module * (c.ring + 2.314), 1e-9);
+        EXPECT_NEAR(c.ring_params.m, c.module, 1e-12);
+    }
+    // 24/24/72 fits module 2 (148.6 mm) but not 2.25
+    auto it = std::find_if(configs.begin(), configs.end(), [](const gearforge::PlanetaryConfig& c) { return c.sun == 24 && c.ring == 72; });
+    ASSERT_NE(it, configs.end());
+    EXPECT_DOUBLE_EQ(it->module, 2.0);
+}
+
+TEST(PlanetaryTest, StreamsOnlyTheLimitInRankOrder) {
+    gearforge::PlanetaryOptions options;
+    options.target_ratio = 7.0;
+    options.ratio_tolerance = 0.05;
+    options.max_teeth = 400;
+    options.limit = 25;
+    std::vector<gearforge::PlanetaryConfig> streamed;
+    size_t found = gearforge::PlanetaryEnumerator(options).enumerate(
+        [&](const gearforge::PlanetaryConfig& c) { streamed.push_back(c); }, 4);
+    EXPECT_EQ(streamed.size(), 25u);
+    EXPECT_GT(found, streamed.size());
+    EXPECT_TRUE(std::is_sorted(streamed.begin(), streamed.end(), gearforge::PlanetaryEnumerator::better));
+}
@@ -0,0 +1,101 @@
+#include <filesystem>
+#include <gtest/gtest.h>
+#include "gear_calculator.h"
+
+namespace {
+
+template <typename T>
+gearforge::BasicGearParams<T> spur(int n, double dp) {
+    return gearforge::precision_cast<T>(gearforge::GearParams::spec(n, dp, NAN));
+}
+
+// A few thousand inch and module gears over the catalog's usual range, unsolved
+std::vector<gearforge::GearParams> catalog_specs() {
+    std::vector<gearforge::GearParams> specs;
+    for (int n = 7; n <= 200; n += 3) {
+        for (double pa : {14.5, 20.0, 25.0}) {
+            for (double x : {-0.25, 0.0, 0.4}) {
+                for (double dp : {1.0, 4.0, 10.0, 24.0, 64.0}) specs.push_back(gearforge::GearParams::spec(n, dp, pa, x));
+                for (double m : {0.5, 1.5, 6.0}) {
+                    specs.push_back(gearforge::GearParams::spec(n, NAN, pa, x));
+                    specs.back().m = m;
+                }
+            }
+        }
+    }
+    return specs;
+}
+
+std::vector<double> fields(const gearforge::GearParams& g) {
+    return {g.dp, g.m, g.pd, g.od, g.rd, g.a, g.d, g.wd, g.cp, g.pa, g.cd, g.backlash, g.x};
+}
+
+// Solves the catalog in T, saves it, reloads it and checks every field: the
+// reload must give back exactly what was saved, and the saved values must be
+// within the policy's tolerance of double
+template <typename T>
+void round_trip_catalog(const char* name, double relative, double absolute) {
+    auto specs = catalog_specs();
+    auto expected = gearforge::GearCalculator().calculate(specs);
+    std::vector<gearforge::BasicGearParams<T>> inputs;
+    for (const auto& s : specs) inputs.push_back(gearforge::precision_cast<T>(s));
+
+    gearforge::BasicGearCalculator<T> calc;
+    auto solved = calc.calculate(inputs);
+    std::string path = (std::filesystem::temp_directory_path() / name).string();
+    ASSERT_TRUE(calc.save(solved, path));
+    auto loaded = calc.load_known(path);
+    std::filesystem::remove(path);
+    ASSERT_EQ(loaded.size(), specs.size());
+
+    for (size_t i = 0; i < loaded.size(); ++i) {
+        ASSERT_EQ(loaded[i].n, expected[i].n);
+        auto saved = fields(gearforge::precision_cast<double>(solved[i]));
+        auto back = fields(gearforge::precision_cast<double>(loaded[i]));
+        auto want = fields(expected[i]);
+        for (size_t f = 0; f < want.size(); ++f) {
+            if (std::isnan(saved[f])) EXPECT_TRUE(std::isnan(back[f])) << "row " << i << " field " << f;
+            else EXPECT_EQ(back[f], saved[f]) << "row " << i << " field " << f;
+            EXPECT_NEAR(back[f], want[f], absolute + relative * std::abs(want[f])) << "row " << i << " field " << f;
+        }
+    }
+}
+
+}  // namespace
+
+TEST(FixedTest, ArithmeticAndNaN) {
+    using gearforge::Fixed;
+    Fixed a = Fixed::from_double(2.5), b = Fixed::from_double(-0.75);
+    EXPECT_DOUBLE_EQ((a + b).to_double(), 1.75);
+    EXPECT_DOUBLE_EQ((a * b).to_double(), -1.875);
+    EXPECT_NEAR((a / b).to_double(), -10.0 / 3.0, 1e-9);
+    EXPECT_TRUE((a / Fixed(0)).is_nan());
+    EXPECT_TRUE((Fixed::nan() + a).is_nan());
+    EXPECT_FALSE(Fixed::nan() == Fixed::nan());
+    EXPECT_NEAR(gearforge::sin(Fixed::from_double(1.0)).to_double(), std::sin(1.0), 1e-9);
+    EXPECT_NEAR(gearforge::cos(Fixed::from_double(-4.0)).to_double(), std::cos(-4.0), 1e-9);
+}
+
+TEST(PrecisionPolicyTest, PoliciesAgree) {
+    auto d = gearforge::BasicGearCalculator<double>().calculate(spur<double>(20, 10.0));
+    auto f = gearforge::BasicGearCalculator<float>().calculate(spur<float>(20, 10.0));
+    auto x = gearforge::BasicGearCalculator<gearforge::Fixed>().calculate(spur<gearforge::Fixed>(20, 10.0));
+    EXPECT_NEAR(f.od, d.od, 1e-6);
+    EXPECT_NEAR(f.cp, d.cp, 1e-6);
+    EXPECT_NEAR(x.od.to_double(), d.od, 1e-8);
+    EXPECT_NEAR(x.m.to_double(), 2.54, 1e-8);
+    EXPECT_DOUBLE_EQ(x.pa.to_double(), 20.0);
+}
+
+TEST(PrecisionPolicyTest, FixedIsExact) {
+    // Integer arithmetic only: the raw bits are pinned, not just close
+    auto x = gearforge::BasicGearCalculator<gearforge::Fixed>().calculate(spur<gearforge::Fixed>(20, 10.0));
+    EXPECT_EQ(x.pd.raw(), int64_t(2) << 32);
+    EXPECT_TRUE(gearforge::precision::is_nan(spur<gearforge::Fixed>(20, 10.0).cd));
+}
+
+TEST(PrecisionPolicyTest, CatalogRoundTripsInEveryPolicy) {
+    round_trip_catalog<double>("gf_precision_double.csv", 0.0, 0.0);
+    round_trip_catalog<float>("gf_precision_float.csv", 1e-6, 1e-7);
+    round_trip_catalog<gearforge::Fixed>("gf_precision_fixed.csv", 0.0, 1e-8);
+}
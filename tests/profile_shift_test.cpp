@@ -0,0 +1,89 @@
+#include <gtest/gtest.h>
+#include "mesh_simulation.h"
+#include "profile_shift.h"
+#include "test_gears.h"
+
+namespace {
+
+gearforge::ShiftPair shift_pair(int n1, int n2, double dp, double cd = NAN) {
+    gearforge::ShiftPair p;
+    p.id = std::to_string(n1) + ":" + std::to_string(n2);
+    p.n1 = n1; p.n2 = n2; p.dp = dp; p.cd = cd;
+    return p;
+}
+
+}  // unnamed namespace
+
+TEST(ProfileShiftTest, ShiftMovesAddendumAndDedendum) {
+    auto r = spur(12, 10.0, 20.0, 0.5);
+    EXPECT_DOUBLE_EQ(r.pd, 1.2);
+    EXPECT_DOUBLE_EQ(r.a, 0.15);
+    EXPECT_NEAR(r.d, 0.0657, 1e-12);
+    EXPECT_DOUBLE_EQ(r.od, 1.5);
+    EXPECT_NEAR(r.wd, 0.2157, 1e-12);
+    // Unshifted by default
+    gearforge::GearParams q{};
+    EXPECT_EQ(q.x, 0.0);
+}
+
+TEST(ProfileShiftTest, StandardCenterBalancesSliding) {
+    gearforge::ShiftOptions options;
+    options.strength_weight = 0.0;
+    auto r = gearforge::ProfileShiftOptimizer(options).optimize(shift_pair(12, 40, 10.0));
+    EXPECT_TRUE(r.feasible) << r.note;
+    EXPECT_NEAR(r.x1 + r.x2, 0.0, 1e-12);
+    EXPECT_NEAR(r.cd, 2.6, 1e-12);
+    EXPECT_GE(r.x1, gearforge::ProfileShiftOptimizer::min_shift(12, 20.0));  // A 12 tooth pinion needs shifting
+    EXPECT_NEAR(r.sliding1, r.sliding2, 1e-3 * r.sliding1);
+    EXPECT_GE(r.tip1, options.min_tip);
+    EXPECT_GE(r.contact_ratio, options.min_contact);
+}
+
+TEST(ProfileShiftTest, KeepsRequiredCenterDistance) {
+    auto pair = shift_pair(12, 40, 10.0, 2.7);
+    auto r = gearforge::ProfileShiftOptimizer().optimize(pair);
+    ASSERT_TRUE(r.feasible) << r.note;
+    EXPECT_DOUBLE_EQ(r.cd, 2.7);
+    EXPECT_GT(r.working_pa, 20.0);
+    EXPECT_GT(r.tip_shortening, 0.0);
+
+    // The mesh simulator closes the same shifted pair at the required distance
+    gearforge::MeshDesign d;
+    auto gears = r.gears(pair);
+    d.pinion.params = gears.first;
+    d.gear.params = gears.second;
+    auto mesh = gearforge::MeshSimulator().simulate(d, 1);
+    EXPECT_NEAR(mesh.center_distance, 2.7, 1e-9);
+    EXPECT_NEAR(mesh.working_pressure_angle, r.working_pa, 1e-9);
+    EXPECT_NEAR(gears.first.od, 1.2 + 2.0 * (1.0 + r.x1 - r.tip_shortening) / 10.0, 1e-12);
+
+    // Closer than the base circles allow
+    auto bad = gearforge::ProfileShiftOptimizer().optimize(shift_pair(12, 40, 10.0, 2.4));
+    EXPECT_FALSE(bad.feasible);
+    EXPECT_FALSE(bad.note.empty());
+}
+
+TEST(ProfileShiftTest, BillOfMaterialsInParallel) {
+    std::vector<gearforge::ShiftPair> bom;
+    for (int n1 = 10; n1 < 30; ++n1) {
+        for (int n2 : {n1 + 5, 2 * n1, 4 * n1}) bom.push_back(shift_pair(n1, n2, 8.0));
+    }
+    bom.push_back(shift_pair(15, 45, 8.0, 3.85));
+    gearforge::ProfileShiftOptimizer optimizer;
+    auto results = optimizer.optimize(bom, 4);
+    ASSERT_EQ(results.size(), bom.size());
+    for (size_t i = 0; i < bom.size(); ++i) {
+        auto single = optimizer.optimize(bom[i]);
+        EXPECT_EQ(results[i].id, bom[i].id);
+        EXPECT_EQ(results[i].x1, single.x1);
+        EXPECT_EQ(results[i].x2, single.x2);
+        // Both gears can avoid undercut at the standard center distance
+        if (bom[i].n1 >= 12 && gearforge::ProfileShiftOptimizer::min_shift(bom[i].n1, 20.0) +
+                                   gearforge::ProfileShiftOptimizer::min_shift(bom[i].n2, 20.0) <= 0.0) {
+            EXPECT_TRUE(results[i].feasible) << bom[i].id << ": " << results[i].note;
+        }
+    }
+
+    bom[0].n1 = 0;
+    EXPECT_THROW(optimizer.optimize(bom), std::runtime_error);
+}
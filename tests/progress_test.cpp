@@ -0,0 +1,150 @@
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <gtest/gtest.h>
+#include "progress.h"
+
+namespace {
+
+using gearforge::ProgressReporter;
+using gearforge::ScopedProgress;
+
+// Points std::cout at a string for the object's lifetime
+class CaptureStdout {
+private:
+    std::ostringstream text;
+    std::streambuf* old;
+
+public:
+    CaptureStdout() : old(std::cout.rdbuf(text.rdbuf())) {}
+    ~CaptureStdout() { std::cout.rdbuf(old); }
+    std::string str() const { return text.str(); }
+};
+
+// Lets the renderer draw the live tasks until a frame contains `want`. The
+// renderer is stopped (joined) before each look, so reads never race it.
+std::string frames_until(const std::string& want) {
+    auto& reporter = ProgressReporter::instance();
+    CaptureStdout out;
+    reporter.set_refresh_interval(std::chrono::milliseconds(1));
+    for (int attempt = 0; attempt < 500 && out.str().find(want) == std::string::npos; ++attempt) {
+        reporter.set_enabled(true);
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        reporter.set_enabled(false);
+    }
+    return out.str();
+}
+
+// Keeps the renderer off outside frames_until, whatever stdout is, and
+// puts the reporter back as it was
+class QuietReporter {
+private:
+    bool was_enabled;
+
+public:
+    QuietReporter() : was_enabled(ProgressReporter::instance().is_enabled()) {
+        ProgressReporter::instance().set_enabled(false);
+    }
+    ~QuietReporter() {
+        ProgressReporter::instance().set_refresh_interval(std::chrono::milliseconds(100));
+        ProgressReporter::instance().set_enabled(was_enabled);
+    }
+};
+
+}  // unnamed namespace
+
+TEST(ProgressTest, PercentFollowsByteOffsets) {
+    QuietReporter quiet;
+    {
+        ScopedProgress load("Loading gears.csv", 4096);  // Loaders count bytes
+        load.set(1024);
+        std::string frames = frames_until(" 25%");
+        EXPECT_NE(frames.find("Loading gears.csv ["), std::string::npos);
+        EXPECT_NE(frames.find(" 25%"), std::string::npos);
+        load.add(2048);
+        EXPECT_NE(frames_until(" 75%").find(" 75%"), std::string::npos);
+        load.set(5000);  // Past the end (the file grew): clamped
+        EXPECT_NE(frames_until("100%").find("100%"), std::string::npos);
+    }
+    {
+        ScopedProgress unknown("Loading pipe", 0);  // Size unknown: shown as done
+        unknown.set(123);
+        EXPECT_NE(frames_until("100%").find("Loading pipe"), std::string::npos);
+    }
+
+    // A real loader: read_csv reports its offset into the file, and the last task out draws 100%
+    std::string path = (std::filesystem::temp_directory_path() / "gearforge_progress.csv").string();
+    {
+        std::ofstream file(path);
+        for (int i = 0; i < 1000; ++i) file << i << ",20,10\n";
+    }
+    std::string frames;
+    {
+        CaptureStdout out;
+        ProgressReporter::instance().set_enabled(true);
+        EXPECT_EQ(gearforge::utils::read_csv(path).size(), 1000u);
+        ProgressReporter::instance().set_enabled(false);
+        frames = out.str();
+    }
+    EXPECT_NE(frames.find("Loading gearforge_progress.csv ["), std::string::npos);
+    EXPECT_NE(frames.find("100%"), std::string::npos);
+    std::filesystem::remove(path);
+}
+
+TEST(ProgressTest, NestedAndConcurrentTasks) {
+    QuietReporter quiet;
+    ScopedProgress outer("Sweeping", 10);
+    outer.set(5);
+    {
+        ScopedProgress inner("Loading", 400);
+        std::vector<std::thread> workers;
+        for (int t = 0; t < 4; ++t) {
+            workers.emplace_back([&inner] {
+                for (int i = 0; i < 100; ++i) inner.add(1);
+            });
+        }
+        for (auto& w : workers) w.join();
+        EXPECT_EQ(inner.state().done.load(), 400u);
+
+        // One line per live task, oldest first
+        std::string frames = frames_until("Loading");
+        size_t sweep = frames.rfind("Sweeping [");
+        size_t load = frames.rfind("Loading [");
+        ASSERT_NE(sweep, std::string::npos);
+        ASSERT_NE(load, std::string::npos);
+        EXPECT_LT(sweep, load);
+        EXPECT_NE(frames.find(" 50%", sweep), std::string::npos);
+        EXPECT_NE(frames.find("100%", load), std::string::npos);
+    }
+    EXPECT_FALSE(outer.state().finished.load());
+
+    // The inner task ended: the next frame moves up over both old lines and clears the one left over
+    std::string frames = frames_until("Sweeping");
+    EXPECT_EQ(frames.rfind("\033[2A", 0), 0u);
+    EXPECT_EQ(frames.find("Loading"), std::string::npos);
+    EXPECT_NE(frames.find("\033[J"), std::string::npos);
+}
+
+TEST(ProgressDeathTest, DisabledWhenStdoutIsNotATerminal) {
+    // threadsafe re-executes the test binary, so the child builds a fresh
+    // reporter, and builds it only after stdout has become a pipe
+    GTEST_FLAG_SET(death_test_style, "threadsafe");
+    EXPECT_EXIT({
+        int pipe_fds[2];
+        if (::pipe(pipe_fds) != 0) std::exit(2);
+        ::fcntl(pipe_fds[0], F_SETFL, O_NONBLOCK);
+        std::fflush(stdout);  // gtest's own output stays out of the pipe
+        ::dup2(pipe_fds[1], STDOUT_FILENO);
+        bool ok = !ProgressReporter::instance().is_enabled();
+        {
+            ScopedProgress load("Loading", 100);
+            load.set(50);
+            std::this_thread::sleep_for(std::chrono::milliseconds(300));  // Three refresh intervals
+            ok = ok && load.state().done.load() == 50u;
+        }
+        std::cout << std::flush;
+        char byte;
+        ok = ok && ::read(pipe_fds[0], &byte, 1) < 0 && errno == EAGAIN;  // Nothing was drawn
+        std::exit(ok ? 0 : 1);
+    }, ::testing::ExitedWithCode(0), "");
+}
@@ -0,0 +1,70 @@
+#include <gtest/gtest.h>
+#include "pty_replay.h"
+
+namespace {
+
+std::vector<gearforge::ReplayStep> trace(const std::string& text) {
+    std::istringstream in(text);
+    return gearforge::parse_trace(in);
+}
+
+}  // namespace
+
+TEST(PtyReplayTest, ParsesTraces) {
+    auto steps = trace("# comment\n\nexpect Main Menu\ntype ab c\nkey enter\nkey up\nkey q\nwait 25\n");
+    ASSERT_EQ(steps.size(), 9u);
+    EXPECT_EQ(steps[0].kind, gearforge::ReplayStep::Expect);
+    EXPECT_EQ(steps[0].bytes, "Main Menu");
+    EXPECT_EQ(steps[0].line, 3);
+    EXPECT_EQ(steps[1].bytes, "a");
+    EXPECT_EQ(steps[3].bytes, " ");
+    EXPECT_EQ(steps[5].bytes, "\r");
+    EXPECT_EQ(steps[6].bytes, "\033[A");
+    EXPECT_EQ(steps[7].bytes, "q");
+    EXPECT_EQ(steps[8].kind, gearforge::ReplayStep::Wait);
+    EXPECT_EQ(steps[8].wait_ms, 25);
+
+    EXPECT_THROW(trace("key pageup\n"), std::runtime_error);
+    EXPECT_THROW(trace("press x\n"), std::runtime_error);
+    EXPECT_THROW(trace("wait soon\n"), std::runtime_error);
+}
+
+TEST(PtyReplayTest, PercentilesUseNearestRank) {
+    std::vector<double> samples;
+    for (int i = 100; i >= 1; --i) samples.push_back(i);
+    samples.push_back(NAN);  // Keys with no frame are left out
+    auto s = gearforge::PtyReplay::summarize(samples);
+    EXPECT_EQ(s.frames, 100u);
+    EXPECT_DOUBLE_EQ(s.p50, 50.0);
+    EXPECT_DOUBLE_EQ(s.p90, 90.0);
+    EXPECT_DOUBLE_EQ(s.p99, 99.0);
+    EXPECT_DOUBLE_EQ(s.max, 100.0);
+    EXPECT_EQ(gearforge::PtyReplay::summarize({}).frames, 0u);
+}
+
+TEST(PtyReplayTest, TimesFramesOfAProgramOnAPty) {
+    // cat in cooked mode: the terminal echoes each key, Enter also echoes the line back
+    gearforge::ReplayOptions options;
+    options.argv = {"cat"};
+    options.settle_ms = 20;
+    auto report = gearforge::PtyReplay(options).run(trace("type hi\nkey enter\nexpect hi\n"));
+    ASSERT_TRUE(report.ok) << report.error;
+    ASSERT_EQ(report.frames.size(), 3u);
+    EXPECT_EQ(report.frames[0].key, "h");
+    EXPECT_EQ(report.frames[2].key, "enter");
+    EXPECT_EQ(report.frames[0].bytes, 1u);
+    EXPECT_EQ(report.frames[2].bytes, 6u);  // "\r\n" echo, then "hi\r\n"
+    for (const auto& f : report.frames) EXPECT_LE(f.first_byte_ms, f.settle_ms);
+    EXPECT_EQ(report.settle.frames, 3u);
+    EXPECT_EQ(report.max_bytes, 6u);
+
+    options.expect_timeout_ms = 100;
+    report = gearforge::PtyReplay(options).run(trace("type a\nexpect never\n"));
+    EXPECT_FALSE(report.ok);
+    EXPECT_NE(report.error.find("timed out"), std::string::npos);
+
+    options.argv = {"true"};
+    report = gearforge::PtyReplay(options).run(trace("wait 200\nkey x\n"));
+    EXPECT_FALSE(report.ok);
+    EXPECT_NE(report.error.find("exited"), std::string::npos);
+}
@@ -0,0 +1,106 @@
+#include <gtest/gtest.h>
+#include "gear_calculator.h"
+#include "user_manager.h"
+#include "test_gears.h"
+
+namespace {
+
+std::string temp_file(const std::string& name, const std::string& text) {
+    std::string path = (std::filesystem::temp_directory_path() / name).string();
+    std::ofstream(path, std::ios::binary) << text;
+    return path;
+}
+
+}  // unnamed namespace
+
+TEST(RecordCodecTest, WritesSchemaOrderAndParsesItBack) {
+    gearforge::GearParams p = spur(24, 12.0);
+
+    gearforge::FormatBuffer out;
+    gearforge::RecordCodec<gearforge::GearParams>::write_header(out);
+    EXPECT_EQ(out.str(), "N,DP,M,PD,OD,RD,A,D,WD,CP,PA,CD,Backlash,X\n");
+    out.clear();
+    gearforge::RecordCodec<gearforge::GearParams>::write(out, p);
+    EXPECT_EQ(out.str().substr(0, 8), "24,12,2.");
+
+    gearforge::GearParams back;
+    gearforge::RecordCodec<gearforge::GearParams> codec;
+    ASSERT_TRUE(codec.parse(out.data(), out.data() + out.size() - 1, back));
+    EXPECT_EQ(back.n, 24);
+    EXPECT_EQ(back.m, p.m);
+    EXPECT_EQ(back.od, p.od);
+    EXPECT_EQ(back.backlash, p.backlash);
+}
+
+TEST(RecordCodecTest, MapsColumnsByHeaderName) {
+    std::string path = temp_file("gearforge_record_codec_reordered.csv",
+                                 "Backlash, pa ,N,Note,DP,M,PD,OD,RD,A,D,WD,CP,CD\r\n"
+                                 "0.001,14.5,30,spare,10,2.54,3,3.2,2.7686,0.1,0.1157,0.2157,0.314159,1.5\r\n"
+                                 "\n");
+    auto gears = gearforge::GearCalculator().load_known(path);
+    ASSERT_EQ(gears.size(), 1u);
+    EXPECT_EQ(gears[0].n, 30);
+    EXPECT_EQ(gears[0].pa, 14.5);
+    EXPECT_EQ(gears[0].backlash, 0.001);
+    EXPECT_EQ(gears[0].cd, 1.5);
+    std::filesystem::remove(path);
+}
+
+TEST(RecordCodecTest, RejectsBadHeadersAndRows) {
+    using Codec = gearforge::RecordCodec<gearforge::GearParams>;
+    EXPECT_THROW(Codec("N,DP,M,PD,OD,RD,A,D,WD,CP,PA,CD"), std::runtime_error);             // No Backlash
+    EXPECT_THROW(Codec("N,DP,M,PD,OD,RD,A,D,WD,CP,PA,CD,Backlash,dp"), std::runtime_error);  // DP twice
+
+    Codec codec("N,DP,M,PD,OD,RD,A,D,WD,CP,PA,CD,Backlash");
+    gearforge::GearParams p;
+    std::string short_row = "1,2,3";
+    std::string bad_cell = "1,2,3,4,5,6,7,8,9,10,11,12,x";
+    std::string good = "1,2,3,4,5,6,7,8,9,10,11,12,+13";
+    EXPECT_FALSE(codec.parse(short_row.data(), short_row.data() + short_row.size(), p));
+    EXPECT_FALSE(codec.parse(bad_cell.data(), bad_cell.data() + bad_cell.size(), p));
+    p.x = 0.25;
+    ASSERT_TRUE(codec.parse(good.data(), good.data() + good.size(), p));
+    EXPECT_EQ(p.backlash, 13.0);
+    EXPECT_EQ(p.x, 0.0);  // No X column: standard teeth
+
+    std::string path = temp_file("gearforge_record_codec_bad.csv",
+                                 "N,DP,M,PD,OD,RD,A,D,WD,CP,PA,CD,Backlash\n" + good + "\n" + bad_cell + "\n");
+    try {
+        gearforge::GearCalculator().load_known(path);
+        FAIL() << "expected a bad row error";
+    } catch (const std::runtime_error& e) {
+        EXPECT_NE(std::string(e.what()).find(":3"), std::string::npos) << e.what();
+    }
+    std::filesystem::remove(path);
+}
+
+TEST(RecordCodecTest, ShiftedGearsRoundTripThroughFiles) {
+    std::string path = (std::filesystem::temp_directory_path() / "gearforge_record_codec_shifted.csv").string();
+    gearforge::GearCalculator calc;
+    gearforge::GearParams p = spur(14, 10.0, 20.0, 0.5);
+    ASSERT_TRUE(calc.save(p, path));
+
+    auto back = calc.load_known(path);
+    ASSERT_EQ(back.size(), 1u);
+    auto again = calc.calculate(back[0]);
+    EXPECT_EQ(again.x, 0.5);
+    EXPECT_EQ(again.od, p.od);
+    EXPECT_EQ(again.rd, p.rd);
+    EXPECT_EQ(gearforge::GearParams::from_csv_row(p.to_csv_row()).x, 0.5);
+    std::filesystem::remove(path);
+}
+
+TEST(RecordCodecTest, UsersRoundTripThroughFiles) {
+    std::string path = (std::filesystem::temp_directory_path() / "gearforge_record_codec_users.csv").string();
+    std::vector<gearforge::User> users = {{"ada", "abc123", gearforge::UserRole::Admin},
+                                          {"bob", "def456", gearforge::UserRole::User}};
+    ASSERT_TRUE(gearforge::write_records(path, users));
+    auto back = gearforge::read_records<gearforge::User>(path);
+    ASSERT_EQ(back.size(), 2u);
+    EXPECT_EQ(back[0].username, "ada");
+    EXPECT_EQ(back[0].password_hash, "abc123");
+    EXPECT_EQ(back[0].role, gearforge::UserRole::Admin);
+    EXPECT_EQ(back[1].role, gearforge::UserRole::User);
+    EXPECT_EQ(back[1].to_csv_row(), (std::vector<std::string>{"bob", "def456", "User"}));
+    std::filesystem::remove(path);
+}
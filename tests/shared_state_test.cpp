@@ -0,0 +1,301 @@
+#include <fcntl.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <gtest/gtest.h>
+#include "settings_manager.h"
+#include "shared_state.h"
+#include "user_manager.h"
+
+namespace {
+
+std::string temp_path(const std::string& name) {
+    return (std::filesystem::temp_directory_path() / name).string();
+}
+
+void remove_all(const std::string& path) {
+    gearforge::SharedFile::remove(path);
+    std::filesystem::remove(path);
+    std::filesystem::remove(path + ".lock");
+}
+
+// Runs body in `count` child processes at once; true if every child exited 0
+bool in_processes(int count, const std::function<bool(int)>& body) {
+    std::vector<pid_t> children;
+    for (int i = 0; i < count; ++i) {
+        pid_t pid = ::fork();
+        if (pid == 0) ::_exit(body(i) ? 0 : 1);
+        children.push_back(pid);
+    }
+    bool ok = true;
+    for (pid_t pid : children) {
+        int status = 0;
+        ::waitpid(pid, &status, 0);
+        ok = ok && WIFEXITED(status) && WEXITSTATUS(status) == 0;
+    }
+    return ok;
+}
+
+size_t count_lines(const std::string& text) {
+    return std::count(text.begin(), text.end(), '\n');
+}
+
+}  // unnamed namespace
+
+TEST(SharedStateTest, PublishesToEveryAttachedCopy) {
+    std::string path = temp_path("gearforge_shared_publish.txt");
+    remove_all(path);
+    std::ofstream(path) << "first\n";
+
+    gearforge::SharedFile a(path, 16);
+    gearforge::SharedFile b(path, 16);
+    ASSERT_TRUE(a.is_shared());
+    EXPECT_EQ(b.read(), "first\n");
+    uint64_t v = b.version();
+
+    // Outgrows the 16 byte segment; b remaps when it sees the new size
+    std::string big(5000, 'x');
+    EXPECT_TRUE(a.update([&](std::string& text) {
+        text += big;
+        return true;
+    }));
+    EXPECT_GT(b.version(), v);
+    EXPECT_EQ(b.read(), "first\n" + big);
+    EXPECT_EQ(b.view([](std::string_view s) { return s.size(); }), 5006u);
+
+    // Declined edits write nothing
+    v = a.version();
+    EXPECT_FALSE(a.update([](std::string& text) {
+        text.clear();
+        return false;
+    }));
+    EXPECT_EQ(a.version(), v);
+    EXPECT_EQ(std::filesystem::file_size(path), 5006u);
+
+    // Hand edits show up on refresh
+    std::ofstream(path) << "edited\n";
+    EXPECT_TRUE(b.refresh());
+    EXPECT_FALSE(a.refresh());
+    EXPECT_EQ(a.read(), "edited\n");
+    remove_all(path);
+}
+
+TEST(SharedStateTest, ConcurrentWritersLoseNothing) {
+    std::string path = temp_path("gearforge_shared_writers.txt");
+    remove_all(path);
+    gearforge::SharedFile reader(path);
+    uint64_t start = reader.version();
+    const int kProcesses = 6, kWrites = 40;
+    bool ok = in_processes(kProcesses, [&](int id) {
+        gearforge::SharedFile file(path);
+        for (int i = 0; i < kWrites; ++i) {
+            file.update([&](std::string& text) {
+                text += std::to_string(id) + "," + std::to_string(i) + "\n";
+                return true;
+            });
+        }
+        return true;
+    });
+    ASSERT_TRUE(ok);
+    EXPECT_EQ(count_lines(reader.read()), size_t(kProcesses * kWrites));
+    EXPECT_EQ(reader.read(), std::string(std::istreambuf_iterator<char>(std::ifstream(path).rdbuf()), {}));
+    EXPECT_EQ(reader.version(), start + kProcesses * kWrites);
+    remove_all(path);
+}
+
+TEST(SharedStateTest, ReadersNeverSeeTornSnapshots) {
+    std::string path = temp_path("gearforge_shared_torn.txt");
+    remove_all(path);
+    gearforge::SharedFile file(path, 64);
+    std::atomic<bool> done{false};
+    std::atomic<int> torn{0};
+    std::thread reader([&] {
+        gearforge::SharedFile mine(path);
+        while (!done) {
+            std::string s = mine.read();
+            // Every version is one letter repeated
+            if (!s.empty() && s.find_first_not_of(s[0]) != std::string::npos) ++torn;
+        }
+    });
+    for (int i = 0; i < 300; ++i) {
+        file.update([&](std::string& text) {
+            text.assign(1000 + i * 13, static_cast<char>('a' + i % 26));
+            return true;
+        });
+    }
+    done = true;
+    reader.join();
+    EXPECT_EQ(torn.load(), 0);
+    remove_all(path);
+}
+
+TEST(SharedStateTest, SessionsShareUsersAndSettings) {
+    std::string users = temp_path("gearforge_shared_users.csv");
+    std::string settings = temp_path("gearforge_shared_settings.ini");
+    remove_all(users);
+    remove_all(settings);
+
+    // Every process registers its own accounts and one name they all want
+    bool ok = in_processes(4, [&](int id) {
+        gearforge::UserManager um(users);
+        for (int i = 0; i < 10; ++i) um.register_user("user" + std::to_string(id) + "_" + std::to_string(i), "pw");
+        um.register_user("shared", "pw" + std::to_string(id));
+        return true;
+    });
+    ASSERT_TRUE(ok);
+    auto rows = gearforge::read_records<gearforge::User>(users);
+    EXPECT_EQ(rows.size(), 41u);
+    gearforge::UserManager um(users);
+    EXPECT_TRUE(um.login("user3_9", "pw"));
+    EXPECT_FALSE(um.login("user3_9", "wrong"));
+    EXPECT_FALSE(um.register_user("user0_0", "again"));
+    EXPECT_TRUE(um.register_user("late", "pw"));
+    EXPECT_TRUE(gearforge::UserManager(users).login("late", "pw"));
+
+    // Two sessions change different keys; both survive
+    std::ofstream(settings) << "theme = dark\nprecision = 3\n";
+    gearforge::SettingsManager one(settings), two(settings);
+    one.set("precision", "5");
+    two.set("single_user", "true");
+    two.erase("theme");
+    EXPECT_EQ(two.get("precision"), "3");
+    EXPECT_EQ(two.get("theme", "none"), "none");  // Unsaved changes apply to this session right away
+    one.save();
+    EXPECT_EQ(two.get("precision"), "5");  // Seen as soon as the other session saves
+    two.save();
+    auto merged = gearforge::SettingsManager(settings).all();
+    EXPECT_EQ(merged.size(), 2u);
+    EXPECT_EQ(merged["precision"], "5");
+    EXPECT_EQ(merged["single_user"], "true");
+    EXPECT_EQ(one.get("theme", "none"), "none");
+
+    // A save from another process reaches a live session too
+    ASSERT_TRUE(in_processes(1, [&](int) {
+        gearforge::SettingsManager other(settings);
+        other.set("precision", "7");
+        other.save();
+        return true;
+    }));
+    EXPECT_EQ(one.get("precision"), "7");
+    EXPECT_TRUE(one.has("single_user"));
+    remove_all(users);
+    remove_all(settings);
+}
+
+TEST(SharedStateTest, RefusesToWriteWithoutTheLock) {
+    std::string path = temp_path("gearforge_shared_nolock.csv");
+    remove_all(path);
+    std::filesystem::remove_all(path + ".lock");
+    std::ofstream(path) << "Username,PasswordHash,Role\n";
+    std::filesystem::create_directory(path + ".lock");  // open() on it fails, so flock is never taken
+    EXPECT_FALSE(gearforge::FileLock(path).locked());
+
+    gearforge::SharedFile file(path);
+    EXPECT_THROW(file.update([](std::string& text) {
+        text += "lost\n";
+        return true;
+    }), std::runtime_error);
+    gearforge::UserManager um(path);
+    EXPECT_THROW(um.register_user("nobody", "pw"), std::runtime_error);
+    EXPECT_EQ(file.read(), "Username,PasswordHash,Role\n");
+    EXPECT_EQ(std::filesystem::file_size(path), 27u);
+    std::filesystem::remove(path + ".lock");
+    remove_all(path);
+}
+
+TEST(SharedStateTest, SegmentsAreOwnerOnlyAndForeignOnesAreRefused) {
+    std::string path = temp_path("gearforge_shared_private.csv");
+    remove_all(path);
+    std::ofstream(path) << "Username,PasswordHash,Role\n";
+    std::set<std::filesystem::path> before;
+    for (const auto& entry : std::filesystem::directory_iterator("/dev/shm")) before.insert(entry.path());
+    gearforge::SharedFile file(path);
+    ASSERT_TRUE(file.is_shared());
+    auto block = gearforge::SharedBlock::create("/gearforge-test-private", 16, [](char*) {});
+    ASSERT_TRUE(block);
+    size_t created = 0;
+    for (const auto& entry : std::filesystem::directory_iterator("/dev/shm")) {
+        if (before.count(entry.path())) continue;
+        struct stat st;
+        ASSERT_EQ(::stat(entry.path().c_str(), &st), 0);
+        EXPECT_EQ(st.st_mode & 077, 0u) << entry.path();
+        ++created;
+    }
+    EXPECT_EQ(created, 2u);
+
+    // Writable by others: anyone could have put rows in it
+    int fd = ::shm_open("/gearforge-test-private", O_RDWR, 0);
+    ASSERT_GE(fd, 0);
+    ::fchmod(fd, 0622);
+    ::close(fd);
+    EXPECT_FALSE(gearforge::SharedBlock::attach("/gearforge-test-private"));
+
+    // Made by another user
+    if (::geteuid() == 0) {
+        ASSERT_TRUE(in_processes(1, [](int) {
+            if (::setuid(65534) != 0) return false;
+            auto foreign = gearforge::SharedBlock::create("/gearforge-test-foreign", 16, [](char*) {});
+            ::_exit(foreign ? 0 : 1);  // Leaves it behind, as a spoofing process would
+        }));
+        EXPECT_FALSE(gearforge::SharedBlock::attach("/gearforge-test-foreign"));
+        ::shm_unlink("/gearforge-test-foreign");
+    }
+    block.reset();
+    remove_all(path);
+}
+
+TEST(SharedStateTest, KilledSessionsLeaveNothingBehind) {
+    std::string path = temp_path("gearforge_shared_killed.csv");
+    std::string alive = temp_path("gearforge_shared_alive.csv");
+    remove_all(path);
+    remove_all(alive);
+    std::ofstream(path) << "Username,PasswordHash,Role\n";
+    std::ofstream(alive) << "Username,PasswordHash,Role\n";
+    gearforge::SharedFile held(alive);
+    auto block = gearforge::SharedBlock::create("/gearforge-test-held", 16, [](char*) {});
+    ASSERT_TRUE(held.is_shared());
+    ASSERT_TRUE(block);
+
+    auto segments = [] {
+        std::set<std::filesystem::path> found;
+        for (const auto& entry : std::filesystem::directory_iterator("/dev/shm")) found.insert(entry.path());
+        return found;
+    };
+    auto before = segments();
+    int ready[2];
+    ASSERT_EQ(::pipe(ready), 0);
+    pid_t pid = ::fork();
+    if (pid == 0) {
+        gearforge::SharedFile file(path);
+        auto mine = gearforge::SharedBlock::create("/gearforge-test-killed", 1 << 20, [](char*) {});
+        char ok = file.is_shared() && mine;
+        if (::write(ready[1], &ok, 1) != 1) ::_exit(1);
+        while (true) ::pause();
+    }
+    char ok = 0;
+    ASSERT_EQ(::read(ready[0], &ok, 1), 1);
+    ASSERT_TRUE(ok);
+    std::vector<std::filesystem::path> left;
+    for (const auto& p : segments()) {
+        if (!before.count(p)) left.push_back(p);
+    }
+    EXPECT_EQ(left.size(), 2u);  // The killed session's users.csv copy and its block
+    ::kill(pid, SIGKILL);
+    ::waitpid(pid, nullptr, 0);
+    ::close(ready[0]);
+    ::close(ready[1]);
+
+    EXPECT_GE(gearforge::remove_stale_segments(), 2u);
+    for (const auto& p : left) EXPECT_FALSE(std::filesystem::exists(p)) << p;
+    EXPECT_TRUE(gearforge::SharedBlock::attach("/gearforge-test-held"));  // Still in use here
+    EXPECT_EQ(held.read(), "Username,PasswordHash,Role\n");
+    gearforge::SharedFile again(alive);
+    EXPECT_TRUE(again.is_shared());
+    block.reset();
+    EXPECT_FALSE(gearforge::SharedBlock::attach("/gearforge-test-held"));  // Last holder gone
+    remove_all(path);
+    remove_all(alive);
+}
@@ -0,0 +1,8 @@
+#pragma once
+
+#include "gear_calculator.h"
+
+// A solved spur gear (inches); consumers that solve their input again get the same values
+inline gearforge::GearParams spur(int n, double dp, double pa = 20.0, double x = 0.0) {
+    return gearforge::GearCalculator().calculate(gearforge::GearParams::spec(n, dp, pa, x));
+}
@@ -0,0 +1,47 @@
+#include <gtest/gtest.h>
+#include "tolerance_analysis.h"
+#include "test_gears.h"
+
+TEST(ToleranceAnalyzerTest, NominalMatchesDesignBacklash) {
+    gearforge::ToleranceAnalyzer analyzer;
+    auto report = analyzer.analyze(spur(20, 10.0), spur(40, 10.0), gearforge::ToleranceInputs(), 1000, 1);
+    EXPECT_NEAR(report.nominal_backlash, 0.003 * 2.0, 1e-6);  // Default 0.003 * PD of the pinion
+    EXPECT_GT(report.nominal_contact_ratio, 1.5);
+    EXPECT_LT(report.nominal_contact_ratio, 1.7);
+}
+
+TEST(ToleranceAnalyzerTest, ZeroSpreadGivesNominal) {
+    gearforge::ToleranceInputs tol;
+    tol.pitch_error.spread = tol.pressure_angle.spread = 0.0;
+    tol.runout = tol.center_distance = tol.tooth_thickness = gearforge::ToleranceSpec();
+    gearforge::ToleranceAnalyzer analyzer;
+    auto report = analyzer.analyze(spur(20, 10.0), spur(40, 10.0), tol, 5000, 2);
+    EXPECT_NEAR(report.backlash.p01, report.nominal_backlash, 1e-6);
+    EXPECT_NEAR(report.backlash.p99, report.nominal_backlash, 1e-6);
+    EXPECT_NEAR(report.backlash.stddev, 0.0, 1e-6);
+    EXPECT_EQ(report.binding_probability, 0.0);
+}
+
+TEST(ToleranceAnalyzerTest, IdenticalForAnyThreadCount) {
+    gearforge::ToleranceAnalyzer analyzer(42);
+    gearforge::ToleranceInputs tol;
+    auto one = analyzer.analyze(spur(18, 12.0), spur(54, 12.0), tol, 100000, 1);
+    auto many = analyzer.analyze(spur(18, 12.0), spur(54, 12.0), tol, 100000, 7);
+    EXPECT_EQ(one.backlash.mean, many.backlash.mean);
+    EXPECT_EQ(one.backlash.stddev, many.backlash.stddev);
+    EXPECT_EQ(one.backlash.p05, many.backlash.p05);
+    EXPECT_EQ(one.contact_ratio.p50, many.contact_ratio.p50);
+    EXPECT_EQ(one.binding_probability, many.binding_probability);
+}
+
+TEST(ToleranceAnalyzerTest, TighterCenterDistanceBindsMore) {
+    gearforge::ToleranceAnalyzer analyzer;
+    gearforge::ToleranceInputs loose, tight;
+    tight.center_distance.mean = -0.004;
+    auto a = analyzer.analyze(spur(20, 10.0), spur(40, 10.0), loose, 20000);
+    auto b = analyzer.analyze(spur(20, 10.0), spur(40, 10.0), tight, 20000);
+    EXPECT_LT(b.backlash.mean, a.backlash.mean);
+    EXPECT_GT(b.binding_probability, a.binding_probability);
+    EXPECT_LE(a.backlash.p01, a.backlash.p50);
+    EXPECT_LE(a.backlash.p50, a.backlash.p99);
+}
@@ -0,0 +1,206 @@
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <gtest/gtest.h>
+#include "watched_catalog.h"
+#include "test_gears.h"
+
+namespace {
+
+std::string catalog_text(int rows, int edited = -1) {
+    gearforge::FormatBuffer out;
+    gearforge::RecordCodec<gearforge::GearParams>::write_header(out);
+    for (int i = 0; i < rows; ++i) {
+        gearforge::GearParams p = spur(10 + i % 190, 4.0 + (i / 190) * 0.25);
+        if (i == edited) p.backlash = 0.125;
+        gearforge::RecordCodec<gearforge::GearParams>::write(out, p);
+    }
+    return out.str();
+}
+
+// Written to a temporary name and renamed over the target, as editors save
+void save(const std::string& path, const std::string& text) {
+    std::ofstream(path + ".tmp", std::ios::binary) << text;
+    std::filesystem::rename(path + ".tmp", path);
+}
+
+std::string temp_path(const std::string& name) {
+    return (std::filesystem::temp_directory_path() / name).string();
+}
+
+void expect_same(const gearforge::CatalogSnapshot& snap, const std::vector<gearforge::GearParams>& rows) {
+    ASSERT_EQ(snap.size(), rows.size());
+    auto flat = snap.rows();
+    for (size_t i = 0; i < rows.size(); ++i) {
+        ASSERT_EQ(flat[i].n, rows[i].n) << i;
+        ASSERT_EQ(flat[i].dp, rows[i].dp) << i;
+        ASSERT_EQ(flat[i].backlash, rows[i].backlash) << i;
+        ASSERT_EQ(snap[i].od, rows[i].od) << i;
+    }
+}
+
+}  // unnamed namespace
+
+TEST(WatchedCatalogTest, EditReparsesOnlyNearbyChunks) {
+    std::string path = temp_path("gearforge_watched_edit.csv");
+    save(path, catalog_text(20000));
+    gearforge::WatchedCatalog catalog(path);
+    auto first = catalog.snapshot();
+    expect_same(*first, gearforge::GearCalculator().load_known(path));
+    EXPECT_GT(first->chunks.size(), 50u);
+
+    save(path, catalog_text(20000, 12345));
+    auto reload = catalog.reload();
+    EXPECT_TRUE(reload.changed);
+    EXPECT_LE(reload.reparsed_chunks, 2u);
+    EXPECT_LT(reload.reparsed_rows, 2048u);
+    auto second = catalog.snapshot();
+    EXPECT_EQ(second->version, first->version + 1);
+    expect_same(*second, gearforge::GearCalculator().load_known(path));
+    EXPECT_EQ((*second)[12345].backlash, 0.125);
+    EXPECT_NE((*first)[12345].backlash, 0.125);  // Old snapshot is untouched
+
+    // Same bytes again: nothing to do
+    save(path, catalog_text(20000, 12345));
+    EXPECT_FALSE(catalog.reload().changed);
+    EXPECT_EQ(catalog.snapshot()->version, second->version);
+    std::filesystem::remove(path);
+}
+
+TEST(WatchedCatalogTest, InsertedAndDeletedLinesShiftTheRest) {
+    std::string path = temp_path("gearforge_watched_shift.csv");
+    std::string text = catalog_text(10000);
+    save(path, text);
+    gearforge::WatchedCatalog catalog(path);
+
+    // Drop line 101 and duplicate line 5001
+    std::vector<size_t> starts = {0};
+    for (size_t i = 0; i < text.size(); ++i) if (text[i] == '\n') starts.push_back(i + 1);
+    std::string edited = text.substr(0, starts[101]) + text.substr(starts[102], starts[5002] - starts[102]) +
+                         text.substr(starts[5001], starts[5002] - starts[5001]) + text.substr(starts[5002]);
+    save(path, edited);
+    auto reload = catalog.reload();
+    EXPECT_LE(reload.reparsed_chunks, 4u);
+    expect_same(*catalog.snapshot(), gearforge::GearCalculator().load_known(path));
+
+    size_t teeth = 0;
+    catalog.snapshot()->for_each_with_teeth(42, [&](size_t row, const gearforge::GearParams& p) {
+        EXPECT_EQ(p.n, 42);
+        EXPECT_EQ(catalog.snapshot()->operator[](row).n, 42);
+        ++teeth;
+    });
+    EXPECT_GT(teeth, 0u);
+    std::filesystem::remove(path);
+}
+
+TEST(WatchedCatalogTest, BadRowKeepsTheCurrentVersion) {
+    std::string path = temp_path("gearforge_watched_bad.csv");
+    save(path, catalog_text(500));
+    gearforge::WatchedCatalog catalog(path);
+    auto before = catalog.snapshot();
+    save(path, catalog_text(500) + "12,oops\n");
+    EXPECT_THROW(catalog.reload(), std::runtime_error);
+    EXPECT_EQ(catalog.snapshot(), before);
+    std::filesystem::remove(path);
+}
+
+TEST(WatchedCatalogTest, WatcherAppliesSavedEdits) {
+    std::string dir = temp_path("gearforge_watched_dir");
+    std::filesystem::create_directories(dir);
+    std::string path = dir + "/known_values.csv";
+    save(path, catalog_text(3000));
+    gearforge::WatchedCatalog catalog(path);
+
+    std::mutex mutex;
+    std::condition_variable updated;
+    uint64_t seen = 0;
+    catalog.on_update([&](const gearforge::CatalogSnapshot&, const gearforge::CatalogSnapshot& after,
+                          const gearforge::CatalogReload&) {
+        std::lock_guard<std::mutex> lock(mutex);
+        seen = after.version;
+        updated.notify_all();
+    });
+    ASSERT_TRUE(catalog.start());
+    save(path, catalog_text(3000, 2999));
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        ASSERT_TRUE(updated.wait_for(lock, std::chrono::seconds(5), [&] { return seen > 1; }));
+    }
+    EXPECT_EQ((*catalog.snapshot())[2999].backlash, 0.125);
+    EXPECT_EQ(catalog.last_error(), "");
+    catalog.stop();
+    std::filesystem::remove_all(dir);
+}
+
+TEST(WatchedCatalogTest, SessionsShareOneCopy) {
+    std::string path = temp_path("gearforge_watched_shared.csv");
+    save(path, catalog_text(5000));
+    gearforge::WatchedCatalog first(path);
+    auto snap = first.snapshot();
+    ASSERT_TRUE(snap->chunks[0]->block);
+    EXPECT_TRUE(snap->chunks[0]->parsed.empty());  // Private rows are dropped once published
+
+    // Another process maps the same block
+    pid_t pid = ::fork();
+    if (pid == 0) {
+        bool ok;
+        {
+            gearforge::WatchedCatalog other(path);
+            auto mine = other.snapshot();
+            ok = mine->chunks[0]->block && mine->chunks[0]->block->name() == snap->chunks[0]->block->name() &&
+                 mine->size() == 5000 && mine->rows()[4999].od == snap->rows()[4999].od;
+        }
+        ::_exit(ok ? 0 : 1);
+    }
+    int status = 0;
+    ::waitpid(pid, &status, 0);
+    EXPECT_TRUE(WIFEXITED(status) && WEXITSTATUS(status) == 0);
+
+    // The first session to see an edit parses it and publishes just those
+    // rows; the next one attaches
+    gearforge::WatchedCatalog second(path);
+    save(path, catalog_text(5000, 4000));
+    auto parsed = first.reload();
+    auto attached = second.reload();
+    EXPECT_FALSE(parsed.attached);
+    EXPECT_GT(parsed.reparsed_rows, 0u);
+    EXPECT_TRUE(attached.attached);
+    EXPECT_EQ(attached.reparsed_rows, 0u);
+    EXPECT_EQ(attached.added, parsed.added);
+    expect_same(*second.snapshot(), gearforge::GearCalculator().load_known(path));
+    EXPECT_EQ(first.snapshot()->chunks[0]->block, snap->chunks[0]->block);
+    EXPECT_EQ(second.snapshot()->chunks[0]->block->name(), first.snapshot()->chunks[0]->block->name());
+
+    // Every edit adds a block until the version is packed into one again
+    for (int edit = 0; edit < 40; ++edit) {
+        save(path, catalog_text(5000, edit * 97));
+        first.reload();
+    }
+    std::set<const gearforge::SharedBlock*> blocks;
+    for (const auto& chunk : first.snapshot()->chunks) blocks.insert(chunk->block.get());
+    EXPECT_LE(blocks.size(), 16u);
+    EXPECT_TRUE(second.reload().attached);
+    expect_same(*second.snapshot(), gearforge::GearCalculator().load_known(path));
+    std::filesystem::remove(path);
+}
+
+TEST(WatchedCatalogTest, HeaderOrderKeepsRowBlocksApart) {
+    // Same data lines; the second header swaps the OD and RD columns
+    std::string text = catalog_text(3000);
+    std::string body = text.substr(text.find('\n') + 1);
+    std::string path = temp_path("gearforge_watched_layout.csv");
+    std::string swapped_path = temp_path("gearforge_watched_layout_swapped.csv");
+    save(path, "N,DP,M,PD,OD,RD,A,D,WD,CP,PA,CD,Backlash,X\n" + body);
+    save(swapped_path, "N,DP,M,PD,RD,OD,A,D,WD,CP,PA,CD,Backlash,X\n" + body);
+
+    gearforge::WatchedCatalog catalog(path);
+    gearforge::WatchedCatalog swapped(swapped_path);
+    auto a = catalog.snapshot(), b = swapped.snapshot();
+    ASSERT_TRUE(a->chunks[0]->block && b->chunks[0]->block);
+    EXPECT_NE(a->chunks[0]->block->name(), b->chunks[0]->block->name());
+    expect_same(*b, gearforge::GearCalculator().load_known(swapped_path));
+    EXPECT_EQ((*b)[10].od, (*a)[10].rd);
+    EXPECT_EQ((*b)[10].rd, (*a)[10].od);
+    std::filesystem::remove(path);
+    std::filesystem::remove(swapped_path);
+}